@@ -0,0 +1,211 @@
+#include "asset/assetloader.hpp"
+
+#include "core/memory/threadcache.hpp"
+#include "gfx/vertexbuffer.hpp"
+
+namespace asset
+{
+
+AssetLoader::AssetLoader( const uint32 numThreads )
+{
+   stop = false;
+   numPending = 0;
+
+   uint32 count = numThreads;
+   if ( count == 0 )
+   {
+      const uint32 hardwareThreads = std::thread::hardware_concurrency();
+      count = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+   }
+
+   for ( uint32 i = 0; i < count; i++ )
+      workers.push_back( std::thread( &AssetLoader::WorkerLoop, this ) );
+}
+
+AssetLoader::~AssetLoader()
+{
+   {
+      std::lock_guard<std::mutex> lock( jobMutex );
+      stop = true;
+   }
+   jobCondition.notify_all();
+
+   for ( uint32 i = 0; i < workers.size(); i++ )
+      workers[i].join();
+}
+
+void AssetLoader::WorkerLoop()
+{
+   for (;;)
+   {
+      std::function<void()> job;
+      {
+         std::unique_lock<std::mutex> lock( jobMutex );
+         while ( jobs.empty() && !stop )
+            jobCondition.wait( lock );
+         // the queue is worked off before stopping, every handle gets its result
+         if ( jobs.empty() )
+            break;
+         job = jobs.front();
+         jobs.pop_front();
+      }
+      job();
+   }
+
+   threadcache::FlushThread();
+}
+
+void AssetLoader::PushJob( const std::function<void()> &job )
+{
+   {
+      std::lock_guard<std::mutex> lock( jobMutex );
+      jobs.push_back( job );
+   }
+   jobCondition.notify_one();
+}
+
+void AssetLoader::PushUpload( const std::function<void()> &upload )
+{
+   std::lock_guard<std::mutex> lock( uploadMutex );
+   uploads.push_back( upload );
+}
+
+uint32 AssetLoader::ProcessUploads( const uint32 maxUploads )
+{
+   uint32 numProcessed = 0;
+   while ( numProcessed < maxUploads )
+   {
+      std::function<void()> upload;
+      {
+         std::lock_guard<std::mutex> lock( uploadMutex );
+         if ( uploads.empty() )
+            break;
+         upload = uploads.front();
+         uploads.pop_front();
+      }
+      // outside the lock, workers keep posting while the GPU is fed
+      upload();
+      numProcessed++;
+   }
+   return numProcessed;
+}
+
+static bool LoadObjFile( const String_c &path, const String_c &materialPath, ObjFile &obj )
+{
+   obj.SetMaterialFilePath( materialPath );
+   if ( !obj.Open( path ) )
+      return false;
+
+   const bool ok = obj.Read();
+   obj.Close();
+   return ok;
+}
+
+AssetHandle<ObjFile> AssetLoader::LoadObj( const String_c &path, const String_c &materialPath,
+   const std::function<bool( ObjFile& )> &upload )
+{
+   return Load<ObjFile>( path, std::bind( &LoadObjFile, std::placeholders::_1, materialPath, std::placeholders::_2 ), upload );
+}
+
+const float *ObjMesh::GetVertexData() const
+{
+   if ( cache.IsOpen() )
+      return (const float*)cache.GetVertexData();
+   return vertices.empty() ? NULL : &vertices[0];
+}
+
+const uint32 *ObjMesh::GetIndexData() const
+{
+   if ( cache.IsOpen() )
+      return (const uint32*)cache.GetIndexData();
+   return indices.empty() ? NULL : &indices[0];
+}
+
+static bool LoadObjMeshFile( const String_c &path, const String_c &materialPath, ObjMesh &mesh )
+{
+   const String_c cachePath = path + ".meshbin";
+   if ( mesh.cache.Open( cachePath ) )
+   {
+      if ( mesh.cache.GetIndexSize() == sizeof(uint32) && !mesh.cache.IsStale( path ) )
+      {
+         mesh.vertexFormat = mesh.cache.GetVertexFormat();
+         mesh.vertexStride = mesh.cache.GetVertexStride();
+         mesh.numVertices = mesh.cache.GetNumVertices();
+         mesh.numIndices = mesh.cache.GetNumIndices();
+         return true;
+      }
+      mesh.cache.Close();
+   }
+
+   // hashed before the import, a source that changes meanwhile makes the cache stale next time
+   meshbin::MeshBinDesc desc;
+   const bool hashed = meshbin::HashSourceFile( path, desc.sourceHash, desc.sourceSize, desc.sourceTime );
+
+   ObjFile obj;
+   if ( !LoadObjFile( path, materialPath, obj ) )
+      return false;
+
+   // welded here instead of in VertexBuffer::PrepareMesh, that needs GL and the frame allocator
+   // of the main thread
+   mesh.vertexFormat = (eVertexFormat)(obj.mesh.GetVertexFormat() &
+      (vertexformat::VF_POSITION | vertexformat::VF_NORMAL | vertexformat::VF_TEXCOORD2D_1));
+   mesh.vertexStride = vbo::GetMeshVertexStride( mesh.vertexFormat );
+   const uint32 floatsPerVertex = mesh.vertexStride / sizeof(float);
+   std::vector<float> corners( (size_t)vbo::GetNumMeshCorners( obj.mesh ) * floatsPerVertex );
+   const uint32 numCorners = corners.empty() ? 0 : vbo::ExpandMeshCorners( obj.mesh, mesh.vertexStride, &corners[0] );
+   if ( numCorners > 0 )
+   {
+      VertexWelder<uint32> welder( floatsPerVertex );
+      if ( !welder.Weld( &corners[0], numCorners, mesh.vertices, mesh.indices ) )
+         return false;
+   }
+   mesh.numVertices = (uint32)(mesh.vertices.size() / (floatsPerVertex > 0 ? floatsPerVertex : 1));
+   mesh.numIndices = (uint32)mesh.indices.size();
+
+   // ObjFile does not hand out its materials, the cache is written without a material table
+   desc.vertexFormat = mesh.vertexFormat;
+   desc.vertexStride = mesh.vertexStride;
+   desc.vertices = mesh.GetVertexData();
+   desc.numVertices = mesh.numVertices;
+   desc.indices = mesh.GetIndexData();
+   desc.numIndices = mesh.numIndices;
+   desc.indexSize = sizeof(uint32);
+   desc.materials = NULL;
+   desc.numMaterials = 0;
+
+   // from now on the mesh is read from the mapped cache, a cache that can not be written leaves
+   // the data in the vectors
+   if ( hashed && meshbin::WriteMeshBin( cachePath, desc ) && mesh.cache.Open( cachePath ) )
+   {
+      std::vector<float>().swap( mesh.vertices );
+      std::vector<uint32>().swap( mesh.indices );
+   }
+   return true;
+}
+
+AssetHandle<ObjMesh> AssetLoader::LoadObjMesh( const String_c &path, const String_c &materialPath,
+   const std::function<bool( ObjMesh& )> &upload )
+{
+   return Load<ObjMesh>( path, std::bind( &LoadObjMeshFile, std::placeholders::_1, materialPath, std::placeholders::_2 ), upload );
+}
+
+static bool LoadBinaryFile( const String_c &path, std::vector<byte> &contents )
+{
+   BufferedReader reader;
+   if ( !reader.Open( path ) )
+      return false;
+
+   contents.resize( (size_t)reader.GetSize() );
+   if ( contents.empty() )
+      return true;
+   // one read of the whole size goes straight into the vector
+   return reader.Read( &contents[0], (uint32)contents.size() ) == contents.size();
+}
+
+AssetHandle<std::vector<byte> > AssetLoader::LoadBinary( const String_c &path,
+   const std::function<bool( std::vector<byte>& )> &upload )
+{
+   return Load<std::vector<byte> >( path, &LoadBinaryFile, upload );
+}
+
+} // namespace asset
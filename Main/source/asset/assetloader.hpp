@@ -0,0 +1,196 @@
+#ifndef _ASSETLOADER_HPP_INCLUDED_
+#define _ASSETLOADER_HPP_INCLUDED_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+#include "core/string/string.hpp"
+#include "core/fileio/bufferedreader.hpp"
+#include "model/objloader.hpp"
+#include "model/meshbin.hpp"
+
+using core::string::String_c;
+
+namespace asset
+{
+
+enum eAssetState
+{
+   ASSET_QUEUED,
+   ASSET_LOADING,
+   ASSET_LOADED, // CPU side data complete, waiting for upload on the render thread
+   ASSET_READY, // loaded and uploaded
+   ASSET_FAILED
+};
+
+// state shared by the loader job and all handles of one asset
+template <class T>
+struct AssetData
+{
+   T asset;
+   String_c path;
+   std::atomic<int32> state;
+   std::promise<bool> loaded;
+   std::shared_future<bool> future;
+
+   AssetData( const String_c &path ) : path(path), state(ASSET_QUEUED)
+   {
+      future = loaded.get_future().share();
+   }
+};
+
+// Reference to an asset that may still be loading. The asset must not be touched before it is
+// loaded, Get returns NULL until then. The future completes when the CPU side data is done, with
+// false if loading failed; the GPU upload happens later in AssetLoader::ProcessUploads
+template <class T>
+class AssetHandle
+{
+private:
+   std::shared_ptr<AssetData<T> > data;
+public:
+   AssetHandle() {}
+   AssetHandle( const std::shared_ptr<AssetData<T> > &data ) : data(data) {}
+
+   bool IsValid() const { return data != NULL; }
+   eAssetState GetState() const { return (eAssetState)data->state.load(); }
+   bool IsLoaded() const { const eAssetState state = GetState(); return state == ASSET_LOADED || state == ASSET_READY; }
+   bool IsReady() const { return GetState() == ASSET_READY; }
+   bool IsFailed() const { return GetState() == ASSET_FAILED; }
+
+   const std::shared_future<bool> &GetFuture() const { return data->future; }
+   // blocks until the CPU side data is loaded, false if loading failed
+   bool Wait() const { return data->future.get(); }
+
+   T *Get() const { return IsLoaded() ? &data->asset : NULL; }
+   const String_c &GetPath() const { return data->path; }
+};
+
+// An OBJ mesh as indexed, interleaved P(N)(T) vertices, ready for a vertex and an index buffer.
+// LoadObjMesh reads it from the .meshbin cache next to the source when that is up to date, else
+// it imports the OBJ, welds it and writes the cache for the next run. The data points into the
+// mapped cache, or into the vectors when the cache could not be written
+struct ObjMesh
+{
+   meshbin::MeshBinFile cache; // open when the data comes from the cache file
+   std::vector<float> vertices;
+   std::vector<uint32> indices;
+   eVertexFormat vertexFormat;
+   uint32 vertexStride;
+   uint32 numVertices;
+   uint32 numIndices;
+
+   ObjMesh() : vertexFormat(vertexformat::VF_EMPTY), vertexStride(0), numVertices(0), numIndices(0) {}
+
+   const float *GetVertexData() const;
+   const uint32 *GetIndexData() const;
+};
+
+// Loads assets on a pool of worker threads. A load function reads and parses the file into the
+// asset on a worker, the optional upload function then runs on the render thread, which calls
+// ProcessUploads once per frame. This way I/O, parsing and GPU uploads overlap with the frame
+// loop, and the frame loop never waits for the disk
+class AssetLoader
+{
+private:
+   std::vector<std::thread> workers;
+   std::deque<std::function<void()> > jobs;
+   std::deque<std::function<void()> > uploads;
+   std::mutex jobMutex;
+   std::mutex uploadMutex;
+   std::condition_variable jobCondition;
+   std::atomic<uint32> numPending;
+   bool stop;
+
+   void WorkerLoop();
+   void PushJob( const std::function<void()> &job );
+   void PushUpload( const std::function<void()> &upload );
+
+   AssetLoader( const AssetLoader &other );
+   AssetLoader &operator=( const AssetLoader &other );
+public:
+   // 0 threads picks one less than the hardware threads, the main thread is busy rendering
+   AssetLoader( const uint32 numThreads = 0 );
+   // finishes the queued loads, uploads that were not processed are dropped
+   ~AssetLoader();
+
+   template <class T>
+   AssetHandle<T> Load( const String_c &path, const std::function<bool( const String_c&, T& )> &load,
+      const std::function<bool( T& )> &upload = std::function<bool( T& )>() );
+
+   // legacy OBJ loader, materials are looked up in materialPath
+   AssetHandle<ObjFile> LoadObj( const String_c &path, const String_c &materialPath,
+      const std::function<bool( ObjFile& )> &upload = std::function<bool( ObjFile& )>() );
+   // OBJ mesh through its .meshbin cache, see ObjMesh
+   AssetHandle<ObjMesh> LoadObjMesh( const String_c &path, const String_c &materialPath,
+      const std::function<bool( ObjMesh& )> &upload = std::function<bool( ObjMesh& )>() );
+   // whole file contents, for images and other data decoded at upload
+   AssetHandle<std::vector<byte> > LoadBinary( const String_c &path,
+      const std::function<bool( std::vector<byte>& )> &upload = std::function<bool( std::vector<byte>& )>() );
+
+   // runs at most maxUploads upload functions of finished assets on the calling thread, returns
+   // the number processed. Call it from the render thread every frame
+   uint32 ProcessUploads( const uint32 maxUploads = 0xffffffff );
+   // assets that are queued, loading or waiting for their upload
+   uint32 GetNumPending() const { return numPending.load(); }
+   uint32 GetNumThreads() const { return (uint32)workers.size(); }
+};
+
+template <class T>
+AssetHandle<T> AssetLoader::Load( const String_c &path, const std::function<bool( const String_c&, T& )> &load,
+   const std::function<bool( T& )> &upload )
+{
+   std::shared_ptr<AssetData<T> > data( new AssetData<T>( path ) );
+   numPending++;
+
+   PushJob( [this, data, load, upload]()
+   {
+      data->state = ASSET_LOADING;
+      bool ok;
+      try
+      {
+         ok = load( data->path, data->asset );
+      }
+      catch ( ... )
+      {
+         ok = false;
+      }
+
+      if ( !ok || !upload )
+      {
+         data->state = ok ? ASSET_READY : ASSET_FAILED;
+         data->loaded.set_value( ok );
+         numPending--;
+         return;
+      }
+
+      data->state = ASSET_LOADED;
+      data->loaded.set_value( true );
+      PushUpload( [this, data, upload]()
+      {
+         bool uploaded;
+         try
+         {
+            uploaded = upload( data->asset );
+         }
+         catch ( ... )
+         {
+            uploaded = false;
+         }
+         data->state = uploaded ? ASSET_READY : ASSET_FAILED;
+         numPending--;
+      } );
+   } );
+
+   return AssetHandle<T>( data );
+}
+
+} // namespace asset
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef _HEAPSORT_HPP_INCLUDED_
+#define _HEAPSORT_HPP_INCLUDED_
+
+#include <algorithm>
+
+#include "core/BasicTypes.hpp"
+
+namespace core
+{
+namespace algorithm
+{
+
+template <class T>
+struct Less
+{
+   bool operator()( const T &a, const T &b ) const { return a < b; }
+};
+
+// moves data[element] down the heap of the first size elements until it is not less than its children
+template <class T, class C>
+inline void HeapSink( T *data, uint32 element, const uint32 size, const C &less )
+{
+   while ( element * 2 + 1 < size )
+   {
+      uint32 child = element * 2 + 1;
+      if ( child + 1 < size && less( data[child], data[child + 1] ) )
+         child++;
+      if ( !less( data[element], data[child] ) )
+         return;
+      std::swap( data[element], data[child] );
+      element = child;
+   }
+}
+
+// In place and O(n log n) in the worst case, but it jumps around the array and is not stable.
+// The sort of core::Array, since it needs nothing but operator <. See sort.hpp for faster ones
+template <class T, class C>
+void Heapsort( T *data, const uint32 count, const C &less )
+{
+   if ( count < 2 )
+      return;
+
+   for ( uint32 i = count / 2; i-- > 0; )
+      HeapSink( data, i, count, less );
+
+   for ( uint32 i = count - 1; i > 0; i-- )
+   {
+      std::swap( data[0], data[i] );
+      HeapSink( data, 0, i, less );
+   }
+}
+
+template <class T>
+void Heapsort( T *data, const uint32 count )
+{
+   Heapsort( data, count, Less<T>() );
+}
+
+} // namespace algorithm
+} // namespace core
+
+#endif
@@ -0,0 +1,299 @@
+#ifndef _SORT_HPP_INCLUDED_
+#define _SORT_HPP_INCLUDED_
+
+#include <string.h>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "core/BasicTypes.hpp"
+#include "core/algorithm/heapsort.hpp"
+#include "core/task/scheduler.hpp"
+
+namespace core
+{
+namespace algorithm
+{
+
+// Sorts of plain arrays, the data of a core::Array or std::vector included. RadixSort is for
+// elements with an integer key, draw and depth keys for example, it is stable and linear in
+// the number of elements. ParallelSort takes any comparator and sorts on the threads of the
+// active TaskScheduler. The arg sorts leave the data alone and give the sorted order as indices.
+// The ones that need scratch memory allocate it, unless it is passed in
+
+// Radix keys map a value to an unsigned integer of the same order. The default handles the
+// integer types and float and double, other elements need a functor that returns their key
+template <class T>
+struct RadixKey
+{
+   typedef typename std::make_unsigned<T>::type KeyType;
+
+   // signed integers have their sign bit flipped, so the negative ones come first
+   KeyType operator()( const T value ) const
+   {
+      return std::is_signed<T>::value ? (KeyType)value ^ ( (KeyType)1 << ( sizeof(T) * 8 - 1 ) ) : (KeyType)value;
+   }
+};
+
+// positive floats order like their bits, negative ones reversed, so those are inverted
+inline uint32 FloatToRadixKey( const float value )
+{
+   uint32 bits;
+   memcpy( &bits, &value, sizeof(bits) );
+   return ( bits & 0x80000000u ) ? ~bits : bits | 0x80000000u;
+}
+
+inline uint64 DoubleToRadixKey( const double value )
+{
+   uint64 bits;
+   memcpy( &bits, &value, sizeof(bits) );
+   return ( bits & 0x8000000000000000ull ) ? ~bits : bits | 0x8000000000000000ull;
+}
+
+template <>
+struct RadixKey<float>
+{
+   uint32 operator()( const float value ) const { return FloatToRadixKey( value ); }
+};
+
+template <>
+struct RadixKey<double>
+{
+   uint64 operator()( const double value ) const { return DoubleToRadixKey( value ); }
+};
+
+// Stable LSD radix sort by key( element ), an unsigned integer of up to 64 bits. One byte of the
+// key per pass, the histograms of all passes are counted in one read. A pass in which every key
+// has the same byte is skipped, so keys that only use some of their bits take fewer passes.
+// scratch holds count elements
+template <class T, class K>
+void RadixSort( T *data, T *scratch, const uint32 count, const K &key )
+{
+   typedef typename std::decay<decltype( key( *data ) )>::type KeyType;
+   static_assert( std::is_unsigned<KeyType>::value, "radix keys have to be unsigned integers" );
+   const uint32 NUM_PASSES = sizeof(KeyType);
+
+   if ( count < 2 )
+      return;
+
+   uint32 histograms[NUM_PASSES][256];
+   memset( histograms, 0, sizeof(histograms) );
+   for ( uint32 i = 0; i < count; i++ )
+   {
+      const KeyType k = key( data[i] );
+      for ( uint32 pass = 0; pass < NUM_PASSES; pass++ )
+         histograms[pass][( k >> ( pass * 8 ) ) & 0xff]++;
+   }
+
+   T *src = data;
+   T *dst = scratch;
+   for ( uint32 pass = 0; pass < NUM_PASSES; pass++ )
+   {
+      const uint32 shift = pass * 8;
+      uint32 *offsets = histograms[pass];
+      if ( offsets[( key( src[0] ) >> shift ) & 0xff] == count )
+         continue;
+
+      uint32 sum = 0;
+      for ( uint32 digit = 0; digit < 256; digit++ )
+      {
+         const uint32 digitCount = offsets[digit];
+         offsets[digit] = sum;
+         sum += digitCount;
+      }
+
+      for ( uint32 i = 0; i < count; i++ )
+         dst[offsets[( key( src[i] ) >> shift ) & 0xff]++] = src[i];
+      std::swap( src, dst );
+   }
+
+   if ( src != data )
+      std::copy( src, src + count, data );
+}
+
+template <class T, class K>
+void RadixSort( T *data, const uint32 count, const K &key )
+{
+   if ( count < 2 )
+      return;
+   std::vector<T> scratch( count );
+   RadixSort( data, &scratch[0], count, key );
+}
+
+template <class T>
+void RadixSort( T *data, const uint32 count )
+{
+   RadixSort( data, count, RadixKey<T>() );
+}
+
+// below this many elements per thread ParallelSort is std::sort
+const uint32 PARALLEL_SORT_MIN_BLOCK = 16384;
+// output elements per task of a merge round
+const uint32 PARALLEL_MERGE_GRAIN = 16384;
+
+// Number of elements of a in the first k of the merge of the sorted ranges a and b, taking
+// equal elements from a first like std::merge does. Lets a merge be split at any output position
+template <class T, class C>
+uint32 MergeCoRank( const uint32 k, const T *a, const uint32 sizeA, const T *b, const uint32 sizeB, const C &less )
+{
+   uint32 low = k > sizeB ? k - sizeB : 0;
+   uint32 high = k < sizeA ? k : sizeA;
+   while ( low < high )
+   {
+      const uint32 i = low + ( high - low ) / 2;
+      // a[i] still belongs to the first k when it does not come after b[k - i - 1]
+      if ( !less( b[k - i - 1], a[i] ) )
+         low = i + 1;
+      else
+         high = i;
+   }
+   return low;
+}
+
+// Sorts with less on the threads of the active TaskScheduler. The data is cut into a power of two
+// of blocks, at least one per thread, which are sorted with std::sort and then merged in pairs.
+// Every merge round is split at even output positions, so all threads keep working up to the
+// last merge. Not stable. Without a scheduler or with few elements it is std::sort.
+// scratch holds count elements
+template <class T, class C>
+void ParallelSort( T *data, T *scratch, const uint32 count, const C &less )
+{
+   TaskScheduler *scheduler = TaskScheduler::GetActive();
+   const uint32 numThreads = scheduler != NULL ? scheduler->GetNumThreads() : 1;
+   uint32 numBlocks = 1;
+   while ( numBlocks < numThreads && count / ( numBlocks * 2 ) >= PARALLEL_SORT_MIN_BLOCK )
+      numBlocks *= 2;
+   if ( numBlocks == 1 )
+   {
+      std::sort( data, data + count, less );
+      return;
+   }
+
+   const uint32 blockSize = ( count + numBlocks - 1 ) / numBlocks;
+   scheduler->ParallelFor( 0, numBlocks, 1, [data, count, blockSize, &less]( uint32 begin, uint32 end )
+   {
+      for ( uint32 block = begin; block < end; block++ )
+      {
+         const uint32 first = block * blockSize;
+         const uint32 last = first + blockSize < count ? first + blockSize : count;
+         if ( first < last )
+            std::sort( data + first, data + last, less );
+      }
+   } );
+
+   T *src = data;
+   T *dst = scratch;
+   for ( uint32 width = blockSize; width < count; width *= 2 )
+   {
+      scheduler->ParallelFor( 0, count, PARALLEL_MERGE_GRAIN, [src, dst, count, width, &less]( uint32 begin, uint32 end )
+      {
+         while ( begin < end )
+         {
+            // the pair of runs that output position begin falls into
+            const uint32 pairBegin = begin / ( width * 2 ) * ( width * 2 );
+            const uint32 middle = pairBegin + width < count ? pairBegin + width : count;
+            const uint32 pairEnd = middle + width < count ? middle + width : count;
+            const uint32 pieceEnd = end < pairEnd ? end : pairEnd;
+
+            const T *a = src + pairBegin;
+            const T *b = src + middle;
+            const uint32 sizeA = middle - pairBegin;
+            const uint32 sizeB = pairEnd - middle;
+            const uint32 firstA = MergeCoRank( begin - pairBegin, a, sizeA, b, sizeB, less );
+            const uint32 lastA = MergeCoRank( pieceEnd - pairBegin, a, sizeA, b, sizeB, less );
+            std::merge( a + firstA, a + lastA, b + ( begin - pairBegin - firstA ), b + ( pieceEnd - pairBegin - lastA ),
+               dst + begin, less );
+            begin = pieceEnd;
+         }
+      } );
+      std::swap( src, dst );
+   }
+
+   if ( src != data )
+   {
+      scheduler->ParallelFor( 0, count, PARALLEL_MERGE_GRAIN, [src, data]( uint32 begin, uint32 end )
+      {
+         std::copy( src + begin, src + end, data + begin );
+      } );
+   }
+}
+
+template <class T, class C>
+void ParallelSort( T *data, const uint32 count, const C &less )
+{
+   if ( count < 2 )
+      return;
+   std::vector<T> scratch( count );
+   ParallelSort( data, &scratch[0], count, less );
+}
+
+template <class T>
+void ParallelSort( T *data, const uint32 count )
+{
+   ParallelSort( data, count, Less<T>() );
+}
+
+// indicesOut[i] is the index of the i-th element in sorted order, equal elements keep their order
+template <class T, class C>
+void ArgSort( const T *data, const uint32 count, uint32 *indicesOut, const C &less )
+{
+   for ( uint32 i = 0; i < count; i++ )
+      indicesOut[i] = i;
+   std::stable_sort( indicesOut, indicesOut + count, [data, &less]( const uint32 a, const uint32 b )
+   {
+      return less( data[a], data[b] );
+   } );
+}
+
+template <class T>
+void ArgSort( const T *data, const uint32 count, uint32 *indicesOut )
+{
+   ArgSort( data, count, indicesOut, Less<T>() );
+}
+
+// key of an element with its index, RadixArgSort sorts these so the passes read them in order
+// instead of fetching the keys through the indices
+template <class K>
+struct RadixArgEntry
+{
+   K key;
+   uint32 index;
+};
+
+template <class K>
+struct RadixArgEntryKey
+{
+   K operator()( const RadixArgEntry<K> &entry ) const { return entry.key; }
+};
+
+// ArgSort by radix key, see RadixSort
+template <class T, class K>
+void RadixArgSort( const T *data, const uint32 count, uint32 *indicesOut, const K &key )
+{
+   typedef typename std::decay<decltype( key( *data ) )>::type KeyType;
+
+   if ( count == 0 )
+      return;
+
+   std::vector<RadixArgEntry<KeyType> > entries( count );
+   std::vector<RadixArgEntry<KeyType> > scratch( count );
+   for ( uint32 i = 0; i < count; i++ )
+   {
+      entries[i].key = key( data[i] );
+      entries[i].index = i;
+   }
+   RadixSort( &entries[0], &scratch[0], count, RadixArgEntryKey<KeyType>() );
+   for ( uint32 i = 0; i < count; i++ )
+      indicesOut[i] = entries[i].index;
+}
+
+template <class T>
+void RadixArgSort( const T *data, const uint32 count, uint32 *indicesOut )
+{
+   RadixArgSort( data, count, indicesOut, RadixKey<T>() );
+}
+
+} // namespace algorithm
+} // namespace core
+
+#endif
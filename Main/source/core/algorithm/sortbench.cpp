@@ -0,0 +1,150 @@
+#include "core/algorithm/sortbench.hpp"
+#include "core/algorithm/sort.hpp"
+#include "core/bench/benchtimer.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace core
+{
+namespace algorithm
+{
+
+// few layers, shaders and materials in the high bits and the depth below, the low bits unused
+static uint64 RandomDrawKey()
+{
+   const uint64 layer = rand() % 4;
+   const uint64 shader = rand() % 64;
+   const uint64 material = rand() % 1024;
+   const uint64 depth = ( (uint64)rand() << 15 | (uint64)rand() ) & 0xffffff;
+   return layer << 62 | shader << 56 | material << 46 | depth << 22;
+}
+
+static float RandomDepth()
+{
+   return (float)rand() / RAND_MAX * 1000.0f - 10.0f;
+}
+
+struct DepthLess
+{
+   const float *depths;
+   bool operator()( const uint32 a, const uint32 b ) const { return depths[a] < depths[b]; }
+};
+
+// time of sorting a fresh copy of input, iterations times
+template <class T, class F>
+static double TimeSort( const std::vector<T> &input, std::vector<T> &work, const uint32 iterations, const F &sort )
+{
+   double ms = 0.0;
+   for ( uint32 it = 0; it < iterations; it++ )
+   {
+      work = input;
+      BenchTimer timer;
+      sort( &work[0], (uint32)work.size() );
+      ms += timer.GetMilliSecs();
+   }
+   return ms;
+}
+
+// indices is a permutation that orders depths
+static bool IsArgSorted( const std::vector<float> &depths, const std::vector<uint32> &indices )
+{
+   std::vector<bool> seen( depths.size(), false );
+   for ( uint32 i = 0; i < indices.size(); i++ )
+   {
+      if ( indices[i] >= depths.size() || seen[indices[i]] )
+         return false;
+      seen[indices[i]] = true;
+      if ( i > 0 && depths[indices[i]] < depths[indices[i - 1]] )
+         return false;
+   }
+   return true;
+}
+
+template <class T, class F>
+static void RunKeyBench( SortBenchResult &r, const char *name, const std::vector<T> &keys, const uint32 iterations,
+   const F &sort )
+{
+   std::vector<T> reference, work;
+   r.name = name;
+   r.heapsortMs = TimeSort( keys, work, iterations, []( T *data, const uint32 count ) { Heapsort( data, count ); } );
+   r.stdSortMs = TimeSort( keys, reference, iterations, []( T *data, const uint32 count ) { std::sort( data, data + count ); } );
+   r.sortMs = TimeSort( keys, work, iterations, sort );
+   // sorted and the same elements as the std::sort result
+   r.isSorted = work == reference;
+}
+
+template <class F>
+static void RunArgSortBench( SortBenchResult &r, const char *name, const std::vector<float> &depths,
+   const uint32 iterations, const F &sort )
+{
+   const DepthLess less = { &depths[0] };
+   std::vector<uint32> identity( depths.size() );
+   for ( uint32 i = 0; i < identity.size(); i++ )
+      identity[i] = i;
+   std::vector<uint32> work;
+
+   r.name = name;
+   r.heapsortMs = TimeSort( identity, work, iterations, [&less]( uint32 *indices, const uint32 count )
+   {
+      Heapsort( indices, count, less );
+   } );
+   r.stdSortMs = TimeSort( identity, work, iterations, [&less]( uint32 *indices, const uint32 count )
+   {
+      std::sort( indices, indices + count, less );
+   } );
+   // the arg sorts fill in the indices themselves
+   r.sortMs = TimeSort( identity, work, iterations, [&depths, &sort]( uint32 *indices, const uint32 count )
+   {
+      sort( &depths[0], count, indices );
+   } );
+   r.isSorted = IsArgSorted( depths, work );
+}
+
+void RunSortBenchmarks( SortBenchResult *results, const uint32 count, const uint32 iterations )
+{
+   srand( 1 );
+
+   std::vector<uint64> drawKeys( count );
+   std::vector<float> depths( count );
+   for ( uint32 i = 0; i < count; i++ )
+   {
+      drawKeys[i] = RandomDrawKey();
+      depths[i] = RandomDepth();
+   }
+
+   RunKeyBench( results[SORTBENCH_RADIX_DRAW_KEYS], "radix uint64 draw keys", drawKeys, iterations,
+      []( uint64 *data, const uint32 count ) { RadixSort( data, count ); } );
+
+   RunKeyBench( results[SORTBENCH_RADIX_DEPTH_KEYS], "radix float depths", depths, iterations,
+      []( float *data, const uint32 count ) { RadixSort( data, count ); } );
+
+   RunKeyBench( results[SORTBENCH_PARALLEL_DRAW_KEYS], "parallel uint64 draw keys", drawKeys, iterations,
+      []( uint64 *data, const uint32 count ) { ParallelSort( data, count ); } );
+
+   RunArgSortBench( results[SORTBENCH_RADIX_ARGSORT_DEPTH], "radix argsort depths", depths, iterations,
+      []( const float *data, const uint32 count, uint32 *indices ) { RadixArgSort( data, count, indices ); } );
+
+   RunArgSortBench( results[SORTBENCH_ARGSORT_DEPTH], "argsort depths", depths, iterations,
+      []( const float *data, const uint32 count, uint32 *indices ) { ArgSort( data, count, indices ); } );
+}
+
+void PrintSortBenchmarks( const uint32 count, const uint32 iterations )
+{
+   SortBenchResult results[SORTBENCH_COUNT];
+   RunSortBenchmarks( results, count, iterations );
+
+   printf( "%u keys x %u iterations\n", count, iterations );
+   printf( "%-28s %12s %12s %12s %10s %10s %7s\n", "", "heapsort ms", "std::sort ms", "sort ms", "vs heap", "vs std", "sorted" );
+   for ( int32 i = 0; i < SORTBENCH_COUNT; i++ )
+   {
+      const SortBenchResult &r = results[i];
+      printf( "%-28s %12.3f %12.3f %12.3f %9.2fx %9.2fx %7s\n", r.name, r.heapsortMs, r.stdSortMs, r.sortMs,
+         r.sortMs > 0.0 ? r.heapsortMs / r.sortMs : 0.0, r.sortMs > 0.0 ? r.stdSortMs / r.sortMs : 0.0,
+         r.isSorted ? "yes" : "NO" );
+   }
+}
+
+} // namespace algorithm
+} // namespace core
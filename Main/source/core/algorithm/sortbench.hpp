@@ -0,0 +1,41 @@
+#ifndef _SORTBENCH_HPP_INCLUDED_
+#define _SORTBENCH_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+namespace core
+{
+namespace algorithm
+{
+
+// timings of one kind of keys, the heapsort of core::Array and std::sort against the sort of sort.hpp
+struct SortBenchResult
+{
+   const char *name;
+   double heapsortMs;
+   double stdSortMs;
+   double sortMs;
+   bool isSorted; // the result of sort.hpp is in order and holds the same elements
+};
+
+enum eSortBench
+{
+   SORTBENCH_RADIX_DRAW_KEYS = 0,
+   SORTBENCH_RADIX_DEPTH_KEYS,
+   SORTBENCH_PARALLEL_DRAW_KEYS,
+   SORTBENCH_RADIX_ARGSORT_DEPTH,
+   SORTBENCH_ARGSORT_DEPTH,
+   SORTBENCH_COUNT
+};
+
+// run every benchmark on count random keys, iterations times each. The parallel sort runs on the
+// active TaskScheduler, without one it is std::sort. results needs room for SORTBENCH_COUNT entries
+void RunSortBenchmarks( SortBenchResult *results, const uint32 count = 262144, const uint32 iterations = 10 );
+
+// run the benchmarks and print a table to stdout
+void PrintSortBenchmarks( const uint32 count = 262144, const uint32 iterations = 10 );
+
+} // namespace algorithm
+} // namespace core
+
+#endif
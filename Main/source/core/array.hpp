@@ -2,13 +2,28 @@
 #ifndef _ARRAY_HPP_INCLUDED_
 #define _ARRAY_HPP_INCLUDED_
 
-#include "types.hpp"
-#include "math/mathcommon.hpp"
-#include "memory/allocator.hpp"
+#include <assert.h>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+
+#include "core/BasicTypes.hpp"
+#include "core/algorithm/heapsort.hpp"
+#include "core/math/mathcommon.hpp"
+#include "core/memory/allocator.hpp"
 
 namespace core
 {
 
+//! How an array grows when it is full
+enum eAllocStrategy
+{
+	//! exactly as much as needed
+	ALLOC_STRATEGY_SAFE = 0,
+	//! about twice the size for small arrays, a quarter more for big ones
+	ALLOC_STRATEGY_DOUBLE = 1
+};
+
 //! Self reallocating template array (like stl vector) with additional features.
 /** Some features are: Heap sorting, binary search methods, easier debugging.
 */
@@ -23,6 +38,57 @@ private:
 	eAllocStrategy strategy : 4;
 	bool freeWhenDestroyed : 1;
 	bool isSorted : 1;
+
+	// Elements that can be copied bytewise are moved, copied and appended with memcpy, the
+	// others are constructed one by one, moving where they are relocated
+	typedef std::integral_constant<bool, std::is_trivially_copyable<T>::value> IsTrivial;
+
+	void Relocate( T *dest, T *src, const uint32 count, std::true_type )
+	{
+		if (count)
+			memcpy(dest, src, count * sizeof(T));
+	}
+
+	void Relocate( T *dest, T *src, const uint32 count, std::false_type )
+	{
+		for (uint32 i = 0; i < count; ++i)
+		{
+			allocator.Construct(&dest[i], std::move(src[i]));
+			allocator.Destruct(&src[i]);
+		}
+	}
+
+	void CopyConstruct( T *dest, const T *src, const uint32 count, std::true_type )
+	{
+		if (count)
+			memcpy(dest, src, count * sizeof(T));
+	}
+
+	void CopyConstruct( T *dest, const T *src, const uint32 count, std::false_type )
+	{
+		for (uint32 i = 0; i < count; ++i)
+			allocator.Construct(&dest[i], src[i]);
+	}
+
+	//! Size to allocate to hold at least needed elements, after the allocation strategy
+	uint32 GetGrowSize( const uint32 needed ) const
+	{
+		if (strategy != ALLOC_STRATEGY_DOUBLE)
+			return needed;
+		const uint32 grown = used + 1 + (allocated < 500 ? (allocated < 5 ? 5 : used) : used >> 2);
+		return grown > needed ? grown : needed;
+	}
+
+	//! Moves the elements into newData, allocated for newAllocated elements, and frees the old block.
+	/** Growing is split in two, so that new elements are constructed in the new block before
+	the old elements are moved, as their sources may be elements of this array. */
+	void Adopt( T *newData, const uint32 newAllocated )
+	{
+		Relocate(newData, data, used, IsTrivial());
+		allocator.Free(data, allocated);
+		data = newData;
+		allocated = newAllocated;
+	}
 public:
 
 	//! Default constructor for empty array.
@@ -43,13 +109,30 @@ public:
 	}
 
 
-	//! Copy constructor
-	Array( const Array<T, TAlloc> &other) : data(0)
+	//! Constructs an empty array that allocates from the given allocator.
+	explicit Array( const TAlloc &allocator )
+		: data(0), allocated(0), used(0), allocator(allocator),
+		strategy(ALLOC_STRATEGY_DOUBLE), freeWhenDestroyed(true), isSorted(true)
+	{
+	}
+
+
+	//! Copy constructor, the copy uses the allocator of other
+	Array( const Array<T, TAlloc> &other) : data(0), allocated(0), used(0), allocator(other.allocator)
 	{
 		*this = other;
 	}
 
 
+	//! Move constructor, takes over the memory of other and leaves it empty
+	Array( Array<T, TAlloc> &&other )
+		: data(0), allocated(0), used(0), allocator(other.allocator),
+		strategy(ALLOC_STRATEGY_DOUBLE), freeWhenDestroyed(true), isSorted(true)
+	{
+		Swap(other);
+	}
+
+
 	//! Destructor.
 	/** Frees allocated memory, if set_free_when_destroyed was not set to
 	false by the user before. */
@@ -65,35 +148,29 @@ public:
 	enough space is available. Setting this flag to false can speed up
 	array usage, but may use more memory than required by the data.
 	*/
-	void Reallocate( uint32 new_size, bool canShrink = true )
+	void Reallocate( uint32 newSize, bool canShrink = true )
 	{
 		if (allocated == newSize)
 			return;
 		if (!canShrink && (newSize < allocated))
 			return;
 
-		T* oldData = data;
-
-		data = allocator.allocate(newSize); //new T[new_size];
-		allocated = newSize;
-
-		// copy old data
-		int32 end = used < newSize ? used : newSize;
-
-		for (int32 i = 0; i<end; ++i)
-		{
-			// data[i] = old_data[i];
-			allocator.Construct(&data[i], oldData[i]);
-		}
+		// the elements that do not fit anymore
+		for (uint32 i = newSize; i < used; ++i)
+			allocator.Destruct(&data[i]);
+		if (newSize < used)
+			used = newSize;
 
-		// destruct old data
-		for (uint32 j = 0; j<used; ++j)
-			allocator.destruct(&old_data[j]);
+		Adopt(newSize ? allocator.Allocate(newSize) : 0, newSize);
+	}
 
-		if (allocated < used)
-			used = allocated;
 
-		allocator.Deallocate(old_data); //delete [] old_data;
+	//! Makes room for at least count elements, never shrinks.
+	/** Call before adding a known number of elements, so the array grows only once. */
+	void Reserve( uint32 count )
+	{
+		if (count > allocated)
+			Reallocate(count);
 	}
 
 
@@ -112,7 +189,62 @@ public:
 	\param element: Element to add at the back of the array. */
 	void PushBack(const T &element)
 	{
-		Insert(element, used);
+		EmplaceBack(element);
+	}
+
+
+	//! Adds an element at back of array, moving it in.
+	void PushBack(T &&element)
+	{
+		EmplaceBack(std::move(element));
+	}
+
+
+	//! Constructs an element at the back of the array from the arguments.
+	/** The arguments may refer to elements of this array, when it grows the new element is
+	constructed before the old ones move.
+	\return The new element. */
+	template <class... Args>
+	T &EmplaceBack(Args&&... args)
+	{
+		if (used < allocated)
+		{
+			new ((void*)&data[used]) T(std::forward<Args>(args)...);
+		}
+		else
+		{
+			const uint32 newAlloc = GetGrowSize(used + 1);
+			T *newData = allocator.Allocate(newAlloc);
+			new ((void*)&newData[used]) T(std::forward<Args>(args)...);
+			Adopt(newData, newAlloc);
+		}
+		isSorted = false;
+		return data[used++];
+	}
+
+
+	//! Adds count elements at the back of the array.
+	/** Grows at most once. Elements that can be copied bytewise are copied with memcpy.
+	\param elements First element to add, may point into this array.
+	\param count Number of elements. */
+	void Append(const T *elements, uint32 count)
+	{
+		if (!count)
+			return;
+
+		if (used + count <= allocated)
+		{
+			CopyConstruct(&data[used], elements, count, IsTrivial());
+		}
+		else
+		{
+			const uint32 newAlloc = GetGrowSize(used + count);
+			T *newData = allocator.Allocate(newAlloc);
+			CopyConstruct(&newData[used], elements, count, IsTrivial());
+			Adopt(newData, newAlloc);
+		}
+		isSorted = false;
+		used += count;
 	}
 
 
@@ -133,67 +265,30 @@ public:
 	push_back().
 	\param element: Element to be inserted
 	\param index: Where position to insert the new element. */
-	void Insert(const T& element, u32 index = 0)
-	{
-		assert(index > used);
-
-			if (used + 1 > allocated)
-			{
-				// this doesn't work if the element is in the same
-				// array. So we'll copy the element first to be sure
-				// we'll get no data corruption
-				const T e(element);
-
-				// increase data block
-				uint32 newAlloc;
-				switch (strategy)
-				{
-				case ALLOC_STRATEGY_DOUBLE:
-					newAlloc = used + 1 + (allocated < 500 ?
-						(allocated < 5 ? 5 : used) : used >> 2);
-					break;
-				default:
-				case ALLOC_STRATEGY_SAFE:
-					newAlloc = used + 1;
-					break;
-				}
-				Reallocate(newAlloc);
-
-				// move array content and construct new element
-				// first move end one up
-				for (uint32 i = used; i>index; --i)
-				{
-					if (i<used)
-						allocator.Destruct(&data[i]);
-					allocator.Construct(&data[i], data[i - 1]); // data[i] = data[i-1];
-				}
-				// then add new element
-				if (used > index)
-					allocator.Destruct(&data[index]);
-				allocator.Construct(&data[index], e); // data[index] = e;
-			}
-			else
-			{
-				// element inserted not at end
-				if (used > index)
-				{
-					// create one new element at the end
-					allocator.Construct(&data[used], data[used - 1]);
-
-					// move the rest of the array content
-					for (uint32 i = used - 1; i>index; --i)
-					{
-						data[i] = data[i - 1];
-					}
-					// insert the new element
-					data[index] = element;
-				}
-				else
-				{
-					// insert the new element to the end
-					allocator.Construct(&data[index], element);
-				}
-			}
+	void Insert(const T& element, uint32 index = 0)
+	{
+		assert(index <= used);
+
+		if (index == used)
+		{
+			EmplaceBack(element);
+			return;
+		}
+
+		// this doesn't work if the element is in the same
+		// array. So we'll copy the element first to be sure
+		// we'll get no data corruption
+		T e(element);
+
+		if (used + 1 > allocated)
+			Reallocate(GetGrowSize(used + 1));
+
+		// create one new element at the end, then move the rest of the array content up
+		allocator.Construct(&data[used], std::move(data[used - 1]));
+		for (uint32 i = used - 1; i > index; --i)
+			data[i] = std::move(data[i - 1]);
+		data[index] = std::move(e);
+
 		// set to false as we don't know if we have the comparison operators
 		isSorted = false;
 		used++;
@@ -208,7 +303,7 @@ public:
 			for (uint32 i = 0; i<used; i++)
 				allocator.Destruct(&data[i]);
 
-			allocator.Deallocate(data); // delete [] data;
+			allocator.Free(data, allocated); // delete [] data;
 		}
 		data = 0;
 		used = 0;
@@ -228,7 +323,7 @@ public:
 	application. */
 	void SetPointer( T* newPointer, uint32 size, bool isSorted = false, bool freeWhenDestroyed = true )
 	{
-		clear();
+		Clear();
 		data = newPointer;
 		allocated = size;
 		used = size;
@@ -285,12 +380,22 @@ public:
 		isSorted = other.isSorted;
 		allocated = other.allocated;
 
-		for (uint32 i = 0; i < other.used; i++)
-			allocator.Construct(&data[i], other.data[i]); // data[i] = other.data[i];
+		CopyConstruct(data, other.data, other.used, IsTrivial());
 
 		return *this;
 	}
 
+	//! Move assignment, takes over the memory of other and leaves it empty
+	Array<T, TAlloc>& operator=( Array<T, TAlloc> &&other )
+	{
+		if (this != &other)
+		{
+			Clear();
+			Swap(other);
+		}
+		return *this;
+	}
+
 	bool operator==( const Array<T, TAlloc> &other ) const
 	{
 		if (used != other.used)
@@ -310,14 +415,14 @@ public:
 
 	T &operator[]( uint32 index )
 	{
-		assert(index >= used);
+		assert(index < used);
 
 		return data[index];
 	}
 
 	const T &operator[]( uint32 index ) const
 	{
-		assert(index >= used);
+		assert(index < used);
 
 		return data[index];
 	}
@@ -325,7 +430,7 @@ public:
 
 	T &GetLastElement()
 	{
-		assert(!used);
+		assert(used);
 
 		return data[used - 1];
 	}
@@ -334,7 +439,7 @@ public:
 	//! Gets last element
 	const T &GetLastElement() const
 	{
-		assert(!used);
+		assert(used);
 
 		return data[used - 1];
 	}
@@ -383,11 +488,12 @@ public:
 
 	//! Sorts the array using heapsort.
 	/** There is no additional memory waste and the algorithm performs
-	O(n*log n) in worst case. */
+	O(n*log n) in worst case. Big arrays sort much faster with RadixSort or
+	ParallelSort of core/algorithm/sort.hpp on Pointer(), call SetSorted after. */
 	void Sort()
 	{
 		if (!isSorted && used>1)
-			Heapsort(data, used);
+			core::algorithm::Heapsort(data, used);
 		isSorted = true;
 	}
 
@@ -499,7 +605,7 @@ public:
 	{
 		for (uint32 i = 0; i<used; ++i)
 			if (element == data[i])
-				return (s32)i;
+				return (int32)i;
 
 		return -1;
 	}
@@ -527,13 +633,10 @@ public:
 	\param index: Index of element to be erased. */
 	void Erase( uint32 index )
 	{
-		assert(index >= used); 
+		assert(index < used);
 
-			for (uint32 i = index + 1; i<used; i++)
-			{
-				allocator.Destruct(&data[i - 1]);
-				allocator.Construct(&data[i - 1], data[i]); // data[i-1] = data[i];
-			}
+		for (uint32 i = index + 1; i<used; i++)
+			data[i - 1] = std::move(data[i]);
 
 		allocator.Destruct(&data[used - 1]);
 
@@ -553,20 +656,13 @@ public:
 		if (index + count>used)
 			count = used - index;
 
-		u32 i;
-		for (i = index; i<index + count; i++)
-			allocator.Destruct(&data[i]);
-
+		uint32 i;
 		for (i = index + count; i<used; i++)
-		{
-			if (i - count >= index + count)	// not already destructed before loop
-				allocator.Destruct(&data[i - count]);
-
-			allocator.construct(&data[i - count], data[i]); // data[i-count] = data[i];
+			data[i - count] = std::move(data[i]);
 
-			if (i >= used - count)	// those which are not overwritten
-				allocator.Destruct(&data[i]);
-		}
+		// those which are not overwritten
+		for (i = used - count; i<used; i++)
+			allocator.Destruct(&data[i]);
 
 		used -= count;
 	}
@@ -583,12 +679,12 @@ public:
 	/** Afterwards this object will contain the content of the other object and the other
 	object will contain the content of this object.
 	\param other Swap content with this object	*/
-	void Swap(array<T, TAlloc>& other)
+	void Swap(Array<T, TAlloc>& other)
 	{
-		core::Swap(data, other.data);
-		core::Swap(allocated, other.allocated);
-		core::Swap(used, other.used);
-		core::Swap(allocator, other.allocator);	// memory is still released by the same allocator used for allocation
+		core::math::Swap(data, other.data);
+		core::math::Swap(allocated, other.allocated);
+		core::math::Swap(used, other.used);
+		core::math::Swap(allocator, other.allocator);	// memory is still released by the same allocator used for allocation
 		eAllocStrategy helperStrategy(strategy);	// can't use core::swap with bitfields
 		strategy = other.strategy;
 		other.strategy = helperStrategy;
@@ -0,0 +1,23 @@
+#ifndef _BENCHTIMER_HPP_INCLUDED_
+#define _BENCHTIMER_HPP_INCLUDED_
+
+#include <Windows.h>
+
+// Wall clock time since construction from the performance counter, shared by the benchmarks
+class BenchTimer
+{
+private:
+   LARGE_INTEGER frequency;
+   LARGE_INTEGER start;
+public:
+   BenchTimer() { QueryPerformanceFrequency( &frequency ); QueryPerformanceCounter( &start ); }
+
+   double GetMilliSecs() const
+   {
+      LARGE_INTEGER now;
+      QueryPerformanceCounter( &now );
+      return 1000.0 * (double)(now.QuadPart - start.QuadPart) / (double)frequency.QuadPart;
+   }
+};
+
+#endif
@@ -0,0 +1,388 @@
+#ifndef _FLATHASHMAP_HPP_INCLUDED_
+#define _FLATHASHMAP_HPP_INCLUDED_
+
+#include <assert.h>
+#include <string.h>
+#include <new>
+#include <utility>
+
+#include "core/BasicTypes.hpp"
+#include "core/hash/hash.hpp"
+
+// SSE2 is always available on x64 and with /arch:SSE2 on x86
+#if defined(_M_X64) || defined(_M_IX86)
+#  include <intrin.h>
+#endif
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define CORE_FLATHASHMAP_SSE2
+#  include <emmintrin.h>
+#endif
+
+namespace core
+{
+
+   namespace containers
+   {
+
+      template <class K, class V>
+      struct FlatHashMapEntry
+      {
+         K key;
+         V value;
+
+         FlatHashMapEntry( const K &key, const V &value ) : key(key), value(value) {}
+         FlatHashMapEntry( FlatHashMapEntry &&other ) : key(std::move( other.key )), value(std::move( other.value )) {}
+      };
+
+      // Open addressing hash map in the style of SwissTable. The entries live in one flat array,
+      // next to it one control byte per slot holds 7 bits of the hash of the entry or marks the
+      // slot empty or deleted. A lookup compares the control bytes of a group of 16 slots at once
+      // (SSE2) and only looks at entries whose 7 bits match, usually one. Groups are probed
+      // quadratically until a group with an empty slot shows that the key is not there.
+      //
+      // Nothing is allocated per entry. Lookups take any key type the hash and equality functors
+      // accept, so a map with String_c keys is searched with a StringView_c or a C string without
+      // building a String_c. Entries move when the map grows, pointers into it are only valid
+      // until the next insertion
+      template <class K, class V, class H = core::hash::Hash<K>, class E = core::hash::EqualTo<K> >
+      class FlatHashMap
+      {
+      public:
+         typedef FlatHashMapEntry<K, V> Entry;
+
+         template <class TMap, class TEntry>
+         class IteratorBase
+         {
+         private:
+            TMap *map;
+            uint32 index;
+
+            void SkipFree()
+            {
+               while ( index < map->capacity && map->control[index] < 0 )
+                  index++;
+            }
+         public:
+            IteratorBase( TMap *map, const uint32 index ) : map(map), index(index) { SkipFree(); }
+
+            TEntry &operator*() const { return map->entries[index]; }
+            TEntry *operator->() const { return &map->entries[index]; }
+            IteratorBase &operator++() { index++; SkipFree(); return *this; }
+            bool operator==( const IteratorBase &other ) const { return index == other.index; }
+            bool operator!=( const IteratorBase &other ) const { return index != other.index; }
+         };
+
+         typedef IteratorBase<FlatHashMap, Entry> Iterator;
+         typedef IteratorBase<const FlatHashMap, const Entry> ConstIterator;
+
+      private:
+         static const uint32 GROUP_SIZE = 16;
+         static const uint32 NOT_FOUND = 0xffffffff;
+         // control bytes of free slots are negative, those of full slots hold 7 bits of the hash
+         static const int8 CONTROL_EMPTY = -128;
+         static const int8 CONTROL_DELETED = -2;
+
+         int8 *control;
+         Entry *entries;
+         uint32 capacity; // 0 or a power of two of at least GROUP_SIZE
+         uint32 size;
+         uint32 growthLeft; // empty slots that may be filled before the map grows
+         H hasher;
+         E equal;
+
+         // bit i is set for the slots i of the group that match
+         static uint32 Match( const int8 *group, const int8 value )
+         {
+#ifdef CORE_FLATHASHMAP_SSE2
+            const __m128i bytes = _mm_loadu_si128( (const __m128i*)group );
+            return (uint32)_mm_movemask_epi8( _mm_cmpeq_epi8( bytes, _mm_set1_epi8( value ) ) );
+#else
+            uint32 mask = 0;
+            for ( uint32 i = 0; i < GROUP_SIZE; i++ )
+               mask |= ( group[i] == value ? 1u : 0u ) << i;
+            return mask;
+#endif
+         }
+
+         // empty and deleted slots, those have the sign bit set
+         static uint32 MatchFree( const int8 *group )
+         {
+#ifdef CORE_FLATHASHMAP_SSE2
+            return (uint32)_mm_movemask_epi8( _mm_loadu_si128( (const __m128i*)group ) );
+#else
+            uint32 mask = 0;
+            for ( uint32 i = 0; i < GROUP_SIZE; i++ )
+               mask |= ( group[i] < 0 ? 1u : 0u ) << i;
+            return mask;
+#endif
+         }
+
+         static uint32 LowestBit( const uint32 mask )
+         {
+            unsigned long index;
+            _BitScanForward( &index, mask );
+            return (uint32)index;
+         }
+
+         // the functors may return weak hashes, identity for integers for example
+         static uint64 Mix( uint64 hash )
+         {
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+            hash *= 0xc4ceb9fe1a85ec53ULL;
+            hash ^= hash >> 33;
+            return hash;
+         }
+
+         template <class Q>
+         uint64 HashOf( const Q &key ) const { return Mix( hasher( key ) ); }
+         static int8 H2( const uint64 hash ) { return (int8)( hash & 0x7f ); }
+         uint32 FirstGroup( const uint64 hash ) const { return (uint32)( hash >> 7 ) & ( capacity / GROUP_SIZE - 1 ); }
+         static uint32 MaxLoad( const uint32 capacity ) { return capacity - capacity / 8; }
+
+         template <class Q>
+         uint32 FindIndex( const Q &key, const uint64 hash ) const
+         {
+            if ( capacity == 0 )
+               return NOT_FOUND;
+
+            const uint32 groupMask = capacity / GROUP_SIZE - 1;
+            uint32 group = FirstGroup( hash );
+            // group, group + 1, group + 3, group + 6, ... visits every group once
+            for ( uint32 step = 1; step <= groupMask + 1; step++ )
+            {
+               const int8 *groupControl = control + group * GROUP_SIZE;
+               for ( uint32 mask = Match( groupControl, H2( hash ) ); mask != 0; mask &= mask - 1 )
+               {
+                  const uint32 index = group * GROUP_SIZE + LowestBit( mask );
+                  if ( equal( entries[index].key, key ) )
+                     return index;
+               }
+               if ( Match( groupControl, CONTROL_EMPTY ) != 0 )
+                  return NOT_FOUND;
+               group = ( group + step ) & groupMask;
+            }
+            return NOT_FOUND;
+         }
+
+         // first free slot on the probe sequence of hash, there always is one
+         uint32 FindFree( const uint64 hash ) const
+         {
+            const uint32 groupMask = capacity / GROUP_SIZE - 1;
+            uint32 group = FirstGroup( hash );
+            for ( uint32 step = 1; ; step++ )
+            {
+               const uint32 mask = MatchFree( control + group * GROUP_SIZE );
+               if ( mask != 0 )
+                  return group * GROUP_SIZE + LowestBit( mask );
+               group = ( group + step ) & groupMask;
+            }
+         }
+
+         // claims a slot for a new key, the caller constructs the entry
+         uint32 PrepareInsert( const uint64 hash )
+         {
+            if ( growthLeft == 0 )
+            {
+               // grow, or just drop the deleted slots when they are what fills the map
+               Rehash( size + 1 > MaxLoad( capacity ) / 2 ? ( capacity == 0 ? GROUP_SIZE : capacity * 2 ) : capacity );
+            }
+
+            const uint32 index = FindFree( hash );
+            if ( control[index] == CONTROL_EMPTY )
+               growthLeft--;
+            control[index] = H2( hash );
+            size++;
+            return index;
+         }
+
+         void Rehash( const uint32 newCapacity )
+         {
+            assert( newCapacity >= GROUP_SIZE && ( newCapacity & ( newCapacity - 1 ) ) == 0 && MaxLoad( newCapacity ) >= size );
+
+            int8 *oldControl = control;
+            Entry *oldEntries = entries;
+            const uint32 oldCapacity = capacity;
+
+            control = new int8[newCapacity];
+            memset( control, CONTROL_EMPTY, newCapacity );
+            entries = (Entry*)::operator new( newCapacity * sizeof(Entry) );
+            capacity = newCapacity;
+            growthLeft = MaxLoad( newCapacity ) - size;
+
+            for ( uint32 i = 0; i < oldCapacity; i++ )
+            {
+               if ( oldControl[i] < 0 )
+                  continue;
+               const uint64 hash = HashOf( oldEntries[i].key );
+               const uint32 index = FindFree( hash );
+               control[index] = H2( hash );
+               new ( &entries[index] ) Entry( std::move( oldEntries[i] ) );
+               oldEntries[i].~Entry();
+            }
+
+            delete[] oldControl;
+            ::operator delete( oldEntries );
+         }
+
+         void Destroy()
+         {
+            for ( uint32 i = 0; i < capacity; i++ )
+               if ( control[i] >= 0 )
+                  entries[i].~Entry();
+            delete[] control;
+            ::operator delete( entries );
+            control = NULL;
+            entries = NULL;
+            capacity = size = growthLeft = 0;
+         }
+
+      public:
+         FlatHashMap() : control(NULL), entries(NULL), capacity(0), size(0), growthLeft(0) {}
+
+         FlatHashMap( const FlatHashMap &other ) : control(NULL), entries(NULL), capacity(0), size(0), growthLeft(0),
+            hasher(other.hasher), equal(other.equal)
+         {
+            Reserve( other.size );
+            for ( ConstIterator it = other.begin(); it != other.end(); ++it )
+               Insert( it->key, it->value );
+         }
+
+         FlatHashMap( FlatHashMap &&other ) : control(NULL), entries(NULL), capacity(0), size(0), growthLeft(0)
+         {
+            Swap( other );
+         }
+
+         ~FlatHashMap() { Destroy(); }
+
+         FlatHashMap &operator=( const FlatHashMap &other )
+         {
+            if ( this != &other )
+            {
+               FlatHashMap copy( other );
+               Swap( copy );
+            }
+            return *this;
+         }
+
+         FlatHashMap &operator=( FlatHashMap &&other )
+         {
+            Swap( other );
+            return *this;
+         }
+
+         void Swap( FlatHashMap &other )
+         {
+            std::swap( control, other.control );
+            std::swap( entries, other.entries );
+            std::swap( capacity, other.capacity );
+            std::swap( size, other.size );
+            std::swap( growthLeft, other.growthLeft );
+            std::swap( hasher, other.hasher );
+            std::swap( equal, other.equal );
+         }
+
+         // NULL if the key is not there
+         template <class Q>
+         V *Find( const Q &key )
+         {
+            const uint32 index = FindIndex( key, HashOf( key ) );
+            return index == NOT_FOUND ? NULL : &entries[index].value;
+         }
+
+         template <class Q>
+         const V *Find( const Q &key ) const
+         {
+            const uint32 index = FindIndex( key, HashOf( key ) );
+            return index == NOT_FOUND ? NULL : &entries[index].value;
+         }
+
+         template <class Q>
+         bool Contains( const Q &key ) const { return FindIndex( key, HashOf( key ) ) != NOT_FOUND; }
+
+         // false if the key is already there, its value is left as it is then
+         bool Insert( const K &key, const V &value )
+         {
+            const uint64 hash = HashOf( key );
+            if ( FindIndex( key, hash ) != NOT_FOUND )
+               return false;
+            const uint32 index = PrepareInsert( hash ); // may move entries
+            new ( &entries[index] ) Entry( key, value );
+            return true;
+         }
+
+         // the value of key, a default constructed one is inserted if the key is not there
+         template <class Q>
+         V &operator[]( const Q &key )
+         {
+            const uint64 hash = HashOf( key );
+            uint32 index = FindIndex( key, hash );
+            if ( index == NOT_FOUND )
+            {
+               index = PrepareInsert( hash );
+               new ( &entries[index] ) Entry( K( key ), V() );
+            }
+            return entries[index].value;
+         }
+
+         template <class Q>
+         bool Erase( const Q &key )
+         {
+            const uint32 index = FindIndex( key, HashOf( key ) );
+            if ( index == NOT_FOUND )
+               return false;
+
+            entries[index].~Entry();
+            size--;
+            // a group with an empty slot never filled up, so no probe went on past it and the
+            // slot can be empty again. Otherwise it has to stay a tombstone
+            if ( Match( control + index / GROUP_SIZE * GROUP_SIZE, CONTROL_EMPTY ) != 0 )
+            {
+               control[index] = CONTROL_EMPTY;
+               growthLeft++;
+            }
+            else
+            {
+               control[index] = CONTROL_DELETED;
+            }
+            return true;
+         }
+
+         void Clear()
+         {
+            for ( uint32 i = 0; i < capacity; i++ )
+            {
+               if ( control[i] >= 0 )
+                  entries[i].~Entry();
+               control[i] = CONTROL_EMPTY;
+            }
+            size = 0;
+            growthLeft = MaxLoad( capacity );
+         }
+
+         // room for count entries without growing
+         void Reserve( const uint32 count )
+         {
+            uint32 newCapacity = capacity == 0 ? GROUP_SIZE : capacity;
+            while ( MaxLoad( newCapacity ) < count )
+               newCapacity *= 2;
+            if ( newCapacity != capacity )
+               Rehash( newCapacity );
+         }
+
+         uint32 GetSize() const { return size; }
+         bool IsEmpty() const { return size == 0; }
+         uint32 GetCapacity() const { return capacity; }
+
+         Iterator begin() { return Iterator( this, 0 ); }
+         Iterator end() { return Iterator( this, capacity ); }
+         ConstIterator begin() const { return ConstIterator( this, 0 ); }
+         ConstIterator end() const { return ConstIterator( this, capacity ); }
+      };
+
+   } // namespace containers
+
+} // namespace core
+
+#endif
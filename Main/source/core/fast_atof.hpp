@@ -16,12 +16,29 @@
 #define __FAST_A_TO_F_H_INCLUDED__
 
 #include <cmath>
+#include <cstring>
+#include <algorithm>
 #include <limits>
 #include <stdint.h>
 #include <stdexcept>
 
 #include "StringComparison.hpp"
 
+// SWAR digit conversion needs a little endian target with cheap unaligned loads. SSE2 is
+// always available on x64 and with /arch:SSE2 on x86, AVX2 with /arch:AVX2
+#if defined(_M_X64) || defined(_M_IX86)
+#  define AI_FAST_ATOF_SWAR
+#  include <intrin.h>
+#endif
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define AI_FAST_ATOF_SSE2
+#  include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#  define AI_FAST_ATOF_AVX2
+#  include <immintrin.h>
+#endif
+
 namespace Assimp
 {
 
@@ -239,6 +256,210 @@ namespace Assimp
    }
 
 
+   // ------------------------------------------------------------------------------------
+   // Bounded scanning helpers. The *_n functions never read at or past 'end', so they
+   // work on ranges that are not zero-terminated (memory mapped files). Runs of digits
+   // are converted eight characters at a time (SWAR) and token ends are searched 16 or
+   // 32 bytes at a time with SSE2 / AVX2 when enough input is left, the tail falls back
+   // to the scalar loops.
+   // ------------------------------------------------------------------------------------
+#ifdef AI_FAST_ATOF_SWAR
+   // load eight characters, the first character ends up in the lowest byte
+   inline uint64 LoadEightChars(const char* in)
+   {
+      uint64 v;
+      memcpy(&v, in, sizeof(v));
+      return v;
+   }
+
+   // 0x80 in every byte of v that is not an ascii digit
+   inline uint64 NonDigitMask(const uint64 v)
+   {
+      const uint64 x = v & 0x7F7F7F7F7F7F7F7FULL;
+      const uint64 ge0 = x + 0x5050505050505050ULL;   // high bit set for bytes >= '0'
+      const uint64 gt9 = x + 0x4646464646464646ULL;   // high bit set for bytes > '9'
+      return (~ge0 | gt9 | v) & 0x8080808080808080ULL;
+   }
+
+   // index of the lowest set bit, mask must not be zero
+   inline uint32 LowestBitIndex(const uint64 mask)
+   {
+      unsigned long index;
+#ifdef _M_X64
+      _BitScanForward64(&index, mask);
+#else
+      if (!_BitScanForward(&index, (unsigned long)mask))
+      {
+         _BitScanForward(&index, (unsigned long)(mask >> 32));
+         index += 32;
+      }
+#endif
+      return index;
+   }
+
+   // convert eight ascii digits, the first character is the most significant digit
+   inline uint32 ParseEightDigits(uint64 v)
+   {
+      v -= 0x3030303030303030ULL;
+      v = (v * 10) + (v >> 8);
+      v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+         (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+      return (uint32)v;
+   }
+#endif
+
+   const uint64 fast_atoi_pow10[9] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+
+   inline bool IsDigit_n(const char* in, const char* end)
+   {
+      return in != end && *in >= '0' && *in <= '9';
+   }
+
+   // ------------------------------------------------------------------------------------
+   // Read at most maxDigits (<= 19, so the value can not overflow) digits, numDigits
+   // receives the number of digits read
+   // ------------------------------------------------------------------------------------
+   inline uint64 ReadDigits_n(const char*& in, const char* end, uint32 maxDigits, uint32& numDigits)
+   {
+      uint64 value = 0;
+      numDigits = 0;
+#ifdef AI_FAST_ATOF_SWAR
+      while (end - in >= 8 && maxDigits - numDigits >= 8)
+      {
+         const uint64 v = LoadEightChars(in);
+         const uint64 mask = NonDigitMask(v);
+         const uint32 n = mask ? LowestBitIndex(mask) >> 3 : 8;
+         if (n == 0)
+            break;
+
+         // pad a short run with leading zeros
+         const uint64 digits = n == 8 ? v : (v << (8 * (8 - n))) | (0x3030303030303030ULL >> (8 * n));
+         value = value * fast_atoi_pow10[n] + ParseEightDigits(digits);
+         in += n;
+         numDigits += n;
+         if (n < 8)
+            return value;
+      }
+#endif
+      while (numDigits < maxDigits && IsDigit_n(in, end))
+      {
+         value = (value * 10) + (*in - '0');
+         ++in;
+         ++numDigits;
+      }
+      return value;
+   }
+
+   // ------------------------------------------------------------------------------------
+   // Skip a run of digits
+   // ------------------------------------------------------------------------------------
+   inline const char* SkipDigits_n(const char* in, const char* end)
+   {
+#ifdef AI_FAST_ATOF_SWAR
+      while (end - in >= 8)
+      {
+         const uint64 mask = NonDigitMask(LoadEightChars(in));
+         if (mask)
+            return in + (LowestBitIndex(mask) >> 3);
+         in += 8;
+      }
+#endif
+      while (IsDigit_n(in, end))
+         ++in;
+      return in;
+   }
+
+   // ------------------------------------------------------------------------------------
+   // Find the end of a token, that is the next space, tab, line end or 'end'
+   // ------------------------------------------------------------------------------------
+   inline const char* FindTokenEnd_n(const char* in, const char* end)
+   {
+#ifdef AI_FAST_ATOF_AVX2
+      const __m256i space32 = _mm256_set1_epi8(' ');
+      const __m256i tab32 = _mm256_set1_epi8('\t');
+      const __m256i cr32 = _mm256_set1_epi8('\r');
+      const __m256i lf32 = _mm256_set1_epi8('\n');
+      const __m256i ff32 = _mm256_set1_epi8('\f');
+      const __m256i zero32 = _mm256_setzero_si256();
+      while (end - in >= 32)
+      {
+         const __m256i chars = _mm256_loadu_si256((const __m256i*)in);
+         const __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chars, space32), _mm256_cmpeq_epi8(chars, tab32)),
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chars, cr32), _mm256_cmpeq_epi8(chars, lf32)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chars, ff32), _mm256_cmpeq_epi8(chars, zero32))));
+         const uint32 mask = (uint32)_mm256_movemask_epi8(hits);
+         if (mask)
+            return in + LowestBitIndex(mask);
+         in += 32;
+      }
+#endif
+#ifdef AI_FAST_ATOF_SSE2
+      const __m128i space = _mm_set1_epi8(' ');
+      const __m128i tab = _mm_set1_epi8('\t');
+      const __m128i cr = _mm_set1_epi8('\r');
+      const __m128i lf = _mm_set1_epi8('\n');
+      const __m128i ff = _mm_set1_epi8('\f');
+      const __m128i zero = _mm_setzero_si128();
+      while (end - in >= 16)
+      {
+         const __m128i chars = _mm_loadu_si128((const __m128i*)in);
+         const __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chars, space), _mm_cmpeq_epi8(chars, tab)),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, cr), _mm_cmpeq_epi8(chars, lf)),
+            _mm_or_si128(_mm_cmpeq_epi8(chars, ff), _mm_cmpeq_epi8(chars, zero))));
+         const uint32 mask = (uint32)_mm_movemask_epi8(hits);
+         if (mask)
+            return in + LowestBitIndex(mask);
+         in += 16;
+      }
+#endif
+      while (in != end && *in != ' ' && *in != '\t' && *in != '\r' && *in != '\n' && *in != '\0' && *in != '\f')
+         ++in;
+      return in;
+   }
+
+   // ------------------------------------------------------------------------------------
+   // Bounded variant of strtoul10
+   // ------------------------------------------------------------------------------------
+   inline uint32 strtoul10_n(const char* in, const char* end, const char** out = 0)
+   {
+      uint32 value = 0;
+      uint32 numDigits;
+
+      // the value wraps like strtoul10 does for overlong input
+      do
+      {
+         const uint32 part = (uint32)ReadDigits_n(in, end, 8, numDigits);
+         value = value * (uint32)fast_atoi_pow10[numDigits] + part;
+      } while (numDigits == 8);
+
+      if (out)*out = in;
+      return value;
+   }
+
+   // ------------------------------------------------------------------------------------
+   // Bounded variant of strtol10
+   // ------------------------------------------------------------------------------------
+   inline int strtol10_n(const char* in, const char* end, const char** out = 0)
+   {
+      if (in == end)
+      {
+         if (out)*out = in;
+         return 0;
+      }
+
+      bool inv = (*in == '-');
+      if (inv || *in == '+')
+         ++in;
+
+      int32 value = strtoul10_n(in, end, out);
+      if (inv) {
+         value = -value;
+      }
+      return value;
+   }
+
    // Number of relevant decimals for floating-point parsing.
 #define AI_FAST_ATOF_RELAVANT_DECIMALS 15
 
@@ -392,6 +613,123 @@ namespace Assimp
       return ret;
    }
 
+   // ------------------------------------------------------------------------------------
+   // Parse a token of fast_atoreal_move_n on a zero-terminated copy
+   // ------------------------------------------------------------------------------------
+   template <typename Real>
+   inline const char* fast_atoreal_move_copy(const char* c, const char* end, Real& out, bool check_comma)
+   {
+      char buffer[128];
+      const size_t length = std::min<size_t>(FindTokenEnd_n(c, end) - c, sizeof(buffer) - 1);
+      memcpy(buffer, c, length);
+      buffer[length] = '\0';
+      return c + (fast_atoreal_move<Real>(buffer, out, check_comma) - buffer);
+   }
+
+   // ------------------------------------------------------------------------------------
+   // Bounded variant of fast_atoreal_move with the same results. The digits are converted
+   // in place, only rare spellings (nan, inf, more than 19 integer digits, no number at all)
+   // go through fast_atoreal_move on a zero-terminated copy of the token.
+   // ------------------------------------------------------------------------------------
+   template <typename Real>
+   inline const char* fast_atoreal_move_n(const char* c, const char* end, Real& out, bool check_comma = true)
+   {
+      const char* start = c;
+      Real f = 0;
+
+      bool inv = (c != end && *c == '-');
+      if (inv || (c != end && *c == '+')) {
+         ++c;
+      }
+
+      if (IsDigit_n(c, end))
+      {
+         uint32 numDigits;
+         const uint64 value = ReadDigits_n(c, end, 19, numDigits);
+         if (IsDigit_n(c, end))
+            return fast_atoreal_move_copy<Real>(start, end, out, check_comma);
+         f = static_cast<Real>(value);
+      }
+      else if (!(c != end && (*c == '.' || (check_comma && *c == ',')) && IsDigit_n(c + 1, end)))
+      {
+         return fast_atoreal_move_copy<Real>(start, end, out, check_comma);
+      }
+
+      if (c != end && (*c == '.' || (check_comma && *c == ',')) && IsDigit_n(c + 1, end))
+      {
+         ++c;
+
+         // same precision handling as fast_atoreal_move
+         uint32 diff;
+         double pl = static_cast<double>(ReadDigits_n(c, end, AI_FAST_ATOF_RELAVANT_DECIMALS, diff));
+         c = SkipDigits_n(c, end);
+
+         pl *= fast_atof_table[diff];
+         f += static_cast<Real>(pl);
+      }
+      // For backwards compatibility: eat trailing dots, but not trailing commas.
+      else if (c != end && *c == '.') {
+         ++c;
+      }
+
+      if (c != end && (*c == 'e' || *c == 'E'))	{
+
+         ++c;
+         const bool einv = (c != end && *c == '-');
+         if (einv || (c != end && *c == '+')) {
+            ++c;
+         }
+
+         if (!IsDigit_n(c, end))
+            throw std::invalid_argument("Cannot parse string as real number: exponent has no digits.");
+
+         uint32 numDigits;
+         Real exp = static_cast<Real>(ReadDigits_n(c, end, 19, numDigits));
+         if (IsDigit_n(c, end))
+            return fast_atoreal_move_copy<Real>(start, end, out, check_comma);
+         if (einv) {
+            exp = -exp;
+         }
+         f *= std::pow(static_cast<Real>(10.0), exp);
+      }
+
+      if (inv) {
+         f = -f;
+      }
+      out = f;
+      return c;
+   }
+
+   // ------------------------------------------------------------------------------------
+   // Parse count whitespace separated values of one line into out. Every token is consumed
+   // up to the next whitespace, like a word copied out and passed to fast_atof. A value
+   // missing on the line throws just as fast_atof does on an empty string.
+   // Returns the position behind the last token.
+   // ------------------------------------------------------------------------------------
+   template <typename Real>
+   inline const char* fast_atoreal_n(const char* c, const char* end, Real* out, uint32 count)
+   {
+      for (uint32 i = 0; i < count; ++i)
+      {
+         while (c != end && (*c == ' ' || *c == '\t'))
+            ++c;
+
+         c = fast_atoreal_move_n<Real>(c, end, out[i]);
+         c = FindTokenEnd_n(c, end);
+      }
+      return c;
+   }
+
+   inline const char* fast_atof_n(const char* c, const char* end, float* out, uint32 count)
+   {
+      return fast_atoreal_n<float>(c, end, out, count);
+   }
+
+   inline const char* fast_atod_n(const char* c, const char* end, double* out, uint32 count)
+   {
+      return fast_atoreal_n<double>(c, end, out, count);
+   }
+
 } // end of namespace Assimp
 
 #endif
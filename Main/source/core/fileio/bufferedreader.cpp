@@ -0,0 +1,248 @@
+#include "core/fileio/bufferedreader.hpp"
+
+#include <Windows.h>
+
+BufferedReader::BufferedReader()
+{
+   fileHandle = INVALID_HANDLE_VALUE;
+   fileSize = 0;
+   blockStart = 0;
+   buffers[0] = buffers[1] = NULL;
+   blockSize = 0;
+   front = 0;
+   pos = 0;
+   fill = 0;
+   isOpen = false;
+
+   usePrefetch = false;
+   backRequested = false;
+   backReady = false;
+   stopWorker = false;
+   backFill = 0;
+}
+
+BufferedReader::~BufferedReader()
+{
+   Close();
+}
+
+bool BufferedReader::Open( const String_c &path, const uint32 blockSize, const bool prefetch )
+{
+   Close();
+
+   // sequential scan tells the cache manager to read ahead and to drop pages behind the reader
+   fileHandle = CreateFileA( path.CString(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+   if ( fileHandle == INVALID_HANDLE_VALUE )
+      return false;
+
+   LARGE_INTEGER size;
+   if ( !GetFileSizeEx( fileHandle, &size ) )
+   {
+      Close();
+      return false;
+   }
+   fileSize = (uint64)size.QuadPart;
+
+   this->blockSize = blockSize > 0 ? blockSize : 4096;
+   buffers[0] = new byte[this->blockSize];
+   buffers[1] = prefetch ? new byte[this->blockSize] : NULL;
+   front = 0;
+   blockStart = 0;
+   pos = 0;
+   fill = 0;
+   isOpen = true;
+
+   usePrefetch = prefetch;
+   if ( usePrefetch )
+   {
+      stopWorker = false;
+      backReady = false;
+      backRequested = false;
+      worker = std::thread( &BufferedReader::PrefetchLoop, this );
+      RequestBack();
+   }
+
+   return true;
+}
+
+void BufferedReader::Close()
+{
+   if ( worker.joinable() )
+   {
+      {
+         std::lock_guard<std::mutex> lock( mutex );
+         stopWorker = true;
+      }
+      condition.notify_all();
+      worker.join();
+   }
+   usePrefetch = false;
+   backRequested = false;
+   backReady = false;
+
+   if ( fileHandle != INVALID_HANDLE_VALUE )
+      CloseHandle( fileHandle );
+   fileHandle = INVALID_HANDLE_VALUE;
+
+   delete [] buffers[0];
+   delete [] buffers[1];
+   buffers[0] = buffers[1] = NULL;
+
+   fileSize = 0;
+   blockStart = 0;
+   pos = 0;
+   fill = 0;
+   isOpen = false;
+}
+
+uint32 BufferedReader::ReadFromFile( void *bufferOut, const uint32 bytes )
+{
+   DWORD numRead = 0;
+   if ( !ReadFile( fileHandle, bufferOut, bytes, &numRead, NULL ) )
+      return 0;
+   return (uint32)numRead;
+}
+
+// fills the back buffer whenever the reader asks for it
+void BufferedReader::PrefetchLoop()
+{
+   std::unique_lock<std::mutex> lock( mutex );
+   for (;;)
+   {
+      while ( !backRequested && !stopWorker )
+         condition.wait( lock );
+      if ( stopWorker )
+         return;
+
+      // front does not change while a request is pending
+      byte *back = buffers[1 - front];
+      lock.unlock();
+      const uint32 numRead = ReadFromFile( back, blockSize );
+      lock.lock();
+
+      backFill = numRead;
+      backRequested = false;
+      backReady = true;
+      condition.notify_all();
+   }
+}
+
+void BufferedReader::RequestBack()
+{
+   {
+      std::lock_guard<std::mutex> lock( mutex );
+      backReady = false;
+      backRequested = true;
+   }
+   condition.notify_all();
+}
+
+// waits until no read is pending
+void BufferedReader::WaitForBack()
+{
+   std::unique_lock<std::mutex> lock( mutex );
+   while ( backRequested )
+      condition.wait( lock );
+}
+
+bool BufferedReader::NextBlock()
+{
+   blockStart += fill;
+   pos = 0;
+   fill = 0;
+   if ( blockStart >= fileSize )
+      return false;
+
+   if ( usePrefetch )
+   {
+      WaitForBack();
+      if ( !backReady )
+         return false;
+      front = 1 - front;
+      fill = backFill;
+      // the file pointer is at the end of this block, read on while it is consumed
+      if ( blockStart + fill < fileSize )
+         RequestBack();
+      else
+         backReady = false;
+   }
+   else
+      fill = ReadFromFile( buffers[front], blockSize );
+
+   return fill > 0;
+}
+
+// drops the buffered data and continues reading at position
+void BufferedReader::RestartAt( const uint64 position )
+{
+   if ( usePrefetch )
+   {
+      WaitForBack();
+      backReady = false;
+   }
+
+   LARGE_INTEGER distance;
+   distance.QuadPart = (LONGLONG)position;
+   SetFilePointerEx( fileHandle, distance, NULL, FILE_BEGIN );
+
+   blockStart = position;
+   pos = 0;
+   fill = 0;
+
+   if ( usePrefetch && position < fileSize )
+      RequestBack();
+}
+
+uint32 BufferedReader::Read( void *bufferOut, const uint32 bytes )
+{
+   assert( isOpen );
+
+   byte *out = (byte*)bufferOut;
+   uint32 done = 0;
+   while ( done < bytes )
+   {
+      if ( pos == fill )
+      {
+         // without prefetch reads of a block or more go straight to the destination
+         if ( !usePrefetch && bytes - done >= blockSize )
+         {
+            blockStart += fill;
+            pos = 0;
+            fill = 0;
+            const uint32 numRead = ReadFromFile( out + done, bytes - done );
+            blockStart += numRead;
+            done += numRead;
+            break;
+         }
+         if ( !NextBlock() )
+            break;
+      }
+
+      const uint32 available = fill - pos;
+      const uint32 count = available < bytes - done ? available : bytes - done;
+      memcpy( out + done, buffers[front] + pos, count );
+      pos += count;
+      done += count;
+   }
+   return done;
+}
+
+bool BufferedReader::Seek( const uint64 position )
+{
+   assert( isOpen );
+
+   if ( position > fileSize )
+      return false;
+
+   if ( position >= blockStart && position <= blockStart + fill )
+      pos = (uint32)(position - blockStart);
+   else
+      RestartAt( position );
+   return true;
+}
+
+bool BufferedReader::Skip( const uint32 bytes )
+{
+   return Seek( GetPosition() + bytes );
+}
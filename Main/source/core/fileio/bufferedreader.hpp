@@ -0,0 +1,125 @@
+#ifndef _BUFFEREDREADER_HPP_INCLUDED_
+#define _BUFFEREDREADER_HPP_INCLUDED_
+
+#include <string.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "core/string/string.hpp"
+
+using core::string::String_c;
+
+// Sequential binary reader that fetches the file in large blocks, so small typed reads cost a
+// memcpy instead of a CRT call each. The file is opened for sequential scan, which makes the
+// OS read ahead aggressively (the Windows counterpart of posix_fadvise SEQUENTIAL).
+//
+// With prefetch a background thread reads the next block while the current one is consumed,
+// so parsing and disk I/O overlap. All values in files are little-endian
+class BufferedReader
+{
+private:
+   void *fileHandle;
+   uint64 fileSize;
+   uint64 blockStart; // file offset of the first byte in the current block
+   byte *buffers[2];
+   uint32 blockSize;
+   uint32 front;
+   uint32 pos; // read position in the current block
+   uint32 fill; // valid bytes in the current block
+   bool isOpen;
+
+   // prefetch thread state, guarded by mutex
+   bool usePrefetch;
+   std::thread worker;
+   std::mutex mutex;
+   std::condition_variable condition;
+   bool backRequested;
+   bool backReady;
+   bool stopWorker;
+   uint32 backFill;
+
+   uint32 ReadFromFile( void *bufferOut, const uint32 bytes );
+   void PrefetchLoop();
+   void RequestBack();
+   void WaitForBack();
+   bool NextBlock();
+   void RestartAt( const uint64 position );
+
+   // not copyable, owns the file handle and the thread
+   BufferedReader( const BufferedReader &other );
+   BufferedReader &operator=( const BufferedReader &other );
+public:
+   BufferedReader();
+   ~BufferedReader();
+
+   bool Open( const String_c &path, const uint32 blockSize = 256 * 1024, const bool prefetch = false );
+   void Close();
+   bool IsOpen() const { return isOpen; }
+
+   // returns the number of bytes read, less than bytes only at the end of the file
+   uint32 Read( void *bufferOut, const uint32 bytes );
+   // typed reads return 0 past the end of the file, check IsEof
+   byte ReadU8();
+   uint16 ReadU16();
+   uint32 ReadU32();
+   int32 ReadI32();
+   float ReadF32();
+
+   bool Skip( const uint32 bytes );
+   bool Seek( const uint64 position );
+   uint64 GetPosition() const { return blockStart + pos; }
+   uint64 GetSize() const { return fileSize; }
+   bool IsEof() const { return GetPosition() >= fileSize; }
+};
+
+inline byte BufferedReader::ReadU8()
+{
+   if ( pos == fill && !NextBlock() )
+      return 0;
+   return buffers[front][pos++];
+}
+
+inline uint16 BufferedReader::ReadU16()
+{
+   byte b[2] = { 0 };
+   if ( fill - pos >= 2 )
+   {
+      b[0] = buffers[front][pos];
+      b[1] = buffers[front][pos + 1];
+      pos += 2;
+   }
+   else
+      Read( b, 2 );
+   return (uint16)(b[0] | (b[1] << 8));
+}
+
+inline uint32 BufferedReader::ReadU32()
+{
+   byte b[4] = { 0 };
+   if ( fill - pos >= 4 )
+   {
+      const byte *p = &buffers[front][pos];
+      b[0] = p[0]; b[1] = p[1]; b[2] = p[2]; b[3] = p[3];
+      pos += 4;
+   }
+   else
+      Read( b, 4 );
+   return (uint32)b[0] | ((uint32)b[1] << 8) | ((uint32)b[2] << 16) | ((uint32)b[3] << 24);
+}
+
+inline int32 BufferedReader::ReadI32()
+{
+   return (int32)ReadU32();
+}
+
+inline float BufferedReader::ReadF32()
+{
+   const uint32 bits = ReadU32();
+   float value;
+   memcpy( &value, &bits, sizeof(value) );
+   return value;
+}
+
+#endif
@@ -1,9 +1,13 @@
 #include "core/fileio/file.hpp"
+#include "core/memory/frameallocator.hpp"
 
 using core::string::String_c;
 
+static const size_t FILE_BUFFER_SIZE = 64 * 1024;
+
 File::File()
 {
+   stream = NULL;
    isOpen = false;
 }
 
@@ -40,6 +44,9 @@ bool File::Open( const String_c &path, const bool readAsBinary, const eFileMode
    
    isOpen = true;
 
+   // a bigger CRT buffer than the default 4 KB, GetByte and ReadLine refill it less often
+   setvbuf( stream, NULL, _IOFBF, FILE_BUFFER_SIZE );
+
    fseek( stream, 0, SEEK_END );
    fileSize = GetPosition();
    fseek( stream, 0, SEEK_SET );
@@ -96,32 +103,49 @@ void File::Close()
    if ( stream )
       fclose( stream );
 
+   stream = NULL;
    isOpen = false;
 }
 
+// lines up to this length are read into a stack buffer
+static const int32 LINE_BUFFER_SIZE = 256;
+
+static bool ReadLineInto( FILE *stream, char *str, const int32 length, String_c &lineOut, const bool includeNewLine )
+{
+   if (fgets(str, length, stream) == NULL) // false
+      return false;
+
+   lineOut = str;
+   if (!includeNewLine)
+      lineOut.RemoveChars("\n\r");
+   return true;
+}
+
 bool File::ReadLine( String_c &lineOut, const bool includeNewLine, const uint32 offset, const int32 length, const bool relative ) const
 {
    assert( isOpen );
 
-   char *str = new char[length];
-
    if (offset != -1)
    {
       fseek( stream, offset, relative ? SEEK_CUR : SEEK_SET );
    }
 
-   if (fgets(str, length, stream) == NULL) // false
+   if (length <= LINE_BUFFER_SIZE)
    {
-      delete[] str;
-      return false;
+      char str[LINE_BUFFER_SIZE];
+      return ReadLineInto( stream, str, length, lineOut, includeNewLine );
    }
 
-   lineOut = str;
-   if (!includeNewLine)
-      lineOut.RemoveChars("\n\r");
+   // longer lines go to frame memory, the heap is only used when no frame allocator is active
+   FrameScratch<char> str( length );
+   return ReadLineInto( stream, str.Get(), length, lineOut, includeNewLine );
+}
 
-   delete[] str;
-   return true;
+uint32 File::ReadBlock( void *bufferOut, const uint32 bytes ) const
+{
+   assert( isOpen );
+
+   return (uint32)fread( bufferOut, 1, bytes, stream );
 }
 
 File &File::operator<<( const String_c &str )
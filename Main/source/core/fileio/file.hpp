@@ -38,6 +38,8 @@ public:
 
    // read a line from file and the file pointer advances, or read line from an offset, -1 means only advance ptr
    bool ReadLine( String_c &lineOut, const bool includeNewLine = true, const uint32 offset = -1, const int32 length = 256, const bool relative = false ) const;
+   // read up to bytes from the file pointer on, returns the number of bytes read, 0 at the end of the file
+   uint32 ReadBlock( void *bufferOut, const uint32 bytes ) const;
    //bool WriteLine(
 
    File &operator<<( const String_c &str );
@@ -0,0 +1,78 @@
+#include "core/fileio/linereader.hpp"
+
+#include <string.h>
+
+LineReader::LineReader( const char *begin, const char *end )
+{
+   file = NULL;
+   data = begin;
+   pos = 0;
+   fill = begin != NULL ? end - begin : 0;
+   lineNumber = 0;
+   endOfInput = true;
+}
+
+LineReader::LineReader( const File &file, const size_t blockSize )
+{
+   this->file = &file;
+   buffer.resize( blockSize > 0 ? blockSize : 1 );
+   data = &buffer[0];
+   pos = 0;
+   fill = 0;
+   lineNumber = 0;
+   endOfInput = false;
+}
+
+// moves the unread rest to the front and reads after it, grows the buffer when the rest fills it
+bool LineReader::Refill()
+{
+   const size_t rest = fill - pos;
+   if ( rest > 0 && pos > 0 )
+      memmove( &buffer[0], &buffer[pos], rest );
+   pos = 0;
+   fill = rest;
+
+   if ( fill == buffer.size() )
+      buffer.resize( buffer.size() * 2 );
+   data = &buffer[0];
+
+   const uint32 numRead = file->ReadBlock( &buffer[fill], (uint32)(buffer.size() - fill) );
+   if ( numRead == 0 )
+      endOfInput = true;
+   fill += numRead;
+   return numRead > 0;
+}
+
+bool LineReader::ReadLine( StringView_c &lineOut )
+{
+   if ( endOfInput && pos == fill )
+      return false;
+
+   size_t searchFrom = pos;
+   const char *lineEnd;
+   while ( (lineEnd = (const char*)memchr( data + searchFrom, '\n', fill - searchFrom )) == NULL )
+   {
+      if ( endOfInput )
+      {
+         // last line without a line end
+         if ( pos == fill )
+            return false;
+         lineEnd = data + fill;
+         break;
+      }
+
+      // the part searched already is kept, only the new data is searched after a refill
+      searchFrom = fill - pos;
+      Refill();
+   }
+
+   const char *lineBegin = data + pos;
+   pos = (lineEnd - data) + (lineEnd != data + fill ? 1 : 0);
+
+   if ( lineEnd > lineBegin && lineEnd[-1] == '\r' )
+      lineEnd--;
+
+   lineOut = StringView_c( lineBegin, (uint32)(lineEnd - lineBegin) );
+   lineNumber++;
+   return true;
+}
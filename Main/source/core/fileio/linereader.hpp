@@ -0,0 +1,37 @@
+#ifndef _LINEREADER_HPP_INCLUDED_
+#define _LINEREADER_HPP_INCLUDED_
+
+#include <vector>
+
+#include "core/fileio/file.hpp"
+#include "core/string/stringview.hpp"
+
+using core::string::StringView_c;
+
+// Splits text into lines without copying or allocating per line. Either walks a block that is
+// already in memory, a MappedFile for example, or streams an open File through one big buffer
+// that is refilled as the lines are consumed. Lines have no length limit, the buffer grows to
+// fit the longest line. The returned line excludes the line end ("\n" or "\r\n") and stays
+// valid until the next call of ReadLine
+class LineReader
+{
+private:
+   const File *file; // NULL when reading a block in memory
+   std::vector<char> buffer;
+   const char *data;
+   size_t pos;
+   size_t fill;
+   uint32 lineNumber;
+   bool endOfInput;
+
+   bool Refill();
+public:
+   LineReader( const char *begin, const char *end );
+   LineReader( const File &file, const size_t blockSize = 64 * 1024 );
+
+   bool ReadLine( StringView_c &lineOut );
+   // 1-based number of the line returned last
+   uint32 GetLineNumber() const { return lineNumber; }
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "core/fileio/mappedfile.hpp"
+
+#include <Windows.h>
+
+MappedFile::MappedFile()
+{
+   fileHandle = INVALID_HANDLE_VALUE;
+   mappingHandle = NULL;
+   data = NULL;
+   size = 0;
+   isOpen = false;
+}
+
+MappedFile::~MappedFile()
+{
+   Close();
+}
+
+bool MappedFile::Open( const String_c &path )
+{
+   Close();
+
+   // sequential scan lets the cache manager read ahead aggressively while the parser walks the view
+   fileHandle = CreateFileA( path.CString(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+   if ( fileHandle == INVALID_HANDLE_VALUE )
+      return false;
+
+   LARGE_INTEGER fileSize;
+   if ( !GetFileSizeEx( fileHandle, &fileSize ) )
+   {
+      Close();
+      return false;
+   }
+   size = (uint64)fileSize.QuadPart;
+
+   // an empty file can not be mapped, treat it as an open file without data
+   if ( size == 0 )
+   {
+      isOpen = true;
+      return true;
+   }
+
+   // a 32 bit process can not map a view bigger than its address space
+   if ( size > (uint64)((size_t)-1) )
+   {
+      Close();
+      return false;
+   }
+
+   mappingHandle = CreateFileMappingA( fileHandle, NULL, PAGE_READONLY, 0, 0, NULL );
+   if ( mappingHandle == NULL )
+   {
+      Close();
+      return false;
+   }
+
+   data = (const char*)MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 );
+   if ( data == NULL )
+   {
+      Close();
+      return false;
+   }
+
+   isOpen = true;
+   return true;
+}
+
+void MappedFile::Close()
+{
+   if ( data != NULL )
+      UnmapViewOfFile( data );
+   if ( mappingHandle != NULL )
+      CloseHandle( mappingHandle );
+   if ( fileHandle != INVALID_HANDLE_VALUE )
+      CloseHandle( fileHandle );
+
+   fileHandle = INVALID_HANDLE_VALUE;
+   mappingHandle = NULL;
+   data = NULL;
+   size = 0;
+   isOpen = false;
+}
+
+bool MappedFile::IsOpen() const
+{
+   return isOpen;
+}
+
+const char *MappedFile::GetData() const
+{
+   return data;
+}
+
+const char *MappedFile::GetEnd() const
+{
+   return data + (size_t)size;
+}
+
+uint64 MappedFile::GetSize() const
+{
+   return size;
+}
@@ -0,0 +1,38 @@
+#ifndef _MAPPEDFILE_HPP_INCLUDED_
+#define _MAPPEDFILE_HPP_INCLUDED_
+
+#include "core/string/string.hpp"
+
+using core::string::String_c;
+
+// read only view of a whole file mapped into the address space. Nothing is copied on Open,
+// the pages are faulted in by the OS as the data is touched, so parsers can walk the
+// returned range directly. Note that the data is not zero-terminated
+class MappedFile
+{
+private:
+   void *fileHandle;
+   void *mappingHandle;
+   const char *data;
+   uint64 size;
+   bool isOpen;
+
+   // not copyable, the view is owned by this instance
+   MappedFile( const MappedFile &other );
+   MappedFile &operator=( const MappedFile &other );
+public:
+   MappedFile();
+   ~MappedFile();
+
+   bool Open( const String_c &path );
+   void Close();
+   bool IsOpen() const;
+
+   // first byte of the mapped view, NULL for empty files
+   const char *GetData() const;
+   // one past the last byte of the mapped view
+   const char *GetEnd() const;
+   uint64 GetSize() const;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef _FNV_HPP_INCLUDED_
+#define _FNV_HPP_INCLUDED_
+
+#include <stddef.h>
+
+#include "core/BasicTypes.hpp"
+
+namespace core
+{
+namespace hash
+{
+
+// FNV-1a, a simple byte-wise hash used for content checks and string ids.
+// Pass the previous result as 'hash' to continue hashing over several blocks
+const uint32 FNV1A32_OFFSET = 2166136261u;
+const uint32 FNV1A32_PRIME = 16777619u;
+const uint64 FNV1A64_OFFSET = 14695981039346656037ULL;
+const uint64 FNV1A64_PRIME = 1099511628211ULL;
+
+inline uint32 Fnv1a32( const void *data, const size_t size, uint32 hash = FNV1A32_OFFSET )
+{
+   const byte *bytes = (const byte*)data;
+   for ( size_t i = 0; i < size; i++ )
+   {
+      hash ^= bytes[i];
+      hash *= FNV1A32_PRIME;
+   }
+   return hash;
+}
+
+inline uint64 Fnv1a64( const void *data, const size_t size, uint64 hash = FNV1A64_OFFSET )
+{
+   const byte *bytes = (const byte*)data;
+   for ( size_t i = 0; i < size; i++ )
+   {
+      hash ^= bytes[i];
+      hash *= FNV1A64_PRIME;
+   }
+   return hash;
+}
+
+// FNV-1a 32 of a string literal up to its terminating zero, hash is that of the first I
+// characters. Without constexpr the hash is built by template recursion, every step is an inline
+// function of constants, so with optimizations on the whole hash folds into one constant at
+// compile time. Fnv1a32Literal<N, 0>::Hash( str ) equals Fnv1a32( str, strlen( str ) ), also for
+// an array that is longer than its string
+template <uint32 N, uint32 I>
+struct Fnv1a32Literal
+{
+   static inline uint32 Hash( const char (&str)[N], const uint32 hash = FNV1A32_OFFSET )
+   {
+      return str[I] == '\0' ? hash : Fnv1a32Literal<N, I + 1>::Hash( str, ( hash ^ (byte)str[I] ) * FNV1A32_PRIME );
+   }
+};
+
+// past the end of an array without a terminating zero
+template <uint32 N>
+struct Fnv1a32Literal<N, N>
+{
+   static inline uint32 Hash( const char (&)[N], const uint32 hash ) { return hash; }
+};
+
+} // namespace hash
+} // namespace core
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef _HASH_HPP_INCLUDED_
+#define _HASH_HPP_INCLUDED_
+
+#include <string.h>
+#include <string>
+
+#include "core/hash/fnv.hpp"
+#include "core/string/string.hpp"
+#include "core/string/stringview.hpp"
+
+namespace core
+{
+namespace hash
+{
+
+// Hash and equality functors of the hash containers. The hash does not need to be well mixed, the
+// containers mix it once more. The string versions also take string views and C strings, so a
+// lookup with a view or a literal does not build a temporary key. Every overload of one functor
+// has to give the same hash for equal strings
+
+template <class T>
+struct Hash
+{
+   uint64 operator()( const T &key ) const { return (uint64)key; }
+};
+
+template <class T>
+struct Hash<T*>
+{
+   uint64 operator()( const T *key ) const { return (uint64)(size_t)key; }
+};
+
+struct StringHash
+{
+   uint64 operator()( const core::string::StringView_c &key ) const { return Fnv1a64( key.GetData(), key.GetSize() ); }
+   uint64 operator()( const char *key ) const { return Fnv1a64( key, strlen( key ) ); }
+   uint64 operator()( const core::string::String_c &key ) const { return (*this)( key.GetView() ); }
+   uint64 operator()( const std::string &key ) const { return Fnv1a64( key.c_str(), key.size() ); }
+};
+
+template <> struct Hash<core::string::String_c> : StringHash {};
+template <> struct Hash<core::string::StringView_c> : StringHash {};
+template <> struct Hash<std::string> : StringHash {};
+
+template <class T>
+struct EqualTo
+{
+   template <class Q>
+   bool operator()( const T &key, const Q &other ) const { return key == other; }
+};
+
+// compares the characters, whatever string type is on either side
+struct StringEqualTo
+{
+   static core::string::StringView_c View( const core::string::StringView_c &str ) { return str; }
+   static core::string::StringView_c View( const char *str ) { return core::string::StringView_c( str ); }
+   static core::string::StringView_c View( const core::string::String_c &str ) { return str.GetView(); }
+   static core::string::StringView_c View( const std::string &str ) { return core::string::StringView_c( str.c_str(), (uint32)str.size() ); }
+
+   template <class A, class B>
+   bool operator()( const A &key, const B &other ) const { return View( key ) == View( other ); }
+};
+
+template <> struct EqualTo<core::string::String_c> : StringEqualTo {};
+template <> struct EqualTo<core::string::StringView_c> : StringEqualTo {};
+template <> struct EqualTo<std::string> : StringEqualTo {};
+
+} // namespace hash
+} // namespace core
+
+#endif
@@ -31,6 +31,8 @@ public:
    void Reset( const Point3<T> & ); // reset to one-point box
    void Reset( const AABBox &initValue );
    void AddInternalPoint( const T x, const T y, const T z );
+   const Point3<T> &GetMinEdge() const { return minEdge; }
+   const Point3<T> &GetMaxEdge() const { return maxEdge; }
    Point3<T> GetCenter() const;
    Point3<T> GetExtent() const; // get maximal distance of two points in the box
    bool IsEmpty() const;
@@ -93,15 +95,15 @@ inline bool AABBox<T>::operator!=( const AABBox<T> &other) const
 template <class T>
 void AABBox<T>::Reset( T x, T y, T z )
 {
-   maxEdge.set(x,y,z);
+   maxEdge.Set(x,y,z);
    minEdge = maxEdge;
 }
 
 template <class T>
 void AABBox<T>::Reset( const Point3<T> &point )
 {
-   MaxEdge = point;
-   MinEdge = point;
+   maxEdge = point;
+   minEdge = point;
 }
 
 template <class T>
@@ -0,0 +1,604 @@
+#include "bvh.hpp"
+
+#include <float.h>
+#include <string.h>
+
+namespace core
+{
+
+namespace math
+{
+
+namespace bvh
+{
+
+using culling::CullBox;
+using culling::eCullResult;
+using culling::CULL_OUTSIDE;
+using culling::CULL_INSIDE;
+using culling::CULL_ALL_PLANES;
+
+// the centroids are sorted into this many bins per axis to evaluate the SAH splits
+static const uint32 NUM_BINS = 16;
+// cost of one node traversal relative to one primitive test
+static const float TRAVERSAL_COST = 1.0f;
+
+Ray::Ray( const Point3f &origin, const Point3f &direction, const float maxDistance )
+{
+   for ( uint8 i = 0; i < 3; i++ )
+   {
+      this->origin[i] = origin[i];
+      this->direction[i] = direction[i];
+      // a huge value instead of infinity keeps 0 * inv out of the slab tests
+      invDirection[i] = direction[i] != 0.0f ? 1.0f / direction[i] : 1e30f;
+   }
+   this->maxDistance = maxDistance;
+}
+
+float IntersectRayBox( const Ray &ray, const float minEdge[3], const float maxEdge[3], const float maxDistance )
+{
+   float tNear = 0.0f;
+   float tFar = maxDistance;
+   for ( int32 i = 0; i < 3; i++ )
+   {
+      float t0 = ( minEdge[i] - ray.origin[i] ) * ray.invDirection[i];
+      float t1 = ( maxEdge[i] - ray.origin[i] ) * ray.invDirection[i];
+      if ( t0 > t1 )
+         Swap( t0, t1 );
+      if ( t0 > tNear )
+         tNear = t0;
+      if ( t1 < tFar )
+         tFar = t1;
+      if ( tNear > tFar )
+         return -1.0f;
+   }
+   return tNear;
+}
+
+bool IntersectRayTriangle( const Ray &ray, const float *p0, const float *p1, const float *p2, float &distance, float &u, float &v )
+{
+   const float e1[3] = { p1[X] - p0[X], p1[Y] - p0[Y], p1[Z] - p0[Z] };
+   const float e2[3] = { p2[X] - p0[X], p2[Y] - p0[Y], p2[Z] - p0[Z] };
+   const float *d = ray.direction;
+   const float p[3] = { d[Y] * e2[Z] - d[Z] * e2[Y], d[Z] * e2[X] - d[X] * e2[Z], d[X] * e2[Y] - d[Y] * e2[X] };
+   const float det = e1[X] * p[X] + e1[Y] * p[Y] + e1[Z] * p[Z];
+   // parallel to the triangle
+   if ( fabsf( det ) < 1e-12f )
+      return false;
+
+   const float invDet = 1.0f / det;
+   const float s[3] = { ray.origin[X] - p0[X], ray.origin[Y] - p0[Y], ray.origin[Z] - p0[Z] };
+   const float hitU = ( s[X] * p[X] + s[Y] * p[Y] + s[Z] * p[Z] ) * invDet;
+   if ( hitU < 0.0f || hitU > 1.0f )
+      return false;
+
+   const float q[3] = { s[Y] * e1[Z] - s[Z] * e1[Y], s[Z] * e1[X] - s[X] * e1[Z], s[X] * e1[Y] - s[Y] * e1[X] };
+   const float hitV = ( d[X] * q[X] + d[Y] * q[Y] + d[Z] * q[Z] ) * invDet;
+   if ( hitV < 0.0f || hitU + hitV > 1.0f )
+      return false;
+
+   const float t = ( e2[X] * q[X] + e2[Y] * q[Y] + e2[Z] * q[Z] ) * invDet;
+   if ( t < 0.0f || t >= distance )
+      return false;
+
+   distance = t;
+   u = hitU;
+   v = hitV;
+   return true;
+}
+
+static float HalfArea( const float minEdge[3], const float maxEdge[3] )
+{
+   const float dx = maxEdge[X] - minEdge[X];
+   const float dy = maxEdge[Y] - minEdge[Y];
+   const float dz = maxEdge[Z] - minEdge[Z];
+   return dx * dy + dy * dz + dz * dx;
+}
+
+static void ResetBounds( float minEdge[3], float maxEdge[3] )
+{
+   for ( int32 i = 0; i < 3; i++ )
+   {
+      minEdge[i] = FLT_MAX;
+      maxEdge[i] = -FLT_MAX;
+   }
+}
+
+static void GrowBounds( float minEdge[3], float maxEdge[3], const float otherMin[3], const float otherMax[3] )
+{
+   for ( int32 i = 0; i < 3; i++ )
+   {
+      if ( otherMin[i] < minEdge[i] )
+         minEdge[i] = otherMin[i];
+      if ( otherMax[i] > maxEdge[i] )
+         maxEdge[i] = otherMax[i];
+   }
+}
+
+static bool Overlaps( const float minA[3], const float maxA[3], const float minB[3], const float maxB[3] )
+{
+   return minA[X] <= maxB[X] && minA[Y] <= maxB[Y] && minA[Z] <= maxB[Z] &&
+      maxA[X] >= minB[X] && maxA[Y] >= minB[Y] && maxA[Z] >= minB[Z];
+}
+
+Bvh::Bvh()
+{
+   numPrims = 0;
+}
+
+void Bvh::Clear()
+{
+   nodes.clear();
+   primIndices.clear();
+   numPrims = 0;
+}
+
+void Bvh::SetNodeBounds( BvhNode &node, const AABBox_f *boxes ) const
+{
+   ResetBounds( node.minEdge, node.maxEdge );
+   for ( uint32 i = 0; i < node.count; i++ )
+   {
+      const AABBox_f &box = boxes[primIndices[node.leftFirst + i]];
+      GrowBounds( node.minEdge, node.maxEdge, box.GetMinEdge().Ptr(), box.GetMaxEdge().Ptr() );
+   }
+}
+
+namespace
+{
+
+struct BuildItem
+{
+   uint32 node;
+   uint32 depth;
+};
+
+struct Bin
+{
+   float minEdge[3];
+   float maxEdge[3];
+   uint32 count;
+};
+
+}
+
+void Bvh::Build( const AABBox_f *boxes, const uint32 count, const uint32 maxLeafSize )
+{
+   Clear();
+   if ( count == 0 )
+      return;
+
+   const uint32 leafSize = maxLeafSize > 0 ? maxLeafSize : 1;
+   numPrims = count;
+   primIndices.resize( count );
+   std::vector<float> centroids( count * 3 );
+   for ( uint32 i = 0; i < count; i++ )
+   {
+      primIndices[i] = i;
+      const Point3f &min = boxes[i].GetMinEdge();
+      const Point3f &max = boxes[i].GetMaxEdge();
+      centroids[i * 3 + X] = ( min[X] + max[X] ) * 0.5f;
+      centroids[i * 3 + Y] = ( min[Y] + max[Y] ) * 0.5f;
+      centroids[i * 3 + Z] = ( min[Z] + max[Z] ) * 0.5f;
+   }
+
+   // a binary tree with one primitive per leaf has 2n - 1 nodes, so node references stay valid
+   nodes.reserve( count * 2 - 1 );
+   nodes.resize( 1 );
+   nodes[0].leftFirst = 0;
+   nodes[0].count = count;
+
+   std::vector<BuildItem> stack;
+   BuildItem root = { 0, 0 };
+   stack.push_back( root );
+
+   Bin bins[NUM_BINS];
+   float rightArea[NUM_BINS];
+   uint32 rightCount[NUM_BINS];
+
+   while ( !stack.empty() )
+   {
+      const BuildItem item = stack.back();
+      stack.pop_back();
+
+      BvhNode &node = nodes[item.node];
+      SetNodeBounds( node, boxes );
+
+      const uint32 first = node.leftFirst;
+      const uint32 numNodePrims = node.count;
+      if ( numNodePrims <= 1 || item.depth + 1 >= BVH_MAX_DEPTH )
+         continue;
+
+      float centroidMin[3], centroidMax[3];
+      ResetBounds( centroidMin, centroidMax );
+      for ( uint32 i = first; i < first + numNodePrims; i++ )
+      {
+         const float *c = &centroids[primIndices[i] * 3];
+         GrowBounds( centroidMin, centroidMax, c, c );
+      }
+
+      // best split over all axes, the split lies between bin splitBin and splitBin + 1
+      int32 splitAxis = -1;
+      uint32 splitBin = 0;
+      float splitCost = FLT_MAX;
+      for ( int32 axis = 0; axis < 3; axis++ )
+      {
+         const float extent = centroidMax[axis] - centroidMin[axis];
+         if ( extent <= 0.0f )
+            continue;
+         const float scale = NUM_BINS / extent;
+
+         for ( uint32 b = 0; b < NUM_BINS; b++ )
+         {
+            ResetBounds( bins[b].minEdge, bins[b].maxEdge );
+            bins[b].count = 0;
+         }
+         for ( uint32 i = first; i < first + numNodePrims; i++ )
+         {
+            const uint32 prim = primIndices[i];
+            uint32 b = (uint32)( ( centroids[prim * 3 + axis] - centroidMin[axis] ) * scale );
+            if ( b >= NUM_BINS )
+               b = NUM_BINS - 1;
+            bins[b].count++;
+            GrowBounds( bins[b].minEdge, bins[b].maxEdge, boxes[prim].GetMinEdge().Ptr(), boxes[prim].GetMaxEdge().Ptr() );
+         }
+
+         // sweep from the right, then from the left evaluating every split
+         float sweepMin[3], sweepMax[3];
+         ResetBounds( sweepMin, sweepMax );
+         uint32 sweepCount = 0;
+         for ( uint32 b = NUM_BINS - 1; b > 0; b-- )
+         {
+            GrowBounds( sweepMin, sweepMax, bins[b].minEdge, bins[b].maxEdge );
+            sweepCount += bins[b].count;
+            rightArea[b] = sweepCount ? HalfArea( sweepMin, sweepMax ) : 0.0f;
+            rightCount[b] = sweepCount;
+         }
+
+         ResetBounds( sweepMin, sweepMax );
+         sweepCount = 0;
+         for ( uint32 b = 0; b < NUM_BINS - 1; b++ )
+         {
+            GrowBounds( sweepMin, sweepMax, bins[b].minEdge, bins[b].maxEdge );
+            sweepCount += bins[b].count;
+            if ( sweepCount == 0 || rightCount[b + 1] == 0 )
+               continue;
+            const float cost = sweepCount * HalfArea( sweepMin, sweepMax ) + rightCount[b + 1] * rightArea[b + 1];
+            if ( cost < splitCost )
+            {
+               splitCost = cost;
+               splitAxis = axis;
+               splitBin = b;
+            }
+         }
+      }
+
+      uint32 mid;
+      if ( splitAxis < 0 )
+      {
+         // every centroid in one spot, only split up leaves that are too big
+         if ( numNodePrims <= leafSize )
+            continue;
+         mid = first + numNodePrims / 2;
+      }
+      else
+      {
+         const float nodeArea = HalfArea( node.minEdge, node.maxEdge );
+         if ( numNodePrims <= leafSize && TRAVERSAL_COST * nodeArea + splitCost >= numNodePrims * nodeArea )
+            continue;
+
+         const float scale = NUM_BINS / ( centroidMax[splitAxis] - centroidMin[splitAxis] );
+         uint32 i = first;
+         uint32 j = first + numNodePrims;
+         while ( i < j )
+         {
+            uint32 b = (uint32)( ( centroids[primIndices[i] * 3 + splitAxis] - centroidMin[splitAxis] ) * scale );
+            if ( b >= NUM_BINS )
+               b = NUM_BINS - 1;
+            if ( b <= splitBin )
+               i++;
+            else
+               Swap( primIndices[i], primIndices[--j] );
+         }
+         mid = i;
+         if ( mid == first || mid == first + numNodePrims )
+            mid = first + numNodePrims / 2;
+      }
+
+      const uint32 left = (uint32)nodes.size();
+      nodes.resize( left + 2 );
+      node.leftFirst = left;
+      node.count = 0;
+      nodes[left].leftFirst = first;
+      nodes[left].count = mid - first;
+      nodes[left + 1].leftFirst = mid;
+      nodes[left + 1].count = first + numNodePrims - mid;
+
+      BuildItem child = { left + 1, item.depth + 1 };
+      stack.push_back( child );
+      child.node = left;
+      stack.push_back( child );
+   }
+}
+
+void Bvh::Refit( const AABBox_f *boxes )
+{
+   // children come after their parents, walking backwards updates every child before its parent
+   for ( uint32 i = (uint32)nodes.size(); i-- > 0; )
+   {
+      BvhNode &node = nodes[i];
+      if ( node.IsLeaf() )
+      {
+         SetNodeBounds( node, boxes );
+         continue;
+      }
+
+      const BvhNode &left = nodes[node.leftFirst];
+      const BvhNode &right = nodes[node.leftFirst + 1];
+      for ( int32 k = 0; k < 3; k++ )
+      {
+         node.minEdge[k] = left.minEdge[k] < right.minEdge[k] ? left.minEdge[k] : right.minEdge[k];
+         node.maxEdge[k] = left.maxEdge[k] > right.maxEdge[k] ? left.maxEdge[k] : right.maxEdge[k];
+      }
+   }
+}
+
+void Bvh::AddSubtree( const uint32 nodeIndex, std::vector<uint32> &out ) const
+{
+   uint32 stack[BVH_MAX_DEPTH];
+   uint32 stackSize = 0;
+   stack[stackSize++] = nodeIndex;
+   while ( stackSize > 0 )
+   {
+      const BvhNode &node = nodes[stack[--stackSize]];
+      if ( node.IsLeaf() )
+      {
+         out.insert( out.end(), primIndices.begin() + node.leftFirst, primIndices.begin() + node.leftFirst + node.count );
+         continue;
+      }
+      stack[stackSize++] = node.leftFirst + 1;
+      stack[stackSize++] = node.leftFirst;
+   }
+}
+
+void Bvh::QueryFrustum( const culling::FrustumPlanes &planes, const AABBox_f *boxes, std::vector<uint32> &out ) const
+{
+   if ( nodes.empty() )
+      return;
+
+   uint32 stack[BVH_MAX_DEPTH];
+   uint32 stackMask[BVH_MAX_DEPTH];
+   uint32 stackSize = 0;
+   stack[stackSize] = 0;
+   stackMask[stackSize] = CULL_ALL_PLANES;
+   stackSize++;
+
+   // the plane that culled the last node is tried first, neighbouring nodes tend to share it
+   uint32 lastPlane = 0;
+   while ( stackSize > 0 )
+   {
+      stackSize--;
+      const uint32 nodeIndex = stack[stackSize];
+      const BvhNode &node = nodes[nodeIndex];
+      uint32 planeMask = stackMask[stackSize];
+
+      const float center[3] = { ( node.minEdge[X] + node.maxEdge[X] ) * 0.5f,
+         ( node.minEdge[Y] + node.maxEdge[Y] ) * 0.5f, ( node.minEdge[Z] + node.maxEdge[Z] ) * 0.5f };
+      const float extent[3] = { ( node.maxEdge[X] - node.minEdge[X] ) * 0.5f,
+         ( node.maxEdge[Y] - node.minEdge[Y] ) * 0.5f, ( node.maxEdge[Z] - node.minEdge[Z] ) * 0.5f };
+      const eCullResult result = CullBox( planes, center, extent, planeMask, lastPlane );
+      if ( result == CULL_OUTSIDE )
+         continue;
+      if ( result == CULL_INSIDE )
+      {
+         AddSubtree( nodeIndex, out );
+         continue;
+      }
+
+      if ( node.IsLeaf() )
+      {
+         for ( uint32 i = 0; i < node.count; i++ )
+         {
+            const uint32 prim = primIndices[node.leftFirst + i];
+            uint32 primMask = planeMask;
+            if ( CullBox( planes, boxes[prim], primMask, lastPlane ) != CULL_OUTSIDE )
+               out.push_back( prim );
+         }
+         continue;
+      }
+
+      stack[stackSize] = node.leftFirst + 1;
+      stackMask[stackSize] = planeMask;
+      stackSize++;
+      stack[stackSize] = node.leftFirst;
+      stackMask[stackSize] = planeMask;
+      stackSize++;
+   }
+}
+
+void Bvh::QueryBox( const AABBox_f &box, const AABBox_f *boxes, std::vector<uint32> &out ) const
+{
+   if ( nodes.empty() )
+      return;
+
+   const float *boxMin = box.GetMinEdge().Ptr();
+   const float *boxMax = box.GetMaxEdge().Ptr();
+   uint32 stack[BVH_MAX_DEPTH];
+   uint32 stackSize = 0;
+   stack[stackSize++] = 0;
+   while ( stackSize > 0 )
+   {
+      const BvhNode &node = nodes[stack[--stackSize]];
+      if ( !Overlaps( node.minEdge, node.maxEdge, boxMin, boxMax ) )
+         continue;
+
+      if ( node.IsLeaf() )
+      {
+         for ( uint32 i = 0; i < node.count; i++ )
+         {
+            const uint32 prim = primIndices[node.leftFirst + i];
+            if ( boxes[prim].IntersectsWith( box ) )
+               out.push_back( prim );
+         }
+         continue;
+      }
+      stack[stackSize++] = node.leftFirst + 1;
+      stack[stackSize++] = node.leftFirst;
+   }
+}
+
+void Bvh::QueryRay( const Ray &ray, const AABBox_f *boxes, std::vector<uint32> &out ) const
+{
+   if ( nodes.empty() )
+      return;
+
+   uint32 stack[BVH_MAX_DEPTH];
+   uint32 stackSize = 0;
+   stack[stackSize++] = 0;
+   while ( stackSize > 0 )
+   {
+      const BvhNode &node = nodes[stack[--stackSize]];
+      if ( IntersectRayBox( ray, node.minEdge, node.maxEdge, ray.maxDistance ) < 0.0f )
+         continue;
+
+      if ( node.IsLeaf() )
+      {
+         for ( uint32 i = 0; i < node.count; i++ )
+         {
+            const uint32 prim = primIndices[node.leftFirst + i];
+            if ( IntersectRayBox( ray, boxes[prim].GetMinEdge().Ptr(), boxes[prim].GetMaxEdge().Ptr(), ray.maxDistance ) >= 0.0f )
+               out.push_back( prim );
+         }
+         continue;
+      }
+      stack[stackSize++] = node.leftFirst + 1;
+      stack[stackSize++] = node.leftFirst;
+   }
+}
+
+namespace
+{
+
+struct BoxIntersector
+{
+   const AABBox_f *boxes;
+
+   bool operator()( const uint32 prim, const Ray &ray, float &distance ) const
+   {
+      const float t = IntersectRayBox( ray, boxes[prim].GetMinEdge().Ptr(), boxes[prim].GetMaxEdge().Ptr(), distance );
+      if ( t < 0.0f || t >= distance )
+         return false;
+      distance = t;
+      return true;
+   }
+};
+
+struct TriangleIntersector
+{
+   const float *positions;
+   const uint32 *indices;
+   float u, v;
+
+   bool operator()( const uint32 prim, const Ray &ray, float &distance )
+   {
+      const uint32 *tri = indices + prim * 3;
+      return IntersectRayTriangle( ray, positions + tri[0] * 3, positions + tri[1] * 3, positions + tri[2] * 3, distance, u, v );
+   }
+};
+
+}
+
+bool Bvh::PickBox( const Ray &ray, const AABBox_f *boxes, uint32 &hitPrim, float &hitDistance ) const
+{
+   BoxIntersector intersector;
+   intersector.boxes = boxes;
+   return Raycast( ray, intersector, hitPrim, hitDistance );
+}
+
+AABBox_f Bvh::GetBounds() const
+{
+   if ( nodes.empty() )
+      return AABBox_f( 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f );
+   const BvhNode &root = nodes[0];
+   return AABBox_f( root.minEdge[X], root.minEdge[Y], root.minEdge[Z], root.maxEdge[X], root.maxEdge[Y], root.maxEdge[Z] );
+}
+
+void TriangleBvh::Clear()
+{
+   bvh.Clear();
+   positions.clear();
+   indices.clear();
+   triangleBoxes.clear();
+}
+
+void TriangleBvh::CalcTriangleBoxes()
+{
+   const uint32 numTriangles = GetNumTriangles();
+   triangleBoxes.resize( numTriangles );
+   for ( uint32 t = 0; t < numTriangles; t++ )
+   {
+      const float *p0 = &positions[indices[t * 3] * 3];
+      const float *p1 = &positions[indices[t * 3 + 1] * 3];
+      const float *p2 = &positions[indices[t * 3 + 2] * 3];
+      triangleBoxes[t].Reset( p0[X], p0[Y], p0[Z] );
+      triangleBoxes[t].AddInternalPoint( p1[X], p1[Y], p1[Z] );
+      triangleBoxes[t].AddInternalPoint( p2[X], p2[Y], p2[Z] );
+   }
+}
+
+void TriangleBvh::Build( const float *positions, const uint32 numVertices, const uint32 *indices, const uint32 numTriangles, const uint32 maxLeafSize )
+{
+   Clear();
+   if ( numTriangles == 0 )
+      return;
+
+   this->positions.assign( positions, positions + numVertices * 3 );
+   this->indices.assign( indices, indices + numTriangles * 3 );
+   CalcTriangleBoxes();
+   bvh.Build( &triangleBoxes[0], numTriangles, maxLeafSize );
+}
+
+void TriangleBvh::Refit( const float *positions )
+{
+   if ( indices.empty() )
+      return;
+
+   memcpy( &this->positions[0], positions, this->positions.size() * sizeof(float) );
+   CalcTriangleBoxes();
+   bvh.Refit( &triangleBoxes[0] );
+}
+
+bool TriangleBvh::Raycast( const Ray &ray, TriangleHit &hit ) const
+{
+   if ( indices.empty() )
+      return false;
+
+   TriangleIntersector intersector;
+   intersector.positions = &positions[0];
+   intersector.indices = &indices[0];
+   intersector.u = intersector.v = 0.0f;
+
+   // u and v of the closest hit are the ones of the last accepted hit, every accepted hit is closer
+   if ( !bvh.Raycast( ray, intersector, hit.triangle, hit.distance ) )
+      return false;
+   hit.u = intersector.u;
+   hit.v = intersector.v;
+   return true;
+}
+
+void TriangleBvh::QueryBox( const AABBox_f &box, std::vector<uint32> &out ) const
+{
+   if ( !triangleBoxes.empty() )
+      bvh.QueryBox( box, &triangleBoxes[0], out );
+}
+
+void TriangleBvh::QueryFrustum( const culling::FrustumPlanes &planes, std::vector<uint32> &out ) const
+{
+   if ( !triangleBoxes.empty() )
+      bvh.QueryFrustum( planes, &triangleBoxes[0], out );
+}
+
+} // namespace bvh
+
+} // namespace math
+
+} // namespace core
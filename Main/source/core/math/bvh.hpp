@@ -0,0 +1,222 @@
+#ifndef _BVH_HPP_INCLUDED_
+#define _BVH_HPP_INCLUDED_
+
+#include <vector>
+
+#include "aabbox.hpp"
+#include "culling.hpp"
+
+namespace core
+{
+
+namespace math
+{
+
+namespace bvh
+{
+
+// 32 bytes, two nodes per cache line. The children of an inner node are stored next to
+// each other, the right child is leftFirst + 1. Children always come after their parent
+struct BvhNode
+{
+   float minEdge[3];
+   uint32 leftFirst; // first child for inner nodes, first primitive index for leaves
+   float maxEdge[3];
+   uint32 count; // number of primitives of a leaf, 0 for inner nodes
+
+   bool IsLeaf() const { return count != 0; }
+};
+
+// Build stops splitting at this depth, so the traversal stacks can not overflow
+const uint32 BVH_MAX_DEPTH = 64;
+
+// a ray with the reciprocal direction precomputed for the slab tests
+struct Ray
+{
+   float origin[3];
+   float direction[3];
+   float invDirection[3];
+   float maxDistance;
+
+   Ray() {}
+   // direction does not need to be unit length, distances are in multiples of it
+   Ray( const Point3f &origin, const Point3f &direction, const float maxDistance );
+};
+
+// slab test, returns the distance where the ray enters the box or a negative value on a miss
+float IntersectRayBox( const Ray &ray, const float minEdge[3], const float maxEdge[3], const float maxDistance );
+
+// Bounding volume hierarchy over a set of boxes. The primitives are only referenced by index,
+// the BVH never stores or owns them. Built top down with a binned surface area heuristic and
+// flattened into one node array, the queries walk it with a small explicit stack.
+//
+// Moving objects can be handled with Refit, which keeps the tree and only recomputes the
+// node bounds. The tree gets worse the further the objects move from where they were at
+// Build, rebuild it every now and then
+class Bvh
+{
+private:
+   std::vector<BvhNode> nodes;
+   std::vector<uint32> primIndices; // leaves point into this, grouped per leaf
+   uint32 numPrims;
+
+   void SetNodeBounds( BvhNode &node, const AABBox_f *boxes ) const;
+   void AddSubtree( const uint32 nodeIndex, std::vector<uint32> &out ) const;
+public:
+   Bvh();
+
+   void Clear();
+   // build over count boxes, primitive i is boxes[i]. Leaves hold at most maxLeafSize
+   // primitives, less when the SAH finds splitting them cheaper
+   void Build( const AABBox_f *boxes, const uint32 count, const uint32 maxLeafSize = 4 );
+   // recompute the node bounds after the boxes moved, boxes has to hold the same primitives as at Build
+   void Refit( const AABBox_f *boxes );
+
+   // The queries append the indices of the primitives they find to out. boxes are the primitive
+   // boxes of the last Build or Refit, leaves test them so the results are exact per box
+   // primitives whose box is inside or intersects the frustum. Subtrees completely inside are
+   // added without further tests and planes a node is inside of are not tested for its children
+   void QueryFrustum( const culling::FrustumPlanes &planes, const AABBox_f *boxes, std::vector<uint32> &out ) const;
+   // primitives whose box overlaps box
+   void QueryBox( const AABBox_f &box, const AABBox_f *boxes, std::vector<uint32> &out ) const;
+   // primitives whose box is hit by the ray, in no particular order
+   void QueryRay( const Ray &ray, const AABBox_f *boxes, std::vector<uint32> &out ) const;
+
+   // Closest hit along the ray. The nodes are visited front to back and nodes beyond the
+   // closest hit so far are skipped. The intersector decides what a hit is:
+   //    bool operator()( const uint32 primIndex, const Ray &ray, float &distance )
+   // distance holds the closest hit so far, when the primitive is hit closer it updates it
+   // and returns true. Returns the primitive of the closest hit or false if nothing was hit
+   template <class TIntersector>
+   bool Raycast( const Ray &ray, TIntersector &intersector, uint32 &hitPrim, float &hitDistance ) const;
+
+   // closest primitive box hit by the ray, picking against the bounds only
+   bool PickBox( const Ray &ray, const AABBox_f *boxes, uint32 &hitPrim, float &hitDistance ) const;
+
+   uint32 GetNumNodes() const { return (uint32)nodes.size(); }
+   uint32 GetNumPrimitives() const { return numPrims; }
+   const BvhNode *GetNodes() const { return nodes.empty() ? NULL : &nodes[0]; }
+   // the primitives in leaf order, primitives that are close in space are close in this list
+   const uint32 *GetPrimitiveIndices() const { return primIndices.empty() ? NULL : &primIndices[0]; }
+   // bounds of everything, empty BVHs return a zero box
+   AABBox_f GetBounds() const;
+};
+
+template <class TIntersector>
+bool Bvh::Raycast( const Ray &ray, TIntersector &intersector, uint32 &hitPrim, float &hitDistance ) const
+{
+   hitDistance = ray.maxDistance;
+   if ( nodes.empty() || IntersectRayBox( ray, nodes[0].minEdge, nodes[0].maxEdge, hitDistance ) < 0.0f )
+      return false;
+
+   bool hit = false;
+   uint32 stack[BVH_MAX_DEPTH];
+   float stackDistance[BVH_MAX_DEPTH];
+   uint32 stackSize = 0;
+   uint32 nodeIndex = 0;
+
+   for (;;)
+   {
+      const BvhNode &node = nodes[nodeIndex];
+      if ( node.IsLeaf() )
+      {
+         for ( uint32 i = 0; i < node.count; i++ )
+         {
+            const uint32 prim = primIndices[node.leftFirst + i];
+            if ( intersector( prim, ray, hitDistance ) )
+            {
+               hitPrim = prim;
+               hit = true;
+            }
+         }
+      }
+      else
+      {
+         const BvhNode &left = nodes[node.leftFirst];
+         const BvhNode &right = nodes[node.leftFirst + 1];
+         float leftDistance = IntersectRayBox( ray, left.minEdge, left.maxEdge, hitDistance );
+         float rightDistance = IntersectRayBox( ray, right.minEdge, right.maxEdge, hitDistance );
+         uint32 nearChild = node.leftFirst;
+         uint32 farChild = node.leftFirst + 1;
+         if ( rightDistance >= 0.0f && ( leftDistance < 0.0f || rightDistance < leftDistance ) )
+         {
+            Swap( nearChild, farChild );
+            Swap( leftDistance, rightDistance );
+         }
+
+         if ( leftDistance >= 0.0f )
+         {
+            if ( rightDistance >= 0.0f )
+            {
+               stack[stackSize] = farChild;
+               stackDistance[stackSize] = rightDistance;
+               stackSize++;
+            }
+            nodeIndex = nearChild;
+            continue;
+         }
+      }
+
+      // pop the next node that is still in front of the closest hit
+      bool found = false;
+      while ( stackSize > 0 )
+      {
+         stackSize--;
+         if ( stackDistance[stackSize] <= hitDistance )
+         {
+            nodeIndex = stack[stackSize];
+            found = true;
+            break;
+         }
+      }
+      if ( !found )
+         break;
+   }
+
+   return hit;
+}
+
+struct TriangleHit
+{
+   uint32 triangle;
+   float distance;
+   float u, v; // barycentric coordinates of the hit, weights of the second and third corner
+};
+
+// BVH over an indexed triangle list, for ray picking and overlap queries against meshes.
+// The positions and indices are copied, Refit takes new positions for deforming meshes
+class TriangleBvh
+{
+private:
+   Bvh bvh;
+   std::vector<float> positions; // x, y, z per vertex
+   std::vector<uint32> indices; // three per triangle
+   std::vector<AABBox_f> triangleBoxes;
+
+   void CalcTriangleBoxes();
+public:
+   void Clear();
+   void Build( const float *positions, const uint32 numVertices, const uint32 *indices, const uint32 numTriangles, const uint32 maxLeafSize = 4 );
+   // same vertex count and triangles as at Build, only the positions changed
+   void Refit( const float *positions );
+
+   // closest triangle hit by the ray, both sides of a triangle count
+   bool Raycast( const Ray &ray, TriangleHit &hit ) const;
+   // triangles whose bounds overlap box
+   void QueryBox( const AABBox_f &box, std::vector<uint32> &out ) const;
+   void QueryFrustum( const culling::FrustumPlanes &planes, std::vector<uint32> &out ) const;
+
+   uint32 GetNumTriangles() const { return (uint32)indices.size() / 3; }
+   const Bvh &GetBvh() const { return bvh; }
+};
+
+// Moller-Trumbore, distance is the closest hit so far and is updated on a closer hit
+bool IntersectRayTriangle( const Ray &ray, const float *p0, const float *p1, const float *p2, float &distance, float &u, float &v );
+
+} // namespace bvh
+
+} // namespace math
+
+} // namespace core
+
+#endif
@@ -1,5 +1,12 @@
 #include "core/math/camera.hpp"
 
+using core::math::Point3f;
+using core::math::AABBox_f;
+using core::math::X;
+using core::math::Y;
+using core::math::Z;
+namespace culling = core::math::culling;
+
 namespace camera
 {
 
@@ -78,6 +85,7 @@ namespace camera
          right[2], _up[2], -forward[2], 0.0,
          0.0, 0.0, 0.0, 1.0);
 
+      CalcFrustumPlanes();
       isDirty = false;
    }//UPDATE
 
@@ -103,6 +111,41 @@ namespace camera
 
 
 
+    void AbstractCamera::CalcFrustumPlanes()
+    {
+       culling::ExtractFrustumPlanes(projMatrix * viewMatrix, frustumPlanes);
+
+       Point3f corners[8];
+       culling::CalcFrustumCorners(frustumPlanes, corners);
+       for (int32 i = 0; i < 4; i++)
+       {
+          nearPts[i].Set(corners[i][X], corners[i][Y], corners[i][Z]);
+          farPts[i].Set(corners[i + 4][X], corners[i + 4][Y], corners[i + 4][Z]);
+       }
+    }
+
+    bool AbstractCamera::IsPointInFrustum(const Vector3f &point)
+    {
+       return culling::IsPointInside(frustumPlanes, point);
+    }
+
+    bool AbstractCamera::IsSphereInFrustum(const Vector3f &center, const float radius)
+    {
+       return culling::CullSphere(frustumPlanes, center, radius) != culling::CULL_OUTSIDE;
+    }
+
+    bool AbstractCamera::IsBoxInFrustum(const Vector3f &min, const Vector3f &max)
+    {
+       uint32 planeMask = culling::CULL_ALL_PLANES, lastPlane = 0;
+       return culling::CullBox(frustumPlanes, AABBox_f(min, max), planeMask, lastPlane) != culling::CULL_OUTSIDE;
+    }
+
+    void AbstractCamera::GetFrustumPlanes(Vector4f planes[6])
+    {
+       for (int32 i = 0; i < 6; i++)
+          planes[i].Set(frustumPlanes.nx[i], frustumPlanes.ny[i], frustumPlanes.nz[i], frustumPlanes.d[i]);
+    }
+
     void FreeCamera::SetTranslation(const Vector3f &t)
     {
          translation += t; 
@@ -1,6 +1,7 @@
 #include "vector3.hpp"
 #include "matrix4.hpp"
 #include "quaternion.hpp"
+#include "culling.hpp"
 using core::math::Vector3f;
 using core::math::Vector4f;
 using core::math::Matrix4f;
@@ -76,7 +77,7 @@ namespace camera
       Vector3f position;
       Matrix4f viewMatrix; //view matrix
       Matrix4f projMatrix; //projection matrix
-      //Plane_f planes[6]; //Frustum planes
+      core::math::culling::FrustumPlanes frustumPlanes; // world space, updated by CalcFrustumPlanes
 
       bool IsDirty() { return isDirty; }
       void SetupProjection(const float fovy, const float aspectRatio);
@@ -94,6 +95,7 @@ namespace camera
       const float GetAspectRatio() const { return aspectRatio; }
 
 
+      // extract the planes and corners from projMatrix * viewMatrix
       void CalcFrustumPlanes();
       bool IsPointInFrustum(const Vector3f &point);
       bool IsSphereInFrustum(const Vector3f &center, const float
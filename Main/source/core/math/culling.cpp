@@ -0,0 +1,481 @@
+#include "culling.hpp"
+
+#include <float.h>
+#include <intrin.h>
+#include <string.h>
+
+namespace core
+{
+
+namespace math
+{
+
+namespace culling
+{
+
+using frustum::FRUSTUM_FAR_PLANE;
+using frustum::FRUSTUM_NEAR_PLANE;
+using frustum::FRUSTUM_LEFT_PLANE;
+using frustum::FRUSTUM_RIGHT_PLANE;
+using frustum::FRUSTUM_BOTTOM_PLANE;
+using frustum::FRUSTUM_TOP_PLANE;
+
+static void SetPlane( FrustumPlanes &out, const int32 plane, const float a, const float b, const float c, const float d )
+{
+   const float length = sqrtf( a * a + b * b + c * c );
+   const float inv = length > 0.0f ? 1.0f / length : 0.0f;
+   out.nx[plane] = a * inv;
+   out.ny[plane] = b * inv;
+   out.nz[plane] = c * inv;
+   out.d[plane] = d * inv;
+}
+
+void ExtractFrustumPlanes( const Matrix4f &m, FrustumPlanes &out )
+{
+   // row 3 plus or minus one of the other rows, the clip space test -w <= x <= w and so on
+   SetPlane( out, FRUSTUM_LEFT_PLANE, m(3, 0) + m(0, 0), m(3, 1) + m(0, 1), m(3, 2) + m(0, 2), m(3, 3) + m(0, 3) );
+   SetPlane( out, FRUSTUM_RIGHT_PLANE, m(3, 0) - m(0, 0), m(3, 1) - m(0, 1), m(3, 2) - m(0, 2), m(3, 3) - m(0, 3) );
+   SetPlane( out, FRUSTUM_BOTTOM_PLANE, m(3, 0) + m(1, 0), m(3, 1) + m(1, 1), m(3, 2) + m(1, 2), m(3, 3) + m(1, 3) );
+   SetPlane( out, FRUSTUM_TOP_PLANE, m(3, 0) - m(1, 0), m(3, 1) - m(1, 1), m(3, 2) - m(1, 2), m(3, 3) - m(1, 3) );
+   SetPlane( out, FRUSTUM_NEAR_PLANE, m(3, 0) + m(2, 0), m(3, 1) + m(2, 1), m(3, 2) + m(2, 2), m(3, 3) + m(2, 3) );
+   SetPlane( out, FRUSTUM_FAR_PLANE, m(3, 0) - m(2, 0), m(3, 1) - m(2, 1), m(3, 2) - m(2, 2), m(3, 3) - m(2, 3) );
+}
+
+// the point where three planes meet, the frustum planes never are parallel
+static Point3f IntersectPlanes( const FrustumPlanes &planes, const int32 p1, const int32 p2, const int32 p3 )
+{
+   const Vector3f n1( planes.nx[p1], planes.ny[p1], planes.nz[p1] );
+   const Vector3f n2( planes.nx[p2], planes.ny[p2], planes.nz[p2] );
+   const Vector3f n3( planes.nx[p3], planes.ny[p3], planes.nz[p3] );
+
+   const Vector3f c23 = n2.CrossProd( n3 );
+   const Vector3f c31 = n3.CrossProd( n1 );
+   const Vector3f c12 = n1.CrossProd( n2 );
+   const float invDenom = -1.0f / ( n1 * c23 );
+
+   return Point3f(
+      ( planes.d[p1] * c23[X] + planes.d[p2] * c31[X] + planes.d[p3] * c12[X] ) * invDenom,
+      ( planes.d[p1] * c23[Y] + planes.d[p2] * c31[Y] + planes.d[p3] * c12[Y] ) * invDenom,
+      ( planes.d[p1] * c23[Z] + planes.d[p2] * c31[Z] + planes.d[p3] * c12[Z] ) * invDenom );
+}
+
+void CalcFrustumCorners( const FrustumPlanes &planes, Point3f corners[8] )
+{
+   for ( int32 i = 0; i < 8; i++ )
+   {
+      corners[i] = IntersectPlanes( planes,
+         i & 1 ? FRUSTUM_RIGHT_PLANE : FRUSTUM_LEFT_PLANE,
+         i & 2 ? FRUSTUM_TOP_PLANE : FRUSTUM_BOTTOM_PLANE,
+         i & 4 ? FRUSTUM_FAR_PLANE : FRUSTUM_NEAR_PLANE );
+   }
+}
+
+eCullResult CullBox( const FrustumPlanes &planes, const float center[3], const float extent[3], uint32 &planeMask, uint32 &lastPlane )
+{
+   if ( lastPlane > 5 )
+      lastPlane = 0;
+
+   // lastPlane first, then the rest in order
+   for ( int32 k = -1; k < 6; k++ )
+   {
+      const uint32 p = k < 0 ? lastPlane : (uint32)k;
+      if ( ( k >= 0 && p == lastPlane ) || !( planeMask & (1 << p) ) )
+         continue;
+
+      const float dist = planes.nx[p] * center[0] + planes.ny[p] * center[1] + planes.nz[p] * center[2] + planes.d[p];
+      const float radius = fabsf( planes.nx[p] ) * extent[0] + fabsf( planes.ny[p] ) * extent[1] + fabsf( planes.nz[p] ) * extent[2];
+      if ( dist + radius < 0.0f )
+      {
+         lastPlane = p;
+         return CULL_OUTSIDE;
+      }
+      // completely on the inside, nothing below this box has to test the plane again
+      if ( dist - radius >= 0.0f )
+         planeMask &= ~(1 << p);
+   }
+
+   return planeMask ? CULL_INTERSECT : CULL_INSIDE;
+}
+
+eCullResult CullBox( const FrustumPlanes &planes, const AABBox_f &box, uint32 &planeMask, uint32 &lastPlane )
+{
+   const Point3f &min = box.GetMinEdge();
+   const Point3f &max = box.GetMaxEdge();
+   const float center[3] = { (min[X] + max[X]) * 0.5f, (min[Y] + max[Y]) * 0.5f, (min[Z] + max[Z]) * 0.5f };
+   const float extent[3] = { (max[X] - min[X]) * 0.5f, (max[Y] - min[Y]) * 0.5f, (max[Z] - min[Z]) * 0.5f };
+   return CullBox( planes, center, extent, planeMask, lastPlane );
+}
+
+eCullResult CullSphere( const FrustumPlanes &planes, const Point3f &center, const float radius )
+{
+   eCullResult result = CULL_INSIDE;
+   for ( int32 p = 0; p < 6; p++ )
+   {
+      const float dist = planes.nx[p] * center[X] + planes.ny[p] * center[Y] + planes.nz[p] * center[Z] + planes.d[p];
+      if ( dist < -radius )
+         return CULL_OUTSIDE;
+      if ( dist < radius )
+         result = CULL_INTERSECT;
+   }
+   return result;
+}
+
+bool IsPointInside( const FrustumPlanes &planes, const Point3f &point )
+{
+   return CullSphere( planes, point, 0.0f ) != CULL_OUTSIDE;
+}
+
+// grow min/max by the box center +- extent
+static void GrowBounds( float boundsMin[3], float boundsMax[3], const float center[3], const float extent[3] )
+{
+   for ( int32 i = 0; i < 3; i++ )
+   {
+      if ( center[i] - extent[i] < boundsMin[i] )
+         boundsMin[i] = center[i] - extent[i];
+      if ( center[i] + extent[i] > boundsMax[i] )
+         boundsMax[i] = center[i] + extent[i];
+   }
+}
+
+static void ResetBounds( float boundsMin[3], float boundsMax[3] )
+{
+   for ( int32 i = 0; i < 3; i++ )
+   {
+      boundsMin[i] = FLT_MAX;
+      boundsMax[i] = -FLT_MAX;
+   }
+}
+
+// round up to whole groups
+static uint32 PaddedSize( const uint32 count )
+{
+   return (count + CULL_GROUP_SIZE - 1) & ~(CULL_GROUP_SIZE - 1);
+}
+
+BoxArray::BoxArray()
+{
+   Clear();
+}
+
+void BoxArray::Clear()
+{
+   centerX.clear(); centerY.clear(); centerZ.clear();
+   extentX.clear(); extentY.clear(); extentZ.clear();
+   count = 0;
+   ResetBounds( boundsMin, boundsMax );
+}
+
+void BoxArray::Reserve( const uint32 count )
+{
+   const uint32 padded = PaddedSize( count );
+   centerX.reserve( padded ); centerY.reserve( padded ); centerZ.reserve( padded );
+   extentX.reserve( padded ); extentY.reserve( padded ); extentZ.reserve( padded );
+}
+
+uint32 BoxArray::Add( const AABBox_f &box )
+{
+   // a new group is filled with padding boxes, a negative extent can not reach any plane
+   if ( count == centerX.size() )
+   {
+      const uint32 padded = PaddedSize( count + 1 );
+      centerX.resize( padded, 0.0f ); centerY.resize( padded, 0.0f ); centerZ.resize( padded, 0.0f );
+      extentX.resize( padded, -FLT_MAX ); extentY.resize( padded, -FLT_MAX ); extentZ.resize( padded, -FLT_MAX );
+   }
+
+   Set( count, box );
+   return count++;
+}
+
+void BoxArray::Set( const uint32 index, const AABBox_f &box )
+{
+   const Point3f &min = box.GetMinEdge();
+   const Point3f &max = box.GetMaxEdge();
+   const float center[3] = { (min[X] + max[X]) * 0.5f, (min[Y] + max[Y]) * 0.5f, (min[Z] + max[Z]) * 0.5f };
+   const float extent[3] = { (max[X] - min[X]) * 0.5f, (max[Y] - min[Y]) * 0.5f, (max[Z] - min[Z]) * 0.5f };
+
+   centerX[index] = center[0]; centerY[index] = center[1]; centerZ[index] = center[2];
+   extentX[index] = extent[0]; extentY[index] = extent[1]; extentZ[index] = extent[2];
+   GrowBounds( boundsMin, boundsMax, center, extent );
+}
+
+SphereArray::SphereArray()
+{
+   Clear();
+}
+
+void SphereArray::Clear()
+{
+   centerX.clear(); centerY.clear(); centerZ.clear(); radius.clear();
+   count = 0;
+   ResetBounds( boundsMin, boundsMax );
+}
+
+void SphereArray::Reserve( const uint32 count )
+{
+   const uint32 padded = PaddedSize( count );
+   centerX.reserve( padded ); centerY.reserve( padded ); centerZ.reserve( padded ); radius.reserve( padded );
+}
+
+uint32 SphereArray::Add( const Point3f &center, const float radius )
+{
+   if ( count == centerX.size() )
+   {
+      const uint32 padded = PaddedSize( count + 1 );
+      centerX.resize( padded, 0.0f ); centerY.resize( padded, 0.0f ); centerZ.resize( padded, 0.0f );
+      this->radius.resize( padded, -FLT_MAX );
+   }
+
+   Set( count, center, radius );
+   return count++;
+}
+
+void SphereArray::Set( const uint32 index, const Point3f &center, const float radius )
+{
+   centerX[index] = center[X]; centerY[index] = center[Y]; centerZ[index] = center[Z];
+   this->radius[index] = radius;
+
+   const float c[3] = { center[X], center[Y], center[Z] };
+   const float e[3] = { radius, radius, radius };
+   GrowBounds( boundsMin, boundsMax, c, e );
+}
+
+static inline uint32 CountBits( uint32 bits )
+{
+   uint32 n = 0;
+   for ( ; bits; bits &= bits - 1 )
+      n++;
+   return n;
+}
+
+// Objects as seen by the group loop. Both kinds are tested with dist + radius < 0, only the
+// radius differs: the projected half extent of a box, the radius of a sphere
+struct BoxLanes
+{
+   const float *cx, *cy, *cz, *ex, *ey, *ez;
+
+   float Radius( const FrustumPlanes &planes, const uint32 p, const uint32 i ) const
+   {
+      return fabsf( planes.nx[p] ) * ex[i] + fabsf( planes.ny[p] ) * ey[i] + fabsf( planes.nz[p] ) * ez[i];
+   }
+#ifdef CORE_MATH_SSE
+   __m128 Radius( const __m128 *absN, const uint32 i ) const
+   {
+      return _mm_add_ps( _mm_add_ps( _mm_mul_ps( absN[0], _mm_loadu_ps( ex + i ) ), _mm_mul_ps( absN[1], _mm_loadu_ps( ey + i ) ) ),
+         _mm_mul_ps( absN[2], _mm_loadu_ps( ez + i ) ) );
+   }
+#endif
+#ifdef CORE_MATH_AVX
+   __m256 Radius( const __m256 *absN, const uint32 i ) const
+   {
+      return _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( absN[0], _mm256_loadu_ps( ex + i ) ), _mm256_mul_ps( absN[1], _mm256_loadu_ps( ey + i ) ) ),
+         _mm256_mul_ps( absN[2], _mm256_loadu_ps( ez + i ) ) );
+   }
+#endif
+};
+
+struct SphereLanes
+{
+   const float *cx, *cy, *cz, *r;
+
+   float Radius( const FrustumPlanes &, const uint32, const uint32 i ) const { return r[i]; }
+#ifdef CORE_MATH_SSE
+   __m128 Radius( const __m128 *, const uint32 i ) const { return _mm_loadu_ps( r + i ); }
+#endif
+#ifdef CORE_MATH_AVX
+   __m256 Radius( const __m256 *, const uint32 i ) const { return _mm256_loadu_ps( r + i ); }
+#endif
+};
+
+// the culled lanes of the group starting at i as a CULL_GROUP_SIZE bit mask
+template <class TLanes>
+class PlaneTester
+{
+private:
+   const TLanes &lanes;
+#if defined(CORE_MATH_AVX)
+   __m256 n[6][4]; // nx, ny, nz, d
+   __m256 absN[6][3];
+#elif defined(CORE_MATH_SSE)
+   __m128 n[6][4];
+   __m128 absN[6][3];
+#else
+   const FrustumPlanes &planes;
+#endif
+public:
+#if defined(CORE_MATH_AVX) || defined(CORE_MATH_SSE)
+   PlaneTester( const FrustumPlanes &planes, const TLanes &lanes ) : lanes( lanes )
+   {
+      for ( int32 p = 0; p < 6; p++ )
+      {
+         const float values[4] = { planes.nx[p], planes.ny[p], planes.nz[p], planes.d[p] };
+         for ( int32 k = 0; k < 4; k++ )
+         {
+#ifdef CORE_MATH_AVX
+            n[p][k] = _mm256_set1_ps( values[k] );
+            if ( k < 3 )
+               absN[p][k] = _mm256_set1_ps( fabsf( values[k] ) );
+#else
+            n[p][k] = _mm_set1_ps( values[k] );
+            if ( k < 3 )
+               absN[p][k] = _mm_set1_ps( fabsf( values[k] ) );
+#endif
+         }
+      }
+   }
+#else
+   PlaneTester( const FrustumPlanes &planes, const TLanes &lanes ) : lanes( lanes ), planes( planes ) {}
+#endif
+
+   uint32 Outside( const uint32 p, const uint32 i ) const
+   {
+#if defined(CORE_MATH_AVX)
+      __m256 dist = _mm256_add_ps( _mm256_mul_ps( n[p][0], _mm256_loadu_ps( lanes.cx + i ) ), _mm256_mul_ps( n[p][1], _mm256_loadu_ps( lanes.cy + i ) ) );
+      dist = _mm256_add_ps( dist, _mm256_add_ps( _mm256_mul_ps( n[p][2], _mm256_loadu_ps( lanes.cz + i ) ), n[p][3] ) );
+      const __m256 reach = _mm256_add_ps( dist, lanes.Radius( absN[p], i ) );
+      return (uint32)_mm256_movemask_ps( _mm256_cmp_ps( reach, _mm256_setzero_ps(), _CMP_LT_OQ ) );
+#elif defined(CORE_MATH_SSE)
+      uint32 mask = 0;
+      for ( uint32 half = 0; half < 8; half += 4 )
+      {
+         __m128 dist = _mm_add_ps( _mm_mul_ps( n[p][0], _mm_loadu_ps( lanes.cx + i + half ) ), _mm_mul_ps( n[p][1], _mm_loadu_ps( lanes.cy + i + half ) ) );
+         dist = _mm_add_ps( dist, _mm_add_ps( _mm_mul_ps( n[p][2], _mm_loadu_ps( lanes.cz + i + half ) ), n[p][3] ) );
+         const __m128 reach = _mm_add_ps( dist, lanes.Radius( absN[p], i + half ) );
+         mask |= (uint32)_mm_movemask_ps( _mm_cmplt_ps( reach, _mm_setzero_ps() ) ) << half;
+      }
+      return mask;
+#else
+      uint32 mask = 0;
+      for ( uint32 lane = 0; lane < CULL_GROUP_SIZE; lane++ )
+      {
+         const uint32 k = i + lane;
+         const float dist = planes.nx[p] * lanes.cx[k] + planes.ny[p] * lanes.cy[k] + planes.nz[p] * lanes.cz[k] + planes.d[p];
+         if ( dist + lanes.Radius( planes, p, k ) < 0.0f )
+            mask |= 1 << lane;
+      }
+      return mask;
+#endif
+   }
+};
+
+// Cull count objects, the arrays are padded to whole groups. The array bounds were tested
+// already, only the planes in planeMask can cull anything
+template <class TLanes>
+static uint32 CullGroups( const FrustumPlanes &planes, const TLanes &lanes, const uint32 count, const uint32 planeMask,
+   uint32 *visibleBits, CullCache *cache, std::vector<uint8> *firstPlane )
+{
+   const PlaneTester<TLanes> tester( planes, lanes );
+   const uint32 numGroups = (count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE;
+   if ( cache && firstPlane->size() != numGroups )
+      firstPlane->assign( numGroups, 0 );
+
+   // one byte of the mask per group, x86 is little endian
+   uint8 *groupBits = (uint8*)visibleBits;
+   uint32 numVisible = 0;
+   for ( uint32 g = 0; g < numGroups; g++ )
+   {
+      const uint32 first = cache ? (*firstPlane)[g] : 0;
+      uint32 visible = (1 << CULL_GROUP_SIZE) - 1;
+
+      for ( int32 k = -1; k < 6; k++ )
+      {
+         const uint32 p = k < 0 ? first : (uint32)k;
+         if ( ( k >= 0 && p == first ) || !( planeMask & (1 << p) ) )
+            continue;
+
+         visible &= ~tester.Outside( p, g * CULL_GROUP_SIZE );
+         if ( visible == 0 )
+         {
+            // the whole group is gone, start with this plane next time
+            if ( cache )
+               (*firstPlane)[g] = (uint8)p;
+            break;
+         }
+      }
+
+      groupBits[g] = (uint8)visible;
+      numVisible += CountBits( visible );
+   }
+   return numVisible;
+}
+
+// all objects visible, without padding bits
+static uint32 SetAllVisible( uint32 *visibleBits, const uint32 count )
+{
+   const uint32 numWords = GetNumMaskWords( count );
+   memset( visibleBits, 0xFF, numWords * sizeof(uint32) );
+   if ( count & 31 )
+      visibleBits[numWords - 1] = (1u << (count & 31)) - 1;
+   return count;
+}
+
+// test the bounds of a whole array, returns the planes the objects have to be tested against
+static eCullResult CullArrayBounds( const FrustumPlanes &planes, const float boundsMin[3], const float boundsMax[3], uint32 &planeMask )
+{
+   const float center[3] = { (boundsMin[0] + boundsMax[0]) * 0.5f, (boundsMin[1] + boundsMax[1]) * 0.5f, (boundsMin[2] + boundsMax[2]) * 0.5f };
+   const float extent[3] = { (boundsMax[0] - boundsMin[0]) * 0.5f, (boundsMax[1] - boundsMin[1]) * 0.5f, (boundsMax[2] - boundsMin[2]) * 0.5f };
+   uint32 lastPlane = 0;
+   planeMask = CULL_ALL_PLANES;
+   return CullBox( planes, center, extent, planeMask, lastPlane );
+}
+
+uint32 CullBoxes( const FrustumPlanes &planes, const BoxArray &boxes, uint32 *visibleBits, CullCache *cache )
+{
+   if ( boxes.count == 0 )
+      return 0;
+
+   memset( visibleBits, 0, GetNumMaskWords( boxes.count ) * sizeof(uint32) );
+
+   uint32 planeMask;
+   const eCullResult bounds = CullArrayBounds( planes, boxes.boundsMin, boxes.boundsMax, planeMask );
+   if ( bounds == CULL_OUTSIDE )
+      return 0;
+   if ( bounds == CULL_INSIDE )
+      return SetAllVisible( visibleBits, boxes.count );
+
+   BoxLanes lanes;
+   lanes.cx = &boxes.centerX[0]; lanes.cy = &boxes.centerY[0]; lanes.cz = &boxes.centerZ[0];
+   lanes.ex = &boxes.extentX[0]; lanes.ey = &boxes.extentY[0]; lanes.ez = &boxes.extentZ[0];
+   return CullGroups( planes, lanes, boxes.count, planeMask, visibleBits, cache, cache ? &cache->firstPlane : NULL );
+}
+
+uint32 CullSpheres( const FrustumPlanes &planes, const SphereArray &spheres, uint32 *visibleBits, CullCache *cache )
+{
+   if ( spheres.count == 0 )
+      return 0;
+
+   memset( visibleBits, 0, GetNumMaskWords( spheres.count ) * sizeof(uint32) );
+
+   uint32 planeMask;
+   const eCullResult bounds = CullArrayBounds( planes, spheres.boundsMin, spheres.boundsMax, planeMask );
+   if ( bounds == CULL_OUTSIDE )
+      return 0;
+   if ( bounds == CULL_INSIDE )
+      return SetAllVisible( visibleBits, spheres.count );
+
+   SphereLanes lanes;
+   lanes.cx = &spheres.centerX[0]; lanes.cy = &spheres.centerY[0]; lanes.cz = &spheres.centerZ[0];
+   lanes.r = &spheres.radius[0];
+   return CullGroups( planes, lanes, spheres.count, planeMask, visibleBits, cache, cache ? &cache->firstPlane : NULL );
+}
+
+uint32 CompactVisible( const uint32 *visibleBits, const uint32 count, uint32 *outIndices )
+{
+   uint32 written = 0;
+   const uint32 numWords = GetNumMaskWords( count );
+   for ( uint32 w = 0; w < numWords; w++ )
+   {
+      for ( uint32 bits = visibleBits[w]; bits; bits &= bits - 1 )
+      {
+         unsigned long bit;
+         _BitScanForward( &bit, bits );
+         outIndices[written++] = w * 32 + bit;
+      }
+   }
+   return written;
+}
+
+} // namespace culling
+
+} // namespace math
+
+} // namespace core
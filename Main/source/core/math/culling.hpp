@@ -0,0 +1,152 @@
+#ifndef _CULLING_HPP_INCLUDED_
+#define _CULLING_HPP_INCLUDED_
+
+#include <vector>
+
+#include "simd.hpp"
+#include "aabbox.hpp"
+#include "matrix4.hpp"
+#include "frustum.hpp"
+
+namespace core
+{
+
+namespace math
+{
+
+namespace culling
+{
+
+// The six frustum planes in SoA form, indexed by frustum::eFrustumPlanes. A point p is on the
+// inside of plane i when nx[i] * p.x + ny[i] * p.y + nz[i] * p.z + d[i] >= 0. The normals are unit length
+struct FrustumPlanes
+{
+   float nx[6];
+   float ny[6];
+   float nz[6];
+   float d[6];
+};
+
+// Gribb/Hartmann plane extraction from a view projection matrix that multiplies column vectors
+// (clip = proj * view * p) with OpenGL clip space, -w <= z <= w. Planes of a projection matrix
+// alone are in view space, of proj * view in world space and of proj * view * model in model space
+void ExtractFrustumPlanes( const Matrix4f &viewProj, FrustumPlanes &out );
+
+// corners of the frustum, bit 0 of the index is right, bit 1 top and bit 2 far
+enum eFrustumCorner
+{
+   CORNER_NEAR_LEFT_BOTTOM = 0,
+   CORNER_NEAR_RIGHT_BOTTOM,
+   CORNER_NEAR_LEFT_TOP,
+   CORNER_NEAR_RIGHT_TOP,
+   CORNER_FAR_LEFT_BOTTOM,
+   CORNER_FAR_RIGHT_BOTTOM,
+   CORNER_FAR_LEFT_TOP,
+   CORNER_FAR_RIGHT_TOP
+};
+
+// intersect the side planes with the near and far plane
+void CalcFrustumCorners( const FrustumPlanes &planes, Point3f corners[8] );
+
+enum eCullResult
+{
+   CULL_OUTSIDE = 0,
+   CULL_INTERSECT,
+   CULL_INSIDE
+};
+
+// one bit per plane, frustum::eFrustumPlanes gives the bit index
+const uint32 CULL_ALL_PLANES = 0x3F;
+
+// Scalar box test with plane masking and plane coherency, meant for hierarchies:
+//  - planeMask holds the planes that still have to be tested. Planes the box is completely
+//    inside of are cleared from it, so the children of the box can skip them
+//  - lastPlane is the plane to test first. When the box is culled it is set to the plane that
+//    culled it, an object that was culled last frame is usually culled by the same plane again
+eCullResult CullBox( const FrustumPlanes &planes, const float center[3], const float extent[3], uint32 &planeMask, uint32 &lastPlane );
+eCullResult CullBox( const FrustumPlanes &planes, const AABBox_f &box, uint32 &planeMask, uint32 &lastPlane );
+eCullResult CullSphere( const FrustumPlanes &planes, const Point3f &center, const float radius );
+bool IsPointInside( const FrustumPlanes &planes, const Point3f &point );
+
+// number of uint32 words of a visibility bitmask for count objects
+inline uint32 GetNumMaskWords( const uint32 count ) { return (count + 31) / 32; }
+
+// Objects are culled in groups of CULL_GROUP_SIZE, eight with AVX, two times four with SSE
+const uint32 CULL_GROUP_SIZE = 8;
+
+class BoxArray;
+class SphereArray;
+class CullCache;
+
+// Cull every object of the array and write one visible bit per object to visibleBits, which
+// needs GetNumMaskWords( count ) words. Returns the number of visible objects
+uint32 CullBoxes( const FrustumPlanes &planes, const BoxArray &boxes, uint32 *visibleBits, CullCache *cache = NULL );
+uint32 CullSpheres( const FrustumPlanes &planes, const SphereArray &spheres, uint32 *visibleBits, CullCache *cache = NULL );
+
+// turn a visibility bitmask into the list of visible indices, returns the number written
+uint32 CompactVisible( const uint32 *visibleBits, const uint32 count, uint32 *outIndices );
+
+// Boxes in SoA form, stored as center and half extent. The arrays are padded to whole groups
+// with boxes that are never visible. The bounds of all boxes are kept so CullBoxes can accept
+// or reject the whole array at once and mask out the planes the array is completely inside of
+class BoxArray
+{
+private:
+   std::vector<float> centerX, centerY, centerZ;
+   std::vector<float> extentX, extentY, extentZ;
+   uint32 count;
+   float boundsMin[3];
+   float boundsMax[3];
+
+   friend uint32 CullBoxes( const FrustumPlanes &, const BoxArray &, uint32 *, CullCache * );
+public:
+   BoxArray();
+
+   void Clear();
+   void Reserve( const uint32 count );
+   // returns the index of the new box
+   uint32 Add( const AABBox_f &box );
+   // the bounds only grow, they stay conservative when a box shrinks or moves
+   void Set( const uint32 index, const AABBox_f &box );
+   uint32 GetCount() const { return count; }
+};
+
+class SphereArray
+{
+private:
+   std::vector<float> centerX, centerY, centerZ, radius;
+   uint32 count;
+   float boundsMin[3];
+   float boundsMax[3];
+
+   friend uint32 CullSpheres( const FrustumPlanes &, const SphereArray &, uint32 *, CullCache * );
+public:
+   SphereArray();
+
+   void Clear();
+   void Reserve( const uint32 count );
+   uint32 Add( const Point3f &center, const float radius );
+   void Set( const uint32 index, const Point3f &center, const float radius );
+   uint32 GetCount() const { return count; }
+};
+
+// Plane coherency between frames. For every group it stores the plane that culled the whole
+// group last time, that plane is tested first the next frame. Use one cache per array
+class CullCache
+{
+private:
+   std::vector<uint8> firstPlane;
+
+   friend uint32 CullBoxes( const FrustumPlanes &, const BoxArray &, uint32 *, CullCache * );
+   friend uint32 CullSpheres( const FrustumPlanes &, const SphereArray &, uint32 *, CullCache * );
+public:
+   void Reset() { firstPlane.clear(); }
+};
+
+} // namespace culling
+
+} // namespace math
+
+} // namespace core
+
+#endif
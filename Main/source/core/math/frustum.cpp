@@ -1,4 +1,5 @@
 #include "frustum.hpp"
+#include "culling.hpp"
 
 namespace core
 {
@@ -42,6 +43,8 @@ namespace core
 
             for (int32 i = 0; i < 6; i++)
                planes[i] = other.planes[i];
+            for (int32 i = 0; i < 8; i++)
+               corners[i] = other.corners[i];
          }
 
          void Frustum::Update()
@@ -81,6 +84,20 @@ namespace core
             }
          }
 
+         void Frustum::Create(const Matrix4f &viewProj)
+         {
+            culling::FrustumPlanes soaPlanes;
+            culling::ExtractFrustumPlanes(viewProj, soaPlanes);
+            for (int32 i = 0; i < 6; i++)
+            {
+               planes[i].normal.Set(soaPlanes.nx[i], soaPlanes.ny[i], soaPlanes.nz[i]);
+               planes[i].distance = soaPlanes.d[i];
+            }
+
+            culling::CalcFrustumCorners(soaPlanes, corners);
+            RecalcBoundingBox();
+         }
+
          Matrix4f &Frustum::GetProjectionMatrix()
          {
             Update();
@@ -48,6 +48,9 @@ namespace core
             float nearBottom;
             float nearDist;
             float farDist;
+
+            // bit 0 of the index is right, bit 1 top and bit 2 far (see culling::eFrustumCorner)
+            Point3f corners[8];
          public:
             AABBox_f aabbox;
             Vector3f cameraPos;
@@ -64,7 +67,8 @@ namespace core
 
             void Update();
             void Transform(const Matrix4f &);
-            void Create(const Matrix4f &);
+            // planes, corners and bounding box of the frustum of a view projection matrix
+            void Create(const Matrix4f &viewProj);
 
             Matrix4f &GetProjectionMatrix();
 
@@ -78,47 +82,51 @@ namespace core
             Point3f GetNearRightBottom() const;
 
             const AABBox_f &GetBoundingBox() const;
-            void RecalcBoundingBox() const;
+            void RecalcBoundingBox();
          };
 
          inline void Frustum::Transform(const Matrix4f &mat4)
          {
          }
 
-         inline void Frustum::Create(const Matrix4f &mat4)
-         {
-         }
-
          inline Point3f Frustum::GetFarLeftTop() const
          {
+            return corners[6];
          }
 
          inline Point3f Frustum::GetFarLeftBottom() const
          {
+            return corners[4];
          }
 
          inline Point3f Frustum::GetFarRightTop() const
          {
+            return corners[7];
          }
 
          inline Point3f Frustum::GetFarRightBottom() const
          {
+            return corners[5];
          }
 
          inline Point3f Frustum::GetNearLeftTop() const
          {
+            return corners[2];
          }
 
          inline Point3f Frustum::GetNearLeftBottom() const
          {
+            return corners[0];
          }
 
          inline Point3f Frustum::GetNearRightTop() const
          {
+            return corners[3];
          }
 
          inline Point3f Frustum::GetNearRightBottom() const
          {
+            return corners[1];
          }
 
          inline const AABBox_f &Frustum::GetBoundingBox() const
@@ -126,14 +134,11 @@ namespace core
             return aabbox;
          }
 
-         inline void Frustum::RecalcBoundingBox() const
+         inline void Frustum::RecalcBoundingBox()
          {
-            //aabbox.Reset(cameraPosition);
-
-            //aabbox.AddInternalPoint(GetFarLeftUp());
-            //aabbox.AddInternalPoint(GetFarRightUp());
-            //aabbox.AddInternalPoint(GetFarLeftDown());
-            //aabbox.AddInternalPoint(GetFarRightDown());
+            aabbox.Reset(corners[0]);
+            for (int32 i = 1; i < 8; i++)
+               aabbox.AddInternalPoint(corners[i][X], corners[i][Y], corners[i][Z]);
          }
 
       } // namespace frustum
@@ -0,0 +1,170 @@
+#include "core/math/mathbench.hpp"
+#include "core/math/transform.hpp"
+#include "core/bench/benchtimer.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace core
+{
+
+namespace math
+{
+
+// the plain scalar versions of the Matrix4f operations that have SIMD specializations
+static Matrix4f ScalarMultiply( const Matrix4f &a, const Matrix4f &b )
+{
+   Matrix4f result( MAT4_CONST_ZERO );
+   for ( uint8 i = 0; i < 4; i++ )
+      for ( uint8 j = 0; j < 4; j++ )
+         for ( uint8 k = 0; k < 4; k++ )
+            result(i, j) += a(i, k) * b(k, j);
+   return result;
+}
+
+static Vector4f ScalarTransform( const Matrix4f &a, const Vector4f &v )
+{
+   Vector4f result( VEC4_CONST_ZERO );
+   for ( uint8 i = 0; i < 4; i++ )
+      for ( uint8 k = 0; k < 4; k++ )
+         result[i] += a(i, k) * v[k];
+   return result;
+}
+
+static Matrix4f ScalarTranspose( const Matrix4f &a )
+{
+   Matrix4f result;
+   for ( uint8 i = 0; i < 4; i++ )
+      for ( uint8 j = 0; j < 4; j++ )
+         result(i, j) = a(j, i);
+   return result;
+}
+
+// Matrix4f::GetInverse is specialized, so run the generic template on a double copy
+static bool ScalarInverse( const Matrix4f &a, Matrix4f &out )
+{
+   Matrix4d d, inverse;
+   for ( uint8 e = 0; e < 16; e++ )
+      d[e] = a[e];
+   if ( !d.GetInverse( inverse ) )
+      return false;
+   for ( uint8 e = 0; e < 16; e++ )
+      out[e] = (float)inverse[e];
+   return true;
+}
+
+static float RandomFloat()
+{
+   return (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+static float MaxDifference( const float *a, const float *b, const uint32 count )
+{
+   float maxError = 0.0f;
+   for ( uint32 i = 0; i < count; i++ )
+   {
+      const float diff = fabsf( a[i] - b[i] );
+      if ( diff > maxError )
+         maxError = diff;
+   }
+   return maxError;
+}
+
+void RunMathBenchmarks( BenchResult *results, const uint32 count, const uint32 iterations )
+{
+   srand( 1 );
+
+   std::vector<Matrix4f> matrices( count );
+   std::vector<Vector4f> vectors( count );
+   std::vector<Point3f> points( count );
+   std::vector<float> soa( count * 3 );
+   for ( uint32 i = 0; i < count; i++ )
+   {
+      // well conditioned matrices, so the two inverses can be compared
+      matrices[i].SetIdentity();
+      for ( uint8 e = 0; e < 16; e++ )
+         matrices[i][e] += 0.25f * RandomFloat();
+      vectors[i].Set( RandomFloat(), RandomFloat(), RandomFloat(), 1.0f );
+      points[i].Set( RandomFloat() * 100.0f, RandomFloat() * 100.0f, RandomFloat() * 100.0f );
+      soa[i] = points[i][X];
+      soa[count + i] = points[i][Y];
+      soa[count * 2 + i] = points[i][Z];
+   }
+   const Matrix4f &transform = matrices[0];
+
+   std::vector<Matrix4f> scalarMatrices( count ), simdMatrices( count );
+   std::vector<Vector4f> scalarVectors( count ), simdVectors( count );
+   std::vector<Point3f> scalarPoints( count ), simdPoints( count );
+   std::vector<float> scalarSoa( count * 3 ), simdSoa( count * 3 );
+
+   // each benchmark is a pair of loops over the same input, writing to different outputs
+#define MATHBENCH_RUN( id, label, scalarLoop, simdLoop, scalarOut, simdOut, numFloats ) \
+   { \
+      BenchResult &r = results[id]; \
+      r.name = label; \
+      BenchTimer scalarTimer; \
+      for ( uint32 it = 0; it < iterations; it++ ) { scalarLoop; } \
+      r.scalarMs = scalarTimer.GetMilliSecs(); \
+      BenchTimer simdTimer; \
+      for ( uint32 it = 0; it < iterations; it++ ) { simdLoop; } \
+      r.simdMs = simdTimer.GetMilliSecs(); \
+      r.maxError = MaxDifference( (const float*)&scalarOut[0], (const float*)&simdOut[0], numFloats ); \
+   }
+
+   MATHBENCH_RUN( MATHBENCH_MATRIX_MULTIPLY, "Matrix4f * Matrix4f",
+      for ( uint32 i = 0; i < count; i++ ) scalarMatrices[i] = ScalarMultiply( matrices[i], transform ),
+      for ( uint32 i = 0; i < count; i++ ) simdMatrices[i] = matrices[i] * transform,
+      scalarMatrices, simdMatrices, count * 16 );
+
+   MATHBENCH_RUN( MATHBENCH_MATRIX_VECTOR, "Matrix4f * Vector4f",
+      for ( uint32 i = 0; i < count; i++ ) scalarVectors[i] = ScalarTransform( transform, vectors[i] ),
+      for ( uint32 i = 0; i < count; i++ ) simdVectors[i] = transform * vectors[i],
+      scalarVectors, simdVectors, count * 4 );
+
+   MATHBENCH_RUN( MATHBENCH_MATRIX_TRANSPOSE, "Matrix4f transpose",
+      for ( uint32 i = 0; i < count; i++ ) scalarMatrices[i] = ScalarTranspose( matrices[i] ),
+      for ( uint32 i = 0; i < count; i++ ) simdMatrices[i] = matrices[i].Transpose(),
+      scalarMatrices, simdMatrices, count * 16 );
+
+   MATHBENCH_RUN( MATHBENCH_MATRIX_INVERSE, "Matrix4f inverse",
+      for ( uint32 i = 0; i < count; i++ ) ScalarInverse( matrices[i], scalarMatrices[i] ),
+      for ( uint32 i = 0; i < count; i++ ) matrices[i].GetInverse( simdMatrices[i] ),
+      scalarMatrices, simdMatrices, count * 16 );
+
+   MATHBENCH_RUN( MATHBENCH_POINTS_AOS, "transform Point3f[]",
+      TransformPoints<float>( transform, &points[0], &scalarPoints[0], count ),
+      TransformPoints( transform, &points[0], &simdPoints[0], count ),
+      scalarPoints, simdPoints, count * 3 );
+
+   MATHBENCH_RUN( MATHBENCH_VECTORS_AOS, "transform Vector3f[]",
+      TransformVectors<float>( transform, (const Vector3f*)&points[0], (Vector3f*)&scalarPoints[0], count ),
+      TransformVectors( transform, (const Vector3f*)&points[0], (Vector3f*)&simdPoints[0], count ),
+      scalarPoints, simdPoints, count * 3 );
+
+   MATHBENCH_RUN( MATHBENCH_POINTS_SOA, "transform SoA points",
+      TransformPointsSoA<float>( transform, &soa[0], &soa[count], &soa[count * 2], &scalarSoa[0], &scalarSoa[count], &scalarSoa[count * 2], count ),
+      TransformPointsSoA( transform, &soa[0], &soa[count], &soa[count * 2], &simdSoa[0], &simdSoa[count], &simdSoa[count * 2], count ),
+      scalarSoa, simdSoa, count * 3 );
+
+#undef MATHBENCH_RUN
+}
+
+void PrintMathBenchmarks( const uint32 count, const uint32 iterations )
+{
+   BenchResult results[MATHBENCH_COUNT];
+   RunMathBenchmarks( results, count, iterations );
+
+   printf( "%u elements x %u iterations\n", count, iterations );
+   printf( "%-24s %12s %12s %8s %12s\n", "", "scalar ms", "simd ms", "speedup", "max error" );
+   for ( int32 i = 0; i < MATHBENCH_COUNT; i++ )
+   {
+      const BenchResult &r = results[i];
+      printf( "%-24s %12.3f %12.3f %7.2fx %12g\n", r.name, r.scalarMs, r.simdMs,
+         r.simdMs > 0.0 ? r.scalarMs / r.simdMs : 0.0, r.maxError );
+   }
+}
+
+} // namespace math
+
+} // namespace core
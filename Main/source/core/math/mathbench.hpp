@@ -0,0 +1,44 @@
+#ifndef _MATHBENCH_HPP_INCLUDED_
+#define _MATHBENCH_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+namespace core
+{
+
+namespace math
+{
+
+// timings of one operation, the scalar templates against the SIMD versions
+struct BenchResult
+{
+   const char *name;
+   double scalarMs;
+   double simdMs;
+   float maxError; // largest difference between the two results
+};
+
+enum eMathBench
+{
+   MATHBENCH_MATRIX_MULTIPLY = 0,
+   MATHBENCH_MATRIX_VECTOR,
+   MATHBENCH_MATRIX_TRANSPOSE,
+   MATHBENCH_MATRIX_INVERSE,
+   MATHBENCH_POINTS_AOS,
+   MATHBENCH_VECTORS_AOS,
+   MATHBENCH_POINTS_SOA,
+   MATHBENCH_COUNT
+};
+
+// run every benchmark on count random elements, iterations times each, timed with the
+// performance counter. results needs room for MATHBENCH_COUNT entries
+void RunMathBenchmarks( BenchResult *results, const uint32 count = 65536, const uint32 iterations = 50 );
+
+// run the benchmarks and print a table to stdout
+void PrintMathBenchmarks( const uint32 count = 65536, const uint32 iterations = 50 );
+
+} // namespace math
+
+} // namespace core
+
+#endif
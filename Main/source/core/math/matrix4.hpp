@@ -1,6 +1,7 @@
 #ifndef _MATRIX4_HPP_INCLUDED_
 #define _MATRIX4_HPP_INCLUDED_
 
+#include "simd.hpp"
 #include "vector3.hpp"
 #include "vector4.hpp"
 
@@ -58,6 +59,9 @@ public:
    Matrix4 &operator-=( Matrix4 const &other );
    void Swap( Matrix4 &other );
    Matrix4 Transpose() const;
+   T Determinant() const;
+   // returns false and leaves out untouched if the matrix is singular
+   bool GetInverse( Matrix4 &out ) const;
    void SetTranslation( const Vector3<T> &vec );
    void SetTranslation( const T x, const T y, const T z );
    Vector3<T> GetTranslationVec() const;
@@ -116,7 +120,7 @@ inline Matrix4<T>::Matrix4(
    m[0][0] = m00; m[0][1] = m01; m[0][2] = m02; m[0][3] = m03;
    m[1][0] = m10; m[1][1] = m11; m[1][2] = m12; m[1][3] = m13;
    m[2][0] = m20; m[2][1] = m21; m[2][2] = m22; m[2][3] = m23;
-   m[3][0] = m30; m[3][1] = m21; m[3][2] = m22; m[3][3] = m33;
+   m[3][0] = m30; m[3][1] = m31; m[3][2] = m32; m[3][3] = m33;
 }
 
 template <class T>
@@ -132,7 +136,7 @@ template <class T>
 inline void Matrix4<T>::SetIdentity()
 {
    m[0][1] = m[0][2] = m[0][3] = m[1][0] = m[1][2] = m[1][3]
-   = m[2][0] = m[2][1] = m[2][3] (T)0;
+   = m[2][0] = m[2][1] = m[2][3] = m[3][0] = m[3][1] = m[3][2] = (T)0;
    m[0][0] = m[1][1] = m[2][2] = m[3][3] = (T)1;
 }
 
@@ -146,7 +150,7 @@ inline void Matrix4<T>::Set(
    m[0][0] = m00; m[0][1] = m01; m[0][2] = m02; m[0][3] = m03;
    m[1][0] = m10; m[1][1] = m11; m[1][2] = m12; m[1][3] = m13;
    m[2][0] = m20; m[2][1] = m21; m[2][2] = m22; m[2][3] = m23;
-   m[3][0] = m30; m[3][1] = m21; m[3][2] = m22; m[3][3] = m33;
+   m[3][0] = m30; m[3][1] = m31; m[3][2] = m32; m[3][3] = m33;
 }
 
 template <class T>
@@ -173,14 +177,14 @@ template <class T>
 inline T Matrix4<T>::operator[]( const uint8 index ) const
 {
    assert( index < 16 );
-	return (&x)[index];
+	return (&m[0][0])[index];
 }
 
 template <class T>
 inline T &Matrix4<T>::operator[]( const uint8 index )
 {
    assert( index < 16 );
-	return (&x)[index];
+	return (&m[0][0])[index];
 }
 
 template <class T>
@@ -225,10 +229,10 @@ template <class T>
 inline Vector4<T> Matrix4<T>::operator*( const Vector4<T> &vec ) const
 {
    return Vector4<T>(
-      m[0][0] * vec.x + m[0][1] * vec.y + m[0][2] * vec.z + m[0][3] * vec.w, 
-      m[1][0] * vec.x + m[1][1] * vec.y + m[1][2] * vec.z + m[1][3] * vec.w,
-      m[2][0] * vec.x + m[2][1] * vec.y + m[2][2] * vec.z + m[2][3] * vec.w,
-      m[3][0] * vec.x + m[3][1] * vec.y + m[3][2] * vec.z + m[3][3] * vec.w
+      m[0][0] * vec[X] + m[0][1] * vec[Y] + m[0][2] * vec[Z] + m[0][3] * vec[W],
+      m[1][0] * vec[X] + m[1][1] * vec[Y] + m[1][2] * vec[Z] + m[1][3] * vec[W],
+      m[2][0] * vec[X] + m[2][1] * vec[Y] + m[2][2] * vec[Z] + m[2][3] * vec[W],
+      m[3][0] * vec[X] + m[3][1] * vec[Y] + m[3][2] * vec[Z] + m[3][3] * vec[W]
       );
 }
 
@@ -323,6 +327,72 @@ inline Matrix4<T> Matrix4<T>::Transpose() const
       m[0][3], m[1][3], m[2][3], m[3][3] );
 }
 
+// cofactor expansion along the 2x2 minors of the upper and lower halves
+template <class T>
+inline T Matrix4<T>::Determinant() const
+{
+   const T s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+   const T s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+   const T s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+   const T s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+   const T s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+   const T s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+
+   const T c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+   const T c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+   const T c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+   const T c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+   const T c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+   const T c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+   return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+}
+
+template <class T>
+inline bool Matrix4<T>::GetInverse( Matrix4<T> &out ) const
+{
+   const T s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+   const T s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+   const T s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+   const T s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+   const T s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+   const T s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+
+   const T c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+   const T c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+   const T c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+   const T c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+   const T c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+   const T c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+   const T det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+   if ( det == (T)0 )
+      return false;
+   const T invDet = (T)1 / det;
+
+   out.Set(
+      ( m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3) * invDet,
+      (-m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3) * invDet,
+      ( m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3) * invDet,
+      (-m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3) * invDet,
+
+      (-m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1) * invDet,
+      ( m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1) * invDet,
+      (-m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1) * invDet,
+      ( m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1) * invDet,
+
+      ( m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0) * invDet,
+      (-m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0) * invDet,
+      ( m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0) * invDet,
+      (-m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0) * invDet,
+
+      (-m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0) * invDet,
+      ( m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0) * invDet,
+      (-m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0) * invDet,
+      ( m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0) * invDet );
+   return true;
+}
+
 template <class T>
 inline void Matrix4<T>::SetTranslation( const Vector3<T> &vec )
 {
@@ -364,9 +434,9 @@ inline void Matrix4<T>::SetScale( const T x, const T y, const T z )
 template <class T>
 inline void Matrix4<T>::SetScale( const T scale )
 {
-   m[0][0] = scalingFactor;
-   m[1][1] = scalingFactor;
-   m[2][2] = scalingFactor;
+   m[0][0] = scale;
+   m[1][1] = scale;
+   m[2][2] = scale;
 }
 
 template <class T>
@@ -409,6 +479,162 @@ inline bool Matrix4<T>::IsAffine(void) const
    return m[3][0] == 0 && m[3][1] == 0 && m[3][2] == 0 && m[3][3] == 1;
 }
 
+#ifdef CORE_MATH_SSE
+// SSE versions for Matrix4f. The rows are loaded unaligned since a Matrix4 may live anywhere
+
+template <>
+inline Matrix4<float> Matrix4<float>::operator*( const Matrix4<float> &other ) const
+{
+   const __m128 b0 = _mm_loadu_ps( other.m[0] );
+   const __m128 b1 = _mm_loadu_ps( other.m[1] );
+   const __m128 b2 = _mm_loadu_ps( other.m[2] );
+   const __m128 b3 = _mm_loadu_ps( other.m[3] );
+
+   // every row of the result is a linear combination of the rows of other
+   Matrix4<float> result;
+   for ( int32 i = 0; i < 4; i++ )
+   {
+      __m128 row = _mm_mul_ps( _mm_set1_ps( m[i][0] ), b0 );
+      row = _mm_add_ps( row, _mm_mul_ps( _mm_set1_ps( m[i][1] ), b1 ) );
+      row = _mm_add_ps( row, _mm_mul_ps( _mm_set1_ps( m[i][2] ), b2 ) );
+      row = _mm_add_ps( row, _mm_mul_ps( _mm_set1_ps( m[i][3] ), b3 ) );
+      _mm_storeu_ps( result.m[i], row );
+   }
+   return result;
+}
+
+template <>
+inline Vector4<float> Matrix4<float>::operator*( const Vector4<float> &vec ) const
+{
+   __m128 c0 = _mm_loadu_ps( m[0] );
+   __m128 c1 = _mm_loadu_ps( m[1] );
+   __m128 c2 = _mm_loadu_ps( m[2] );
+   __m128 c3 = _mm_loadu_ps( m[3] );
+   _MM_TRANSPOSE4_PS( c0, c1, c2, c3 );
+
+   const __m128 v = _mm_loadu_ps( vec.Ptr() );
+   __m128 r = _mm_mul_ps( c0, _mm_shuffle_ps( v, v, _MM_SHUFFLE(0, 0, 0, 0) ) );
+   r = _mm_add_ps( r, _mm_mul_ps( c1, _mm_shuffle_ps( v, v, _MM_SHUFFLE(1, 1, 1, 1) ) ) );
+   r = _mm_add_ps( r, _mm_mul_ps( c2, _mm_shuffle_ps( v, v, _MM_SHUFFLE(2, 2, 2, 2) ) ) );
+   r = _mm_add_ps( r, _mm_mul_ps( c3, _mm_shuffle_ps( v, v, _MM_SHUFFLE(3, 3, 3, 3) ) ) );
+
+   Vector4<float> result;
+   _mm_storeu_ps( result.Ptr(), r );
+   return result;
+}
+
+template <>
+inline Matrix4<float> Matrix4<float>::Transpose() const
+{
+   __m128 r0 = _mm_loadu_ps( m[0] );
+   __m128 r1 = _mm_loadu_ps( m[1] );
+   __m128 r2 = _mm_loadu_ps( m[2] );
+   __m128 r3 = _mm_loadu_ps( m[3] );
+   _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+
+   Matrix4<float> result;
+   _mm_storeu_ps( result.m[0], r0 );
+   _mm_storeu_ps( result.m[1], r1 );
+   _mm_storeu_ps( result.m[2], r2 );
+   _mm_storeu_ps( result.m[3], r3 );
+   return result;
+}
+
+namespace detail
+{
+
+#define CORE_MATH_SWIZZLE( v, x, y, z, w ) _mm_shuffle_ps( v, v, _MM_SHUFFLE(w, z, y, x) )
+#define CORE_MATH_SHUFFLE( a, b, x, y, z, w ) _mm_shuffle_ps( a, b, _MM_SHUFFLE(w, z, y, x) )
+
+// 2x2 matrices stored row major in one register
+// A * B
+inline __m128 Mat2Mul( const __m128 a, const __m128 b )
+{
+   return _mm_add_ps( _mm_mul_ps( a, CORE_MATH_SWIZZLE( b, 0, 3, 0, 3 ) ),
+      _mm_mul_ps( CORE_MATH_SWIZZLE( a, 1, 0, 3, 2 ), CORE_MATH_SWIZZLE( b, 2, 1, 2, 1 ) ) );
+}
+
+// adj(A) * B
+inline __m128 Mat2AdjMul( const __m128 a, const __m128 b )
+{
+   return _mm_sub_ps( _mm_mul_ps( CORE_MATH_SWIZZLE( a, 3, 3, 0, 0 ), b ),
+      _mm_mul_ps( CORE_MATH_SWIZZLE( a, 1, 1, 2, 2 ), CORE_MATH_SWIZZLE( b, 2, 3, 0, 1 ) ) );
+}
+
+// A * adj(B)
+inline __m128 Mat2MulAdj( const __m128 a, const __m128 b )
+{
+   return _mm_sub_ps( _mm_mul_ps( a, CORE_MATH_SWIZZLE( b, 3, 0, 3, 0 ) ),
+      _mm_mul_ps( CORE_MATH_SWIZZLE( a, 1, 0, 3, 2 ), CORE_MATH_SWIZZLE( b, 2, 1, 2, 1 ) ) );
+}
+
+} // namespace detail
+
+// blockwise inversion over the four 2x2 sub matrices
+//    M = | A B |
+//        | C D |
+template <>
+inline bool Matrix4<float>::GetInverse( Matrix4<float> &out ) const
+{
+   using detail::Mat2Mul;
+   using detail::Mat2AdjMul;
+   using detail::Mat2MulAdj;
+
+   const __m128 r0 = _mm_loadu_ps( m[0] );
+   const __m128 r1 = _mm_loadu_ps( m[1] );
+   const __m128 r2 = _mm_loadu_ps( m[2] );
+   const __m128 r3 = _mm_loadu_ps( m[3] );
+
+   const __m128 a = _mm_movelh_ps( r0, r1 );
+   const __m128 b = _mm_movehl_ps( r1, r0 );
+   const __m128 c = _mm_movelh_ps( r2, r3 );
+   const __m128 d = _mm_movehl_ps( r3, r2 );
+
+   // ( |A| |B| |C| |D| )
+   const __m128 detSub = _mm_sub_ps(
+      _mm_mul_ps( CORE_MATH_SHUFFLE( r0, r2, 0, 2, 0, 2 ), CORE_MATH_SHUFFLE( r1, r3, 1, 3, 1, 3 ) ),
+      _mm_mul_ps( CORE_MATH_SHUFFLE( r0, r2, 1, 3, 1, 3 ), CORE_MATH_SHUFFLE( r1, r3, 0, 2, 0, 2 ) ) );
+   const __m128 detA = CORE_MATH_SWIZZLE( detSub, 0, 0, 0, 0 );
+   const __m128 detB = CORE_MATH_SWIZZLE( detSub, 1, 1, 1, 1 );
+   const __m128 detC = CORE_MATH_SWIZZLE( detSub, 2, 2, 2, 2 );
+   const __m128 detD = CORE_MATH_SWIZZLE( detSub, 3, 3, 3, 3 );
+
+   const __m128 dc = Mat2AdjMul( d, c );
+   const __m128 ab = Mat2AdjMul( a, b );
+
+   // the blocks of the inverse before the adjugate and the division by |M|
+   __m128 x = _mm_sub_ps( _mm_mul_ps( detD, a ), Mat2Mul( b, dc ) );
+   __m128 w = _mm_sub_ps( _mm_mul_ps( detA, d ), Mat2Mul( c, ab ) );
+   __m128 y = _mm_sub_ps( _mm_mul_ps( detB, c ), Mat2MulAdj( d, ab ) );
+   __m128 z = _mm_sub_ps( _mm_mul_ps( detC, b ), Mat2MulAdj( a, dc ) );
+
+   // |M| = |A||D| + |B||C| - tr( adj(A)B adj(D)C )
+   __m128 tr = _mm_mul_ps( ab, CORE_MATH_SWIZZLE( dc, 0, 2, 1, 3 ) );
+   tr = _mm_add_ps( tr, _mm_movehl_ps( tr, tr ) );
+   tr = _mm_add_ss( tr, _mm_shuffle_ps( tr, tr, _MM_SHUFFLE(1, 1, 1, 1) ) );
+   const float det = _mm_cvtss_f32( detSub ) * _mm_cvtss_f32( detD ) + _mm_cvtss_f32( detB ) * _mm_cvtss_f32( detC ) - _mm_cvtss_f32( tr );
+   if ( det == 0.0f )
+      return false;
+
+   const __m128 invDet = _mm_div_ps( _mm_setr_ps( 1.0f, -1.0f, -1.0f, 1.0f ), _mm_set1_ps( det ) );
+   x = _mm_mul_ps( x, invDet );
+   y = _mm_mul_ps( y, invDet );
+   z = _mm_mul_ps( z, invDet );
+   w = _mm_mul_ps( w, invDet );
+
+   // the adjugate of each block folded into the shuffles that assemble the rows
+   _mm_storeu_ps( out.m[0], CORE_MATH_SHUFFLE( x, y, 3, 1, 3, 1 ) );
+   _mm_storeu_ps( out.m[1], CORE_MATH_SHUFFLE( x, y, 2, 0, 2, 0 ) );
+   _mm_storeu_ps( out.m[2], CORE_MATH_SHUFFLE( z, w, 3, 1, 3, 1 ) );
+   _mm_storeu_ps( out.m[3], CORE_MATH_SHUFFLE( z, w, 2, 0, 2, 0 ) );
+   return true;
+}
+
+#undef CORE_MATH_SWIZZLE
+#undef CORE_MATH_SHUFFLE
+
+#endif // CORE_MATH_SSE
+
 } // namespace math
 
 } // namespace core
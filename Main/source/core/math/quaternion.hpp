@@ -2,7 +2,8 @@
 #define QUATERNION_HPP
 
 #include <assert.h>
-#include <cmath> // sqrt(), sin(), cos()
+#include <string.h>
+#include <cmath> // sqrt(), sin(), cos(), acos()
 
 #include "vector3.hpp"
 
@@ -38,6 +39,19 @@ public:
    void Swap( Quaternion& other );
    bool operator==( const Quaternion &other ) const;
    bool operator!=( const Quaternion &other ) const;
+
+   // rotation of other followed by this one
+   Quaternion operator*( const Quaternion &other ) const;
+   Quaternion operator*( const T scalar ) const;
+   Quaternion operator-() const;
+   T Dot( const Quaternion &other ) const;
+   T Length() const;
+   Quaternion &Normalize();
+   // the inverse of a unit quaternion
+   Quaternion Conjugate() const;
+   Vector3<T> Rotate( const Vector3<T> &v ) const;
+   // restore w of a unit quaternion from x, y and z, w ends up negative (the md5 convention)
+   void ComputeW();
    
    /* .cpp methods */
    void FromAngleAxis( const float angle, const Vector3<T> &vec );
@@ -63,7 +77,7 @@ inline Quaternion<T>::Quaternion()
 template <class T>
 inline Quaternion<T>::Quaternion( const T* ptr )
 {
-   memcpy( &w, valptr, sizeof(T)*4 );
+   memcpy( &x, ptr, sizeof(T)*4 );
 }
 
 template <class T>
@@ -215,6 +229,112 @@ inline bool Quaternion<T>::operator!=( const Quaternion<T> &other ) const
 	return false;
 }
 
+template <class T>
+inline Quaternion<T> Quaternion<T>::operator*( const Quaternion<T> &other ) const
+{
+   return Quaternion<T>(
+      w * other.x + x * other.w + y * other.z - z * other.y,
+      w * other.y + y * other.w + z * other.x - x * other.z,
+      w * other.z + z * other.w + x * other.y - y * other.x,
+      w * other.w - x * other.x - y * other.y - z * other.z );
+}
+
+template <class T>
+inline Quaternion<T> Quaternion<T>::operator*( const T scalar ) const
+{
+   return Quaternion<T>( x * scalar, y * scalar, z * scalar, w * scalar );
+}
+
+template <class T>
+inline Quaternion<T> Quaternion<T>::operator-() const
+{
+   return Quaternion<T>( -x, -y, -z, -w );
+}
+
+template <class T>
+inline T Quaternion<T>::Dot( const Quaternion<T> &other ) const
+{
+   return x * other.x + y * other.y + z * other.z + w * other.w;
+}
+
+template <class T>
+inline T Quaternion<T>::Length() const
+{
+   return sqrt( Dot( *this ) );
+}
+
+template <class T>
+inline Quaternion<T> &Quaternion<T>::Normalize()
+{
+   const T length = Length();
+   if ( length > (T)0 )
+   {
+      const T inv = (T)1 / length;
+      x *= inv;
+      y *= inv;
+      z *= inv;
+      w *= inv;
+   }
+   return *this;
+}
+
+template <class T>
+inline Quaternion<T> Quaternion<T>::Conjugate() const
+{
+   return Quaternion<T>( -x, -y, -z, w );
+}
+
+template <class T>
+inline Vector3<T> Quaternion<T>::Rotate( const Vector3<T> &v ) const
+{
+   // v + w * t + q x t with t = 2 * (q x v), cheaper than q * v * q^-1
+   const T tx = (T)2 * ( y * v[Z] - z * v[Y] );
+   const T ty = (T)2 * ( z * v[X] - x * v[Z] );
+   const T tz = (T)2 * ( x * v[Y] - y * v[X] );
+   return Vector3<T>(
+      v[X] + w * tx + ( y * tz - z * ty ),
+      v[Y] + w * ty + ( z * tx - x * tz ),
+      v[Z] + w * tz + ( x * ty - y * tx ) );
+}
+
+template <class T>
+inline void Quaternion<T>::ComputeW()
+{
+   const T t = (T)1 - x * x - y * y - z * z;
+   w = t < (T)0 ? (T)0 : -sqrt( t );
+}
+
+// Normalized linear interpolation along the shorter arc. Not constant speed, but close to slerp
+// for the small angles between animation frames and much cheaper
+template <class T>
+inline Quaternion<T> Nlerp( const Quaternion<T> &a, const Quaternion<T> &b, const T t )
+{
+   const T sign = a.Dot( b ) < (T)0 ? (T)-1 : (T)1;
+   Quaternion<T> result = a * ( (T)1 - t ) + b * ( t * sign );
+   return result.Normalize();
+}
+
+// spherical linear interpolation along the shorter arc, constant angular speed
+template <class T>
+inline Quaternion<T> Slerp( const Quaternion<T> &a, const Quaternion<T> &b, const T t )
+{
+   T cosAngle = a.Dot( b );
+   Quaternion<T> end = b;
+   if ( cosAngle < (T)0 )
+   {
+      cosAngle = -cosAngle;
+      end = -b;
+   }
+
+   // nearly parallel, sin( angle ) goes to 0
+   if ( cosAngle > (T)0.9995 )
+      return Nlerp( a, end, t );
+
+   const T angle = acos( cosAngle );
+   const T invSin = (T)1 / sin( angle );
+   return a * ( sin( ( (T)1 - t ) * angle ) * invSin ) + end * ( sin( t * angle ) * invSin );
+}
+
 template <class T>
 void Quaternion<T>::FromAngleAxis( const float angle, const Vector3<T> &axis )
 {
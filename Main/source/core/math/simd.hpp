@@ -0,0 +1,17 @@
+#ifndef _SIMD_HPP_INCLUDED_
+#define _SIMD_HPP_INCLUDED_
+
+// instruction sets the math library may use. SSE is always there on x64 and on x86 when
+// compiling with /arch:SSE or higher, AVX needs /arch:AVX
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define CORE_MATH_SSE
+#include <xmmintrin.h>
+#endif
+
+#if defined(__AVX__)
+#define CORE_MATH_AVX
+#include <immintrin.h>
+#endif
+
+#endif
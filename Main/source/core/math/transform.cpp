@@ -0,0 +1,156 @@
+#include "transform.hpp"
+
+namespace core
+{
+
+namespace math
+{
+
+#ifdef CORE_MATH_SSE
+
+// xyz of 4 packed points or vectors, 12 floats, to and from one register per component
+static inline void Deinterleave( const float *src, __m128 &x, __m128 &y, __m128 &z )
+{
+   const __m128 a = _mm_loadu_ps( src );     // x0 y0 z0 x1
+   const __m128 b = _mm_loadu_ps( src + 4 ); // y1 z1 x2 y2
+   const __m128 c = _mm_loadu_ps( src + 8 ); // z2 x3 y3 z3
+
+   x = _mm_shuffle_ps( a, _mm_shuffle_ps( b, c, _MM_SHUFFLE(1, 1, 2, 2) ), _MM_SHUFFLE(2, 0, 3, 0) );
+   y = _mm_shuffle_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE(0, 0, 1, 1) ), _mm_shuffle_ps( b, c, _MM_SHUFFLE(2, 2, 3, 3) ), _MM_SHUFFLE(2, 0, 2, 0) );
+   z = _mm_shuffle_ps( _mm_shuffle_ps( a, b, _MM_SHUFFLE(1, 1, 2, 2) ), c, _MM_SHUFFLE(3, 0, 2, 0) );
+}
+
+static inline void Interleave( float *dst, const __m128 x, const __m128 y, const __m128 z )
+{
+   const __m128 a = _mm_shuffle_ps( _mm_shuffle_ps( x, y, _MM_SHUFFLE(0, 0, 0, 0) ), _mm_shuffle_ps( z, x, _MM_SHUFFLE(1, 1, 0, 0) ), _MM_SHUFFLE(2, 0, 2, 0) );
+   const __m128 b = _mm_shuffle_ps( _mm_shuffle_ps( y, z, _MM_SHUFFLE(1, 1, 1, 1) ), _mm_shuffle_ps( x, y, _MM_SHUFFLE(2, 2, 2, 2) ), _MM_SHUFFLE(2, 0, 2, 0) );
+   const __m128 c = _mm_shuffle_ps( _mm_shuffle_ps( z, x, _MM_SHUFFLE(3, 3, 2, 2) ), _mm_shuffle_ps( y, z, _MM_SHUFFLE(3, 3, 3, 3) ), _MM_SHUFFLE(2, 0, 2, 0) );
+
+   _mm_storeu_ps( dst, a );
+   _mm_storeu_ps( dst + 4, b );
+   _mm_storeu_ps( dst + 8, c );
+}
+
+// the 12 used elements of the matrix, each broadcast to all lanes
+struct BroadcastMatrix
+{
+   __m128 e[3][4];
+
+   BroadcastMatrix( const Matrix4f &mat )
+   {
+      for ( uint8 row = 0; row < 3; row++ )
+         for ( uint8 col = 0; col < 4; col++ )
+            e[row][col] = _mm_set1_ps( mat(row, col) );
+   }
+};
+
+static inline __m128 TransformRow( const __m128 *row, const __m128 x, const __m128 y, const __m128 z )
+{
+   return _mm_add_ps( _mm_add_ps( _mm_mul_ps( row[0], x ), _mm_mul_ps( row[1], y ) ), _mm_mul_ps( row[2], z ) );
+}
+
+// four points or vectors at a time in SoA form, the rest with the scalar template
+static void TransformPacked( const Matrix4f &mat, const float *in, float *out, const uint32 count, const bool translate )
+{
+   const BroadcastMatrix bm( mat );
+   const __m128 zero = _mm_setzero_ps();
+
+   uint32 i = 0;
+   for ( ; i + 4 <= count; i += 4 )
+   {
+      __m128 x, y, z;
+      Deinterleave( in + i * 3, x, y, z );
+
+      __m128 ox = TransformRow( bm.e[0], x, y, z );
+      __m128 oy = TransformRow( bm.e[1], x, y, z );
+      __m128 oz = TransformRow( bm.e[2], x, y, z );
+      ox = _mm_add_ps( ox, translate ? bm.e[0][3] : zero );
+      oy = _mm_add_ps( oy, translate ? bm.e[1][3] : zero );
+      oz = _mm_add_ps( oz, translate ? bm.e[2][3] : zero );
+
+      Interleave( out + i * 3, ox, oy, oz );
+   }
+
+   if ( translate )
+      TransformPoints<float>( mat, (const Point3f*)in + i, (Point3f*)out + i, count - i );
+   else
+      TransformVectors<float>( mat, (const Vector3f*)in + i, (Vector3f*)out + i, count - i );
+}
+
+void TransformPoints( const Matrix4f &mat, const Point3f *in, Point3f *out, const uint32 count )
+{
+   if ( count > 0 )
+      TransformPacked( mat, in->Ptr(), out->Ptr(), count, true );
+}
+
+void TransformVectors( const Matrix4f &mat, const Vector3f *in, Vector3f *out, const uint32 count )
+{
+   if ( count > 0 )
+      TransformPacked( mat, in->Ptr(), out->Ptr(), count, false );
+}
+
+void TransformPointsSoA( const Matrix4f &mat, const float *inX, const float *inY, const float *inZ,
+   float *outX, float *outY, float *outZ, const uint32 count )
+{
+   uint32 i = 0;
+
+#ifdef CORE_MATH_AVX
+   __m256 e[3][4];
+   for ( uint8 row = 0; row < 3; row++ )
+      for ( uint8 col = 0; col < 4; col++ )
+         e[row][col] = _mm256_set1_ps( mat(row, col) );
+
+   for ( ; i + 8 <= count; i += 8 )
+   {
+      const __m256 x = _mm256_loadu_ps( inX + i );
+      const __m256 y = _mm256_loadu_ps( inY + i );
+      const __m256 z = _mm256_loadu_ps( inZ + i );
+      for ( uint8 row = 0; row < 3; row++ )
+      {
+         __m256 r = _mm256_add_ps( _mm256_mul_ps( e[row][0], x ), _mm256_mul_ps( e[row][1], y ) );
+         r = _mm256_add_ps( r, _mm256_add_ps( _mm256_mul_ps( e[row][2], z ), e[row][3] ) );
+         _mm256_storeu_ps( (row == 0 ? outX : row == 1 ? outY : outZ) + i, r );
+      }
+   }
+#endif
+
+   const BroadcastMatrix bm( mat );
+   for ( ; i + 4 <= count; i += 4 )
+   {
+      const __m128 x = _mm_loadu_ps( inX + i );
+      const __m128 y = _mm_loadu_ps( inY + i );
+      const __m128 z = _mm_loadu_ps( inZ + i );
+      const __m128 ox = _mm_add_ps( TransformRow( bm.e[0], x, y, z ), bm.e[0][3] );
+      const __m128 oy = _mm_add_ps( TransformRow( bm.e[1], x, y, z ), bm.e[1][3] );
+      const __m128 oz = _mm_add_ps( TransformRow( bm.e[2], x, y, z ), bm.e[2][3] );
+      _mm_storeu_ps( outX + i, ox );
+      _mm_storeu_ps( outY + i, oy );
+      _mm_storeu_ps( outZ + i, oz );
+   }
+
+   TransformPointsSoA<float>( mat, inX + i, inY + i, inZ + i, outX + i, outY + i, outZ + i, count - i );
+}
+
+#else
+
+void TransformPoints( const Matrix4f &mat, const Point3f *in, Point3f *out, const uint32 count )
+{
+   TransformPoints<float>( mat, in, out, count );
+}
+
+void TransformVectors( const Matrix4f &mat, const Vector3f *in, Vector3f *out, const uint32 count )
+{
+   TransformVectors<float>( mat, in, out, count );
+}
+
+void TransformPointsSoA( const Matrix4f &mat, const float *inX, const float *inY, const float *inZ,
+   float *outX, float *outY, float *outZ, const uint32 count )
+{
+   TransformPointsSoA<float>( mat, inX, inY, inZ, outX, outY, outZ, count );
+}
+
+#endif // CORE_MATH_SSE
+
+} // namespace math
+
+} // namespace core
@@ -0,0 +1,71 @@
+#ifndef _TRANSFORM_HPP_INCLUDED_
+#define _TRANSFORM_HPP_INCLUDED_
+
+#include "matrix4.hpp"
+#include "point3.hpp"
+#include "vector3.hpp"
+
+namespace core
+{
+
+namespace math
+{
+
+// Batch transforms of many points or vectors by one matrix. The matrix is row major and
+// multiplies column vectors (M * v), its bottom row is taken to be 0 0 0 1.
+// Points get the translation, vectors do not. in and out may be the same array.
+//
+// The templates are the plain scalar versions for any T. The float overloads use SSE (and
+// AVX for the SoA version) when available, call the template with an explicit <float>
+// to get the scalar version
+
+template <class T>
+void TransformPoints( const Matrix4<T> &mat, const Point3<T> *in, Point3<T> *out, const uint32 count )
+{
+   for ( uint32 i = 0; i < count; i++ )
+   {
+      const T x = in[i][X], y = in[i][Y], z = in[i][Z];
+      out[i].Set(
+         mat(0, 0) * x + mat(0, 1) * y + mat(0, 2) * z + mat(0, 3),
+         mat(1, 0) * x + mat(1, 1) * y + mat(1, 2) * z + mat(1, 3),
+         mat(2, 0) * x + mat(2, 1) * y + mat(2, 2) * z + mat(2, 3) );
+   }
+}
+
+template <class T>
+void TransformVectors( const Matrix4<T> &mat, const Vector3<T> *in, Vector3<T> *out, const uint32 count )
+{
+   for ( uint32 i = 0; i < count; i++ )
+   {
+      const T x = in[i][X], y = in[i][Y], z = in[i][Z];
+      out[i].Set(
+         mat(0, 0) * x + mat(0, 1) * y + mat(0, 2) * z,
+         mat(1, 0) * x + mat(1, 1) * y + mat(1, 2) * z,
+         mat(2, 0) * x + mat(2, 1) * y + mat(2, 2) * z );
+   }
+}
+
+// structure of arrays points, one array per component
+template <class T>
+void TransformPointsSoA( const Matrix4<T> &mat, const T *inX, const T *inY, const T *inZ,
+   T *outX, T *outY, T *outZ, const uint32 count )
+{
+   for ( uint32 i = 0; i < count; i++ )
+   {
+      const T x = inX[i], y = inY[i], z = inZ[i];
+      outX[i] = mat(0, 0) * x + mat(0, 1) * y + mat(0, 2) * z + mat(0, 3);
+      outY[i] = mat(1, 0) * x + mat(1, 1) * y + mat(1, 2) * z + mat(1, 3);
+      outZ[i] = mat(2, 0) * x + mat(2, 1) * y + mat(2, 2) * z + mat(2, 3);
+   }
+}
+
+void TransformPoints( const Matrix4f &mat, const Point3f *in, Point3f *out, const uint32 count );
+void TransformVectors( const Matrix4f &mat, const Vector3f *in, Vector3f *out, const uint32 count );
+void TransformPointsSoA( const Matrix4f &mat, const float *inX, const float *inY, const float *inZ,
+   float *outX, float *outY, float *outZ, const uint32 count );
+
+} // namespace math
+
+} // namespace core
+
+#endif
@@ -1,74 +1,178 @@
 #ifndef _ALLOCATOR_HPP_INCLUDED_
 #define _ALLOCATOR_HPP_INCLUDED_
 
+#include <assert.h>
 #include <new>
+#include <utility>
 
+#include "core/memory/pool.hpp"
+#include "core/memory/arena.hpp"
+#include "core/memory/threadcache.hpp"
+
+// Allocators are the TAlloc parameter of core::Array and core::string::String. An allocator
+// hands out raw memory for count elements and constructs and destroys elements in it:
+//    T *Allocate( const size_t count );
+//    void Free( T *ptr, const size_t count ); // count as passed to Allocate, ptr may be NULL
+//    void Construct( T *ptr, const T &elem );
+//    void Construct( T *ptr, T &&elem ); // moves elem, used when a container relocates elements
+//    void Destruct( T *ptr );
+// Containers keep their allocator by value and copy it along with themselves, so allocators
+// that draw from a pool or arena only hold a pointer to it
+
+// plain heap allocator, the default of the containers
 template <class T>
 class Allocator
 {
-protected:
-	virtual void* InternalNew(size_t cnt)
-	{
-		return operator new(cnt);
-	}
-
-	virtual void InternalDelete(void* ptr)
-	{
-		operator delete(ptr);
-	}
 public:
-   ~Allocator() {}
-
-	T* Allocate( const size_t count )
-	{
-		return (T*)InternalNew( count * sizeof(T) );
-	}
-
-   void Free( T* ptr )
-	{
-		InternalDelete( ptr );
-	}
-
-	void AddElem( const T* ptr, const T &elem )
-	{
-		new ( (void*)ptr ) T(elem);
-	}
-
-   void RemoveElem( const T* ptr )
-	{
-		ptr->~T();
-	}
+   T *Allocate( const size_t count )
+   {
+      return (T*)operator new( count * sizeof(T) );
+   }
+
+   void Free( T *ptr, const size_t count )
+   {
+      operator delete( ptr );
+   }
+
+   void Construct( T *ptr, const T &elem )
+   {
+      new ( (void*)ptr ) T(elem);
+   }
+
+   void Construct( T *ptr, T &&elem )
+   {
+      new ( (void*)ptr ) T(std::move( elem ));
+   }
+
+   void Destruct( T *ptr )
+   {
+      ptr->~T();
+   }
 };
 
-template <class T, class TAlloc>
+// Takes every allocation that fits a block of the pool from the pool, bigger ones from TAlloc.
+// Meant for many small, short lived containers of about the same size, strings of a parser for
+// example. Without a pool everything goes to TAlloc
+template <class T, class TAlloc = Allocator<T> >
 class PoolAllocator
 {
- protected:
-	virtual void* InternalNew(size_t cnt)
-	{
-	}
-
-	virtual void InternalDelete(void* ptr)
-	{
-	}
+private:
+   MemoryPool *pool;
+   TAlloc fallback;
+
+   bool FromPool( const size_t count ) const { return pool != NULL && count * sizeof(T) <= pool->GetBlockSize(); }
+public:
+   PoolAllocator() : pool(NULL) {}
+   PoolAllocator( MemoryPool *pool ) : pool(pool) {}
+
+   T *Allocate( const size_t count )
+   {
+      if ( FromPool( count ) )
+         return (T*)pool->Allocate();
+      return fallback.Allocate( count );
+   }
+
+   void Free( T *ptr, const size_t count )
+   {
+      if ( FromPool( count ) )
+         pool->Free( ptr );
+      else
+         fallback.Free( ptr, count );
+   }
+
+   void Construct( T *ptr, const T &elem )
+   {
+      new ( (void*)ptr ) T(elem);
+   }
+
+   void Construct( T *ptr, T &&elem )
+   {
+      new ( (void*)ptr ) T(std::move( elem ));
+   }
+
+   void Destruct( T *ptr )
+   {
+      ptr->~T();
+   }
+};
+
+// Allocates from an arena. Free only reclaims the most recent allocation, the memory of the
+// container is released when the arena is reset or rewound, so the container must not outlive
+// that. Without an arena it falls back to the heap
+template <class T>
+class ArenaAllocator
+{
+private:
+   MemoryArena *arena;
+public:
+   ArenaAllocator() : arena(NULL) {}
+   ArenaAllocator( MemoryArena *arena ) : arena(arena) {}
+
+   T *Allocate( const size_t count )
+   {
+      if ( arena == NULL )
+         return (T*)operator new( count * sizeof(T) );
+
+      const size_t alignment = __alignof(T) > sizeof(void*) ? __alignof(T) : sizeof(void*);
+      T *ptr = (T*)arena->Allocate( count * sizeof(T), alignment );
+      if ( ptr == NULL )
+         throw std::bad_alloc();
+      return ptr;
+   }
+
+   void Free( T *ptr, const size_t count )
+   {
+      if ( arena == NULL )
+         operator delete( ptr );
+      else
+         arena->Free( ptr, count * sizeof(T) );
+   }
+
+   void Construct( T *ptr, const T &elem )
+   {
+      new ( (void*)ptr ) T(elem);
+   }
+
+   void Construct( T *ptr, T &&elem )
+   {
+      new ( (void*)ptr ) T(std::move( elem ));
+   }
+
+   void Destruct( T *ptr )
+   {
+      ptr->~T();
+   }
+};
+
+// small allocations go through the calling thread's block cache, see threadcache.hpp
+template <class T>
+class ThreadCacheAllocator
+{
 public:
-   ~PoolAllocator() {}
+   T *Allocate( const size_t count )
+   {
+      return (T*)threadcache::Allocate( count * sizeof(T) );
+   }
 
-	T* Allocate( const size_t count )
-	{
-	}
+   void Free( T *ptr, const size_t count )
+   {
+      threadcache::Free( ptr, count * sizeof(T) );
+   }
 
-   void Free( T* ptr )
-	{
-	}
+   void Construct( T *ptr, const T &elem )
+   {
+      new ( (void*)ptr ) T(elem);
+   }
 
-	void AddElem( const T* ptr, const T &elem )
-	{
-	}
+   void Construct( T *ptr, T &&elem )
+   {
+      new ( (void*)ptr ) T(std::move( elem ));
+   }
 
-   void RemoveElem( const T* ptr )
-	{
-	}
+   void Destruct( T *ptr )
+   {
+      ptr->~T();
+   }
 };
 
-#endif
\ No newline at end of file
+#endif
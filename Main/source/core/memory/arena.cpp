@@ -0,0 +1,129 @@
+#include "core/memory/arena.hpp"
+
+#include <assert.h>
+#include <new>
+
+static size_t AlignOffset( const char *base, const size_t offset, const size_t alignment )
+{
+   const size_t address = (size_t)(base + offset);
+   return offset + (((address + alignment - 1) & ~(alignment - 1)) - address);
+}
+
+MemoryArena::MemoryArena( const size_t chunkSize )
+{
+   this->chunkSize = chunkSize > 0 ? chunkSize : 64 * 1024;
+   currentChunk = 0;
+   offset = 0;
+   used = 0;
+   highWater = 0;
+   numChunkAllocs = 0;
+}
+
+MemoryArena::~MemoryArena()
+{
+   Release();
+}
+
+// moves on to the next chunk that can hold the allocation, allocating one if there is none
+bool MemoryArena::NextChunk( const size_t bytes, const size_t alignment )
+{
+   // the tail of the current chunk is lost until the next Reset or Rewind
+   if ( !chunks.empty() )
+   {
+      used += chunks[currentChunk].size - offset;
+      currentChunk++;
+   }
+
+   const size_t needed = bytes + alignment;
+   while ( currentChunk < chunks.size() && chunks[currentChunk].size < needed )
+   {
+      used += chunks[currentChunk].size;
+      currentChunk++;
+   }
+
+   if ( currentChunk == chunks.size() )
+   {
+      Chunk chunk;
+      chunk.size = needed > chunkSize ? needed : chunkSize;
+      chunk.data = (char*)operator new( chunk.size, std::nothrow );
+      if ( chunk.data == NULL )
+         return false;
+      chunks.push_back( chunk );
+      numChunkAllocs++;
+   }
+
+   offset = 0;
+   return true;
+}
+
+void *MemoryArena::Allocate( const size_t bytes, const size_t alignment )
+{
+   assert( alignment > 0 && (alignment & (alignment - 1)) == 0 );
+
+   size_t start = chunks.empty() ? 0 : AlignOffset( chunks[currentChunk].data, offset, alignment );
+   if ( chunks.empty() || start + bytes > chunks[currentChunk].size )
+   {
+      if ( !NextChunk( bytes, alignment ) )
+         return NULL;
+      start = AlignOffset( chunks[currentChunk].data, 0, alignment );
+   }
+
+   used += start - offset + bytes;
+   offset = start + bytes;
+   if ( used > highWater )
+      highWater = used;
+   return chunks[currentChunk].data + start;
+}
+
+void MemoryArena::Free( void *ptr, const size_t bytes )
+{
+   if ( ptr == NULL || chunks.empty() )
+      return;
+
+   if ( (char*)ptr + bytes == chunks[currentChunk].data + offset )
+   {
+      offset -= bytes;
+      used -= bytes;
+   }
+}
+
+MemoryArena::Marker MemoryArena::GetMarker() const
+{
+   Marker marker;
+   marker.chunk = currentChunk;
+   marker.offset = offset;
+   marker.used = used;
+   return marker;
+}
+
+void MemoryArena::Rewind( const Marker &marker )
+{
+   assert( marker.chunk <= currentChunk && marker.used <= used );
+
+   currentChunk = marker.chunk;
+   offset = marker.offset;
+   used = marker.used;
+}
+
+void MemoryArena::Reset()
+{
+   currentChunk = 0;
+   offset = 0;
+   used = 0;
+}
+
+void MemoryArena::Release()
+{
+   for ( uint32 i = 0; i < chunks.size(); i++ )
+      operator delete( chunks[i].data );
+   chunks.clear();
+   Reset();
+}
+
+size_t MemoryArena::GetCapacity() const
+{
+   size_t capacity = 0;
+   for ( uint32 i = 0; i < chunks.size(); i++ )
+      capacity += chunks[i].size;
+   return capacity;
+}
@@ -0,0 +1,82 @@
+#ifndef _ARENA_HPP_INCLUDED_
+#define _ARENA_HPP_INCLUDED_
+
+#include <vector>
+
+#include "core/BasicTypes.hpp"
+
+// Linear (bump) allocator. Allocations are taken from the front of the current chunk and
+// are not freed one by one, the whole arena or everything after a marker is released at
+// once with Reset or Rewind. The chunks stay allocated for reuse, so an arena that is reset
+// every frame stops touching the heap once it reached the size of the biggest frame.
+// Not thread safe
+class MemoryArena
+{
+private:
+   struct Chunk
+   {
+      char *data;
+      size_t size;
+   };
+
+   std::vector<Chunk> chunks;
+   uint32 currentChunk;
+   size_t offset; // in the current chunk
+   size_t chunkSize;
+   size_t used; // bytes handed out including padding and chunk tails skipped
+   size_t highWater;
+   uint32 numChunkAllocs;
+
+   bool NextChunk( const size_t bytes, const size_t alignment );
+
+   // not copyable, the chunks are owned by this instance
+   MemoryArena( const MemoryArena &other );
+   MemoryArena &operator=( const MemoryArena &other );
+public:
+   struct Marker
+   {
+      uint32 chunk;
+      size_t offset;
+      size_t used;
+   };
+
+   MemoryArena( const size_t chunkSize = 64 * 1024 );
+   ~MemoryArena();
+
+   // alignment has to be a power of two
+   void *Allocate( const size_t bytes, const size_t alignment = 16 );
+   // Only the most recent allocation is given back, so a growing array that reallocates
+   // right after its last allocation reuses the space. Anything else waits for Reset or Rewind
+   void Free( void *ptr, const size_t bytes );
+
+   Marker GetMarker() const;
+   // release everything allocated after the marker was taken
+   void Rewind( const Marker &marker );
+   // release all allocations, the chunks are kept
+   void Reset();
+   // release all allocations and give the chunks back to the heap
+   void Release();
+
+   size_t GetUsed() const { return used; }
+   size_t GetCapacity() const;
+   // most bytes in use at once since construction or the last ResetHighWater
+   size_t GetHighWater() const { return highWater; }
+   void ResetHighWater() { highWater = used; }
+   // number of chunks taken from the heap, stops growing once the arena is warmed up
+   uint32 GetNumChunkAllocs() const { return numChunkAllocs; }
+};
+
+// rewinds the arena to where it was when the scope was entered
+class ArenaScope
+{
+private:
+   MemoryArena &arena;
+   MemoryArena::Marker marker;
+
+   ArenaScope &operator=( const ArenaScope &other );
+public:
+   ArenaScope( MemoryArena &arena ) : arena(arena), marker(arena.GetMarker()) {}
+   ~ArenaScope() { arena.Rewind( marker ); }
+};
+
+#endif
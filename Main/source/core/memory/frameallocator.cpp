@@ -0,0 +1,72 @@
+#include "core/memory/frameallocator.hpp"
+
+#include <string.h>
+
+// the active allocator of the calling thread, plain data for __declspec(thread)
+static __declspec(thread) FrameAllocator *active;
+
+FrameAllocator::FrameAllocator( const uint32 numFrames, const size_t chunkSize )
+{
+   assert( numFrames > 0 && numFrames <= MAX_FRAMES_IN_FLIGHT );
+
+   this->numFrames = numFrames < 1 ? 1 : (numFrames > MAX_FRAMES_IN_FLIGHT ? MAX_FRAMES_IN_FLIGHT : numFrames);
+   for ( uint32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+      arenas[i] = i < this->numFrames ? new MemoryArena( chunkSize ) : NULL;
+
+   current = 0;
+   heapAllocsAtFrameStart = 0;
+   memset( &stats, 0, sizeof(stats) );
+}
+
+FrameAllocator::~FrameAllocator()
+{
+   if ( active == this )
+      active = NULL;
+
+   for ( uint32 i = 0; i < numFrames; i++ )
+      delete arenas[i];
+}
+
+void FrameAllocator::SetActive( FrameAllocator *frameAllocator )
+{
+   active = frameAllocator;
+}
+
+FrameAllocator *FrameAllocator::GetActive()
+{
+   return active;
+}
+
+uint32 FrameAllocator::GetTotalChunkAllocs() const
+{
+   uint32 total = 0;
+   for ( uint32 i = 0; i < numFrames; i++ )
+      total += arenas[i]->GetNumChunkAllocs();
+   return total;
+}
+
+void *FrameAllocator::Allocate( const size_t bytes, const size_t alignment )
+{
+   return arenas[current]->Allocate( bytes, alignment );
+}
+
+void FrameAllocator::EndFrame()
+{
+   const uint32 totalHeapAllocs = GetTotalChunkAllocs();
+
+   stats.frameNumber++;
+   stats.frameBytes = arenas[current]->GetUsed();
+   if ( stats.frameBytes > stats.peakFrameBytes )
+      stats.peakFrameBytes = stats.frameBytes;
+   stats.frameHeapAllocs = totalHeapAllocs - heapAllocsAtFrameStart;
+   stats.totalHeapAllocs = totalHeapAllocs;
+
+   stats.capacity = 0;
+   for ( uint32 i = 0; i < numFrames; i++ )
+      stats.capacity += arenas[i]->GetCapacity();
+
+   // the arena of the next frame was last used numFrames frames ago, its data has expired
+   current = (current + 1) % numFrames;
+   arenas[current]->Reset();
+   heapAllocsAtFrameStart = totalHeapAllocs;
+}
@@ -0,0 +1,96 @@
+#ifndef _FRAMEALLOCATOR_HPP_INCLUDED_
+#define _FRAMEALLOCATOR_HPP_INCLUDED_
+
+#include "core/memory/allocator.hpp"
+
+const uint32 MAX_FRAMES_IN_FLIGHT = 4;
+
+struct FrameStats
+{
+   uint32 frameNumber; // frames ended so far
+   size_t frameBytes; // bytes the last frame allocated
+   size_t peakFrameBytes; // most bytes any frame allocated, size the chunks after this
+   size_t capacity; // bytes held by all frame arenas
+   uint32 frameHeapAllocs; // chunks the last frame had to take from the heap, 0 once warmed up
+   uint32 totalHeapAllocs;
+};
+
+// Transient memory for temporaries that live at most numFrames frames. Every frame allocates
+// from its own arena, EndFrame moves on to the next arena and resets it, which releases what
+// was allocated numFrames frames ago in O(1). With two frames (double buffered) data written in
+// one frame can still be read while the next one is built, by the renderer for example.
+// Nothing is freed one by one and nothing is destructed, use it for plain data only.
+//
+// One instance is made active for the main thread, FrameScratch and the code that wants frame
+// memory find it through GetActive. Not thread safe, so the active allocator is per thread: on
+// the workers GetActive returns NULL and FrameScratch takes its memory from the heap
+class FrameAllocator
+{
+private:
+   MemoryArena *arenas[MAX_FRAMES_IN_FLIGHT];
+   uint32 numFrames;
+   uint32 current;
+   uint32 heapAllocsAtFrameStart;
+   FrameStats stats;
+
+   uint32 GetTotalChunkAllocs() const;
+
+   FrameAllocator( const FrameAllocator &other );
+   FrameAllocator &operator=( const FrameAllocator &other );
+public:
+   FrameAllocator( const uint32 numFrames = 2, const size_t chunkSize = 256 * 1024 );
+   ~FrameAllocator();
+
+   // valid until numFrames calls to EndFrame later, NULL when out of memory
+   void *Allocate( const size_t bytes, const size_t alignment = 16 );
+   template <class T> T *AllocateArray( const size_t count )
+   {
+      return (T*)Allocate( count * sizeof(T), __alignof(T) > sizeof(void*) ? __alignof(T) : sizeof(void*) );
+   }
+   // for core::Array and core::string::String, the container must not outlive the frame
+   template <class T> ArenaAllocator<T> GetAllocator() { return ArenaAllocator<T>( arenas[current] ); }
+
+   void EndFrame();
+
+   // statistics up to the last EndFrame
+   const FrameStats &GetStats() const { return stats; }
+   uint32 GetNumFrames() const { return numFrames; }
+
+   // the allocator of the calling thread
+   static void SetActive( FrameAllocator *frameAllocator );
+   static FrameAllocator *GetActive();
+};
+
+// Scratch buffer of count uninitialized elements for the duration of a scope. It comes from
+// the frame allocator active on the calling thread and falls back to the heap when there is
+// none or it runs out
+template <class T>
+class FrameScratch
+{
+private:
+   T *data;
+   bool onHeap;
+
+   FrameScratch( const FrameScratch &other );
+   FrameScratch &operator=( const FrameScratch &other );
+public:
+   FrameScratch( const size_t count )
+   {
+      FrameAllocator *frameAllocator = FrameAllocator::GetActive();
+      data = frameAllocator != NULL ? frameAllocator->AllocateArray<T>( count ) : NULL;
+      onHeap = data == NULL;
+      if ( onHeap )
+         data = (T*)operator new( count * sizeof(T) );
+   }
+
+   ~FrameScratch()
+   {
+      if ( onHeap )
+         operator delete( data );
+   }
+
+   T *Get() const { return data; }
+   T &operator[]( const size_t index ) const { return data[index]; }
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "core/memory/pool.hpp"
+
+#include <assert.h>
+#include <new>
+
+// the chunk header holds the next chunk pointer, padded so the first block keeps the alignment of
+// operator new
+static const size_t CHUNK_HEADER_SIZE = 16;
+
+MemoryPool::MemoryPool( const size_t blockSize, const uint32 blocksPerChunk )
+{
+   assert( blocksPerChunk > 0 );
+
+   // every block has to be able to hold the free list link, keep them 8 byte aligned
+   size_t size = blockSize < sizeof(FreeBlock) ? sizeof(FreeBlock) : blockSize;
+   this->blockSize = (size + 7) & ~(size_t)7;
+   this->blocksPerChunk = blocksPerChunk;
+   freeList = NULL;
+   chunks = NULL;
+   numBlocks = 0;
+   numUsed = 0;
+}
+
+MemoryPool::~MemoryPool()
+{
+   Clear();
+}
+
+void MemoryPool::Grow()
+{
+   char *chunk = (char*)operator new( CHUNK_HEADER_SIZE + blockSize * blocksPerChunk );
+   *(void**)chunk = chunks;
+   chunks = chunk;
+
+   // link the new blocks in address order so they are handed out front to back
+   char *block = chunk + CHUNK_HEADER_SIZE;
+   for ( uint32 i = 0; i < blocksPerChunk; i++, block += blockSize )
+      ((FreeBlock*)block)->next = i + 1 < blocksPerChunk ? (FreeBlock*)(block + blockSize) : freeList;
+   freeList = (FreeBlock*)(chunk + CHUNK_HEADER_SIZE);
+   numBlocks += blocksPerChunk;
+}
+
+void *MemoryPool::Allocate()
+{
+   if ( freeList == NULL )
+      Grow();
+
+   FreeBlock *block = freeList;
+   freeList = block->next;
+   numUsed++;
+   return block;
+}
+
+void MemoryPool::Free( void *ptr )
+{
+   if ( ptr == NULL )
+      return;
+
+   assert( numUsed > 0 );
+   FreeBlock *block = (FreeBlock*)ptr;
+   block->next = freeList;
+   freeList = block;
+   numUsed--;
+}
+
+void MemoryPool::Clear()
+{
+   while ( chunks != NULL )
+   {
+      void *next = *(void**)chunks;
+      operator delete( chunks );
+      chunks = next;
+   }
+   freeList = NULL;
+   numBlocks = 0;
+   numUsed = 0;
+}
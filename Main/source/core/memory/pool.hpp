@@ -0,0 +1,45 @@
+#ifndef _POOL_HPP_INCLUDED_
+#define _POOL_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+// Fixed size block allocator. Blocks are carved out of chunks of blocksPerChunk blocks and
+// handed back through an intrusive free list, so Allocate and Free are a couple of pointer
+// moves. The chunks are only returned to the heap by Clear or the destructor.
+// Block sizes are rounded up to a multiple of 8, so blocks are 8 byte aligned, not enough for
+// SSE types. Not thread safe
+class MemoryPool
+{
+private:
+   struct FreeBlock
+   {
+      FreeBlock *next;
+   };
+
+   FreeBlock *freeList;
+   void *chunks; // chain of chunks, the first pointer of every chunk points to the next one
+   size_t blockSize;
+   uint32 blocksPerChunk;
+   uint32 numBlocks;
+   uint32 numUsed;
+
+   void Grow();
+
+   // not copyable, the blocks are owned by this instance
+   MemoryPool( const MemoryPool &other );
+   MemoryPool &operator=( const MemoryPool &other );
+public:
+   MemoryPool( const size_t blockSize, const uint32 blocksPerChunk = 256 );
+   ~MemoryPool();
+
+   void *Allocate();
+   void Free( void *ptr );
+   // gives every chunk back to the heap, blocks that are still in use become invalid
+   void Clear();
+
+   size_t GetBlockSize() const { return blockSize; }
+   uint32 GetNumBlocks() const { return numBlocks; }
+   uint32 GetNumUsedBlocks() const { return numUsed; }
+};
+
+#endif
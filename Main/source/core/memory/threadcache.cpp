@@ -0,0 +1,96 @@
+#include "core/memory/threadcache.hpp"
+
+#include <new>
+
+namespace threadcache
+{
+
+// size classes 16, 32, 64, 128, 256 and 512 bytes
+static const uint32 NUM_SIZE_CLASSES = 6;
+static const uint32 MIN_CLASS_SHIFT = 4;
+// cached blocks per class and thread, at most 64 KB per thread
+static const uint32 MAX_BLOCKS_PER_CLASS = 64;
+
+struct FreeBlock
+{
+   FreeBlock *next;
+};
+
+// __declspec(thread) only takes plain data, the lists start out zeroed for every thread
+static __declspec(thread) FreeBlock *freeLists[NUM_SIZE_CLASSES];
+static __declspec(thread) uint32 freeCounts[NUM_SIZE_CLASSES];
+static __declspec(thread) uint32 numHits;
+static __declspec(thread) uint32 numMisses;
+
+static uint32 GetSizeClass( const size_t bytes )
+{
+   uint32 sizeClass = 0;
+   while ( ((size_t)1 << (sizeClass + MIN_CLASS_SHIFT)) < bytes )
+      sizeClass++;
+   return sizeClass;
+}
+
+void *Allocate( const size_t bytes )
+{
+   if ( bytes > MAX_CACHED_SIZE )
+      return operator new( bytes );
+
+   const uint32 sizeClass = GetSizeClass( bytes );
+   FreeBlock *block = freeLists[sizeClass];
+   if ( block != NULL )
+   {
+      freeLists[sizeClass] = block->next;
+      freeCounts[sizeClass]--;
+      numHits++;
+      return block;
+   }
+
+   numMisses++;
+   return operator new( (size_t)1 << (sizeClass + MIN_CLASS_SHIFT) );
+}
+
+void Free( void *ptr, const size_t bytes )
+{
+   if ( ptr == NULL )
+      return;
+
+   if ( bytes > MAX_CACHED_SIZE )
+   {
+      operator delete( ptr );
+      return;
+   }
+
+   const uint32 sizeClass = GetSizeClass( bytes );
+   if ( freeCounts[sizeClass] >= MAX_BLOCKS_PER_CLASS )
+   {
+      operator delete( ptr );
+      return;
+   }
+
+   FreeBlock *block = (FreeBlock*)ptr;
+   block->next = freeLists[sizeClass];
+   freeLists[sizeClass] = block;
+   freeCounts[sizeClass]++;
+}
+
+void FlushThread()
+{
+   for ( uint32 i = 0; i < NUM_SIZE_CLASSES; i++ )
+   {
+      while ( freeLists[i] != NULL )
+      {
+         FreeBlock *next = freeLists[i]->next;
+         operator delete( freeLists[i] );
+         freeLists[i] = next;
+      }
+      freeCounts[i] = 0;
+   }
+}
+
+void GetThreadStats( uint32 &hits, uint32 &misses )
+{
+   hits = numHits;
+   misses = numMisses;
+}
+
+} // namespace threadcache
@@ -0,0 +1,30 @@
+#ifndef _THREADCACHE_HPP_INCLUDED_
+#define _THREADCACHE_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+// Per thread cache of small heap blocks. Sizes up to MAX_CACHED_SIZE are rounded up to a power
+// of two size class, a freed block goes onto the free list of the calling thread and the next
+// allocation of that class takes it back without locking the heap. Bigger blocks and blocks
+// beyond the per class limit go straight to the heap.
+// Every block comes from operator new, so a block may be freed on another thread than the one
+// that allocated it
+namespace threadcache
+{
+
+const size_t MAX_CACHED_SIZE = 512;
+
+void *Allocate( const size_t bytes );
+// bytes has to be the size that was passed to Allocate
+void Free( void *ptr, const size_t bytes );
+
+// gives the blocks cached by the calling thread back to the heap, the cache of a thread is not
+// released otherwise. The TaskScheduler and AssetLoader workers call this before they exit
+void FlushThread();
+
+// allocations of the calling thread served from its cache and from the heap
+void GetThreadStats( uint32 &hits, uint32 &misses );
+
+} // namespace threadcache
+
+#endif
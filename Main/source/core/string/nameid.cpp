@@ -0,0 +1,53 @@
+#include "core/string/nameid.hpp"
+
+#include <assert.h>
+#include <string.h>
+#include <mutex>
+
+#include "core/containers/flathashmap.hpp"
+#include "core/memory/arena.hpp"
+
+namespace core
+{
+
+   namespace string
+   {
+
+      // file scope, function local statics are not thread safe to initialize with this compiler.
+      // The names are copied into the arena, which never moves them, so GetName can hand out
+      // the pointers without holding the lock
+      static std::mutex nameLock;
+      static core::containers::FlatHashMap<uint32, const char*> names;
+      static MemoryArena nameStorage(16 * 1024);
+
+      NameId NameId::Intern(const StringView_c &name)
+      {
+         const NameId nameId = FromString(name);
+         assert(nameId.IsValid());
+
+         std::lock_guard<std::mutex> lock(nameLock);
+         const char **interned = names.Find(nameId.id);
+         if (interned)
+         {
+            // two different names with the same id would be mixed up in every map
+            assert(StringView_c(*interned) == name);
+            return nameId;
+         }
+
+         char *str = (char*)nameStorage.Allocate(name.GetSize() + 1, 1);
+         memcpy(str, name.GetData(), name.GetSize());
+         str[name.GetSize()] = '\0';
+         names.Insert(nameId.id, str);
+         return nameId;
+      }
+
+      const char *NameId::GetName() const
+      {
+         std::lock_guard<std::mutex> lock(nameLock);
+         const char **interned = names.Find(id);
+         return interned ? *interned : NULL;
+      }
+
+   } // namespace string
+
+} // namespace core
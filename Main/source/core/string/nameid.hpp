@@ -0,0 +1,72 @@
+#ifndef _NAMEID_HPP_INCLUDED_
+#define _NAMEID_HPP_INCLUDED_
+
+#include "core/hash/fnv.hpp"
+#include "core/hash/hash.hpp"
+#include "core/string/stringview.hpp"
+
+namespace core
+{
+
+   namespace string
+   {
+
+      // 32 bit id of a name, the FNV-1a hash of its characters. Comparing and hashing ids is an
+      // integer operation, so maps of materials, groups or uniforms are keyed by NameId instead
+      // of strings. A literal is hashed at compile time, Intern hashes at run time and registers
+      // the characters, so GetName can give them back for logging. Two names with the same hash
+      // are caught by Intern
+      class NameId
+      {
+      private:
+         uint32 id;
+
+         explicit NameId(const uint32 id) : id(id) {}
+
+      public:
+         NameId() : id(0) {}
+
+         // for literals, hashed up to the terminating zero
+         template <uint32 N>
+         NameId(const char (&literal)[N]) : id(core::hash::Fnv1a32Literal<N, 0>::Hash(literal)) {}
+         // a writable char buffer would pick the literal constructor, it has to go through Intern
+         // or FromString
+         template <uint32 N>
+         NameId(char (&buffer)[N]) = delete;
+
+         // id of name, registered for GetName. Thread safe
+         static NameId Intern(const StringView_c &name);
+         // id of name without registering it, for lookups of names that are already interned
+         static NameId FromString(const StringView_c &name)
+         {
+            return NameId(core::hash::Fnv1a32(name.GetData(), name.GetSize()));
+         }
+
+         uint32 GetId() const { return id; }
+         bool IsValid() const { return id != 0; }
+
+         // the interned characters, NULL for an id that never went through Intern
+         const char *GetName() const;
+
+         bool operator==(const NameId &other) const { return id == other.id; }
+         bool operator!=(const NameId &other) const { return id != other.id; }
+         bool operator<(const NameId &other) const { return id < other.id; }
+      };
+
+   } // namespace string
+
+   namespace hash
+   {
+
+      // already a hash, the containers mix it
+      template <>
+      struct Hash<core::string::NameId>
+      {
+         uint64 operator()(const core::string::NameId &key) const { return key.GetId(); }
+      };
+
+   } // namespace hash
+
+} // namespace core
+
+#endif
@@ -6,6 +6,7 @@
 #include <iostream>
 
 #include <assert.h>
+#include <string.h>
 
 #include <iostream>
 
@@ -13,6 +14,7 @@
 #include "core/math/mathcommon.hpp" // IsZero
 
 #include "core/chartypes.hpp"
+#include "core/string/stringview.hpp"
 
 namespace core
 {
@@ -20,20 +22,34 @@ namespace core
    namespace string
    {
 
-      template <class T, class TAlloc = Allocator<T>>
+      // Strings of up to LOCAL_CAPACITY - 1 characters are stored inside the string itself, only
+      // longer ones allocate. Those default to the thread cache, the many short strings of parsing
+      // stay off the heap
+      template <class T, class TAlloc = ThreadCacheAllocator<T>>
       class String
       {
       private:
-         T* strArray;
+         static const uint32 LOCAL_CAPACITY = 16; // including the terminating 0
+
+         T* strArray; // points to localBuffer or to memory of the allocator
          uint32 allocated;
          uint32 used;
          TAlloc allocator;
+         T localBuffer[LOCAL_CAPACITY];
 
+         bool IsLocal() const { return strArray == localBuffer; }
+         void InitLocal();
+         void FreeBuffer();
          void Reallocate(const uint32 newSize);
+         // make room for needed elements, growing geometrically
+         void Grow(const uint32 needed);
 
       public:
          String();
+         explicit String(const TAlloc &allocator);
          String(const String &other);
+         String(String &&other);
+         explicit String(const StringView<T> &view);
          template <class B> String(const B* const c, const uint32 length);
          template <class B> String(const B* const c);
          explicit String(const int32 number);
@@ -42,6 +58,7 @@ namespace core
          ~String();
 
          String &operator=(const String &other);
+         String &operator=(String &&other);
          template <class B> String &operator=(const B* const c);
          String &operator=(const int32 number);
 
@@ -57,6 +74,7 @@ namespace core
          bool IsEmpty() const;
          uint32 GetSize() const;
          const T* CString() const;
+         StringView<T> GetView() const { return StringView<T>(strArray, used - 1); }
 
          bool operator==(const T* const str) const;
          bool operator==(const String &other) const;
@@ -96,6 +114,7 @@ namespace core
          int32 FindNext(const T c, const uint32 startPos) const;
          int32 FindNextNumber(const uint32 startPos) const;
 
+         // ret is a container of String or of StringView, splitting into views allocates nothing
          template <class TContainer> int32 Tokenize(TContainer &ret, const T* const delimiter = " \t\r\n", const int32 count = 1,
             const bool ignoreEmptyTokens = true, const bool keepSeparators = false) const;
          String SubString(const uint32 begin, const uint32 length, const bool makeLower = false) const;
@@ -113,50 +132,104 @@ namespace core
       typedef String<char> String_c;
       typedef String<wchar_t> String_w;
 
+      template <class T, class TAlloc>
+      inline void String<T, TAlloc>::InitLocal()
+      {
+         strArray = localBuffer;
+         allocated = LOCAL_CAPACITY;
+         used = 1;
+         localBuffer[0] = 0;
+      }
+
+      template <class T, class TAlloc>
+      inline void String<T, TAlloc>::FreeBuffer()
+      {
+         if (!IsLocal())
+            allocator.Free(strArray, allocated);
+      }
+
       template <class T, class TAlloc>
       void String<T, TAlloc>::Reallocate(const uint32 newSize)
       {
-         T* old_array = strArray;
+         T* oldArray = strArray;
+         const uint32 oldAllocated = allocated;
+         const bool wasLocal = IsLocal();
+
+         if (newSize <= LOCAL_CAPACITY)
+         {
+            if (wasLocal)
+            {
+               if (used > newSize)
+                  used = newSize;
+               return;
+            }
+            strArray = localBuffer;
+            allocated = LOCAL_CAPACITY;
+         }
+         else
+         {
+            strArray = allocator.Allocate(newSize); //new T[new_size];
+            allocated = newSize;
+         }
 
-         strArray = allocator.Allocate(newSize); //new T[new_size];
-         allocated = newSize;
+         if (used > newSize)
+            used = newSize;
+         memcpy(strArray, oldArray, used * sizeof(T));
 
-         int32 amount = used < newSize ? used : newSize;
-         for (int32 i = 0; i < amount; i++)
-            strArray[i] = old_array[i];
+         if (!wasLocal)
+            allocator.Free(oldArray, oldAllocated); // delete [] old_array;
+      }
 
-         if (allocated < used)
-            used = allocated;
+      template <class T, class TAlloc>
+      inline void String<T, TAlloc>::Grow(const uint32 needed)
+      {
+         if (needed > allocated)
+            Reallocate(needed < allocated * 2 ? allocated * 2 : needed);
+      }
 
-         allocator.Free(old_array); // delete [] old_array;
+      template <class T, class TAlloc>
+      inline String<T, TAlloc>::String()
+      {
+         InitLocal();
       }
 
       template <class T, class TAlloc>
-      inline String<T, TAlloc>::String() : allocated(1), used(1)
+      inline String<T, TAlloc>::String(const TAlloc &allocator) : allocator(allocator)
       {
-         strArray = allocator.Allocate(1);
-         strArray[0] = 0;
+         InitLocal();
       }
 
       template <class T, class TAlloc>
-      inline String<T, TAlloc>::String(const String<T, TAlloc> &other) : strArray(NULL), allocated(0), used(0)
+      inline String<T, TAlloc>::String(const String<T, TAlloc> &other) : allocator(other.allocator)
       {
+         InitLocal();
          *this = other;
       }
 
+      template <class T, class TAlloc>
+      inline String<T, TAlloc>::String(String<T, TAlloc> &&other) : allocator(other.allocator)
+      {
+         InitLocal();
+         *this = static_cast<String<T, TAlloc>&&>(other);
+      }
+
+      template <class T, class TAlloc>
+      inline String<T, TAlloc>::String(const StringView<T> &view)
+      {
+         InitLocal();
+         Append(view.GetData(), view.GetSize());
+      }
+
       template <class T, class TAlloc>
       template <class B>
-      String<T, TAlloc>::String(const B* const c, const uint32 length) : strArray(NULL), allocated(0), used(0)
+      String<T, TAlloc>::String(const B* const c, const uint32 length)
       {
+         InitLocal();
          if (!c)
-         {
-            // correctly init the string to an empty one
-            *this = "";
             return;
-         }
 
-         allocated = used = length + 1;
-         strArray = allocator.Allocate(used); // new T[used];
+         Reserve(length + 1);
+         used = length + 1;
 
          for (uint32 i = 0; i < length; i++)
             strArray[i] = (T)c[i];
@@ -166,14 +239,16 @@ namespace core
 
       template <class T, class TAlloc>
       template <class B>
-      String<T, TAlloc>::String(const B* const c) : strArray(NULL), allocated(0), used(0)
+      String<T, TAlloc>::String(const B* const c)
       {
+         InitLocal();
          *this = c;
       }
 
       template <class T, class TAlloc>
-      inline String<T, TAlloc>::String(const int32 number) : strArray(NULL), allocated(0), used(0)
+      inline String<T, TAlloc>::String(const int32 number)
       {
+         InitLocal();
          int32 num = number;
          // store if negative and make positive
          bool negative = false;
@@ -219,8 +294,9 @@ namespace core
 
       // not complete
       template <class T, class TAlloc>
-      inline String<T, TAlloc>::String(const float number) : strArray(NULL), allocated(0), used(0)
+      inline String<T, TAlloc>::String(const float number)
       {
+         InitLocal();
          int32 intNum = (int32)number;
 
          char tmpbuf[32] = { 0 };
@@ -279,7 +355,7 @@ namespace core
       template <class T, class TAlloc>
       inline String<T, TAlloc>::~String()
       {
-         allocator.Free(strArray);
+         FreeBuffer();
       }
 
       template <class T, class TAlloc>
@@ -416,19 +492,13 @@ namespace core
       template <class T, class TAlloc>
       inline int32 String<T, TAlloc>::StringToInt() const
       {
-         int32 index;
-         if ((index = FindNextNumber(0)) != -1)
-            return atoi(&strArray[index]);
-         return INT32_MAX;
+         return GetView().StringToInt();
       }
 
       template <class T, class TAlloc>
       inline float String<T, TAlloc>::StringToFloat() const
       {
-         int32 index;
-         if ((index = FindNextNumber(0)) != -1)
-            return (float)atof(&strArray[index]);
-         return FLOAT_MAX;
+         return GetView().StringToFloat();
       }
 
       template <class T, class TAlloc>
@@ -449,11 +519,6 @@ namespace core
       {
          if (!c)
          {
-            if (!strArray)
-            {
-               strArray = allocator.Allocate(1); //new T[1];
-               allocated = 1;
-            }
             used = 1;
             strArray[0] = 0x0;
             return *this;
@@ -462,7 +527,7 @@ namespace core
          if ((void*)c == (void*)strArray)
             return *this;
 
-         int32 len = 0;
+         uint32 len = 0;
          const B* p = c;
          do
          {
@@ -472,20 +537,23 @@ namespace core
          // we'll keep the old string for a while, because the new
          // string could be a part of the current string.
          T* oldArray = strArray;
+         const uint32 oldAllocated = allocated;
+         bool freeOld = false;
 
-         used = len;
-         if (used > allocated)
+         if (len > allocated)
          {
-            allocated = used;
-            strArray = allocator.Allocate(used); //new T[used];
+            freeOld = !IsLocal();
+            allocated = len;
+            strArray = allocator.Allocate(len); //new T[used];
          }
 
          // build the string array
-         for (int32 i = 0; i < len; i++)
+         for (uint32 i = 0; i < len; i++)
             strArray[i] = (T)c[i];
+         used = len;
 
-         if (oldArray != strArray)
-            allocator.Free(oldArray); // delete [] oldArray;
+         if (freeOld)
+            allocator.Free(oldArray, oldAllocated); // delete [] oldArray;
 
          return *this;
       }
@@ -565,31 +633,15 @@ namespace core
       }
 
       template <class T, class TAlloc>
-      bool String<T, TAlloc>::EqualsN(const String<T, TAlloc> &other, const uint32 n) const
+      inline bool String<T, TAlloc>::EqualsN(const String<T, TAlloc> &other, const uint32 n) const
       {
-         uint32 i;
-         for (i = 0; strArray[i] && other[i] && i < n; i++)
-            if (strArray[i] != other[i])
-               return false;
-
-         // if one (or both) of the strings was smaller then they
-         // are only equal if they have the same length
-         return (i == n) || (used == other.used);
+         return GetView().EqualsN(other.GetView(), n);
       }
 
       template <class T, class TAlloc>
-      bool String<T, TAlloc>::EqualsN(const T* const str, const uint32 n) const
+      inline bool String<T, TAlloc>::EqualsN(const T* const str, const uint32 n) const
       {
-         if (!str)
-            return false;
-         int32 i;
-         for (i = 0; strArray[i] && str[i] && i < n; i++)
-            if (strArray[i] != str[i])
-               return false;
-
-         // if one (or both) of the strings was smaller then they
-         // are only equal if they have the same length
-         return (i == n) || (strArray[i] == 0 && str[i] == 0);
+         return GetView().EqualsN(str, n);
       }
 
       template <class T, class TAlloc>
@@ -618,8 +670,7 @@ namespace core
       template <class T, class TAlloc>
       inline String<T, TAlloc> &String<T, TAlloc>::Append(const T character)
       {
-         if (used + 1 > allocated)
-            Reallocate(used + 1);
+         Grow(used + 1);
 
          used++;
 
@@ -635,26 +686,22 @@ namespace core
          if (!other)
             return *this;
 
+         // stops at length, other doesn't have to be terminated then
          uint32 len = 0;
          const T* p = other;
-         while (*p)
+         while (len < length && *p)
          {
             len++;
             p++;
          }
-         if (len > length)
-            len = length;
 
-         if (used + len > allocated)
-            Reallocate(used + len);
+         Grow(used + len);
 
          used--;
-         len++;
-
-         for (uint32 i = 0; i < len; i++)
-            strArray[i + used] = *(other + i);
-
+         memcpy(strArray + used, other, len * sizeof(T));
          used += len;
+         strArray[used] = 0;
+         used++;
 
          return *this;
       }
@@ -665,15 +712,11 @@ namespace core
          if (other.GetSize() == 0)
             return *this;
 
-         used--;
-         int len = other.GetSize() + 1;
-
-         if (used + len > allocated)
-            Reallocate(used + len);
-
-         for (int i = 0; i < len; i++)
-            strArray[used + i] = other[i];
+         const uint32 len = other.GetSize() + 1;
+         Grow(used - 1 + len);
 
+         used--;
+         memcpy(strArray + used, other.strArray, len * sizeof(T));
          used += len;
 
          return *this;
@@ -691,17 +734,7 @@ namespace core
       template <class T, class TAlloc>
       inline String<T, TAlloc> &String<T, TAlloc>::operator+=(const char character)
       {
-         // Append the given string into a new string
-         char *sub = new (used + 1) char(NULL);
-
-         memcpy(sub, strArray, len);
-         //sub[len] = c;
-         //sub[len+1] = 0;
-
-         //_string->release();
-         //_string = sub;
-
-         return *this;
+         return Append((T)character);
       }
 
       template <class T, class TAlloc>
@@ -751,17 +784,35 @@ namespace core
          if (this == &other)
             return *this;
 
-         used = other.GetSize() + 1;
-         if (used > allocated)
+         if (other.used > allocated)
          {
-            allocator.Free(strArray);
-            allocated = used;
-            strArray = allocator.Allocate(used); //new T[used];
+            FreeBuffer();
+            allocated = other.used;
+            strArray = allocator.Allocate(other.used); //new T[used];
          }
 
-         const T* p = other.CString();
-         for (uint32 i = 0; i < used; i++, p++)
-            strArray[i] = *p;
+         used = other.used;
+         memcpy(strArray, other.strArray, used * sizeof(T));
+
+         return *this;
+      }
+
+      template <class T, class TAlloc>
+      String<T, TAlloc> &String<T, TAlloc>::operator=(String<T, TAlloc> &&other)
+      {
+         if (this == &other)
+            return *this;
+
+         // short strings are copied, long ones hand over their buffer together with the allocator it came from
+         if (other.IsLocal())
+            return *this = other;
+
+         FreeBuffer();
+         allocator = other.allocator;
+         strArray = other.strArray;
+         allocated = other.allocated;
+         used = other.used;
+         other.InitLocal();
 
          return *this;
       }
@@ -905,7 +956,7 @@ namespace core
                {
                   if ((!ignoreEmptyTokens || i - lastpos != 0) &&
                      !lastWasSeparator)
-                     ret.push_back(String<T, TAlloc>(&strArray[lastpos], i - lastpos));
+                     ret.push_back(typename TContainer::value_type(&strArray[lastpos], i - lastpos));
                   foundSeparator = true;
                   lastpos = (keepSeparators ? i : i + 1);
                   break;
@@ -914,7 +965,7 @@ namespace core
             lastWasSeparator = foundSeparator;
          }
          if ((used - 1) > lastpos)
-            ret.push_back(String<T, TAlloc>(&strArray[lastpos], (used - 1) - lastpos));
+            ret.push_back(typename TContainer::value_type(&strArray[lastpos], (used - 1) - lastpos));
          return ret.size() - oldSize;
       }
 
@@ -967,7 +1018,7 @@ namespace core
       template <class T, class TAlloc>
       void String<T, TAlloc>::Reserve(const uint32 count)
       {
-         if (count < allocated)
+         if (count <= allocated)
             return;
 
          Reallocate(count);
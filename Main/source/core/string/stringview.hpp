@@ -0,0 +1,263 @@
+#ifndef _STRINGVIEW_HPP_INCLUDED_
+#define _STRINGVIEW_HPP_INCLUDED_
+
+#include <assert.h>
+
+#include "core/chartypes.hpp"
+#include "core/fast_atof.hpp"
+
+namespace core
+{
+
+   namespace string
+   {
+
+      // Non-owning view of a range of characters, not necessarily zero-terminated. The viewed
+      // string has to outlive the view. Tokenizing into views and parsing them allocates nothing
+      template <class T>
+      class StringView
+      {
+      private:
+         const T *data;
+         uint32 length;
+
+      public:
+         StringView() : data(NULL), length(0) {}
+         StringView(const T* const str, const uint32 length) : data(str), length(length) {}
+         StringView(const T* const str) : data(str), length(0)
+         {
+            if (str)
+               while (str[length])
+                  length++;
+         }
+
+         const T *GetData() const { return data; }
+         uint32 GetSize() const { return length; }
+         bool IsEmpty() const { return length == 0; }
+         const T *Begin() const { return data; }
+         const T *End() const { return data + length; }
+
+         T operator[](const uint32 index) const
+         {
+            assert(index < length);
+            return data[index];
+         }
+
+         bool operator==(const StringView &other) const;
+         bool operator==(const T* const str) const;
+         bool operator!=(const StringView &other) const { return !(*this == other); }
+         bool operator!=(const T* const str) const { return !(*this == str); }
+
+         // the first n characters are equal, or both are shorter than n and equal
+         bool EqualsN(const StringView &other, const uint32 n) const;
+         bool EqualsN(const T* const str, const uint32 n) const;
+
+         int32 FindFirst(const T c) const;
+         int32 FindNext(const T c, const uint32 startPos) const;
+         int32 FindNextNumber(const uint32 startPos) const;
+
+         // clamped to the view like String::SubString
+         StringView SubView(const uint32 begin, const uint32 length = 0xffffffff) const;
+         // without leading and trailing spaces, tabs and line ends
+         StringView Trim() const;
+
+         int32 StringToInt() const; // return the first int32 value in the view or return INT32_MAX if not found
+         float StringToFloat() const; // return the first float value in the view or return FLOAT_MAX if not found
+
+         // same rules as String::Tokenize, ret is a container of StringView
+         template <class TContainer> int32 Tokenize(TContainer &ret, const T* const delimiter = " \t\r\n", const int32 count = 1,
+            const bool ignoreEmptyTokens = true, const bool keepSeparators = false) const;
+      };
+
+      typedef StringView<char> StringView_c;
+      typedef StringView<wchar_t> StringView_w;
+
+      // number parsing on bounded ranges, wide characters are narrowed into a small buffer first.
+      // out receives the position behind the number, like the out parameter of fast_atof
+      inline float ParseFloat(const char *begin, const char *end, const char **out = 0)
+      {
+         float value;
+         const char *stop = Assimp::fast_atoreal_move_n<float>(begin, end, value);
+         if (out)*out = stop;
+         return value;
+      }
+
+      inline int32 ParseInt(const char *begin, const char *end, const char **out = 0)
+      {
+         return Assimp::strtol10_n(begin, end, out);
+      }
+
+      inline float ParseFloat(const wchar_t *begin, const wchar_t *end)
+      {
+         char buffer[64];
+         uint32 length = 0;
+         for (; begin != end && length < sizeof(buffer); begin++)
+            buffer[length++] = (char)*begin;
+         return ParseFloat(buffer, buffer + length);
+      }
+
+      inline int32 ParseInt(const wchar_t *begin, const wchar_t *end)
+      {
+         char buffer[16];
+         uint32 length = 0;
+         for (; begin != end && length < sizeof(buffer); begin++)
+            buffer[length++] = (char)*begin;
+         return ParseInt(buffer, buffer + length);
+      }
+
+      template <class T>
+      bool StringView<T>::operator==(const StringView<T> &other) const
+      {
+         if (length != other.length)
+            return false;
+         for (uint32 i = 0; i < length; i++)
+            if (data[i] != other.data[i])
+               return false;
+         return true;
+      }
+
+      template <class T>
+      bool StringView<T>::operator==(const T* const str) const
+      {
+         if (!str)
+            return false;
+
+         uint32 i;
+         for (i = 0; i < length && str[i]; i++)
+            if (data[i] != str[i])
+               return false;
+         return i == length && !str[i];
+      }
+
+      template <class T>
+      bool StringView<T>::EqualsN(const StringView<T> &other, const uint32 n) const
+      {
+         uint32 i;
+         for (i = 0; i < n && i < length && i < other.length; i++)
+            if (data[i] != other.data[i])
+               return false;
+
+         // if one (or both) of the views was shorter they are only equal with the same length
+         return (i == n) || (length == other.length);
+      }
+
+      template <class T>
+      bool StringView<T>::EqualsN(const T* const str, const uint32 n) const
+      {
+         if (!str)
+            return false;
+
+         uint32 i;
+         for (i = 0; i < n && i < length && str[i]; i++)
+            if (data[i] != str[i])
+               return false;
+
+         return (i == n) || (i == length && !str[i]);
+      }
+
+      template <class T>
+      int32 StringView<T>::FindFirst(const T c) const
+      {
+         return FindNext(c, 0);
+      }
+
+      template <class T>
+      int32 StringView<T>::FindNext(const T c, const uint32 startPos) const
+      {
+         for (uint32 i = startPos; i < length; i++)
+            if (data[i] == c)
+               return i;
+         return -1;
+      }
+
+      template <class T>
+      int32 StringView<T>::FindNextNumber(const uint32 startPos) const
+      {
+         for (uint32 i = startPos; i < length; i++)
+         {
+            if (IsADigit(data[i]))
+            {
+               if (i != 0 && data[i - 1] == '-')
+                  return i - 1;
+               return i;
+            }
+         }
+         return -1;
+      }
+
+      template <class T>
+      StringView<T> StringView<T>::SubView(const uint32 begin, const uint32 length) const
+      {
+         if (begin >= this->length)
+            return StringView<T>(data + this->length, 0);
+         const uint32 rest = this->length - begin;
+         return StringView<T>(data + begin, length < rest ? length : rest);
+      }
+
+      template <class T>
+      StringView<T> StringView<T>::Trim() const
+      {
+         uint32 begin = 0;
+         uint32 end = length;
+         while (begin < end && IsSpaceOrNewLine(data[begin]))
+            begin++;
+         while (end > begin && IsSpaceOrNewLine(data[end - 1]))
+            end--;
+         return StringView<T>(data + begin, end - begin);
+      }
+
+      template <class T>
+      int32 StringView<T>::StringToInt() const
+      {
+         const int32 index = FindNextNumber(0);
+         if (index == -1)
+            return INT32_MAX;
+         return ParseInt(data + index, data + length);
+      }
+
+      template <class T>
+      float StringView<T>::StringToFloat() const
+      {
+         const int32 index = FindNextNumber(0);
+         if (index == -1)
+            return FLOAT_MAX;
+         return ParseFloat(data + index, data + length);
+      }
+
+      template <class T>
+      template <class TContainer>
+      int32 StringView<T>::Tokenize(TContainer &ret, const T* const delimiter, const int32 count,
+         const bool ignoreEmptyTokens, const bool keepSeparators) const
+      {
+         if (!delimiter)
+            return 0;
+
+         const int32 oldSize = (int32)ret.size();
+         uint32 lastpos = 0;
+         bool lastWasSeparator = false;
+         for (uint32 i = 0; i < length; i++)
+         {
+            bool foundSeparator = false;
+            for (int32 j = 0; j < count; j++)
+            {
+               if (data[i] == delimiter[j])
+               {
+                  if ((!ignoreEmptyTokens || i - lastpos != 0) && !lastWasSeparator)
+                     ret.push_back(StringView<T>(data + lastpos, i - lastpos));
+                  foundSeparator = true;
+                  lastpos = (keepSeparators ? i : i + 1);
+                  break;
+               }
+            }
+            lastWasSeparator = foundSeparator;
+         }
+         if (length > lastpos)
+            ret.push_back(StringView<T>(data + lastpos, length - lastpos));
+         return (int32)ret.size() - oldSize;
+      }
+
+   } // namespace string
+
+} // namespace core
+
+#endif
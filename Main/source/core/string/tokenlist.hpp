@@ -0,0 +1,92 @@
+#ifndef _TOKENLIST_HPP_INCLUDED_
+#define _TOKENLIST_HPP_INCLUDED_
+
+#include <assert.h>
+
+#include "core/string/stringview.hpp"
+
+namespace core
+{
+
+   namespace string
+   {
+
+      template <class T>
+      inline bool IsDelimiter(const T c, const T* delimiters)
+      {
+         for (; *delimiters; delimiters++)
+            if (c == *delimiters)
+               return true;
+         return false;
+      }
+
+      // Cuts the next token off the front of rest, skipping delimiters before it. Returns false
+      // when only delimiters are left. Use it directly for lists of unknown length
+      template <class T>
+      bool NextToken(StringView<T> &rest, StringView<T> &tokenOut, const T* const delimiters)
+      {
+         const T* p = rest.Begin();
+         const T* const end = rest.End();
+         while (p != end && IsDelimiter(*p, delimiters))
+            p++;
+         if (p == end)
+         {
+            rest = StringView<T>(end, 0);
+            return false;
+         }
+
+         const T* const tokenBegin = p;
+         while (p != end && !IsDelimiter(*p, delimiters))
+            p++;
+
+         tokenOut = StringView<T>(tokenBegin, (uint32)(p - tokenBegin));
+         rest = StringView<T>(p, (uint32)(end - p));
+         return true;
+      }
+
+      // Splits a line into at most N tokens stored in place, nothing is allocated. The tokens view
+      // the line, which has to outlive them. Tokens beyond N are dropped and IsTruncated is set,
+      // GetRest returns the unsplit remainder of the line after the last stored token
+      template <class T, uint32 N>
+      class TokenList
+      {
+      private:
+         StringView<T> tokens[N];
+         StringView<T> rest;
+         uint32 count;
+         bool truncated;
+
+      public:
+         TokenList() : count(0), truncated(false) {}
+
+         uint32 Split(const StringView<T> &line, const T* const delimiters)
+         {
+            rest = line;
+            count = 0;
+            StringView<T> token;
+            while (count < N && NextToken(rest, token, delimiters))
+               tokens[count++] = token;
+
+            StringView<T> ignored;
+            StringView<T> tmp = rest;
+            truncated = NextToken(tmp, ignored, delimiters);
+            return count;
+         }
+
+         uint32 GetSize() const { return count; }
+         bool IsEmpty() const { return count == 0; }
+         bool IsTruncated() const { return truncated; }
+         const StringView<T> &GetRest() const { return rest; }
+
+         const StringView<T> &operator[](const uint32 index) const
+         {
+            assert(index < count);
+            return tokens[index];
+         }
+      };
+
+   } // namespace string
+
+} // namespace core
+
+#endif
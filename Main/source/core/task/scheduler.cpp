@@ -0,0 +1,284 @@
+#include "core/task/scheduler.hpp"
+
+#include <new>
+
+#include "core/memory/threadcache.hpp"
+
+TaskScheduler *TaskScheduler::active = NULL;
+
+// the scheduler and queue index of the calling thread, plain data for __declspec(thread)
+static __declspec(thread) TaskScheduler *threadScheduler;
+static __declspec(thread) int32 threadIndex;
+static __declspec(thread) uint32 threadRandom;
+
+// a few rounds of looking for work before a worker goes to sleep
+static const uint32 SPIN_COUNT = 64;
+
+Task::Task( const TaskFunction &function, Task *parent ) : function(function), parent(parent)
+{
+   unfinished = 1;
+   dependencies = 1;
+   references = 2; // the creator and the scheduler
+   completed = false;
+}
+
+TaskScheduler::TaskScheduler( const uint32 numThreads )
+{
+   uint32 count = numThreads;
+   if ( count == 0 )
+      count = std::thread::hardware_concurrency();
+   if ( count == 0 )
+      count = 1;
+
+   numInjected = 0;
+   numQueued = 0;
+   numSleeping = 0;
+   stop = false;
+
+   for ( uint32 i = 0; i < count; i++ )
+      queues.push_back( new TaskQueue() );
+
+   previousScheduler = threadScheduler;
+   previousIndex = threadIndex;
+   threadScheduler = this;
+   threadIndex = 0;
+   for ( uint32 i = 1; i < count; i++ )
+      workers.push_back( std::thread( &TaskScheduler::WorkerLoop, this, i ) );
+}
+
+TaskScheduler::~TaskScheduler()
+{
+   stop = true;
+   {
+      std::lock_guard<std::mutex> lock( sleepMutex );
+      sleepCondition.notify_all();
+   }
+   for ( uint32 i = 0; i < workers.size(); i++ )
+      workers[i].join();
+
+   for ( uint32 i = 0; i < queues.size(); i++ )
+      delete queues[i];
+
+   if ( threadScheduler == this )
+   {
+      threadScheduler = previousScheduler;
+      threadIndex = previousIndex;
+   }
+   if ( active == this )
+      active = NULL;
+}
+
+// -1 for threads outside the scheduler
+int32 TaskScheduler::GetThreadIndex() const
+{
+   return threadScheduler == this ? threadIndex : -1;
+}
+
+void TaskScheduler::WorkerLoop( const uint32 index )
+{
+   threadScheduler = this;
+   threadIndex = (int32)index;
+   threadRandom = index * 2654435761u + 1;
+
+   while ( !stop.load() )
+   {
+      Task *task = NULL;
+      for ( uint32 i = 0; i < SPIN_COUNT && task == NULL; i++ )
+      {
+         task = GetTask( index );
+         if ( task == NULL )
+            std::this_thread::yield();
+      }
+
+      if ( task != NULL )
+      {
+         Execute( task );
+         continue;
+      }
+
+      // Schedule checks numSleeping after raising numQueued, so either it sees this worker
+      // sleeping and notifies it or the worker sees the new task and does not sleep
+      std::unique_lock<std::mutex> lock( sleepMutex );
+      numSleeping++;
+      while ( numQueued.load() <= 0 && !stop.load() )
+         sleepCondition.wait( lock );
+      numSleeping--;
+   }
+
+   threadcache::FlushThread();
+}
+
+Task *TaskScheduler::GetTask( const int32 index )
+{
+   Task *task = index >= 0 ? queues[index]->Pop() : NULL;
+
+   if ( task == NULL && numInjected.load() > 0 )
+   {
+      std::lock_guard<std::mutex> lock( injectedMutex );
+      if ( !injected.empty() )
+      {
+         task = injected.front();
+         injected.pop_front();
+         numInjected--;
+      }
+   }
+
+   if ( task == NULL && queues.size() > 1 )
+   {
+      // xorshift, a random first victim keeps the thieves from piling onto the same queue
+      uint32 random = threadRandom != 0 ? threadRandom : 0x9e3779b9;
+      random ^= random << 13;
+      random ^= random >> 17;
+      random ^= random << 5;
+      threadRandom = random;
+
+      const uint32 numQueues = (uint32)queues.size();
+      const uint32 first = random % numQueues;
+      for ( uint32 i = 0; i < numQueues && task == NULL; i++ )
+      {
+         const uint32 victim = (first + i) % numQueues;
+         if ( (int32)victim != index )
+            task = queues[victim]->Steal();
+      }
+   }
+
+   if ( task != NULL )
+      numQueued--;
+   return task;
+}
+
+Task *TaskScheduler::CreateTask( const TaskFunction &function, Task *parent )
+{
+   Task *task = new ( threadcache::Allocate( sizeof(Task) ) ) Task( function, parent );
+   if ( parent != NULL )
+      parent->unfinished++;
+   return task;
+}
+
+void TaskScheduler::AddDependency( Task *task, Task *dependency )
+{
+   std::lock_guard<std::mutex> lock( dependency->continuationMutex );
+   if ( dependency->completed )
+      return;
+
+   task->dependencies++;
+   task->references++; // held by the dependency until it completes
+   dependency->continuations.push_back( task );
+}
+
+void TaskScheduler::Run( Task *task )
+{
+   if ( --task->dependencies == 0 )
+      Schedule( task );
+}
+
+void TaskScheduler::Schedule( Task *task )
+{
+   numQueued++;
+
+   const int32 index = GetThreadIndex();
+   if ( index >= 0 )
+   {
+      if ( !queues[index]->Push( task ) )
+      {
+         // the deque is full, there is plenty of work for the others already
+         numQueued--;
+         Execute( task );
+         return;
+      }
+   }
+   else
+   {
+      std::lock_guard<std::mutex> lock( injectedMutex );
+      injected.push_back( task );
+      numInjected++;
+   }
+
+   if ( numSleeping.load() > 0 )
+   {
+      std::lock_guard<std::mutex> lock( sleepMutex );
+      sleepCondition.notify_one();
+   }
+}
+
+void TaskScheduler::Execute( Task *task )
+{
+   // an exception must not leave a worker thread, nor skip Finish, which the parent waits for
+   try
+   {
+      if ( task->function )
+         task->function();
+   }
+   catch ( ... )
+   {
+      SetException( task, std::current_exception() );
+   }
+   Finish( task );
+}
+
+void TaskScheduler::SetException( Task *task, const std::exception_ptr &exception )
+{
+   std::lock_guard<std::mutex> lock( task->continuationMutex );
+   if ( !task->exception )
+      task->exception = exception;
+}
+
+void TaskScheduler::Finish( Task *task )
+{
+   if ( --task->unfinished == 0 )
+      Complete( task );
+}
+
+void TaskScheduler::Complete( Task *task )
+{
+   std::vector<Task*> continuations;
+   {
+      std::lock_guard<std::mutex> lock( task->continuationMutex );
+      task->completed = true;
+      continuations.swap( task->continuations );
+   }
+
+   for ( uint32 i = 0; i < continuations.size(); i++ )
+   {
+      Run( continuations[i] );
+      Release( continuations[i] );
+   }
+
+   Task *parent = task->parent;
+   if ( parent != NULL && task->exception )
+      SetException( parent, task->exception );
+   Release( task );
+   if ( parent != NULL )
+      Finish( parent );
+}
+
+void TaskScheduler::Wait( Task *task )
+{
+   const int32 index = GetThreadIndex();
+   while ( !task->IsDone() )
+   {
+      Task *other = GetTask( index );
+      if ( other != NULL )
+         Execute( other );
+      else
+         std::this_thread::yield();
+   }
+
+   std::exception_ptr exception;
+   {
+      std::lock_guard<std::mutex> lock( task->continuationMutex );
+      exception = task->exception;
+   }
+   Release( task );
+   if ( exception )
+      std::rethrow_exception( exception );
+}
+
+void TaskScheduler::Release( Task *task )
+{
+   if ( --task->references == 0 )
+   {
+      task->~Task();
+      threadcache::Free( task, sizeof(Task) );
+   }
+}
@@ -0,0 +1,160 @@
+#ifndef _SCHEDULER_HPP_INCLUDED_
+#define _SCHEDULER_HPP_INCLUDED_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/task/workstealingqueue.hpp"
+
+typedef std::function<void()> TaskFunction;
+
+// Unit of work of the TaskScheduler. A task is done when its function and all of its child tasks
+// have finished. Every task returned by CreateTask has to be passed to Wait or Release once.
+// An exception thrown by the function is kept and handed up to the parent, Wait rethrows it
+class Task
+{
+private:
+   friend class TaskScheduler;
+
+   TaskFunction function;
+   Task *parent;
+   std::atomic<int32> unfinished; // the task itself and its children
+   std::atomic<int32> dependencies; // unfinished dependencies plus one for the missing Run
+   std::atomic<int32> references;
+   std::mutex continuationMutex;
+   std::vector<Task*> continuations; // run when this task is done
+   bool completed;
+   std::exception_ptr exception; // the first one thrown by the task or its children, under continuationMutex
+
+   Task( const TaskFunction &function, Task *parent );
+   Task( const Task &other );
+   Task &operator=( const Task &other );
+public:
+   bool IsDone() const { return unfinished.load() == 0; }
+};
+
+// Work-stealing scheduler. Every worker thread and the thread that created the scheduler own a
+// Chase-Lev deque. New tasks go to the deque of the thread that creates them, a thread that runs
+// out of work steals the oldest task of a random other thread. Threads that are not part of the
+// scheduler hand their tasks over through a locked queue.
+//
+// Waiting never blocks a thread that can work: Wait runs other tasks until the awaited one is
+// done, so the main thread helps instead of idling. One scheduler is made active for the engine,
+// parsing, culling and the like find it through GetActive instead of starting threads of their own
+class TaskScheduler
+{
+private:
+   typedef WorkStealingQueue<Task> TaskQueue;
+
+   std::vector<TaskQueue*> queues; // 0 belongs to the creating thread
+   std::vector<std::thread> workers;
+   std::deque<Task*> injected; // tasks from threads outside the scheduler
+   std::mutex injectedMutex;
+   std::atomic<int32> numInjected;
+   std::atomic<int32> numQueued; // tasks in any queue, sleeping workers wake up for them
+   std::atomic<int32> numSleeping;
+   std::mutex sleepMutex;
+   std::condition_variable sleepCondition;
+   std::atomic<bool> stop;
+   // scheduler of the creating thread before this one, it is its scheduler again after the destructor
+   TaskScheduler *previousScheduler;
+   int32 previousIndex;
+
+   static TaskScheduler *active;
+
+   int32 GetThreadIndex() const;
+   void WorkerLoop( const uint32 index );
+   Task *GetTask( const int32 index );
+   void Schedule( Task *task );
+   void Execute( Task *task );
+   void Finish( Task *task );
+   void Complete( Task *task );
+   void SetException( Task *task, const std::exception_ptr &exception );
+
+   template <class F>
+   void RunRange( Task *parent, uint32 begin, uint32 end, const uint32 grainSize, const F &body );
+
+   TaskScheduler( const TaskScheduler &other );
+   TaskScheduler &operator=( const TaskScheduler &other );
+public:
+   // numThreads counts the creating thread, 0 uses one thread per hardware thread
+   TaskScheduler( const uint32 numThreads = 0 );
+   // tasks still queued are not run, wait for them before
+   ~TaskScheduler();
+
+   // the task is a child of parent, parent is not done before it. The task does not run before Run
+   Task *CreateTask( const TaskFunction &function, Task *parent = NULL );
+   // task runs after dependency is done, call it before Run( task )
+   void AddDependency( Task *task, Task *dependency );
+   void Run( Task *task );
+   // runs other tasks until task is done, then releases it. Rethrows the first exception thrown by
+   // the task or one of its children, after all of them have finished
+   void Wait( Task *task );
+   void Release( Task *task );
+
+   // calls body( rangeBegin, rangeEnd ) for pieces of [begin, end) of at most grainSize elements,
+   // returns when all are done. Ranges are split in halves, so idle threads steal big pieces.
+   // An exception thrown by body is rethrown once every piece has finished
+   template <class F>
+   void ParallelFor( const uint32 begin, const uint32 end, const uint32 grainSize, const F &body );
+
+   uint32 GetNumThreads() const { return (uint32)queues.size(); }
+
+   static void SetActive( TaskScheduler *scheduler ) { active = scheduler; }
+   static TaskScheduler *GetActive() { return active; }
+};
+
+template <class F>
+void TaskScheduler::RunRange( Task *parent, uint32 begin, uint32 end, const uint32 grainSize, const F &body )
+{
+   // hand the upper halves to thieves, keep the lower part
+   while ( end - begin > grainSize )
+   {
+      const uint32 middle = begin + (end - begin) / 2;
+      const uint32 rangeEnd = end;
+      Task *upper = CreateTask( [this, parent, middle, rangeEnd, grainSize, &body]()
+      {
+         RunRange( parent, middle, rangeEnd, grainSize, body );
+      }, parent );
+      Run( upper );
+      Release( upper );
+      end = middle;
+   }
+   body( begin, end );
+}
+
+template <class F>
+void TaskScheduler::ParallelFor( const uint32 begin, const uint32 end, const uint32 grainSize, const F &body )
+{
+   if ( begin >= end )
+      return;
+
+   const uint32 grain = grainSize > 0 ? grainSize : 1;
+   if ( end - begin <= grain )
+   {
+      body( begin, end );
+      return;
+   }
+
+   // the ranges are children of an empty root, the calling thread takes the first one itself
+   Task *root = CreateTask( TaskFunction() );
+   try
+   {
+      RunRange( root, begin, end, grain, body );
+   }
+   catch ( ... )
+   {
+      // the pieces already handed out still use body, Wait rethrows once they are done
+      SetException( root, std::current_exception() );
+   }
+   Run( root );
+   Wait( root );
+}
+
+#endif
@@ -0,0 +1,108 @@
+#include "core/task/schedulerbench.hpp"
+#include "core/task/scheduler.hpp"
+#include "core/bench/benchtimer.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+// elements per piece of the ParallelFor and small tasks per iteration
+static const uint32 BENCH_GRAIN = 4096;
+static const uint32 BENCH_NUM_TASKS = 16384;
+
+// enough arithmetic per element that the loop is not bound by memory bandwidth
+static void ComputeRange( float *out, const uint32 begin, const uint32 end )
+{
+   for ( uint32 i = begin; i < end; i++ )
+   {
+      const float x = (float)i * 0.001f;
+      out[i] = sqrtf( x ) * sinf( x ) + cosf( x * 0.5f );
+   }
+}
+
+static uint32 GetMaxThreads( const uint32 maxThreads )
+{
+   uint32 count = maxThreads;
+   if ( count == 0 )
+      count = std::thread::hardware_concurrency();
+   return count > 0 ? count : 1;
+}
+
+uint32 GetNumSchedulerBenchmarks( const uint32 maxThreads )
+{
+   const uint32 count = GetMaxThreads( maxThreads );
+   uint32 numResults = 0;
+   for ( uint32 threads = 1; threads < count; threads *= 2 )
+      numResults++;
+   return numResults + 1;
+}
+
+uint32 RunSchedulerBenchmarks( SchedulerBenchResult *results, const uint32 maxThreads, const uint32 count,
+   const uint32 iterations )
+{
+   const uint32 threadLimit = GetMaxThreads( maxThreads );
+
+   std::vector<float> reference( count ), output( count );
+   ComputeRange( reference.empty() ? NULL : &reference[0], 0, count );
+
+   uint32 numResults = 0;
+   for ( uint32 threads = 1; ; threads *= 2 )
+   {
+      if ( threads > threadLimit )
+         threads = threadLimit;
+
+      SchedulerBenchResult &r = results[numResults++];
+      r.numThreads = threads;
+
+      TaskScheduler scheduler( threads );
+      float *out = output.empty() ? NULL : &output[0];
+
+      BenchTimer parallelForTimer;
+      for ( uint32 it = 0; it < iterations; it++ )
+      {
+         scheduler.ParallelFor( 0, count, BENCH_GRAIN, [out]( uint32 begin, uint32 end )
+         {
+            ComputeRange( out, begin, end );
+         } );
+      }
+      r.parallelForMs = parallelForTimer.GetMilliSecs();
+      r.isCorrect = output == reference;
+
+      std::atomic<uint32> numRun( 0 );
+      BenchTimer tasksTimer;
+      for ( uint32 it = 0; it < iterations; it++ )
+      {
+         Task *root = scheduler.CreateTask( TaskFunction() );
+         for ( uint32 i = 0; i < BENCH_NUM_TASKS; i++ )
+         {
+            Task *task = scheduler.CreateTask( [&numRun]() { numRun++; }, root );
+            scheduler.Run( task );
+            scheduler.Release( task );
+         }
+         scheduler.Run( root );
+         scheduler.Wait( root );
+      }
+      r.tasksMs = tasksTimer.GetMilliSecs();
+      r.isCorrect = r.isCorrect && numRun.load() == BENCH_NUM_TASKS * iterations;
+
+      if ( threads == threadLimit )
+         break;
+   }
+   return numResults;
+}
+
+void PrintSchedulerBenchmarks( const uint32 maxThreads, const uint32 count, const uint32 iterations )
+{
+   std::vector<SchedulerBenchResult> results( GetNumSchedulerBenchmarks( maxThreads ) );
+   const uint32 numResults = RunSchedulerBenchmarks( &results[0], maxThreads, count, iterations );
+
+   printf( "%u elements, %u tasks x %u iterations\n", count, BENCH_NUM_TASKS, iterations );
+   printf( "%8s %16s %8s %12s %8s %8s\n", "threads", "ParallelFor ms", "speedup", "tasks ms", "speedup", "correct" );
+   for ( uint32 i = 0; i < numResults; i++ )
+   {
+      const SchedulerBenchResult &r = results[i];
+      printf( "%8u %16.3f %7.2fx %12.3f %7.2fx %8s\n", r.numThreads, r.parallelForMs,
+         r.parallelForMs > 0.0 ? results[0].parallelForMs / r.parallelForMs : 0.0, r.tasksMs,
+         r.tasksMs > 0.0 ? results[0].tasksMs / r.tasksMs : 0.0, r.isCorrect ? "yes" : "NO" );
+   }
+}
@@ -0,0 +1,27 @@
+#ifndef _SCHEDULERBENCH_HPP_INCLUDED_
+#define _SCHEDULERBENCH_HPP_INCLUDED_
+
+#include "core/BasicTypes.hpp"
+
+// timings of one thread count, a TaskScheduler of numThreads threads running the same work
+struct SchedulerBenchResult
+{
+   uint32 numThreads;
+   double parallelForMs; // ParallelFor over a compute bound loop
+   double tasksMs; // many small child tasks of one root, mostly scheduling overhead
+   bool isCorrect; // the ParallelFor result matches the single threaded one
+};
+
+// run the benchmarks with schedulers of 1 to maxThreads threads, doubling every step, 0 is one
+// per hardware thread. The schedulers are created for the benchmark, the calling thread gets its
+// previous scheduler back afterwards. results needs room for GetNumSchedulerBenchmarks entries,
+// returns the number of entries filled in
+uint32 RunSchedulerBenchmarks( SchedulerBenchResult *results, const uint32 maxThreads = 0,
+   const uint32 count = 1 << 22, const uint32 iterations = 10 );
+
+uint32 GetNumSchedulerBenchmarks( const uint32 maxThreads = 0 );
+
+// run the benchmarks and print a table to stdout, the speedup is against one thread
+void PrintSchedulerBenchmarks( const uint32 maxThreads = 0, const uint32 count = 1 << 22, const uint32 iterations = 10 );
+
+#endif
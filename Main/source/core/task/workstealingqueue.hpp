@@ -0,0 +1,97 @@
+#ifndef _WORKSTEALINGQUEUE_HPP_INCLUDED_
+#define _WORKSTEALINGQUEUE_HPP_INCLUDED_
+
+#include <atomic>
+
+#include "core/BasicTypes.hpp"
+
+// Chase-Lev deque of pointers. The owning thread pushes and pops at the bottom (LIFO, the data it
+// just touched is still in its cache), any other thread steals from the top (FIFO, the oldest
+// and usually biggest pieces of work). Only Steal needs a compare and swap, and only when it
+// races with the owner for the last item. The capacity is fixed, Push fails when it is full
+template <class T, uint32 CAPACITY = 4096>
+class WorkStealingQueue
+{
+private:
+   static const int64 MASK = CAPACITY - 1;
+
+   // owner and thieves write different ends, keep them on different cache lines
+   std::atomic<int64> top;
+   char padding0[64];
+   std::atomic<int64> bottom;
+   char padding1[64];
+   std::atomic<T*> items[CAPACITY];
+
+   WorkStealingQueue( const WorkStealingQueue &other );
+   WorkStealingQueue &operator=( const WorkStealingQueue &other );
+public:
+   WorkStealingQueue()
+   {
+      static_assert( (CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two" );
+      top.store( 0 );
+      bottom.store( 0 );
+   }
+
+   // owner only
+   bool Push( T *item )
+   {
+      const int64 b = bottom.load( std::memory_order_relaxed );
+      const int64 t = top.load( std::memory_order_acquire );
+      if ( b - t >= (int64)CAPACITY )
+         return false;
+
+      items[b & MASK].store( item, std::memory_order_relaxed );
+      std::atomic_thread_fence( std::memory_order_release );
+      bottom.store( b + 1, std::memory_order_relaxed );
+      return true;
+   }
+
+   // owner only, NULL when empty
+   T *Pop()
+   {
+      const int64 b = bottom.load( std::memory_order_relaxed ) - 1;
+      bottom.store( b, std::memory_order_relaxed );
+      std::atomic_thread_fence( std::memory_order_seq_cst );
+      int64 t = top.load( std::memory_order_relaxed );
+
+      if ( t > b )
+      {
+         // was empty
+         bottom.store( b + 1, std::memory_order_relaxed );
+         return NULL;
+      }
+
+      T *item = items[b & MASK].load( std::memory_order_relaxed );
+      if ( t == b )
+      {
+         // last item, race the thieves for it
+         if ( !top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+            item = NULL;
+         bottom.store( b + 1, std::memory_order_relaxed );
+      }
+      return item;
+   }
+
+   // any thread, NULL when empty or when another thread got the item first
+   T *Steal()
+   {
+      int64 t = top.load( std::memory_order_acquire );
+      std::atomic_thread_fence( std::memory_order_seq_cst );
+      const int64 b = bottom.load( std::memory_order_acquire );
+      if ( t >= b )
+         return NULL;
+
+      T *item = items[t & MASK].load( std::memory_order_relaxed );
+      if ( !top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+         return NULL;
+      return item;
+   }
+
+   // a snapshot, only exact on the owning thread
+   bool IsEmpty() const
+   {
+      return bottom.load( std::memory_order_relaxed ) <= top.load( std::memory_order_relaxed );
+   }
+};
+
+#endif
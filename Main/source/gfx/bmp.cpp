@@ -1,11 +1,22 @@
 #include "bmp.hpp"
 
+bool BMPFile::Open( const String_c &path )
+{
+   // headers and pixel rows are read in small pieces, the reader fetches the file in blocks
+   return reader.Open( path, 64 * 1024 );
+}
+
+void BMPFile::Close()
+{
+   reader.Close();
+}
+
 bool BMPFile::ReadBMP( void )
 {
-	//if (!ReadHeader())
-	//{
-	//	return false;
-	//}
+   if (!ReadHeader())
+   {
+      return false;
+   }
 
   // for (int row = header.height - 1; row >= 0; row--)
   // {
@@ -20,7 +31,7 @@ bool BMPFile::ReadBMP( void )
 		//	{
 		//	case 8:
 		//		//palIndex = *buf_p++;
-  //          palIndex = GetByte();
+  //          palIndex = reader.ReadU8();
   //          *pixelBuffer++ = header.palette[palIndex][2];
   //          *pixelBuffer++ = header.palette[palIndex][1];
   //          *pixelBuffer++ = header.palette[palIndex][0];
@@ -63,77 +74,85 @@ bool BMPFile::ReadBMP( void )
 
    return true;
 }
-//
-//bool BMPFile::ReadHeader( void )
-//{
-//   header.id[0] = GetByte();
-//	header.id[1] = GetByte();
-//	if ( header.id[0] != 'B' && header.id[1] != 'M' ) 
-//	{
-//      return false;
-//		//ri.Error( ERR_DROP, "LoadBMP: only Windows-style BMP files supported (%s)\n", name );
-//	}
-//
-//	header.fileSize = GetLittleEndianLong();
-//   if ( header.fileSize != fileSize )
-//   {
-//      return false;
-//   }
-//
-//   header.reserved0 = GetLittleEndianLong();
-//   header.dataOffset = GetLittleEndianLong();
-//   header.headerSize = GetLittleEndianLong();
-//   header.width = GetLittleEndianLong();
-//   header.height = GetLittleEndianLong();
-//   header.planes = GetLittleEndianShort();
-//   header.bitsPerPixel = GetLittleEndianShort();
-//	//if ( bmpHeader.bitsPerPixel == 8 )
-//	//	buf_p += 1024;
-//
-//	if ( header.bitsPerPixel < 8 )
-//	{
-//      return false;
-//		//ri.Error( ERR_DROP, "LoadBMP: monochrome and 4-bit BMP files not supported (%s)\n", name );
-//	}
-//   header.compression = GetLittleEndianLong();
-//   if ( header.compression > 2 ) // only handles RLE compression
-//	{
-//      return false;
-//		//ri.Error( ERR_DROP, "LoadBMP: only uncompressed BMP files supported (%s)\n", name );
-//	}
-//   header.dataSize = GetLittleEndianLong();
-//   header.hRes = GetLittleEndianLong();
-//   header.vRes = GetLittleEndianLong();
-//   header.colors = GetLittleEndianLong();
-//   header.importantColors = GetLittleEndianLong();
-//
-//   //uint32 readSize = Read( (void*)header.palette, sizeof( header.palette ) );
-//   if ( readSize != sizeof( header.palette ) )
-//   {
-//      return false;
-//   }
-//
-//	//if ( header.height < 0 )
-//	//	header.height = -header.height;
-//
-//   //rawImage.SetDimensions(header.width, header.height);
-//
-//	//rawImage.numPixels = header.width * header.height; // calculate in raw
-//   int rawImgSize = header.width * header.height * 4;
-//
-//   //byte	*pixelBuffer;
-//   //data = new byte[rawImgSize];
-//
-//	// decompress data if needed
-//	switch(header.compression)
-//	{
-//	case 1: // 8 bit rle
-//		//decompress8BitRLE(bmpData, header.BitmapDataSize, header.Width, header.Height, pitch);
-//		break;
-//	case 2: // 4 bit rle
-//		//decompress4BitRLE(bmpData, header.BitmapDataSize, header.Width, header.Height, pitch);
-//		break;
-//	}
-//
-//   return true;
-//}
\ No newline at end of file
+
+bool BMPFile::ReadHeader( void )
+{
+   assert( reader.IsOpen() );
+
+   header.id[0] = reader.ReadU8();
+	header.id[1] = reader.ReadU8();
+	if ( header.id[0] != 'B' || header.id[1] != 'M' ) 
+	{
+      return false;
+		//ri.Error( ERR_DROP, "LoadBMP: only Windows-style BMP files supported (%s)\n", name );
+	}
+
+	header.fileSize = reader.ReadU32();
+   if ( header.fileSize != reader.GetSize() )
+   {
+      return false;
+   }
+
+   header.reserved0 = reader.ReadU32();
+   header.dataOffset = reader.ReadU32();
+   header.headerSize = reader.ReadU32();
+   header.width = reader.ReadU32();
+   header.height = reader.ReadU32();
+   header.planes = reader.ReadU16();
+   header.bitsPerPixel = reader.ReadU16();
+
+	if ( header.bitsPerPixel < 8 )
+	{
+      return false;
+		//ri.Error( ERR_DROP, "LoadBMP: monochrome and 4-bit BMP files not supported (%s)\n", name );
+	}
+   header.compression = reader.ReadU32();
+   if ( header.compression > 2 ) // only handles RLE compression
+	{
+      return false;
+		//ri.Error( ERR_DROP, "LoadBMP: only uncompressed BMP files supported (%s)\n", name );
+	}
+   header.dataSize = reader.ReadU32();
+   header.hRes = reader.ReadU32();
+   header.vRes = reader.ReadU32();
+   header.colors = reader.ReadU32();
+   header.importantColors = reader.ReadU32();
+
+   // the palette follows the info header, only 8 bit images have one
+   if ( !reader.Seek( 14 + header.headerSize ) )
+      return false;
+   if ( header.bitsPerPixel == 8 )
+   {
+      const uint32 numColors = header.colors != 0 && header.colors < 256 ? header.colors : 256;
+      const uint32 readSize = reader.Read( (void*)header.palette, numColors * 4 );
+      if ( readSize != numColors * 4 )
+      {
+         return false;
+      }
+   }
+
+	//if ( header.height < 0 )
+	//	header.height = -header.height;
+
+   //rawImage.SetDimensions(header.width, header.height);
+
+	//rawImage.numPixels = header.width * header.height; // calculate in raw
+   //int rawImgSize = header.width * header.height * 4;
+
+   //byte	*pixelBuffer;
+   //data = new byte[rawImgSize];
+
+	// decompress data if needed
+	switch(header.compression)
+	{
+	case 1: // 8 bit rle
+		//decompress8BitRLE(bmpData, header.BitmapDataSize, header.Width, header.Height, pitch);
+		break;
+	case 2: // 4 bit rle
+		//decompress4BitRLE(bmpData, header.BitmapDataSize, header.Width, header.Height, pitch);
+		break;
+	}
+
+   // leave the reader at the pixel data
+   return reader.Seek( header.dataOffset );
+}
@@ -1,7 +1,7 @@
 #ifndef _BMP_HPP_INCLUDED_
 #define _BMP_HPP_INCLUDED_
 
-#include "core/fileio/file.hpp"
+#include "core/fileio/bufferedreader.hpp"
 #include "raw.hpp"
 
 struct Header
@@ -24,9 +24,10 @@ struct Header
 	byte palette[256][4];
 };
 
-class BMPFile: public File
+class BMPFile
 {
 private:
+   BufferedReader reader;
 	 // use rawimage class for storing pixeldata
 	/*int	row, column;*/
 	//byte	*bufferPtr;
@@ -38,6 +39,8 @@ private:
 
    bool ReadHeader( void );
 public:
+   bool Open( const String_c &path );
+   void Close();
    bool ReadBMP( void );
 };
 
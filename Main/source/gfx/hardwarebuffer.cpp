@@ -49,6 +49,14 @@ void HardwareBuffer::WriteBuffer(const float sourceData[], const int32 numElemen
 	glBindBuffer(bufferBindingTarget, 0);
 }
 
+void HardwareBuffer::WriteBuffer(const void *sourceData, const uint32 numBytes)
+{
+	glBindBuffer(bufferBindingTarget, handle);
+	glBufferSubData(bufferBindingTarget, offset, numBytes, sourceData);
+	offset += numBytes;
+	glBindBuffer(bufferBindingTarget, 0);
+}
+
 void HardwareBuffer::Free()
 {
 	glDeleteBuffers(1, &handle);
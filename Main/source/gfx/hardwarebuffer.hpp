@@ -58,6 +58,8 @@ public:
 	void Allocate(const uint32 size);
 	// write to buffer according to the format alignments
 	void WriteBuffer(const float sourceData[], const int32 numElements);
+	// writes numBytes of already packed vertices, see vertexstream::InterleaveStreams
+	void WriteBuffer(const void *sourceData, const uint32 numBytes);
 	void Bind();
 	void Unbind();
 
@@ -0,0 +1,377 @@
+#ifndef _MESHOPTIMIZER_HPP_INCLUDED_
+#define _MESHOPTIMIZER_HPP_INCLUDED_
+
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "core/BasicTypes.hpp"
+
+// Index buffer optimizations for triangle lists, run on the output of VertexBuffer::IndexVBO:
+//  - OptimizeVertexCache reorders the triangles for the post transform vertex cache (Forsyth's
+//    linear speed vertex cache optimization)
+//  - OptimizeOverdraw splits the cache optimized order into clusters and sorts the clusters so the
+//    outer surfaces of the mesh are drawn first (after Sander, Nehab and Barczak, Tipsify)
+//  - OptimizeVertexFetch reorders the vertices in first use order so fetches walk the vertex buffer
+//    linearly
+// AnalyzeVertexCache simulates a FIFO cache to measure the result without a GPU.
+namespace meshoptimizer
+{
+
+// cache statistics of an index buffer
+struct CacheStats
+{
+   uint32 numTransforms; // cache misses, the vertices the vertex shader had to run for
+   float acmr; // average cache miss ratio, transformed vertices per triangle. 0.5 is the best case, 3 the worst
+   float atvr; // average transformed to vertex ratio, 1 is the best case
+};
+
+// simulate a FIFO post transform cache of cacheSize entries, which is how most hardware behaves
+template <typename TFace>
+CacheStats AnalyzeVertexCache(const TFace *indices, const uint32 numIndices, const uint32 numVertices, const uint32 cacheSize = 16)
+{
+   assert(numIndices % 3 == 0);
+
+   CacheStats stats;
+   stats.numTransforms = 0;
+
+   // a vertex is in the cache while fewer than cacheSize misses happened since it was inserted
+   std::vector<uint32> insertedAt(numVertices, 0);
+   for (uint32 i = 0; i < numIndices; i++)
+   {
+      const TFace vertex = indices[i];
+      assert(vertex < numVertices);
+      if (insertedAt[vertex] == 0 || stats.numTransforms + 1 - insertedAt[vertex] > cacheSize)
+      {
+         stats.numTransforms++;
+         insertedAt[vertex] = stats.numTransforms;
+      }
+   }
+
+   stats.acmr = numIndices ? (float)stats.numTransforms / (numIndices / 3) : 0.0f;
+   stats.atvr = numVertices ? (float)stats.numTransforms / numVertices : 0.0f;
+   return stats;
+}
+
+namespace detail
+{
+
+static const uint32 FORSYTH_CACHE_SIZE = 32;
+
+// score of a vertex from its position in the simulated LRU cache and the number of triangles
+// that still use it. Low valence vertices get a boost so the optimizer finishes them off
+// instead of leaving lone triangles behind
+inline float VertexScore(const int32 cachePosition, const uint32 remainingTriangles)
+{
+   if (remainingTriangles == 0)
+      return -1.0f;
+
+   float score = 0.0f;
+   if (cachePosition >= 0)
+   {
+      // the triangle that was just drawn gets a fixed score so it is not reused right away
+      if (cachePosition < 3)
+         score = 0.75f;
+      else
+         score = powf(1.0f - (float)(cachePosition - 3) / (FORSYTH_CACHE_SIZE - 3), 1.5f);
+   }
+
+   return score + 2.0f / sqrtf((float)remainingTriangles);
+}
+
+// triangles that use each vertex, as offsets into one list
+struct Adjacency
+{
+   std::vector<uint32> counts;
+   std::vector<uint32> offsets;
+   std::vector<uint32> triangles;
+
+   template <typename TFace>
+   void Build(const TFace *indices, const uint32 numIndices, const uint32 numVertices)
+   {
+      counts.assign(numVertices, 0);
+      offsets.resize(numVertices);
+      triangles.resize(numIndices);
+
+      for (uint32 i = 0; i < numIndices; i++)
+         counts[indices[i]]++;
+
+      uint32 offset = 0;
+      for (uint32 v = 0; v < numVertices; v++)
+      {
+         offsets[v] = offset;
+         offset += counts[v];
+      }
+
+      std::vector<uint32> fill(offsets);
+      for (uint32 i = 0; i < numIndices; i++)
+         triangles[fill[indices[i]]++] = i / 3;
+   }
+};
+
+} // namespace detail
+
+// reorder the triangles of indices for the vertex cache. dst and indices may be the same buffer
+template <typename TFace>
+void OptimizeVertexCache(TFace *dst, const TFace *indices, const uint32 numIndices, const uint32 numVertices)
+{
+   assert(numIndices % 3 == 0);
+   using detail::FORSYTH_CACHE_SIZE;
+
+   const uint32 numTriangles = numIndices / 3;
+   if (numTriangles == 0)
+      return;
+
+   std::vector<TFace> source(indices, indices + numIndices);
+
+   // counts doubles as the number of triangles left per vertex
+   detail::Adjacency adjacency;
+   adjacency.Build(&source[0], numIndices, numVertices);
+
+   std::vector<int32> cachePosition(numVertices, -1);
+   std::vector<float> vertexScore(numVertices);
+   for (uint32 v = 0; v < numVertices; v++)
+      vertexScore[v] = detail::VertexScore(-1, adjacency.counts[v]);
+
+   std::vector<float> triangleScore(numTriangles);
+   std::vector<bool> emitted(numTriangles, false);
+   uint32 bestTriangle = 0;
+   for (uint32 t = 0; t < numTriangles; t++)
+   {
+      triangleScore[t] = vertexScore[source[t * 3]] + vertexScore[source[t * 3 + 1]] + vertexScore[source[t * 3 + 2]];
+      if (triangleScore[t] > triangleScore[bestTriangle])
+         bestTriangle = t;
+   }
+
+   // three extra entries hold the vertices pushed out by the last triangle
+   uint32 cache[FORSYTH_CACHE_SIZE + 3];
+   uint32 cacheCount = 0;
+   uint32 scanStart = 0;
+
+   for (uint32 written = 0; written < numTriangles; written++)
+   {
+      const TFace *triangle = &source[bestTriangle * 3];
+      dst[written * 3] = triangle[0];
+      dst[written * 3 + 1] = triangle[1];
+      dst[written * 3 + 2] = triangle[2];
+      emitted[bestTriangle] = true;
+
+      // move the triangle's vertices to the front of the cache
+      uint32 newCache[FORSYTH_CACHE_SIZE + 3];
+      uint32 newCount = 0;
+      for (uint32 k = 0; k < 3; k++)
+      {
+         const uint32 v = triangle[k];
+         newCache[newCount++] = v;
+
+         // drop the triangle from the vertex's list of remaining triangles
+         uint32 *list = &adjacency.triangles[adjacency.offsets[v]];
+         const uint32 count = adjacency.counts[v];
+         for (uint32 i = 0; i < count; i++)
+         {
+            if (list[i] == bestTriangle)
+            {
+               list[i] = list[count - 1];
+               break;
+            }
+         }
+         adjacency.counts[v]--;
+      }
+      for (uint32 i = 0; i < cacheCount; i++)
+      {
+         const uint32 v = cache[i];
+         if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+            newCache[newCount++] = v;
+      }
+
+      // update the vertices that are or were in the cache, and their triangles
+      for (uint32 i = 0; i < newCount; i++)
+      {
+         const uint32 v = newCache[i];
+         cachePosition[v] = i < FORSYTH_CACHE_SIZE ? (int32)i : -1;
+         vertexScore[v] = detail::VertexScore(cachePosition[v], adjacency.counts[v]);
+      }
+
+      float bestScore = -1.0f;
+      for (uint32 i = 0; i < newCount; i++)
+      {
+         const uint32 v = newCache[i];
+         const uint32 *list = &adjacency.triangles[adjacency.offsets[v]];
+         for (uint32 j = 0; j < adjacency.counts[v]; j++)
+         {
+            const uint32 t = list[j];
+            const float score = vertexScore[source[t * 3]] + vertexScore[source[t * 3 + 1]] + vertexScore[source[t * 3 + 2]];
+            triangleScore[t] = score;
+            if (score > bestScore)
+            {
+               bestScore = score;
+               bestTriangle = t;
+            }
+         }
+      }
+
+      cacheCount = newCount < FORSYTH_CACHE_SIZE ? newCount : FORSYTH_CACHE_SIZE;
+      memcpy(cache, newCache, cacheCount * sizeof(uint32));
+
+      // no triangle touches the cache, continue with the best remaining one. Scores of triangles
+      // outside the cache only depend on valence, so the first unemitted one is a good enough pick
+      if (bestScore < 0.0f)
+      {
+         while (scanStart < numTriangles && emitted[scanStart])
+            scanStart++;
+         if (scanStart == numTriangles)
+            break;
+
+         bestTriangle = scanStart;
+         for (uint32 t = scanStart; t < numTriangles && t < scanStart + 64; t++)
+         {
+            if (!emitted[t] && triangleScore[t] > triangleScore[bestTriangle])
+               bestTriangle = t;
+         }
+      }
+   }
+}
+
+// Split the cache optimized triangle order into clusters and sort them back to front from the
+// outside of the mesh in, so a typical view draws the occluders first. Clusters are cut where the
+// cache restarts anyway and wherever the ACMR of a cluster stays within threshold times the ACMR
+// of the input, so the cache efficiency loses at most that factor. positions holds
+// positionStride floats per vertex, the position first.
+// dst and indices may not be the same buffer
+template <typename TFace>
+void OptimizeOverdraw(TFace *dst, const TFace *indices, const uint32 numIndices, const float *positions,
+   const uint32 numVertices, const uint32 positionStride, const float threshold = 1.05f, const uint32 cacheSize = 16)
+{
+   assert(numIndices % 3 == 0 && dst != indices);
+
+   const uint32 numTriangles = numIndices / 3;
+   if (numTriangles == 0)
+      return;
+
+   const float targetAcmr = AnalyzeVertexCache(indices, numIndices, numVertices, cacheSize).acmr * threshold;
+
+   // cluster boundaries: a new cluster starts where the simulated cache misses all three
+   // vertices, or when the cluster so far is cache efficient enough on its own
+   std::vector<uint32> clusters;
+   std::vector<uint32> insertedAt(numVertices, 0);
+   uint32 time = 0, clusterTransforms = 0, clusterStart = 0;
+   for (uint32 t = 0; t < numTriangles; t++)
+   {
+      uint32 misses = 0;
+      for (uint32 k = 0; k < 3; k++)
+      {
+         const TFace v = indices[t * 3 + k];
+         if (insertedAt[v] == 0 || time + 1 - insertedAt[v] > cacheSize)
+         {
+            misses++;
+            insertedAt[v] = ++time;
+         }
+      }
+
+      if (t == 0 || misses == 3)
+      {
+         clusters.push_back(t);
+         clusterStart = t;
+         clusterTransforms = 0;
+      }
+      clusterTransforms += misses;
+
+      const uint32 clusterTriangles = t + 1 - clusterStart;
+      if (clusterTriangles >= 16 && t + 1 < numTriangles && (float)clusterTransforms / clusterTriangles <= targetAcmr)
+      {
+         // force the next triangle to open a cluster of its own
+         clusters.push_back(t + 1);
+         clusterStart = t + 1;
+         clusterTransforms = 0;
+         time += cacheSize;
+      }
+   }
+   // the forced split may already have pushed the start of the next cluster
+   clusters.erase(std::unique(clusters.begin(), clusters.end()), clusters.end());
+   clusters.push_back(numTriangles);
+
+   // mesh centroid
+   float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+   for (uint32 i = 0; i < numIndices; i++)
+   {
+      const float *p = positions + indices[i] * positionStride;
+      meshCenter[0] += p[0]; meshCenter[1] += p[1]; meshCenter[2] += p[2];
+   }
+   for (uint32 k = 0; k < 3; k++)
+      meshCenter[k] /= numIndices;
+
+   // sort key of a cluster, how far its area weighted centroid lies along its average normal
+   const uint32 numClusters = (uint32)clusters.size() - 1;
+   std::vector<std::pair<float, uint32> > order(numClusters);
+   for (uint32 c = 0; c < numClusters; c++)
+   {
+      float center[3] = { 0.0f, 0.0f, 0.0f }, normal[3] = { 0.0f, 0.0f, 0.0f }, area = 0.0f;
+      for (uint32 t = clusters[c]; t < clusters[c + 1]; t++)
+      {
+         const float *a = positions + indices[t * 3] * positionStride;
+         const float *b = positions + indices[t * 3 + 1] * positionStride;
+         const float *d = positions + indices[t * 3 + 2] * positionStride;
+         const float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+         const float e2[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+         const float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+         const float triangleArea = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+         for (uint32 k = 0; k < 3; k++)
+         {
+            center[k] += (a[k] + b[k] + d[k]) * triangleArea / 3.0f;
+            normal[k] += n[k];
+         }
+         area += triangleArea;
+      }
+
+      float dot = 0.0f;
+      if (area > 0.0f)
+      {
+         const float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+         for (uint32 k = 0; k < 3 && length > 0.0f; k++)
+            dot += (center[k] / area - meshCenter[k]) * normal[k] / length;
+      }
+      // larger keys first, the stable index keeps equal keys in cache order
+      order[c] = std::make_pair(-dot, c);
+   }
+   std::sort(order.begin(), order.end());
+
+   uint32 written = 0;
+   for (uint32 i = 0; i < numClusters; i++)
+   {
+      const uint32 c = order[i].second;
+      const uint32 count = (clusters[c + 1] - clusters[c]) * 3;
+      memcpy(dst + written, indices + clusters[c] * 3, count * sizeof(TFace));
+      written += count;
+   }
+}
+
+// Reorder the vertices in the order the index buffer first uses them and rewrite the indices to
+// match. Unused vertices are dropped, the new vertex count is returned.
+// dstVertices needs room for numVertices vertices and may not overlap vertices
+template <typename TFace>
+uint32 OptimizeVertexFetch(float *dstVertices, TFace *indices, const uint32 numIndices, const float *vertices,
+   const uint32 numVertices, const uint32 floatsPerVertex)
+{
+   const uint32 unused = ~0u;
+   std::vector<uint32> remap(numVertices, unused);
+
+   uint32 next = 0;
+   for (uint32 i = 0; i < numIndices; i++)
+   {
+      const TFace v = indices[i];
+      if (remap[v] == unused)
+      {
+         memcpy(dstVertices + next * floatsPerVertex, vertices + v * floatsPerVertex, floatsPerVertex * sizeof(float));
+         remap[v] = next++;
+      }
+      indices[i] = (TFace)remap[v];
+   }
+   return next;
+}
+
+} // namespace meshoptimizer
+
+#endif
@@ -6,12 +6,18 @@
 #include "vertexstructs.hpp"
 using vertexstructs::VertexPC;
 
+#include "meshoptimizer.hpp"
+using meshoptimizer::CacheStats;
+
+#include "vertexwelder.hpp"
+using vertexwelder::VertexWelder;
+
+#include "core/memory/frameallocator.hpp"
+
 #include "model/mesh.hpp"
+using mesh::Face;
 using mesh::Mesh;
 
-#include <map>
-using std::map;
-
 using core::math::Point2f;
 using core::math::Point3f;
 using core::math::Vector2f;
@@ -30,6 +36,29 @@ using hardwarebuffer::BBTARGET_ARRAY_BUFFER;
 namespace vbo
 {
 
+// bytes per vertex of the P(N)(T) vertices PrepareMesh and ExpandMeshCorners build for format
+inline uint32 GetMeshVertexStride(const eVertexFormat format)
+{
+   uint32 stride = 0;
+   if (format & VF_POSITION)
+      stride += 3 * sizeof(float);
+   if (format & VF_NORMAL)
+      stride += 3 * sizeof(float);
+   if (format & VF_TEXCOORD2D_1)
+      stride += 2 * sizeof(float);
+   return stride;
+}
+
+// corners of the triangles the faces of mesh are fanned into
+template <typename TFace>
+uint32 GetNumMeshCorners(const Mesh<TFace> &mesh);
+
+// Expands the faces of mesh to one vertex of stride bytes per triangle corner, the input of
+// IndexVBO. out holds GetNumMeshCorners( mesh ) vertices, returns the number written.
+// Does not touch GL, so it can run on a loader thread
+template <typename TFace>
+uint32 ExpandMeshCorners(const Mesh<TFace> &mesh, const uint32 stride, float *out);
+
 template <typename TFace>
 class VertexBuffer : public HardwareBuffer
 {
@@ -45,9 +74,9 @@ private:
 
    //int32 streamIndex;
    
-   // VertexAttrib2T is hard coded as a temporary fix
-   // vector<Vertex<float> > indexedVertexData;
-   // vector<TFace> indexBuffer;
+   // unique interleaved vertices and the index buffer built by IndexVBO
+   vector<float> indexedVertexData;
+   vector<TFace> indexBuffer;
 public:
    void Lock( int32 start, int32 end );
    void Unlock();
@@ -59,13 +88,17 @@ public:
 
    //must use correct vertex type based on what attributes were found in a model file(.obj,.dae etc)
  
-   void PrepareMesh( const Mesh<TFace> & );
-   void IndexVBO(const vector<Vertex<float> > &inVertices);
-
-   bool GetSimilarVertex(const Vertex<float>  &inVertex, const map<Vertex<float>, uint32> &mymap, uint32 index);
-
-   float *GetIndexedVertexData() { return &indexedVertexData[0][0]; }
-   TFace *GetIndexBuffer() { return &indexBuffer[0][0]; }
+   void PrepareMesh( const Mesh<TFace> &, const bool optimize = true );
+   // weld a flat stream of unindexed vertices (stride / sizeof(float) floats each), epsilon 0 welds exact matches only
+   bool IndexVBO( const float *inVertices, const uint32 numVertices, const float epsilon = 0.0f );
+   // reorder the indexed mesh for the post transform cache and for vertex fetch, optionally sorting
+   // for less overdraw. before and after receive the simulated cache statistics when not NULL
+   void OptimizeIndexed( const bool reduceOverdraw = false, CacheStats *before = NULL, CacheStats *after = NULL );
+
+   float *GetIndexedVertexData() { return &indexedVertexData[0]; }
+   TFace *GetIndexBuffer() { return &indexBuffer[0]; }
+   uint32 GetNumIndexedVertices() const { return (uint32)(indexedVertexData.size() * sizeof(float) / m_stride); }
+   uint32 GetNumIndices() const { return (uint32)indexBuffer.size(); }
 };
 
 // ctor for structs (see vertexstructs.hpp)
@@ -107,12 +140,7 @@ VertexBuffer<TFace>::VertexBuffer(eVertexFormat format, int32 count, const eUsag
    this->usageFlag = usageFlag;
    this->accessFlag = accessFlag;
 //http://www.gamedev.net/topic/367617-flexible-vertex-format-on-the-fly/
-    if( format & VERTFORM_POSITION )
-       m_stride += 3 * sizeof(float);
-    if( format & VERTFORM_NORMAL )
-       m_stride += 3 * sizeof(float);    
-     if( format & VERTFORM_TEXCOORD2 )
-       m_stride += 2 * sizeof(float);   
+   m_stride = GetMeshVertexStride(format);
 
    bufferBindingTarget = BBTARGET_ARRAY_BUFFER;
    bufferBindingTarget = bindTarget; // exclusive other bbtargets for vbo?
@@ -206,89 +234,129 @@ VertexBuffer<TFace >::~VertexBuffer()
 
 
 template <typename TFace>
-void VertexBuffer<TFace>::PrepareMesh(const Mesh<TFace> &mesh)
+uint32 GetNumMeshCorners(const Mesh<TFace> &mesh)
 {
-   uint32 vPos, vtPos, vnPos; // assume uint32 for time being
-   int32 i, face, a, b, c;
-   vector<VertexAttrib2T<float> > temp;
-   VertexAttrib2T<float> newVertex;
-   face = a = b = c = 0;
-
-   //PNT - P - PN - PT
-   for (i = 0; i < mesh.vertexList.size(); i++)
+   uint32 numFanCorners = 0;
+   for (uint32 face = 0; face < mesh.GetNumFaces(); face++)
    {
-      //Look up index for each attribute
-      vPos = faceList[face].vertexIndex[a];
-      newVertex.position = vertexList[vPos];
-      if (mesh.HasTexture())
-      {
-         vtPos = faceList[face].textureIndex[b];
-         newVertex.tex2Coord = textureList[vtPos];
-      }
-      if (mesh.HasNormal())
-      {
-         vnPos = faceList[face].normalIndex[c];
-         newVertex.normal = normalList[vnPos];
-      }
-
-      temp.push_back(newVertex);
-
-      a++; b++; c++;
-      if ((i + 1) % 3 == 0)
-      {
-         face++;
-         a = b = c = 0;
-      }
+      const uint32 faceCorners = mesh.GetFaceOffsetPtr()[face + 1] - mesh.GetFaceOffsetPtr()[face];
+      if (faceCorners >= 3)
+         numFanCorners += (faceCorners - 2) * 3;
    }
-   IndexVBO(temp);
-   //this->vertexArrayByteSize = numVertices * sizeof(1111111); // getvertexsize()
-   //this->indexArrayByteSize = numFaces * 3 * sizeof(TFace);
-   return 0;
+   return numFanCorners;
 }
 
 template <typename TFace>
-void VertexBuffer<TFace>::IndexVBO(const vector<Vertex<float> > &inVertices)
+uint32 ExpandMeshCorners(const Mesh<TFace> &mesh, const uint32 stride, float *out)
 {
-   int32 index = 0;
-   Vertex<float> currentVertex;
-
-   map<Vertex<float>, uint32> mymap;
-   int32 face = 0, indexA = 0, indexB = 0, indexC = 0;
-   for (int32 i = 0; inVertices.size(); i++)
+   // one P(N)(T) vertex per corner, in the order of GetMeshVertexStride. The attributes come from
+   // the stride, the ones the mesh lacks are filled in, so every corner is exactly stride bytes
+   const uint32 floatsPerVertex = stride / sizeof(float);
+   const bool hasNormal = stride >= 6 * sizeof(float);
+   const bool hasTexture = stride == 5 * sizeof(float) || stride == 8 * sizeof(float);
+   const float *positions = mesh.GetStream(mesh::MS_POSITION);
+   const float *normals = mesh.HasNormal() ? mesh.GetStream(mesh::MS_NORMAL) : NULL;
+   const float *uvs = mesh.HasTexture2() ? mesh.GetStream(mesh::MS_TEXCOORD2) : NULL;
+   const TFace invalid = Face<TFace>::INVALID_INDEX;
+
+   uint32 numCorners = 0;
+   for (uint32 face = 0; face < mesh.GetNumFaces(); face++)
    {
+      const Face<TFace> current = mesh.GetFace(face);
+      if (current.GetNumVertices() < 3)
+         continue;
 
-      if (GetSimilarVertex(currentVertex, mymap, index))
+      // corners without a normal get the normal of the face plane, (0, 0, 0) for degenerate faces
+      Vector3f faceNormal(0.0f, 0.0f, 0.0f);
+      if (hasNormal)
       {
-         indexBuffer.push_back(index);
+         const float *p0 = positions + current.GetVertexIdx(0) * 3;
+         const float *p1 = positions + current.GetVertexIdx(1) * 3;
+         const float *p2 = positions + current.GetVertexIdx(2) * 3;
+         const Vector3f edge1(p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]);
+         const Vector3f edge2(p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]);
+         faceNormal = edge1.CrossProd(edge2);
+         faceNormal.Normalize();
       }
-      else
+
+      // polygons are fanned around their first corner
+      for (int32 fan = 0; fan < (current.GetNumVertices() - 2) * 3; fan++)
       {
-         VertexAttrib2T<float> newVertex;
-         newVertex.normal = inVertices[i].normal;
-         newVertex.position = inVertices[i].position;
-         newVertex.uv = inVertices[i].uv;
-         outVertices.push_back(newVertex);
-
-         uint32 newIndex = (uint32)outVertices.size() - 1;
-         outIndices.push_back(newIndex);
-         mymap[currentVertex] = newIndex;
+         const int32 corner = fan % 3 == 0 ? 0 : fan / 3 + fan % 3;
+         float *vertex = out;
+         const float *position = positions + current.GetVertexIdx(corner) * 3;
+         *out++ = position[0];
+         *out++ = position[1];
+         *out++ = position[2];
+         if (hasNormal)
+         {
+            const TFace idx = normals != NULL ? current.GetNormalIdx(corner) : invalid;
+            *out++ = idx == invalid ? faceNormal[0] : normals[idx * 3];
+            *out++ = idx == invalid ? faceNormal[1] : normals[idx * 3 + 1];
+            *out++ = idx == invalid ? faceNormal[2] : normals[idx * 3 + 2];
+         }
+         if (hasTexture)
+         {
+            // corners without a texture coordinate get (0, 0)
+            const TFace idx = uvs != NULL ? current.GetTextureIdx(corner) : invalid;
+            *out++ = idx == invalid ? 0.0f : uvs[idx * 2];
+            *out++ = idx == invalid ? 0.0f : uvs[idx * 2 + 1];
+         }
+         // attributes of the format that are not filled from the mesh, colors for example
+         while (out < vertex + floatsPerVertex)
+            *out++ = 0.0f;
+         numCorners++;
       }
    }
+
+   return numCorners;
 }
 
+template <typename TFace>
+void VertexBuffer<TFace>::PrepareMesh(const Mesh<TFace> &mesh, const bool optimize)
+{
+   // the expanded corners are only needed until they are welded, keep them in frame memory
+   FrameScratch<float> corners(GetNumMeshCorners(mesh) * (m_stride / sizeof(float)));
+   const uint32 numCorners = ExpandMeshCorners(mesh, m_stride, corners.Get());
+
+   if (numCorners > 0 && IndexVBO(corners.Get(), numCorners) && optimize)
+      OptimizeIndexed();
+}
+
+template <typename TFace>
+bool VertexBuffer<TFace>::IndexVBO(const float *inVertices, const uint32 numVertices, const float epsilon)
+{
+   VertexWelder<TFace> welder(m_stride / sizeof(float), epsilon);
+   return welder.Weld(inVertices, numVertices, indexedVertexData, indexBuffer);
+}
 
 template <typename TFace>
-bool  VertexBuffer<TFace>::GetSimilarVertex(const Vertex<float>  &inVertex, const map<Vertex<float>, uint32> &mymap, uint32 index)
+void VertexBuffer<TFace>::OptimizeIndexed(const bool reduceOverdraw, CacheStats *before, CacheStats *after)
 {
-   map<Vertex<float>, uint32>::iterator it = mymap.find(inVertex);
+   const uint32 numIndices = GetNumIndices();
+   const uint32 numVertices = GetNumIndexedVertices();
+   const uint32 floatsPerVertex = m_stride / sizeof(float);
+   if (numIndices == 0)
+      return;
 
-   if (it == mymap.end())
+   if (before)
+      *before = meshoptimizer::AnalyzeVertexCache(&indexBuffer[0], numIndices, numVertices);
+
+   meshoptimizer::OptimizeVertexCache(&indexBuffer[0], &indexBuffer[0], numIndices, numVertices);
+   if (reduceOverdraw)
    {
-      return false;
+      vector<TFace> sorted(numIndices);
+      meshoptimizer::OptimizeOverdraw(&sorted[0], &indexBuffer[0], numIndices, &indexedVertexData[0], numVertices, floatsPerVertex);
+      indexBuffer.swap(sorted);
    }
 
-   index = it->second;
-   return true;
+   vector<float> fetchOrder(indexedVertexData.size());
+   const uint32 numUsed = meshoptimizer::OptimizeVertexFetch(&fetchOrder[0], &indexBuffer[0], numIndices, &indexedVertexData[0], numVertices, floatsPerVertex);
+   fetchOrder.resize(numUsed * floatsPerVertex);
+   indexedVertexData.swap(fetchOrder);
+
+   if (after)
+      *after = meshoptimizer::AnalyzeVertexCache(&indexBuffer[0], numIndices, numUsed);
 }
 
 } // namespace vbo
@@ -46,18 +46,18 @@ namespace vertexformat
 // types used in GLSL shaders, prefixed with GL instead of DATATYPE
 enum eDataType
 {
-   DATATYPE_HALF_FLOAT​​,
-   DATATYPE_FLOAT​​,
-   DATATYPE_DOUBLE​​,
-   DATATYPE_BYTE​​,
-   DATATYPE_UNSIGNED_BYTE​​,
-   DATATYPE_SHORT​​,
-   DATATYPE_UNSIGNED_SHORT​​,
+   DATATYPE_HALF_FLOAT,
+   DATATYPE_FLOAT,
+   DATATYPE_DOUBLE,
+   DATATYPE_BYTE,
+   DATATYPE_UNSIGNED_BYTE,
+   DATATYPE_SHORT,
+   DATATYPE_UNSIGNED_SHORT,
    DATATYPE_INT,
    DATATYPE_UNSIGNED_INT,
-   DATATYPE_INT_2_10_10_10_REV​​,
+   DATATYPE_INT_2_10_10_10_REV,
    DATATYPE_UNSIGNED_INT_2_10_10_10_REV,
-   DATATYPE_UNSIGNED_INT_10F_11F_11F_REV​,
+   DATATYPE_UNSIGNED_INT_10F_11F_11F_REV,
 
    DATATYPE_ENUM_SIZE
 };
@@ -68,21 +68,21 @@ inline int32 GetDataTypeSizeInBytes(eDataType type)
 
    switch (type)
    {
-   case DATATYPE_BYTE​​:
-   case DATATYPE_UNSIGNED_BYTE​​:
+   case DATATYPE_BYTE:
+   case DATATYPE_UNSIGNED_BYTE:
       return 1;
-   case DATATYPE_SHORT​​:
-   case DATATYPE_UNSIGNED_SHORT​​:
-   case DATATYPE_HALF_FLOAT​​:
+   case DATATYPE_SHORT:
+   case DATATYPE_UNSIGNED_SHORT:
+   case DATATYPE_HALF_FLOAT:
       return 2;
-   case DATATYPE_FLOAT​​:
+   case DATATYPE_FLOAT:
    case DATATYPE_INT:
    case DATATYPE_UNSIGNED_INT:
-   case DATATYPE_INT_2_10_10_10_REV​​:
+   case DATATYPE_INT_2_10_10_10_REV:
    case DATATYPE_UNSIGNED_INT_2_10_10_10_REV:
-   case DATATYPE_UNSIGNED_INT_10F_11F_11F_REV​:
+   case DATATYPE_UNSIGNED_INT_10F_11F_11F_REV:
       return 4;
-   case DATATYPE_DOUBLE​​:
+   case DATATYPE_DOUBLE:
       return 8;
    default:
       return 0;
@@ -178,7 +178,7 @@ private:
 public:
    // format description is composed of characters used for vertex formats: e.g "PNT" for position, normal, texture, respectively
    // this inits shared (static) vars only, and should be called only once
-   static void Init(/*const char *formatDescriptor,*/ eDataType dataType = DATATYPE_FLOAT​​);
+   static void Init(/*const char *formatDescriptor,*/ eDataType dataType = DATATYPE_FLOAT);
 
 
    // create a vertex containing the basic type and corresponding to the vertex format
@@ -0,0 +1,456 @@
+#include "vertexstream.hpp"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+// SSE2 is always available on x64 and with /arch:SSE2 on x86
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define GFX_VERTEXSTREAM_SSE2
+#  include <emmintrin.h>
+#endif
+
+using vertexformat::DATATYPE_FLOAT;
+using vertexformat::DATATYPE_HALF_FLOAT;
+using vertexformat::DATATYPE_INT_2_10_10_10_REV;
+using vertexformat::DATATYPE_UNSIGNED_BYTE;
+using vertexformat::DATATYPE_UNSIGNED_INT_10F_11F_11F_REV;
+
+namespace vertexstream
+{
+
+// floats from this on do not fit a half (or an 11 or 10 bit float), they have the same exponent
+static const uint32 HALF_OVERFLOW = (127 + 16) << 23;
+// smallest float that is a normal half
+static const uint32 HALF_MIN_NORMAL = (127 - 14) << 23;
+// added to a float below the normal range, its mantissa ends up rounded in the low bits
+static const uint32 HALF_SUBNORMAL_MAGIC = ((127 - 15) + (23 - 10) + 1) << 23;
+static const uint32 HALF_EXPONENT_ADJUST = (127 - 15) << 23;
+
+static inline uint32 FloatBits(const float value)
+{
+   uint32 bits;
+   memcpy(&bits, &value, sizeof(bits));
+   return bits;
+}
+
+static inline float BitsFloat(const uint32 bits)
+{
+   float value;
+   memcpy(&value, &bits, sizeof(value));
+   return value;
+}
+
+// min(max(value, low), high) of SSE, a NaN value gives low on both paths
+static inline float Clamp(const float value, const float low, const float high)
+{
+   return !(value > low) ? low : (value > high ? high : value);
+}
+
+uint16 FloatToHalf(const float value)
+{
+   uint32 bits = FloatBits(value);
+   const uint32 sign = bits & 0x80000000u;
+   bits ^= sign;
+
+   uint32 half;
+   if (bits >= HALF_OVERFLOW)
+      half = bits > 0x7f800000u ? 0x7e00 : 0x7c00; // NaN stays NaN
+   else if (bits < HALF_MIN_NORMAL)
+      half = FloatBits(BitsFloat(bits) + BitsFloat(HALF_SUBNORMAL_MAGIC)) - HALF_SUBNORMAL_MAGIC;
+   else
+      half = (bits - HALF_EXPONENT_ADJUST + 0xfff + ((bits >> 13) & 1)) >> 13;
+   return (uint16)(half | (sign >> 16));
+}
+
+float HalfToFloat(const uint16 value)
+{
+   const uint32 sign = (uint32)(value & 0x8000) << 16;
+   const uint32 exponent = (value >> 10) & 0x1f;
+   const uint32 mantissa = value & 0x3ff;
+
+   if (exponent == 0)
+   {
+      const float subnormal = (float)mantissa * (1.0f / 16777216.0f);
+      return sign ? -subnormal : subnormal;
+   }
+   if (exponent == 0x1f)
+      return BitsFloat(sign | 0x7f800000u | (mantissa << 13));
+   return BitsFloat(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+}
+
+// unsigned float with a 5 bit exponent and mantissaBits of mantissa, rounded like FloatToHalf
+static uint32 FloatToSmallFloat(const float value, const uint32 mantissaBits)
+{
+   const uint32 shift = 23 - mantissaBits;
+   const uint32 infinity = 0x1fu << mantissaBits;
+   const uint32 maxFinite = (0x1eu << mantissaBits) | ((1u << mantissaBits) - 1);
+   const uint32 bits = FloatBits(value);
+
+   if ((bits & 0x7fffffffu) > 0x7f800000u)
+      return infinity | 1;
+   if (bits & 0x80000000u)
+      return 0;
+   if (bits == 0x7f800000u)
+      return infinity;
+   if (bits >= HALF_OVERFLOW)
+      return maxFinite;
+   if (bits < HALF_MIN_NORMAL)
+   {
+      const uint32 magic = ((127 - 15) + shift + 1) << 23;
+      return FloatBits(BitsFloat(bits) + BitsFloat(magic)) - magic;
+   }
+   const uint32 small = (bits - HALF_EXPONENT_ADJUST + ((1u << (shift - 1)) - 1) + ((bits >> shift) & 1)) >> shift;
+   return small > maxFinite ? maxFinite : small;
+}
+
+uint32 PackR11G11B10F(const float r, const float g, const float b)
+{
+   return FloatToSmallFloat(r, 6) | (FloatToSmallFloat(g, 6) << 11) | (FloatToSmallFloat(b, 5) << 22);
+}
+
+// lrintf rounds to nearest even like the SSE conversions, so both paths give the same bits
+uint32 PackSnorm2_10_10_10(const float x, const float y, const float z, const float w)
+{
+   const uint32 ix = (uint32)lrintf(Clamp(x, -1.0f, 1.0f) * 511.0f) & 0x3ff;
+   const uint32 iy = (uint32)lrintf(Clamp(y, -1.0f, 1.0f) * 511.0f) & 0x3ff;
+   const uint32 iz = (uint32)lrintf(Clamp(z, -1.0f, 1.0f) * 511.0f) & 0x3ff;
+   const uint32 iw = (uint32)lrintf(Clamp(w, -1.0f, 1.0f)) & 0x3;
+   return ix | (iy << 10) | (iz << 20) | (iw << 30);
+}
+
+uint32 PackUnorm8(const float x, const float y, const float z, const float w)
+{
+   const uint32 ix = (uint32)lrintf(Clamp(x, 0.0f, 1.0f) * 255.0f);
+   const uint32 iy = (uint32)lrintf(Clamp(y, 0.0f, 1.0f) * 255.0f);
+   const uint32 iz = (uint32)lrintf(Clamp(z, 0.0f, 1.0f) * 255.0f);
+   const uint32 iw = (uint32)lrintf(Clamp(w, 0.0f, 1.0f) * 255.0f);
+   return ix | (iy << 8) | (iz << 16) | (iw << 24);
+}
+
+#ifdef GFX_VERTEXSTREAM_SSE2
+
+// FloatToHalf on four floats, the halves in the low 16 bits of the lanes, sign extended so
+// _mm_packs_epi32 keeps them intact
+static inline __m128i FloatToHalf4(const __m128 value)
+{
+   const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+   const __m128 sign = _mm_and_ps(value, signMask);
+   const __m128 absValue = _mm_xor_ps(value, sign);
+   const __m128i bits = _mm_castps_si128(absValue);
+
+   const __m128i isRegular = _mm_cmpgt_epi32(_mm_set1_epi32(HALF_OVERFLOW), bits);
+   const __m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absValue, absValue));
+   const __m128i special = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7c00));
+   const __m128i isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32(HALF_MIN_NORMAL), bits);
+
+   const __m128i magic = _mm_set1_epi32(HALF_SUBNORMAL_MAGIC);
+   const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absValue, _mm_castsi128_ps(magic))), magic);
+
+   // -1 where the half mantissa is odd, that rounds ties to even
+   const __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(bits, 31 - 13), 31);
+   const __m128i rounded = _mm_sub_epi32(_mm_add_epi32(bits, _mm_set1_epi32(0xfff - HALF_EXPONENT_ADJUST)), mantissaOdd);
+   const __m128i normal = _mm_srli_epi32(rounded, 13);
+
+   const __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+   const __m128i half = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, special));
+   return _mm_or_si128(half, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+
+// components x, y, z and w of four elements, the missing ones set to fill
+static inline void LoadTransposed(const float *src, const uint32 srcStride, const uint32 numComponents, const __m128 fill,
+   __m128 &x, __m128 &y, __m128 &z, __m128 &w)
+{
+   x = _mm_loadu_ps(src);
+   y = _mm_loadu_ps(src + srcStride);
+   z = _mm_loadu_ps(src + srcStride * 2);
+   w = _mm_loadu_ps(src + srcStride * 3);
+   _MM_TRANSPOSE4_PS(x, y, z, w);
+   if (numComponents < 4)
+      w = _mm_shuffle_ps(fill, fill, _MM_SHUFFLE(3, 3, 3, 3));
+   if (numComponents < 3)
+      z = _mm_shuffle_ps(fill, fill, _MM_SHUFFLE(2, 2, 2, 2));
+   if (numComponents < 2)
+      y = _mm_shuffle_ps(fill, fill, _MM_SHUFFLE(1, 1, 1, 1));
+}
+
+static inline void Store4(const __m128i packed, byte *dst, const uint32 dstStride)
+{
+   uint32 words[4];
+   _mm_storeu_si128((__m128i*)words, packed);
+   for (uint32 i = 0; i < 4; i++)
+      memcpy(dst + i * dstStride, &words[i], sizeof(uint32));
+}
+
+#endif
+
+// the element at index can be read with one 4 float load without going past the end of src
+static inline bool CanLoad4(const uint32 index, const uint32 srcStride, const uint32 numComponents, const uint32 count)
+{
+   return index * srcStride + 4 <= (count - 1) * srcStride + numComponents;
+}
+
+static void ConvertHalf(const float *src, const uint32 srcStride, const uint32 numComponents, byte *dst, const uint32 dstStride,
+   const uint32 count)
+{
+   uint32 i = 0;
+#ifdef GFX_VERTEXSTREAM_SSE2
+   for (; i < count && CanLoad4(i, srcStride, numComponents, count); i++)
+   {
+      const __m128i half = FloatToHalf4(_mm_loadu_ps(src + i * srcStride));
+      uint16 halves[8];
+      _mm_storeu_si128((__m128i*)halves, _mm_packs_epi32(half, half));
+      memcpy(dst + i * dstStride, halves, numComponents * sizeof(uint16));
+   }
+#endif
+   for (; i < count; i++)
+   {
+      uint16 halves[4];
+      for (uint32 c = 0; c < numComponents; c++)
+         halves[c] = FloatToHalf(src[i * srcStride + c]);
+      memcpy(dst + i * dstStride, halves, numComponents * sizeof(uint16));
+   }
+}
+
+static void ConvertSnorm2_10_10_10(const float *src, const uint32 srcStride, const uint32 numComponents, byte *dst,
+   const uint32 dstStride, const uint32 count)
+{
+   uint32 i = 0;
+#ifdef GFX_VERTEXSTREAM_SSE2
+   const __m128 one = _mm_set1_ps(1.0f);
+   const __m128 minusOne = _mm_set1_ps(-1.0f);
+   const __m128 scale = _mm_set1_ps(511.0f);
+   const __m128i mask10 = _mm_set1_epi32(0x3ff);
+   for (; i + 4 <= count && CanLoad4(i + 3, srcStride, numComponents, count); i += 4)
+   {
+      __m128 x, y, z, w;
+      LoadTransposed(src + i * srcStride, srcStride, numComponents, _mm_setzero_ps(), x, y, z, w);
+      const __m128i ix = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(x, minusOne), one), scale));
+      const __m128i iy = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(y, minusOne), one), scale));
+      const __m128i iz = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(z, minusOne), one), scale));
+      const __m128i iw = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(w, minusOne), one));
+      __m128i packed = _mm_and_si128(ix, mask10);
+      packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_and_si128(iy, mask10), 10));
+      packed = _mm_or_si128(packed, _mm_slli_epi32(_mm_and_si128(iz, mask10), 20));
+      packed = _mm_or_si128(packed, _mm_slli_epi32(iw, 30));
+      Store4(packed, dst + i * dstStride, dstStride);
+   }
+#endif
+   for (; i < count; i++)
+   {
+      const float *element = src + i * srcStride;
+      const uint32 packed = PackSnorm2_10_10_10(element[0], numComponents > 1 ? element[1] : 0.0f,
+         numComponents > 2 ? element[2] : 0.0f, numComponents > 3 ? element[3] : 0.0f);
+      memcpy(dst + i * dstStride, &packed, sizeof(packed));
+   }
+}
+
+static void ConvertUnorm8(const float *src, const uint32 srcStride, const uint32 numComponents, byte *dst,
+   const uint32 dstStride, const uint32 count)
+{
+   uint32 i = 0;
+#ifdef GFX_VERTEXSTREAM_SSE2
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 one = _mm_set1_ps(1.0f);
+   const __m128 scale = _mm_set1_ps(255.0f);
+   const __m128 fill = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+   for (; i + 4 <= count && CanLoad4(i + 3, srcStride, numComponents, count); i += 4)
+   {
+      __m128 x, y, z, w;
+      LoadTransposed(src + i * srcStride, srcStride, numComponents, fill, x, y, z, w);
+      const __m128i ix = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(x, zero), one), scale));
+      const __m128i iy = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(y, zero), one), scale));
+      const __m128i iz = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(z, zero), one), scale));
+      const __m128i iw = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(w, zero), one), scale));
+      __m128i packed = _mm_or_si128(ix, _mm_slli_epi32(iy, 8));
+      packed = _mm_or_si128(packed, _mm_slli_epi32(iz, 16));
+      packed = _mm_or_si128(packed, _mm_slli_epi32(iw, 24));
+      Store4(packed, dst + i * dstStride, dstStride);
+   }
+#endif
+   for (; i < count; i++)
+   {
+      const float *element = src + i * srcStride;
+      const uint32 packed = PackUnorm8(element[0], numComponents > 1 ? element[1] : 0.0f,
+         numComponents > 2 ? element[2] : 0.0f, numComponents > 3 ? element[3] : 1.0f);
+      memcpy(dst + i * dstStride, &packed, sizeof(packed));
+   }
+}
+
+void ConvertAttribute(const float *src, const uint32 srcStride, const uint32 numComponents, const eDataType type,
+   void *dst, const uint32 dstStride, const uint32 count)
+{
+   assert(numComponents > 0 && numComponents <= 4 && srcStride >= numComponents);
+   if (count == 0)
+      return;
+
+   byte *out = (byte*)dst;
+   switch (type)
+   {
+   case DATATYPE_FLOAT:
+      for (uint32 i = 0; i < count; i++)
+         memcpy(out + i * dstStride, src + i * srcStride, numComponents * sizeof(float));
+      break;
+   case DATATYPE_HALF_FLOAT:
+      ConvertHalf(src, srcStride, numComponents, out, dstStride, count);
+      break;
+   case DATATYPE_INT_2_10_10_10_REV:
+      ConvertSnorm2_10_10_10(src, srcStride, numComponents, out, dstStride, count);
+      break;
+   case DATATYPE_UNSIGNED_BYTE:
+      ConvertUnorm8(src, srcStride, numComponents, out, dstStride, count);
+      break;
+   case DATATYPE_UNSIGNED_INT_10F_11F_11F_REV:
+      assert(numComponents == 3);
+      for (uint32 i = 0; i < count; i++)
+      {
+         const float *element = src + i * srcStride;
+         const uint32 packed = PackR11G11B10F(element[0], element[1], element[2]);
+         memcpy(out + i * dstStride, &packed, sizeof(packed));
+      }
+      break;
+   default:
+      assert(!"unsupported vertex attribute type");
+      break;
+   }
+}
+
+uint32 GetStoredComponents(const eDataType type, const uint32 numComponents)
+{
+   // the packed types hold all four components, the missing ones filled in
+   return type == DATATYPE_INT_2_10_10_10_REV || type == DATATYPE_UNSIGNED_BYTE ? 4 : numComponents;
+}
+
+uint32 GetAttributeSize(const eDataType type, const uint32 numComponents)
+{
+   switch (type)
+   {
+   case DATATYPE_FLOAT:
+      return numComponents * sizeof(float);
+   case DATATYPE_HALF_FLOAT:
+      return (numComponents * sizeof(uint16) + 3) & ~3u;
+   case DATATYPE_INT_2_10_10_10_REV:
+   case DATATYPE_UNSIGNED_BYTE:
+   case DATATYPE_UNSIGNED_INT_10F_11F_11F_REV:
+      return sizeof(uint32);
+   default:
+      assert(!"unsupported vertex attribute type");
+      return 0;
+   }
+}
+
+VertexEncoding VertexEncoding::Compact()
+{
+   VertexEncoding encoding;
+   encoding.normal = DATATYPE_INT_2_10_10_10_REV;
+   encoding.texcoord = DATATYPE_HALF_FLOAT;
+   encoding.color = DATATYPE_UNSIGNED_BYTE;
+   return encoding;
+}
+
+VertexLayout::VertexLayout(const eVertexFormat format, const VertexEncoding &encoding)
+{
+   numAttributes = 0;
+   stride = 0;
+   numFloats = 0;
+   for (uint32 bit = 0; bit < 32; bit++)
+   {
+      const eVertexFormat semantic = (eVertexFormat)(format & (1u << bit));
+      const uint32 floats = vertexformat::GetVertexComponentSize(semantic) / sizeof(float);
+      if (floats == 0)
+         continue;
+      assert(numAttributes < MAX_VERTEX_ATTRIBUTES);
+
+      eDataType type;
+      switch (semantic)
+      {
+      case vertexformat::VF_POSITION:
+         type = encoding.position;
+         break;
+      case vertexformat::VF_NORMAL:
+      case vertexformat::VF_BINORMAL:
+         type = encoding.normal;
+         break;
+      case vertexformat::VF_COLOR:
+         type = encoding.color;
+         break;
+      default:
+         type = encoding.texcoord;
+         break;
+      }
+
+      VertexAttribute &attribute = attributes[numAttributes++];
+      attribute.semantic = semantic;
+      attribute.type = type;
+      attribute.numFloats = floats;
+      attribute.numComponents = GetStoredComponents(type, floats);
+      attribute.offset = stride;
+      attribute.normalized = type == DATATYPE_INT_2_10_10_10_REV || type == DATATYPE_UNSIGNED_BYTE;
+      stride += GetAttributeSize(type, floats);
+      numFloats += floats;
+   }
+}
+
+void InterleaveStreams(const VertexLayout &layout, const float *const *streams, const uint32 numVertices, void *dst)
+{
+   for (uint32 i = 0; i < layout.GetNumAttributes(); i++)
+   {
+      const VertexAttribute &attribute = layout.GetAttribute(i);
+      ConvertAttribute(streams[i], attribute.numFloats, attribute.numFloats, attribute.type, (byte*)dst + attribute.offset,
+         layout.GetStride(), numVertices);
+   }
+}
+
+void ConvertInterleaved(const VertexLayout &layout, const float *src, const uint32 numVertices, void *dst)
+{
+   uint32 floatOffset = 0;
+   for (uint32 i = 0; i < layout.GetNumAttributes(); i++)
+   {
+      const VertexAttribute &attribute = layout.GetAttribute(i);
+      ConvertAttribute(src + floatOffset, layout.GetNumFloats(), attribute.numFloats, attribute.type,
+         (byte*)dst + attribute.offset, layout.GetStride(), numVertices);
+      floatOffset += attribute.numFloats;
+   }
+}
+
+void DeinterleaveStreams(const VertexLayout &layout, const float *src, const uint32 numVertices, float *const *streams)
+{
+   const uint32 vertexFloats = layout.GetNumFloats();
+   uint32 floatOffset = 0;
+   for (uint32 i = 0; i < layout.GetNumAttributes(); i++)
+   {
+      const uint32 floats = layout.GetAttribute(i).numFloats;
+      for (uint32 v = 0; v < numVertices; v++)
+         memcpy(streams[i] + v * floats, src + v * vertexFloats + floatOffset, floats * sizeof(float));
+      floatOffset += floats;
+   }
+}
+
+bool GetMeshStream(const eVertexFormat semantic, mesh::eMeshStream &streamOut)
+{
+   switch (semantic)
+   {
+   case vertexformat::VF_POSITION:
+      streamOut = mesh::MS_POSITION;
+      return true;
+   case vertexformat::VF_NORMAL:
+      streamOut = mesh::MS_NORMAL;
+      return true;
+   case vertexformat::VF_TEXCOORD2D_1:
+      streamOut = mesh::MS_TEXCOORD2;
+      return true;
+   case vertexformat::VF_TEXCOORD3D_1:
+      streamOut = mesh::MS_TEXCOORD3;
+      return true;
+   case vertexformat::VF_COLOR:
+      streamOut = mesh::MS_COLOR;
+      return true;
+   case vertexformat::VF_BINORMAL:
+      streamOut = mesh::MS_BINORMAL;
+      return true;
+   default:
+      return false;
+   }
+}
+
+} // namespace vertexstream
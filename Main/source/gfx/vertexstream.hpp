@@ -0,0 +1,126 @@
+#ifndef _VERTEXSTREAM_HPP_INCLUDED_
+#define _VERTEXSTREAM_HPP_INCLUDED_
+
+#include <vector>
+
+#include "core/BasicTypes.hpp"
+#include "gfx/vertexformat.hpp"
+#include "model/mesh.hpp"
+
+namespace vertexstream
+{
+
+using vertexformat::eDataType;
+using vertexformat::eVertexFormat;
+
+// Packing of float vertex attributes into one interleaved vertex buffer, converting each attribute
+// to a compact type on the way: half floats for texture coordinates, 2_10_10_10 normals and 8 bit
+// colors take a half to a quarter of the floats. The converters are the GL conversions, rounded to
+// nearest even, so a shader reads back what the floats round to
+
+// IEEE half, infinity above the half range
+uint16 FloatToHalf(const float value);
+float HalfToFloat(const uint16 value);
+// signed normalized x, y and z in 10 bits each and w in 2 bits, x in the low bits (GL_INT_2_10_10_10_REV)
+uint32 PackSnorm2_10_10_10(const float x, const float y, const float z, const float w = 0.0f);
+// unsigned normalized 8 bits per component, x in the low byte
+uint32 PackUnorm8(const float x, const float y, const float z, const float w = 1.0f);
+// unsigned 11, 11 and 10 bit floats, r in the low bits (GL_UNSIGNED_INT_10F_11F_11F_REV). Negative
+// values become 0 and values above the range the largest finite value
+uint32 PackR11G11B10F(const float r, const float g, const float b);
+
+// Converts count elements of numComponents floats, srcStride floats apart, to type at dst, dstStride
+// bytes apart. With SSE2, 2_10_10_10 and unorm8 convert four elements at a time and half converts the
+// components of one element per load. The supported types are float, half, 2_10_10_10, unsigned
+// byte (unorm8) and 10F_11F_11F
+void ConvertAttribute(const float *src, const uint32 srcStride, const uint32 numComponents, const eDataType type,
+   void *dst, const uint32 dstStride, const uint32 count);
+
+// components numComponents floats have once stored as type, as glVertexAttribPointer wants them
+uint32 GetStoredComponents(const eDataType type, const uint32 numComponents);
+// bytes of numComponents floats stored as type, padded to 4 bytes
+uint32 GetAttributeSize(const eDataType type, const uint32 numComponents);
+
+struct VertexAttribute
+{
+   eVertexFormat semantic; // one bit of eVertexFormat
+   eDataType type;
+   uint32 numFloats; // of the source attribute
+   uint32 numComponents; // as stored
+   uint32 offset; // bytes from the start of the vertex
+   bool normalized; // integer types are read as normalized floats
+};
+
+// what each kind of attribute is stored as
+struct VertexEncoding
+{
+   eDataType position;
+   eDataType normal; // normals and binormals
+   eDataType texcoord;
+   eDataType color;
+
+   VertexEncoding() :
+      position(vertexformat::DATATYPE_FLOAT),
+      normal(vertexformat::DATATYPE_FLOAT),
+      texcoord(vertexformat::DATATYPE_FLOAT),
+      color(vertexformat::DATATYPE_FLOAT)
+   {
+   }
+
+   // float positions, 2_10_10_10 normals, half texture coordinates and unorm8 colors
+   static VertexEncoding Compact();
+};
+
+const uint32 MAX_VERTEX_ATTRIBUTES = 8;
+
+// packed layout of the attributes of a vertex format, in the order of the eVertexFormat bits
+class VertexLayout
+{
+private:
+   VertexAttribute attributes[MAX_VERTEX_ATTRIBUTES];
+   uint32 numAttributes;
+   uint32 stride;
+   uint32 numFloats; // of a vertex of float attributes in the same order
+public:
+   VertexLayout(const eVertexFormat format, const VertexEncoding &encoding = VertexEncoding());
+
+   uint32 GetNumAttributes() const { return numAttributes; }
+   const VertexAttribute &GetAttribute(const uint32 index) const { return attributes[index]; }
+   uint32 GetStride() const { return stride; }
+   uint32 GetNumFloats() const { return numFloats; }
+};
+
+// packs numVertices vertices of GetStride() bytes into dst, streams[i] holds the floats of attribute i
+void InterleaveStreams(const VertexLayout &layout, const float *const *streams, const uint32 numVertices, void *dst);
+// packs vertices of interleaved floats, GetNumFloats() each with the attributes in layout order
+void ConvertInterleaved(const VertexLayout &layout, const float *src, const uint32 numVertices, void *dst);
+// splits vertices of interleaved floats into one stream per attribute
+void DeinterleaveStreams(const VertexLayout &layout, const float *src, const uint32 numVertices, float *const *streams);
+
+// stream of a mesh that holds the attribute, false if there is none
+bool GetMeshStream(const eVertexFormat semantic, mesh::eMeshStream &streamOut);
+
+// Packs the streams of a mesh whose attributes share one index, element i of every stream belongs
+// to vertex i. Returns false when a stream of the layout is missing or shorter than the positions
+template <typename TFace>
+bool InterleaveMesh(const mesh::Mesh<TFace> &mesh, const VertexLayout &layout, std::vector<byte> &verticesOut)
+{
+   const float *streams[MAX_VERTEX_ATTRIBUTES];
+   const uint32 numVertices = mesh.GetStreamCount(mesh::MS_POSITION);
+   for (uint32 i = 0; i < layout.GetNumAttributes(); i++)
+   {
+      mesh::eMeshStream stream;
+      if (!GetMeshStream(layout.GetAttribute(i).semantic, stream) || mesh.GetStreamCount(stream) < numVertices)
+         return false;
+      streams[i] = mesh.GetStream(stream);
+   }
+
+   verticesOut.resize(numVertices * layout.GetStride());
+   if (numVertices > 0)
+      InterleaveStreams(layout, streams, numVertices, &verticesOut[0]);
+   return true;
+}
+
+} // namespace vertexstream
+
+#endif
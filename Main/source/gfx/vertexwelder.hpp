@@ -0,0 +1,166 @@
+#ifndef _VERTEXWELDER_HPP_INCLUDED_
+#define _VERTEXWELDER_HPP_INCLUDED_
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "core/BasicTypes.hpp"
+
+namespace vertexwelder
+{
+
+// Welds a flat stream of unindexed vertices (one vertex per face corner, floatsPerVertex packed
+// floats each, e.g. position, normal, uv) into the unique vertices and an index buffer.
+// Vertices are looked up in an open addressing hash table with linear probing, so welding is
+// linear in the number of corners and does not allocate per vertex.
+//
+// With an epsilon of 0 vertices weld when they are bitwise equal (with -0 equal to 0). A positive
+// epsilon quantizes every component to a grid of that size and welds vertices in the same cell,
+// the first vertex seen in a cell is the one that is kept.
+//
+// TFace is the index type, uint16 or uint32. The table memory is kept between calls.
+// Components beyond the int32 range of the grid (and NaNs) clamp to its first or last cell.
+template <typename TFace>
+class VertexWelder
+{
+public:
+   // the hash table has twice as many slots as vertices, in 32 bit
+   static const uint32 MAX_VERTICES = 1u << 30;
+private:
+   uint32 floatsPerVertex;
+   float invEpsilon;
+   std::vector<uint32> slots; // unique index + 1, 0 marks an empty slot
+   std::vector<uint32> slotHashes;
+   std::vector<uint32> keys; // quantized or normalized components of the unique vertices
+   std::vector<uint32> key;
+
+   uint32 MakeKey(const float *vertex);
+   bool KeyEquals(const uint32 uniqueIndex) const;
+public:
+   VertexWelder(const uint32 floatsPerVertex, const float epsilon = 0.0f);
+
+   // weld numVertices vertices, the results replace the content of the output vectors.
+   // Returns false if the unique vertices do not fit the TFace index range or there are more
+   // than MAX_VERTICES vertices
+   bool Weld(const float *vertices, const uint32 numVertices, std::vector<float> &uniqueOut, std::vector<TFace> &indicesOut);
+
+   uint32 GetFloatsPerVertex() const { return floatsPerVertex; }
+};
+
+template <typename TFace>
+VertexWelder<TFace>::VertexWelder(const uint32 floatsPerVertex, const float epsilon)
+{
+   assert(floatsPerVertex > 0);
+
+   this->floatsPerVertex = floatsPerVertex;
+   invEpsilon = epsilon > 0.0f ? 1.0f / epsilon : 0.0f;
+   key.resize(floatsPerVertex);
+}
+
+// builds the key of a vertex and returns its hash
+template <typename TFace>
+uint32 VertexWelder<TFace>::MakeKey(const float *vertex)
+{
+   uint32 hash = 0x811C9DC5u;
+   for (uint32 i = 0; i < floatsPerVertex; i++)
+   {
+      uint32 word;
+      if (invEpsilon > 0.0f)
+      {
+         // converting a float outside the int32 range is undefined, clamp first
+         const float cell = floorf(vertex[i] * invEpsilon + 0.5f);
+         if (cell >= 2147483648.0f)
+            word = 0x7FFFFFFFu;
+         else if (!(cell >= -2147483648.0f))
+            word = 0x80000000u;
+         else
+            word = (uint32)(int32)cell;
+      }
+      else
+      {
+         // +0 and -0 must end up in the same slot
+         const float value = vertex[i] == 0.0f ? 0.0f : vertex[i];
+         memcpy(&word, &value, sizeof(word));
+      }
+      key[i] = word;
+
+      hash ^= word;
+      hash *= 0x9E3779B1u;
+      hash ^= hash >> 15;
+   }
+
+   // final avalanche so nearby keys spread over the table
+   hash ^= hash >> 16;
+   hash *= 0x85EBCA6Bu;
+   hash ^= hash >> 13;
+   hash *= 0xC2B2AE35u;
+   hash ^= hash >> 16;
+   return hash;
+}
+
+template <typename TFace>
+bool VertexWelder<TFace>::KeyEquals(const uint32 uniqueIndex) const
+{
+   return memcmp(&keys[uniqueIndex * floatsPerVertex], &key[0], floatsPerVertex * sizeof(uint32)) == 0;
+}
+
+template <typename TFace>
+bool VertexWelder<TFace>::Weld(const float *vertices, const uint32 numVertices, std::vector<float> &uniqueOut, std::vector<TFace> &indicesOut)
+{
+   uniqueOut.clear();
+   indicesOut.clear();
+   keys.clear();
+   if (numVertices == 0)
+      return true;
+   if (numVertices > MAX_VERTICES)
+      return false;
+
+   // keep the load factor at or below one half
+   uint32 capacity = 16;
+   while (capacity < numVertices * 2)
+      capacity <<= 1;
+   const uint32 mask = capacity - 1;
+   slots.assign(capacity, 0);
+   slotHashes.resize(capacity);
+
+   indicesOut.reserve(numVertices);
+   const uint32 maxUnique = (uint32)(TFace)~(TFace)0 + 1u;
+
+   for (uint32 v = 0; v < numVertices; v++)
+   {
+      const float *vertex = vertices + (size_t)v * floatsPerVertex;
+      const uint32 hash = MakeKey(vertex);
+
+      uint32 slot = hash & mask;
+      while (slots[slot] != 0)
+      {
+         if (slotHashes[slot] == hash && KeyEquals(slots[slot] - 1))
+            break;
+         slot = (slot + 1) & mask;
+      }
+
+      if (slots[slot] == 0)
+      {
+         const uint32 uniqueIndex = (uint32)(uniqueOut.size() / floatsPerVertex);
+         if (maxUnique != 0 && uniqueIndex >= maxUnique)
+         {
+            uniqueOut.clear();
+            indicesOut.clear();
+            return false;
+         }
+
+         slots[slot] = uniqueIndex + 1;
+         slotHashes[slot] = hash;
+         uniqueOut.insert(uniqueOut.end(), vertex, vertex + floatsPerVertex);
+         keys.insert(keys.end(), key.begin(), key.end());
+      }
+      indicesOut.push_back((TFace)(slots[slot] - 1));
+   }
+   return true;
+}
+
+} // namespace vertexwelder
+
+#endif
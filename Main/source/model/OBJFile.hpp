@@ -42,9 +42,11 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _OBJFILE_HPP_INCLUDED_
 
 #include <vector>
-#include <map>
 
 #include "mesh2.hpp"
+#include "core/containers/flathashmap.hpp"
+#include "core/string/nameid.hpp"
+using core::string::NameId;
 using mesh2::aiPrimitiveType;
 using mesh2::aiPrimitiveType_POLYGON;
 
@@ -260,9 +262,11 @@ namespace objfile
    //!	\brief	Data structure to store all obj-specific model datas
    struct Model
    {
-      typedef std::map<String_c, std::vector<uint32>* > GroupMap;
-      typedef std::map<String_c, std::vector<uint32>* >::iterator GroupMapIt;
-      typedef std::map<String_c, std::vector<uint32>* >::const_iterator ConstGroupMapIt;
+      // keyed by the interned names, NameId::Intern the name when adding an entry
+      typedef core::containers::FlatHashMap<NameId, std::vector<uint32>* > GroupMap;
+      typedef GroupMap::Iterator GroupMapIt;
+      typedef GroupMap::ConstIterator ConstGroupMapIt;
+      typedef core::containers::FlatHashMap<NameId, Material*> MaterialMap;
 
       //!	Model name
       String_c m_ModelName;
@@ -288,6 +292,8 @@ namespace objfile
       std::vector<uint32> *m_pGroupFaceIDs;
       //!	Active group
       String_c m_strActiveGroup;
+      //!	Id of the active group name
+      NameId m_ActiveGroupId;
       //!	Vector with generated texture coordinates
       std::vector<Vector3f> m_TextureCoord;
       //!	Current mesh instance
@@ -295,7 +301,7 @@ namespace objfile
       //!	Vector with stored meshes
       std::vector<Mesh*> m_Meshes;
       //!	Material map
-      std::map<String_c, Material*> m_MaterialMap;
+      MaterialMap m_MaterialMap;
 
       //!	\brief	The default class constructor
       Model() :
@@ -305,6 +311,7 @@ namespace objfile
          m_pDefaultMaterial(NULL),
          m_pGroupFaceIDs(NULL),
          m_strActiveGroup(""),
+         m_ActiveGroupId(""),
          m_pCurrentMesh(NULL)
       {
          // empty
@@ -328,12 +335,12 @@ namespace objfile
          m_Meshes.clear();
 
          for (GroupMapIt it = m_Groups.begin(); it != m_Groups.end(); ++it) {
-            delete it->second;
+            delete it->value;
          }
          m_Groups.clear();
 
-         for (std::map<String_c, Material*>::iterator it = m_MaterialMap.begin(); it != m_MaterialMap.end(); ++it) {
-            delete it->second;
+         for (MaterialMap::Iterator it = m_MaterialMap.begin(); it != m_MaterialMap.end(); ++it) {
+            delete it->value;
          }
       }
    };
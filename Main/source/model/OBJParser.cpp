@@ -46,6 +46,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "OBJParser.hpp"
 
+#include <algorithm>
+
 using mesh2::aiPrimitiveType_LINE;
 using mesh2::aiPrimitiveType_POINT;
 
@@ -58,6 +60,8 @@ using objtools::getNextWord;
 
 #include "core/fast_atof.hpp"
 using Assimp::fast_atof;
+using Assimp::fast_atof_n;
+using Assimp::strtol10_n;
 
 //#include "ParsingUtils.h"
 //#include "../include/assimp/types.h"
@@ -71,11 +75,42 @@ namespace model
    // -------------------------------------------------------------------
    //	Constructor with loaded data and directories.
    ObjFileParser::ObjFileParser(std::vector<char> &Data, const String_c &strModelName, IOSystem *io) :
-      m_DataIt(Data.begin()),
-      m_DataItEnd(Data.end()),
+      m_DataIt(Data.empty() ? NULL : &Data[0]),
+      m_DataItEnd(Data.empty() ? NULL : &Data[0] + Data.size()),
+      m_pModel(NULL),
+      m_uiLine(0),
+      m_pIO(io)
+   {
+      init(strModelName, 1);
+   }
+
+   // -------------------------------------------------------------------
+   //	Constructor with a character range, parsed in place.
+   ObjFileParser::ObjFileParser(const char *pBegin, const char *pEnd, const String_c &strModelName, IOSystem *io, uint32 uiNumThreads) :
+      m_DataIt(pBegin),
+      m_DataItEnd(pEnd),
+      m_pModel(NULL),
+      m_uiLine(0),
+      m_pIO(io)
+   {
+      init(strModelName, uiNumThreads);
+   }
+
+   // -------------------------------------------------------------------
+   //	Constructor with a memory mapped file, parsed in place.
+   ObjFileParser::ObjFileParser(const MappedFile &File, const String_c &strModelName, IOSystem *io, uint32 uiNumThreads) :
+      m_DataIt(File.GetData()),
+      m_DataItEnd(File.GetEnd()),
       m_pModel(NULL),
       m_uiLine(0),
       m_pIO(io)
+   {
+      init(strModelName, uiNumThreads);
+   }
+
+   // -------------------------------------------------------------------
+   //	Creates the model and starts parsing.
+   void ObjFileParser::init(const String_c &strModelName, uint32 uiNumThreads)
    {
       std::fill_n(m_buffer, BUFFERSIZE, 0);
 
@@ -87,10 +122,13 @@ namespace model
       m_pModel->m_pDefaultMaterial = new objfile::Material();
       m_pModel->m_pDefaultMaterial->MaterialName = DEFAULT_MATERIAL;
       m_pModel->m_MaterialLib.push_back(DEFAULT_MATERIAL);
-      m_pModel->m_MaterialMap[DEFAULT_MATERIAL] = m_pModel->m_pDefaultMaterial;
+      m_pModel->m_MaterialMap[NameId::Intern(DEFAULT_MATERIAL.GetView())] = m_pModel->m_pDefaultMaterial;
 
       // Start parsing the file
-      parseFile();
+      if (uiNumThreads == 1)
+         parseFile();
+      else
+         parseFileParallel(uiNumThreads);
    }
 
    // -------------------------------------------------------------------
@@ -112,120 +150,361 @@ namespace model
    //	File parsing method.
    void ObjFileParser::parseFile()
    {
-      if (m_DataIt == m_DataItEnd)
-         return;
-
       while (m_DataIt != m_DataItEnd)
+         parseStatement();
+   }
+
+   // -------------------------------------------------------------------
+   //	Parse a single statement, the position is left on the next one.
+   void ObjFileParser::parseStatement()
+   {
+      switch (*m_DataIt)
       {
-         switch (*m_DataIt)
-         {
-         case 'v': // Parse a vertex texture coordinate
-         {
+      case 'v': // Parse a vertex texture coordinate
+      {
+         // the range is not zero-terminated, never look past its end
+         if (++m_DataIt == m_DataItEnd)
+            break;
+         if (*m_DataIt == ' ' || *m_DataIt == '\t') {
+            // read in vertex definition
+            getVector3(m_pModel->m_Vertices);
+         }
+         else if (*m_DataIt == 't') {
+            // read in texture coordinate ( 2D or 3D )
             ++m_DataIt;
-            if (*m_DataIt == ' ' || *m_DataIt == '\t') {
-               // read in vertex definition
-               getVector3(m_pModel->m_Vertices);
-            }
-            else if (*m_DataIt == 't') {
-               // read in texture coordinate ( 2D or 3D )
-               ++m_DataIt;
-               getVector(m_pModel->m_TextureCoord);
-            }
-            else if (*m_DataIt == 'n') {
-               // Read in normal vector definition
-               ++m_DataIt;
-               getVector3(m_pModel->m_Normals);
-            }
+            getVector(m_pModel->m_TextureCoord);
          }
-         break;
-
-         case 'p': // Parse a face, line or point statement
-         case 'l':
-         case 'f':
-         {
-            getFace(*m_DataIt == 'f' ? aiPrimitiveType_POLYGON : (*m_DataIt == 'l'
-               ? aiPrimitiveType_LINE : aiPrimitiveType_POINT));
+         else if (*m_DataIt == 'n') {
+            // Read in normal vector definition
+            ++m_DataIt;
+            getVector3(m_pModel->m_Normals);
          }
-         break;
+      }
+      break;
 
-         case '#': // Parse a comment
-         {
-            getComment();
-         }
-         break;
+      case 'p': // Parse a face, line or point statement
+      case 'l':
+      case 'f':
+      {
+         getFace(*m_DataIt == 'f' ? aiPrimitiveType_POLYGON : (*m_DataIt == 'l'
+            ? aiPrimitiveType_LINE : aiPrimitiveType_POINT));
+      }
+      break;
 
-         case 'u': // Parse a material desc. setter
-         {
-            getMaterialDesc();
-         }
-         break;
+      case '#': // Parse a comment
+      {
+         getComment();
+      }
+      break;
+
+      case 'u': // Parse a material desc. setter
+      {
+         getMaterialDesc();
+      }
+      break;
+
+      case 'm': // Parse a material library or merging group ('mg')
+      {
+         if (m_DataIt + 1 != m_DataItEnd && *(m_DataIt + 1) == 'g')
+            getGroupNumberAndResolution();
+         else
+            getMaterialLib();
+      }
+      break;
+
+      case 'g': // Parse group name
+      {
+         getGroupName();
+      }
+      break;
+
+      case 's': // Parse group number
+      {
+         getGroupNumber();
+      }
+      break;
+
+      case 'o': // Parse object name
+      {
+         getObjectName();
+      }
+      break;
+
+      default:
+      {
+         m_DataIt = skipLine<DataArrayIt>(m_DataIt, m_DataItEnd, m_uiLine);
+      }
+      break;
+      }
+   }
+
+   // -------------------------------------------------------------------
+   //	Parallel parsing. The buffer is split at line boundaries, every
+   //	worker parses the vectors of its chunk and records faces and
+   //	directives. Once the vector counts of all chunks are known the
+   //	faces are parsed with the same counts the serial parser would
+   //	see, so relative indices resolve identically. The merge then
+   //	replays the chunks in file order on the calling thread.
+   void ObjFileParser::parseFileParallel(uint32 uiNumThreads)
+   {
+      // the chunks run as tasks of the engine's scheduler, without one the file is parsed serially
+      TaskScheduler *pScheduler = TaskScheduler::GetActive();
+      if (pScheduler == NULL)
+      {
+         parseFile();
+         return;
+      }
+      if (uiNumThreads == 0)
+         uiNumThreads = pScheduler->GetNumThreads();
+
+      const size_t size = m_DataItEnd - m_DataIt;
+      const size_t numChunks = std::min((size_t)uiNumThreads, size / MIN_CHUNKSIZE);
+      if (numChunks < 2)
+      {
+         parseFile();
+         return;
+      }
+
+      std::vector<Chunk> chunks(numChunks);
+      const char *pBegin = m_DataIt;
+      for (size_t i = 0; i < numChunks; ++i)
+      {
+         Chunk &chunk = chunks[i];
+         chunk.m_pBegin = pBegin;
+         if (i + 1 == numChunks)
+            chunk.m_pEnd = m_DataItEnd;
+         else
+            chunk.m_pEnd = findChunkEnd(pBegin, pBegin + (m_DataItEnd - pBegin) / (numChunks - i), m_DataItEnd);
+         chunk.m_uiLines = 0;
+
+         // the serial parser reaches the next chunk through skipLine, which also skips the indentation
+         pBegin = chunk.m_pEnd;
+         while (pBegin != m_DataItEnd && (*pBegin == ' ' || *pBegin == '\t'))
+            ++pBegin;
+      }
 
-         case 'm': // Parse a material library or merging group ('mg')
+      pScheduler->ParallelFor(0, (uint32)numChunks, 1, [&chunks](uint32 uiBegin, uint32 uiEnd)
+      {
+         for (uint32 i = uiBegin; i < uiEnd; ++i)
+            parseChunkStatements(&chunks[i]);
+      });
+
+      size_t numVertices = m_pModel->m_Vertices.size();
+      size_t numTexCoords = m_pModel->m_TextureCoord.size();
+      size_t numNormals = m_pModel->m_Normals.size();
+      for (size_t i = 0; i < numChunks; ++i)
+      {
+         chunks[i].m_uiBaseVertices = (uint32)numVertices;
+         chunks[i].m_uiBaseTexCoords = (uint32)numTexCoords;
+         chunks[i].m_uiBaseNormals = (uint32)numNormals;
+         numVertices += chunks[i].m_Vertices.size();
+         numTexCoords += chunks[i].m_TextureCoord.size();
+         numNormals += chunks[i].m_Normals.size();
+      }
+
+      pScheduler->ParallelFor(0, (uint32)numChunks, 1, [&chunks](uint32 uiBegin, uint32 uiEnd)
+      {
+         for (uint32 i = uiBegin; i < uiEnd; ++i)
+            parseChunkFaces(&chunks[i]);
+      });
+
+      // Merge the vectors
+      m_pModel->m_Vertices.reserve(numVertices);
+      m_pModel->m_TextureCoord.reserve(numTexCoords);
+      m_pModel->m_Normals.reserve(numNormals);
+      for (size_t i = 0; i < numChunks; ++i)
+      {
+         m_pModel->m_Vertices.insert(m_pModel->m_Vertices.end(), chunks[i].m_Vertices.begin(), chunks[i].m_Vertices.end());
+         m_pModel->m_TextureCoord.insert(m_pModel->m_TextureCoord.end(), chunks[i].m_TextureCoord.begin(), chunks[i].m_TextureCoord.end());
+         m_pModel->m_Normals.insert(m_pModel->m_Normals.end(), chunks[i].m_Normals.begin(), chunks[i].m_Normals.end());
+      }
+
+      // Replay faces and directives in file order
+      const char *pDataEnd = m_DataItEnd;
+      uint32 uiLines = m_uiLine;
+      for (size_t i = 0; i < numChunks; ++i)
+      {
+         Chunk &chunk = chunks[i];
+         for (size_t j = 0; j < chunk.m_Statements.size(); ++j)
          {
-            if (*(m_DataIt + 1) == 'g')
-               getGroupNumberAndResolution();
+            const Statement &statement = chunk.m_Statements[j];
+            if (statement.m_bFace)
+            {
+               reportFaceErrors(statement.m_uiFaceErrors);
+               if (chunk.m_Faces[j] != NULL)
+                  addFace(chunk.m_Faces[j]);
+            }
             else
-               getMaterialLib();
+            {
+               m_DataIt = statement.m_pStart;
+               parseStatement();
+            }
          }
-         break;
+         uiLines += chunk.m_uiLines;
+      }
+      m_DataIt = pDataEnd;
+      m_uiLine = uiLines;
+   }
 
-         case 'g': // Parse group name
+   // -------------------------------------------------------------------
+   //	Worker pass 1, mirrors parseStatement() on a chunk.
+   void ObjFileParser::parseChunkStatements(Chunk *pChunk)
+   {
+      const char *pIt = pChunk->m_pBegin;
+      const char *pEnd = pChunk->m_pEnd;
+      while (pIt != pEnd)
+      {
+         switch (*pIt)
+         {
+         case 'v':
          {
-            getGroupName();
+            if (++pIt == pEnd)
+               break;
+            if (*pIt == ' ' || *pIt == '\t')
+               pIt = parseVector3(pIt, pEnd, pChunk->m_Vertices, pChunk->m_uiLines);
+            else if (*pIt == 't')
+               pIt = parseVector(pIt + 1, pEnd, pChunk->m_TextureCoord, pChunk->m_uiLines);
+            else if (*pIt == 'n')
+               pIt = parseVector3(pIt + 1, pEnd, pChunk->m_Normals, pChunk->m_uiLines);
          }
          break;
 
-         case 's': // Parse group number
+         case 'p':
+         case 'l':
+         case 'f':
          {
-            getGroupNumber();
+            Statement statement;
+            statement.m_pStart = pIt;
+            statement.m_bFace = true;
+            statement.m_Type = (*pIt == 'f' ? aiPrimitiveType_POLYGON : (*pIt == 'l'
+               ? aiPrimitiveType_LINE : aiPrimitiveType_POINT));
+            statement.m_uiNumVertices = (uint32)pChunk->m_Vertices.size();
+            statement.m_uiNumTexCoords = (uint32)pChunk->m_TextureCoord.size();
+            statement.m_uiNumNormals = (uint32)pChunk->m_Normals.size();
+            statement.m_uiFaceErrors = 0;
+
+            pChunk->m_Statements.push_back(statement);
+            pIt = copyLine(pIt, pEnd, NULL, BUFFERSIZE);
+            if (pIt == pEnd)
+               break;
+            pIt = skipLine<DataArrayIt>(pIt, pEnd, pChunk->m_uiLines);
          }
          break;
 
-         case 'o': // Parse object name
+         case 'u':
+         case 'm':
+         case 'g':
+         case 's':
+         case 'o':
          {
-            getObjectName();
+            Statement statement;
+            statement.m_pStart = pIt;
+            statement.m_bFace = false;
+            statement.m_Type = aiPrimitiveType_POINT;
+            statement.m_uiNumVertices = 0;
+            statement.m_uiNumTexCoords = 0;
+            statement.m_uiNumNormals = 0;
+            statement.m_uiFaceErrors = 0;
+            pChunk->m_Statements.push_back(statement);
+            pIt = skipLine<DataArrayIt>(pIt, pEnd, pChunk->m_uiLines);
          }
          break;
 
          default:
          {
-            m_DataIt = skipLine<DataArrayIt>(m_DataIt, m_DataItEnd, m_uiLine);
+            pIt = skipLine<DataArrayIt>(pIt, pEnd, pChunk->m_uiLines);
          }
          break;
          }
       }
    }
 
+   // -------------------------------------------------------------------
+   //	Worker pass 2, builds the faces recorded in pass 1.
+   void ObjFileParser::parseChunkFaces(Chunk *pChunk)
+   {
+      pChunk->m_Faces.resize(pChunk->m_Statements.size(), NULL);
+      for (size_t i = 0; i < pChunk->m_Statements.size(); ++i)
+      {
+         Statement &statement = pChunk->m_Statements[i];
+         if (!statement.m_bFace)
+            continue;
+
+         copyLine(statement.m_pStart, pChunk->m_pEnd, pChunk->m_buffer, BUFFERSIZE);
+         pChunk->m_Faces[i] = buildFace(pChunk->m_buffer, statement.m_Type,
+            pChunk->m_uiBaseVertices + statement.m_uiNumVertices,
+            pChunk->m_uiBaseTexCoords + statement.m_uiNumTexCoords,
+            pChunk->m_uiBaseNormals + statement.m_uiNumNormals,
+            statement.m_uiFaceErrors);
+      }
+   }
+
+   // -------------------------------------------------------------------
+   //	Find the first line start at or after pSplit. A line break is only
+   //	taken if it does not continue a face line with a backslash.
+   const char *ObjFileParser::findChunkEnd(const char *pBegin, const char *pSplit, const char *pEnd)
+   {
+      for (const char *pIt = pSplit; pIt != pEnd; ++pIt)
+      {
+         if (*pIt != '\n')
+            continue;
+
+         const char *pPrev = pIt;
+         while (pPrev != pBegin && (*(pPrev - 1) == '\r' || *(pPrev - 1) == '\n'))
+            --pPrev;
+         if (pPrev != pBegin && *(pPrev - 1) == '\\')
+            continue;
+
+         return pIt + 1;
+      }
+      return pEnd;
+   }
+
    // -------------------------------------------------------------------
    //	Copy the next word in a temporary buffer
    void ObjFileParser::copyNextWord(char *pBuffer, size_t length)
+   {
+      m_DataIt = copyWord(m_DataIt, m_DataItEnd, pBuffer, length);
+   }
+
+   // -------------------------------------------------------------------
+   //	Copy the next word from a range in a temporary buffer
+   const char *ObjFileParser::copyWord(const char *pIt, const char *pEnd, char *pBuffer, size_t length)
    {
       size_t index = 0;
-      m_DataIt = getNextWord<DataArrayIt>(m_DataIt, m_DataItEnd);
-      while (m_DataIt != m_DataItEnd && !IsSpaceOrNewLine(*m_DataIt)) {
-         pBuffer[index] = *m_DataIt;
+      pIt = getNextWord<DataArrayIt>(pIt, pEnd);
+      while (pIt != pEnd && !IsSpaceOrNewLine(*pIt)) {
+         pBuffer[index] = *pIt;
          index++;
          if (index == length - 1) {
             break;
          }
-         ++m_DataIt;
+         ++pIt;
       }
 
       assert(index < length);
       pBuffer[index] = '\0';
+      return pIt;
    }
 
    // -------------------------------------------------------------------
    // Copy the next line into a temporary buffer
    void ObjFileParser::copyNextLine(char *pBuffer, size_t length)
+   {
+      m_DataIt = copyLine(m_DataIt, m_DataItEnd, pBuffer, length);
+   }
+
+   // -------------------------------------------------------------------
+   // Copy the next line from a range into a temporary buffer
+   const char *ObjFileParser::copyLine(const char *pIt, const char *pEnd, char *pBuffer, size_t length)
    {
       size_t index = 0u;
 
       // some OBJ files have line continuations using \ (such as in C++ et al)
       bool continuation = false;
-      for (; m_DataIt != m_DataItEnd && index < length - 1; ++m_DataIt)
+      for (; pIt != pEnd && index < length - 1; ++pIt)
       {
-         const char c = *m_DataIt;
+         const char c = *pIt;
          if (c == '\\') {
             continuation = true;
             continue;
@@ -233,71 +512,71 @@ namespace model
 
          if (c == '\n' || c == '\r') {
             if (continuation) {
-               pBuffer[index++] = ' ';
+               if (pBuffer != NULL)
+                  pBuffer[index] = ' ';
+               ++index;
                continue;
             }
             break;
          }
 
          continuation = false;
-         pBuffer[index++] = c;
+         if (pBuffer != NULL)
+            pBuffer[index] = c;
+         ++index;
       }
       assert(index < length);
-      pBuffer[index] = '\0';
+      if (pBuffer != NULL)
+         pBuffer[index] = '\0';
+      return pIt;
    }
 
    // -------------------------------------------------------------------
    void ObjFileParser::getVector(std::vector<Vector3f> &point3d_array) {
+      m_DataIt = parseVector(m_DataIt, m_DataItEnd, point3d_array, m_uiLine);
+   }
+
+   // -------------------------------------------------------------------
+   const char *ObjFileParser::parseVector(const char *pIt, const char *pEnd,
+      std::vector<Vector3f> &point3d_array, uint32 &uiLine) {
       size_t numComponents(0);
-      const char* tmp(&m_DataIt[0]);
-      while (!IsLineEnd(*tmp)) {
-         if (!SkipSpaces(&tmp)) {
+      const char* tmp = pIt;
+      while (tmp != pEnd && !IsLineEnd(*tmp)) {
+         while (tmp != pEnd && (*tmp == ' ' || *tmp == '\t'))
+            ++tmp;
+         if (tmp == pEnd || IsLineEnd(*tmp))
             break;
-         }
-         SkipToken(tmp);
+         while (tmp != pEnd && !IsSpaceOrNewLine(*tmp))
+            ++tmp;
          ++numComponents;
       }
-      float x, y, z;
-      if (2 == numComponents) {
-         copyNextWord(m_buffer, BUFFERSIZE);
-         x = (float)fast_atof(m_buffer);
-
-         copyNextWord(m_buffer, BUFFERSIZE);
-         y = (float)fast_atof(m_buffer);
-         z = 0.0;
-      }
-      else if (3 == numComponents) {
-         copyNextWord(m_buffer, BUFFERSIZE);
-         x = (float)fast_atof(m_buffer);
-
-         copyNextWord(m_buffer, BUFFERSIZE);
-         y = (float)fast_atof(m_buffer);
-
-         copyNextWord(m_buffer, BUFFERSIZE);
-         z = (float)fast_atof(m_buffer);
+      float xyz[3] = { 0.0f, 0.0f, 0.0f };
+      if (2 == numComponents || 3 == numComponents) {
+         pIt = fast_atof_n(pIt, pEnd, xyz, (uint32)numComponents);
       }
       else {
          assert(!"Invalid number of components");
       }
-      point3d_array.push_back(Vector3f(x, y, z));
-      m_DataIt = skipLine<DataArrayIt>(m_DataIt, m_DataItEnd, m_uiLine);
+      point3d_array.push_back(Vector3f(xyz[0], xyz[1], xyz[2]));
+      return skipLine<DataArrayIt>(pIt, pEnd, uiLine);
    }
 
    // -------------------------------------------------------------------
    //	Get values for a new 3D vector instance
    void ObjFileParser::getVector3(std::vector<Vector3f> &point3d_array) {
-      float x, y, z;
-      copyNextWord(m_buffer, BUFFERSIZE);
-      x = (float)fast_atof(m_buffer);
-
-      copyNextWord(m_buffer, BUFFERSIZE);
-      y = (float)fast_atof(m_buffer);
-
-      copyNextWord(m_buffer, BUFFERSIZE);
-      z = (float)fast_atof(m_buffer);
+      m_DataIt = parseVector3(m_DataIt, m_DataItEnd, point3d_array, m_uiLine);
+   }
 
-      point3d_array.push_back(Vector3f(x, y, z));
-      m_DataIt = skipLine<DataArrayIt>(m_DataIt, m_DataItEnd, m_uiLine);
+   // -------------------------------------------------------------------
+   //	Get values for a new 3D vector instance from a range
+   const char *ObjFileParser::parseVector3(const char *pIt, const char *pEnd,
+      std::vector<Vector3f> &point3d_array, uint32 &uiLine) {
+      // the values are converted in place, no word is copied out of the line
+      float xyz[3];
+      pIt = fast_atof_n(pIt, pEnd, xyz, 3);
+
+      point3d_array.push_back(Vector3f(xyz[0], xyz[1], xyz[2]));
+      return skipLine<DataArrayIt>(pIt, pEnd, uiLine);
    }
 
    // -------------------------------------------------------------------
@@ -319,27 +598,37 @@ namespace model
    //	Get values for a new face instance
    void ObjFileParser::getFace(aiPrimitiveType type)
    {
+      // a last line without a newline ends at m_DataItEnd, it is still a face
       copyNextLine(m_buffer, BUFFERSIZE);
-      if (m_DataIt == m_DataItEnd)
-         return;
 
-      char *pPtr = m_buffer;
-      char *pEnd = &pPtr[BUFFERSIZE];
-      pPtr = getNextToken<char*>(pPtr, pEnd);
+      uint32 uiErrors = 0;
+      objfile::Face *face = buildFace(m_buffer, type, (int)m_pModel->m_Vertices.size(),
+         (int)m_pModel->m_TextureCoord.size(), (int)m_pModel->m_Normals.size(), uiErrors);
+      reportFaceErrors(uiErrors);
+      if (face != NULL)
+         addFace(face);
+
+      // Skip the rest of the line
+      m_DataIt = skipLine<DataArrayIt>(m_DataIt, m_DataItEnd, m_uiLine);
+   }
+
+   // -------------------------------------------------------------------
+   //	Build a face from a line copied into a buffer. The vector counts
+   //	are those in front of the face, they resolve relative indices.
+   objfile::Face *ObjFileParser::buildFace(const char *pLine, aiPrimitiveType type, int vSize, int vtSize, int vnSize, uint32 &uiErrors)
+   {
+      const char *pPtr = pLine;
+      const char *pEnd = &pLine[BUFFERSIZE];
+      pPtr = getNextToken<const char*>(pPtr, pEnd);
       if (pPtr == pEnd || *pPtr == '\0')
-         return;
+         return NULL;
 
       std::vector<unsigned int> *pIndices = new std::vector<unsigned int>;
       std::vector<unsigned int> *pTexID = new std::vector<unsigned int>;
       std::vector<unsigned int> *pNormalID = new std::vector<unsigned int>;
-      bool hasNormal = false;
-
-      const int vSize = m_pModel->m_Vertices.size();
-      const int vtSize = m_pModel->m_TextureCoord.size();
-      const int vnSize = m_pModel->m_Normals.size();
 
-      const bool vt = (!m_pModel->m_TextureCoord.empty());
-      const bool vn = (!m_pModel->m_Normals.empty());
+      const bool vt = (vtSize != 0);
+      const bool vn = (vnSize != 0);
       int iStep = 0, iPos = 0;
       while (pPtr != pEnd)
       {
@@ -351,7 +640,7 @@ namespace model
          if (*pPtr == '/')
          {
             if (type == aiPrimitiveType_POINT) {
-               DefaultLogger::get()->error("Obj: Separator unexpected in point statement");
+               uiErrors |= FACEERR_SEPARATOR;
             }
             if (iPos == 0)
             {
@@ -370,14 +659,12 @@ namespace model
          else
          {
             //OBJ USES 1 Base ARRAYS!!!!
-            const int iVal = atoi(pPtr);
+            const char *pNext = pPtr;
+            const int iVal = strtol10_n(pPtr, pEnd, &pNext);
 
-            // increment iStep position based off of the sign and # of digits
-            int tmp = iVal;
-            if (iVal < 0)
-               ++iStep;
-            while ((tmp = tmp / 10) != 0)
-               ++iStep;
+            // step over the sign and all digits, leading zeros included
+            if (pNext != pPtr)
+               iStep = (int)(pNext - pPtr);
 
             if (iVal > 0)
             {
@@ -393,11 +680,10 @@ namespace model
                else if (2 == iPos)
                {
                   pNormalID->push_back(iVal - 1);
-                  hasNormal = true;
                }
                else
                {
-                  reportErrorTokenInFace();
+                  uiErrors |= FACEERR_TOKEN;
                }
             }
             else if (iVal < 0)
@@ -414,11 +700,10 @@ namespace model
                else if (2 == iPos)
                {
                   pNormalID->push_back(vnSize + iVal);
-                  hasNormal = true;
                }
                else
                {
-                  reportErrorTokenInFace();
+                  uiErrors |= FACEERR_TOKEN;
                }
             }
          }
@@ -427,13 +712,32 @@ namespace model
 
       if (pIndices->empty())
       {
-         DefaultLogger::get()->error("Obj: Ignoring empty face");
-         m_DataIt = skipLine<DataArrayIt>(m_DataIt, m_DataItEnd, m_uiLine);
-         return;
+         uiErrors |= FACEERR_EMPTY;
+         delete pIndices;
+         delete pTexID;
+         delete pNormalID;
+         return NULL;
       }
 
-      ObjFile::Face *face = new ObjFile::Face(pIndices, pNormalID, pTexID, type);
+      return new objfile::Face(pIndices, pNormalID, pTexID, type);
+   }
 
+   // -------------------------------------------------------------------
+   //	Logs the errors collected while building a face.
+   void ObjFileParser::reportFaceErrors(uint32 uiErrors)
+   {
+      if (uiErrors & FACEERR_SEPARATOR)
+         DefaultLogger::get()->error("Obj: Separator unexpected in point statement");
+      if (uiErrors & FACEERR_TOKEN)
+         DefaultLogger::get()->error("OBJ: Not supported token in face description detected");
+      if (uiErrors & FACEERR_EMPTY)
+         DefaultLogger::get()->error("Obj: Ignoring empty face");
+   }
+
+   // -------------------------------------------------------------------
+   //	Assign a face to the current mesh
+   void ObjFileParser::addFace(objfile::Face *face)
+   {
       // Set active material, if one set
       if (NULL != m_pModel->m_pCurrentMaterial)
          face->m_pMaterial = m_pModel->m_pCurrentMaterial;
@@ -454,12 +758,10 @@ namespace model
       m_pModel->m_pCurrentMesh->m_Faces.push_back(face);
       m_pModel->m_pCurrentMesh->m_uiNumIndices += (unsigned int)face->m_pVertices->size();
       m_pModel->m_pCurrentMesh->m_uiUVCoordinates[0] += (unsigned int)face->m_pTexturCoords[0].size();
-      if (!m_pModel->m_pCurrentMesh->m_hasNormals && hasNormal)
+      if (!m_pModel->m_pCurrentMesh->m_hasNormals && !face->m_pNormals->empty())
       {
          m_pModel->m_pCurrentMesh->m_hasNormals = true;
       }
-      // Skip the rest of the line
-      m_DataIt = skipLine<DataArrayIt>(m_DataIt, m_DataItEnd, m_uiLine);
    }
 
    // -------------------------------------------------------------------
@@ -480,33 +782,33 @@ namespace model
       if (m_DataIt == m_DataItEnd)
          return;
 
-      char *pStart = &(*m_DataIt);
+      const char *pStart = m_DataIt;
       while (m_DataIt != m_DataItEnd && !IsSpaceOrNewLine(*m_DataIt)) {
          ++m_DataIt;
       }
 
       // Get name
-      String_c strName(pStart, &(*m_DataIt));
-      if (strName.empty())
+      const StringView_c name(pStart, (uint32)(m_DataIt - pStart));
+      if (name.IsEmpty())
          return;
 
       // Search for material
-      std::map<String_c, ObjFile::Material*>::iterator it = m_pModel->m_MaterialMap.find(strName);
-      if (it == m_pModel->m_MaterialMap.end())
+      ObjFile::Material **material = m_pModel->m_MaterialMap.Find(NameId::Intern(name));
+      if (material == NULL)
       {
          // Not found, use default material
          m_pModel->m_pCurrentMaterial = m_pModel->m_pDefaultMaterial;
-         DefaultLogger::get()->error("OBJ: failed to locate material " + strName + ", skipping");
+         DefaultLogger::get()->error("OBJ: failed to locate material " + String_c(pStart, name.GetSize()) + ", skipping");
       }
       else
       {
          // Found, using detected material
-         m_pModel->m_pCurrentMaterial = (*it).second;
-         if (needsNewMesh(strName))
+         m_pModel->m_pCurrentMaterial = *material;
+         if (needsNewMesh(name))
          {
             createMesh();
          }
-         m_pModel->m_pCurrentMesh->m_uiMaterialIndex = getMaterialIndex(strName);
+         m_pModel->m_pCurrentMesh->m_uiMaterialIndex = getMaterialIndex(name);
       }
 
       // Skip rest of line
@@ -517,18 +819,8 @@ namespace model
    //	Get a comment, values will be skipped
    void ObjFileParser::getComment()
    {
-      while (m_DataIt != m_DataItEnd)
-      {
-         if ('\n' == (*m_DataIt))
-         {
-            ++m_DataIt;
-            break;
-         }
-         else
-         {
-            ++m_DataIt;
-         }
-      }
+      // skipLine also drops the indentation of the next line, like every other statement
+      m_DataIt = skipLine<DataArrayIt>(m_DataIt, m_DataItEnd, m_uiLine);
    }
 
    // -------------------------------------------------------------------
@@ -541,13 +833,13 @@ namespace model
          return;
       }
 
-      char *pStart = &(*m_DataIt);
+      const char *pStart = m_DataIt;
       while (m_DataIt != m_DataItEnd && !IsLineEnd(*m_DataIt)) {
          ++m_DataIt;
       }
 
       // Check for existence
-      const String_c strMatName(pStart, &(*m_DataIt));
+      const String_c strMatName(pStart, (uint32)(m_DataIt - pStart));
       IOStream *pFile = m_pIO->Open(strMatName);
 
       if (!pFile)
@@ -576,41 +868,41 @@ namespace model
          return;
       }
 
-      char *pStart = &(*m_DataIt);
-      String_c strMat(pStart, *m_DataIt);
-      while (m_DataIt != m_DataItEnd && IsSpaceOrNewLine(*m_DataIt)) {
+      const char *pStart = m_DataIt;
+      while (m_DataIt != m_DataItEnd && !IsSpaceOrNewLine(*m_DataIt)) {
          ++m_DataIt;
       }
-      std::map<String_c, ObjFile::Material*>::iterator it = m_pModel->m_MaterialMap.find(strMat);
-      if (it == m_pModel->m_MaterialMap.end())
+      const StringView_c matName(pStart, (uint32)(m_DataIt - pStart));
+      ObjFile::Material **material = m_pModel->m_MaterialMap.Find(NameId::FromString(matName));
+      if (material == NULL)
       {
          // Show a warning, if material was not found
-         DefaultLogger::get()->warn("OBJ: Unsupported material requested: " + strMat);
+         DefaultLogger::get()->warn("OBJ: Unsupported material requested: " + String_c(pStart, matName.GetSize()));
          m_pModel->m_pCurrentMaterial = m_pModel->m_pDefaultMaterial;
       }
       else
       {
          // Set new material
-         if (needsNewMesh(strMat))
+         if (needsNewMesh(matName))
          {
             createMesh();
          }
-         m_pModel->m_pCurrentMesh->m_uiMaterialIndex = getMaterialIndex(strMat);
+         m_pModel->m_pCurrentMesh->m_uiMaterialIndex = getMaterialIndex(matName);
       }
 
       m_DataIt = skipLine<DataArrayIt>(m_DataIt, m_DataItEnd, m_uiLine);
    }
 
    // -------------------------------------------------------------------
-   int ObjFileParser::getMaterialIndex(const String_c &strMaterialName)
+   int ObjFileParser::getMaterialIndex(const StringView_c &strMaterialName)
    {
       int mat_index = -1;
-      if (strMaterialName.empty()) {
+      if (strMaterialName.IsEmpty()) {
          return mat_index;
       }
       for (size_t index = 0; index < m_pModel->m_MaterialLib.size(); ++index)
       {
-         if (strMaterialName == m_pModel->m_MaterialLib[index])
+         if (strMaterialName == m_pModel->m_MaterialLib[index].GetView())
          {
             mat_index = (int)index;
             break;
@@ -631,26 +923,28 @@ namespace model
       }
 
       // Change active group, if necessary
-      if (m_pModel->m_strActiveGroup != strGroupName)
+      const NameId groupId = NameId::Intern(strGroupName.GetView());
+      if (m_pModel->m_ActiveGroupId != groupId)
       {
          // Search for already existing entry
-         ObjFile::Model::ConstGroupMapIt it = m_pModel->m_Groups.find(strGroupName);
+         std::vector<uint32> **faceIDs = m_pModel->m_Groups.Find(groupId);
 
          // We are mapping groups into the object structure
          createObject(strGroupName);
 
          // New group name, creating a new entry
-         if (it == m_pModel->m_Groups.end())
+         if (faceIDs == NULL)
          {
             std::vector<unsigned int> *pFaceIDArray = new std::vector<unsigned int>;
-            m_pModel->m_Groups[strGroupName] = pFaceIDArray;
+            m_pModel->m_Groups.Insert(groupId, pFaceIDArray);
             m_pModel->m_pGroupFaceIDs = (pFaceIDArray);
          }
          else
          {
-            m_pModel->m_pGroupFaceIDs = (*it).second;
+            m_pModel->m_pGroupFaceIDs = *faceIDs;
          }
          m_pModel->m_strActiveGroup = strGroupName;
+         m_pModel->m_ActiveGroupId = groupId;
       }
       m_DataIt = skipLine<DataArrayIt>(m_DataIt, m_DataItEnd, m_uiLine);
    }
@@ -682,12 +976,12 @@ namespace model
       if (m_DataIt == m_DataItEnd) {
          return;
       }
-      char *pStart = &(*m_DataIt);
+      const char *pStart = m_DataIt;
       while (m_DataIt != m_DataItEnd && !IsSpaceOrNewLine(*m_DataIt)) {
          ++m_DataIt;
       }
 
-      String_c strObjectName(pStart, &(*m_DataIt));
+      String_c strObjectName(pStart, (uint32)(m_DataIt - pStart));
       if (!strObjectName.empty())
       {
          // Reset current object
@@ -752,7 +1046,7 @@ namespace model
 
    // -------------------------------------------------------------------
    //	Returns true, if a new mesh must be created.
-   bool ObjFileParser::needsNewMesh(const String_c &rMaterialName)
+   bool ObjFileParser::needsNewMesh(const StringView_c &rMaterialName)
    {
       if (m_pModel->m_pCurrentMesh == 0)
       {
@@ -772,14 +1066,6 @@ namespace model
    }
 
    // -------------------------------------------------------------------
-   //	Shows an error in parsing process.
-   void ObjFileParser::reportErrorTokenInFace()
-   {
-      m_DataIt = skipLine<DataArrayIt>(m_DataIt, m_DataItEnd, m_uiLine);
-      DefaultLogger::get()->error("OBJ: Not supported token in face description detected");
-   }
-
-   // -------------------------------------------------------------------
 
 }	// Namespace Assimp
 
@@ -42,13 +42,15 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _OBJPARSER_HPP_INCLUDED_
 
 #include <vector>
-#include <map>
+
+#include "core/task/scheduler.hpp"
 
 #include "mesh2.hpp"
 using mesh2::aiPrimitiveType;
 
 #include "core/string/string.hpp"
 using core::string::String_c;
+using core::string::StringView_c;
 
 #include "core/math/vector2.hpp"
 using core::math::Point2f;
@@ -61,6 +63,8 @@ using core::math::Vector3f;
 #include "ObjFile.hpp"
 using objfile::Model;
 
+#include "core/fileio/mappedfile.hpp"
+
 namespace model
 {
    //namespace objfile
@@ -80,21 +84,102 @@ namespace model
    {
    public:
       static const size_t BUFFERSIZE = 4096;
+      ///	Smallest amount of data handed to a worker thread in parallel mode
+      static const size_t MIN_CHUNKSIZE = 256 * 1024;
       typedef std::vector<char> DataArray;
-      typedef std::vector<char>::iterator DataArrayIt;
-      typedef std::vector<char>::const_iterator ConstDataArrayIt;
+      typedef const char* DataArrayIt;
+      typedef const char* ConstDataArrayIt;
 
    public:
       ///	\brief	Constructor with data array.
       ObjFileParser(std::vector<char> &Data, const String_c &strModelName, IOSystem* io);
+      ///	\brief	Constructor with a raw character range, the data is parsed in place and not copied.
+      ///	\param	uiNumThreads	Chunks parsed in parallel on the active TaskScheduler, 0 uses all of its threads.
+      ///	Without an active TaskScheduler, or with less than MIN_CHUNKSIZE per chunk, the file is parsed serially.
+      ObjFileParser(const char *pBegin, const char *pEnd, const String_c &strModelName, IOSystem* io, uint32 uiNumThreads = 1);
+      ///	\brief	Constructor with a memory mapped file, the view must outlive the parser.
+      ///	\param	uiNumThreads	Same as for the range constructor.
+      ObjFileParser(const MappedFile &File, const String_c &strModelName, IOSystem* io, uint32 uiNumThreads = 1);
       ///	\brief	Destructor
       ~ObjFileParser();
       ///	\brief	Model getter.
       objfile::Model *GetModel() const;
 
    private:
+      ///	Error bits collected while parsing a face, reported by the owning thread
+      enum eFaceError
+      {
+         FACEERR_EMPTY = 1 << 0,
+         FACEERR_SEPARATOR = 1 << 1,
+         FACEERR_TOKEN = 1 << 2
+      };
+
+      ///	\struct	Statement
+      ///	\brief	Face or directive found by a worker, replayed in file order on merge
+      struct Statement
+      {
+         //!	First character of the statement
+         const char *m_pStart;
+         //!	True for f/l/p records, false for directives
+         bool m_bFace;
+         //!	Primitive type of a face
+         aiPrimitiveType m_Type;
+         //!	Vector counts of the chunk in front of the statement
+         uint32 m_uiNumVertices;
+         uint32 m_uiNumTexCoords;
+         uint32 m_uiNumNormals;
+         //!	eFaceError bits
+         uint32 m_uiFaceErrors;
+      };
+
+      ///	\struct	Chunk
+      ///	\brief	Line aligned piece of the buffer parsed by one worker
+      struct Chunk
+      {
+         const char *m_pBegin;
+         const char *m_pEnd;
+         std::vector<Vector3f> m_Vertices;
+         std::vector<Vector3f> m_TextureCoord;
+         std::vector<Vector3f> m_Normals;
+         std::vector<Statement> m_Statements;
+         //!	One entry per statement, NULL for directives and empty faces
+         std::vector<objfile::Face*> m_Faces;
+         //!	Vector counts of all chunks in front of this one
+         uint32 m_uiBaseVertices;
+         uint32 m_uiBaseTexCoords;
+         uint32 m_uiBaseNormals;
+         uint32 m_uiLines;
+         char m_buffer[BUFFERSIZE];
+      };
+
+      ///	Creates the model instance with its default material and parses the range
+      void init(const String_c &strModelName, uint32 uiNumThreads);
       ///	Parse the loaded file
       void parseFile();
+      ///	Parse the loaded file on several threads, the model is identical to parseFile()
+      void parseFileParallel(uint32 uiNumThreads);
+      ///	Parse the statement at the current position
+      void parseStatement();
+      ///	Worker pass 1, parses vectors and records faces and directives of a chunk
+      static void parseChunkStatements(Chunk *pChunk);
+      ///	Worker pass 2, parses the faces of a chunk once the global vector counts are known
+      static void parseChunkFaces(Chunk *pChunk);
+      ///	Returns the end of the chunk starting at pBegin, aligned to a line not continued by '\\'
+      static const char *findChunkEnd(const char *pBegin, const char *pSplit, const char *pEnd);
+      ///	Copies the next word into pBuffer and returns the new position
+      static const char *copyWord(const char *pIt, const char *pEnd, char *pBuffer, size_t length);
+      ///	Copies the next line into pBuffer, or only skips it if pBuffer is NULL
+      static const char *copyLine(const char *pIt, const char *pEnd, char *pBuffer, size_t length);
+      ///	Parses a 2 or 3 component vector and returns the start of the next line
+      static const char *parseVector(const char *pIt, const char *pEnd, std::vector<Vector3f> &point3d_array, uint32 &uiLine);
+      ///	Parses a 3 component vector and returns the start of the next line
+      static const char *parseVector3(const char *pIt, const char *pEnd, std::vector<Vector3f> &point3d_array, uint32 &uiLine);
+      ///	Builds a face from a copied line, vector counts are those in front of the face. NULL if empty
+      static objfile::Face *buildFace(const char *pLine, aiPrimitiveType type, int vSize, int vtSize, int vnSize, uint32 &uiErrors);
+      ///	Logs the eFaceError bits of a face
+      static void reportFaceErrors(uint32 uiErrors);
+      ///	Assigns a parsed face to the current mesh
+      void addFace(objfile::Face *face);
       ///	Method to copy the new delimited word in the current line.
       void copyNextWord(char *pBuffer, size_t length);
       ///	Method to copy the new line.
@@ -122,7 +207,7 @@ namespace model
       /// Gets the group number and resolution from file.
       void getGroupNumberAndResolution();
       /// Returns the index of the material. Is -1 if not material was found.
-      int getMaterialIndex(const String_c &strMaterialName);
+      int getMaterialIndex(const StringView_c &strMaterialName);
       /// Parse object name
       void getObjectName();
       /// Creates a new object.
@@ -130,16 +215,14 @@ namespace model
       ///	Creates a new mesh.
       void createMesh();
       ///	Returns true, if a new mesh instance must be created.
-      bool needsNewMesh(const String_c &rMaterialName);
-      ///	Error report in token
-      void reportErrorTokenInFace();
+      bool needsNewMesh(const StringView_c &rMaterialName);
 
    private:
       ///	Default material name
       static const String_c DEFAULT_MATERIAL;
-      //!	Iterator to current position in buffer
+      //!	Pointer to current position in buffer
       DataArrayIt m_DataIt;
-      //!	Iterator to end position of buffer
+      //!	Pointer to end position of buffer
       DataArrayIt m_DataItEnd;
       //!	Pointer to model instance
       objfile::Model *m_pModel;
@@ -140,7 +140,7 @@ namespace objtools
          return end;
       }
 
-      char *pStart = &(*it);
+      const char *pStart = &(*it);
       while (!isEndOfBuffer(it, end) && !IsLineEnd(*it)) {
          ++it;
       }
@@ -0,0 +1,383 @@
+#include "md5compression.hpp"
+
+#include <math.h>
+
+namespace model
+{
+
+namespace md5
+{
+
+// the three smaller components of a unit quaternion lie within +-1/sqrt(2)
+static const float SMALLEST_THREE_RANGE = 0.707106781f;
+static const uint32 SMALLEST_THREE_MAX = 0x7fff;
+static const uint32 TRANSLATION_MAX = 0xffff;
+// longest stretch between two keys, the frames in between are checked for every candidate key so
+// the fit costs numFrames * MAX_KEY_SPAN error evaluations at most
+static const uint32 MAX_KEY_SPAN = 128;
+
+uint32 MD5CompressedAnim::GetSize() const
+{
+   return (uint32)( sizeof(MD5CompressedAnim)
+      + ( rotationTracks.size() + translationTracks.size() ) * sizeof(MD5CompressedTrack)
+      + ( rotationFrames.size() + rotationKeys.size() + translationFrames.size() + translationKeys.size() ) * sizeof(uint16)
+      + translationRanges.size() * sizeof(float) );
+}
+
+void PackQuaternion( const Quaternion_f &q, uint16 *out )
+{
+   int32 largest = 0;
+   for ( int32 i = 1; i < 4; i++ )
+      if ( fabsf( q[i] ) > fabsf( q[largest] ) )
+         largest = i;
+
+   // q and -q are the same rotation, the dropped component is restored as positive
+   const float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+   uint32 packed[3];
+   for ( int32 i = 0, j = 0; i < 4; i++ )
+   {
+      if ( i == largest )
+         continue;
+      const float unit = ( q[i] * sign / SMALLEST_THREE_RANGE ) * 0.5f + 0.5f;
+      const float scaled = floorf( unit * SMALLEST_THREE_MAX + 0.5f );
+      packed[j++] = scaled < 0.0f ? 0 : ( scaled > SMALLEST_THREE_MAX ? SMALLEST_THREE_MAX : (uint32)scaled );
+   }
+
+   out[0] = (uint16)( ( ( largest >> 1 ) << 15 ) | packed[0] );
+   out[1] = (uint16)( ( ( largest & 1 ) << 15 ) | packed[1] );
+   out[2] = (uint16)packed[2];
+}
+
+Quaternion_f UnpackQuaternion( const uint16 *in )
+{
+   const int32 largest = ( ( in[0] >> 15 ) << 1 ) | ( in[1] >> 15 );
+   const float scale = 2.0f * SMALLEST_THREE_RANGE / SMALLEST_THREE_MAX;
+   const float a = ( in[0] & SMALLEST_THREE_MAX ) * scale - SMALLEST_THREE_RANGE;
+   const float b = ( in[1] & SMALLEST_THREE_MAX ) * scale - SMALLEST_THREE_RANGE;
+   const float c = ( in[2] & SMALLEST_THREE_MAX ) * scale - SMALLEST_THREE_RANGE;
+   const float t = 1.0f - a * a - b * b - c * c;
+   const float d = t > 0.0f ? sqrtf( t ) : 0.0f;
+
+   switch ( largest )
+   {
+   case 0:
+      return Quaternion_f( d, a, b, c );
+   case 1:
+      return Quaternion_f( a, d, b, c );
+   case 2:
+      return Quaternion_f( a, b, d, c );
+   default:
+      return Quaternion_f( a, b, c, d );
+   }
+}
+
+// Encoding, decoding, interpolation and error of the two kinds of tracks, FitTrack and SampleTrack
+// are the same for both
+struct RotationCodec
+{
+   typedef Quaternion_f Value;
+
+   void Encode( const Value &value, uint16 *out ) const { PackQuaternion( value, out ); }
+   Value Decode( const uint16 *in ) const { return UnpackQuaternion( in ); }
+   Value Interpolate( const Value &a, const Value &b, const float t ) const { return core::math::Nlerp( a, b, t ); }
+
+   // angle between the rotations, from the distance of the quaternions since acos of their dot
+   // product is far too inaccurate for small angles
+   float Error( const Value &a, const Value &b ) const
+   {
+      const double sign = a.Dot( b ) < 0.0f ? -1.0 : 1.0;
+      double sqDistance = 0.0;
+      for ( int32 i = 0; i < 4; i++ )
+      {
+         const double d = (double)a[i] - sign * b[i];
+         sqDistance += d * d;
+      }
+      const double halfDistance = sqrt( sqDistance ) * 0.5;
+      return (float)( 4.0 * asin( halfDistance < 1.0 ? halfDistance : 1.0 ) );
+   }
+};
+
+struct TranslationCodec
+{
+   typedef Vector3f Value;
+
+   const float *range; // minimum and step of x, y and z
+
+   void Encode( const Value &value, uint16 *out ) const
+   {
+      for ( int32 i = 0; i < 3; i++ )
+      {
+         const float scaled = range[3 + i] > 0.0f ? floorf( ( value[i] - range[i] ) / range[3 + i] + 0.5f ) : 0.0f;
+         out[i] = (uint16)( scaled < 0.0f ? 0 : ( scaled > TRANSLATION_MAX ? TRANSLATION_MAX : (uint32)scaled ) );
+      }
+   }
+
+   Value Decode( const uint16 *in ) const
+   {
+      return Vector3f( range[0] + in[0] * range[3], range[1] + in[1] * range[4], range[2] + in[2] * range[5] );
+   }
+
+   Value Interpolate( const Value &a, const Value &b, const float t ) const
+   {
+      return Vector3f( a[0] + t * ( b[0] - a[0] ), a[1] + t * ( b[1] - a[1] ), a[2] + t * ( b[2] - a[2] ) );
+   }
+
+   float Error( const Value &a, const Value &b ) const
+   {
+      const Vector3f d( a[0] - b[0], a[1] - b[1], a[2] - b[2] );
+      return sqrtf( d.SqLength() );
+   }
+};
+
+// Piecewise linear fit of the samples. Starting at a key, the next key is pushed out (MAX_KEY_SPAN
+// frames at most) as far as the frames in between stay within tolerance of the interpolation of the
+// quantized keys, so the tolerance covers quantization and fit together. Only a frame whose own key
+// is quantized worse than tolerance gets its quantization error as bound. A track that stays within
+// the bounds of its first frame is constant. Returns the number of keys added
+template <class C>
+static uint32 FitTrack( const C &codec, const std::vector<typename C::Value> &samples, const float tolerance,
+   std::vector<uint16> &framesOut, std::vector<uint16> &keysOut )
+{
+   typedef typename C::Value Value;
+   const uint32 numFrames = (uint32)samples.size();
+
+   // every frame as it would come back from a key, and the error allowed at the frame
+   std::vector<Value> quantized( numFrames );
+   std::vector<float> bounds( numFrames );
+   for ( uint32 i = 0; i < numFrames; i++ )
+   {
+      uint16 key[3];
+      codec.Encode( samples[i], key );
+      quantized[i] = codec.Decode( key );
+      const float error = codec.Error( quantized[i], samples[i] );
+      bounds[i] = error > tolerance ? error : tolerance;
+   }
+
+   std::vector<uint32> keyFrames;
+   bool constant = true;
+   for ( uint32 i = 1; i < numFrames && constant; i++ )
+      constant = codec.Error( quantized[0], samples[i] ) <= bounds[i];
+
+   keyFrames.push_back( 0 );
+   if ( !constant )
+   {
+      uint32 key = 0;
+      while ( key < numFrames - 1 )
+      {
+         uint32 next = key + 1;
+         const uint32 last = numFrames - 1 - key > MAX_KEY_SPAN ? key + MAX_KEY_SPAN : numFrames - 1;
+         for ( uint32 candidate = key + 2; candidate <= last; candidate++ )
+         {
+            bool fits = true;
+            for ( uint32 i = key + 1; i < candidate && fits; i++ )
+            {
+               const float t = (float)( i - key ) / (float)( candidate - key );
+               fits = codec.Error( codec.Interpolate( quantized[key], quantized[candidate], t ), samples[i] ) <= bounds[i];
+            }
+            if ( !fits )
+               break;
+            next = candidate;
+         }
+         keyFrames.push_back( next );
+         key = next;
+      }
+   }
+
+   for ( uint32 i = 0; i < keyFrames.size(); i++ )
+   {
+      uint16 key[3];
+      codec.Encode( samples[keyFrames[i]], key );
+      framesOut.push_back( (uint16)keyFrames[i] );
+      keysOut.insert( keysOut.end(), key, key + 3 );
+   }
+   return (uint32)keyFrames.size();
+}
+
+template <class C>
+static typename C::Value SampleTrack( const C &codec, const MD5CompressedTrack &track, const std::vector<uint16> &frames,
+   const std::vector<uint16> &keys, const float frame )
+{
+   const uint16 *keyFrames = &frames[track.firstKey];
+   const uint16 *key = &keys[track.firstKey * 3];
+   if ( track.numKeys == 1 )
+      return codec.Decode( key );
+
+   // last key at or before frame
+   uint32 low = 0;
+   uint32 high = track.numKeys - 1;
+   while ( high - low > 1 )
+   {
+      const uint32 middle = ( low + high ) / 2;
+      if ( keyFrames[middle] <= frame )
+         low = middle;
+      else
+         high = middle;
+   }
+
+   const float t = ( frame - keyFrames[low] ) / (float)( keyFrames[high] - keyFrames[low] );
+   return codec.Interpolate( codec.Decode( key + low * 3 ), codec.Decode( key + high * 3 ), t < 0.0f ? 0.0f : ( t > 1.0f ? 1.0f : t ) );
+}
+
+static void SamplePose( const MD5CompressedAnim &anim, const float frame, MD5Joint *out )
+{
+   const RotationCodec rotationCodec;
+   TranslationCodec translationCodec;
+   for ( int32 i = 0; i < anim.numJoints; i++ )
+   {
+      translationCodec.range = &anim.translationRanges[i * 6];
+      out[i].orientation = SampleTrack( rotationCodec, anim.rotationTracks[i], anim.rotationFrames, anim.rotationKeys, frame );
+      out[i].position = SampleTrack( translationCodec, anim.translationTracks[i], anim.translationFrames, anim.translationKeys, frame );
+   }
+}
+
+void SampleCompressedPose( const MD5CompressedAnim &anim, const int32 frame, const int32 nextFrame, const float interp,
+   MD5Joint *scratch, MD5Joint *out )
+{
+   if ( nextFrame == frame + 1 )
+   {
+      // the keys are linear in between, one sample does
+      SamplePose( anim, frame + interp, out );
+      return;
+   }
+
+   // looping back, blend the two frames
+   SamplePose( anim, (float)frame, out );
+   SamplePose( anim, (float)nextFrame, scratch );
+   RotationCodec rotationCodec;
+   TranslationCodec translationCodec;
+   for ( int32 i = 0; i < anim.numJoints; i++ )
+   {
+      out[i].orientation = rotationCodec.Interpolate( out[i].orientation, scratch[i].orientation, interp );
+      out[i].position = translationCodec.Interpolate( out[i].position, scratch[i].position, interp );
+   }
+}
+
+static void GetFramePose( const MD5Anim &anim, const int32 frame, std::vector<Quaternion_f> &rotationsOut,
+   std::vector<Vector3f> &translationsOut )
+{
+   const float poseScale = 1.0f / INT16_MAX;
+   for ( int32 i = 0; i < anim.numJoints; i++ )
+   {
+      if ( anim.skeletonFrames != NULL )
+      {
+         rotationsOut[i] = anim.skeletonFrames[frame][i].orientation;
+         translationsOut[i] = anim.skeletonFrames[frame][i].position;
+      }
+      else
+      {
+         const MD5PoseJoint &joint = anim.poseCache[frame * anim.numJoints + i];
+         rotationsOut[i] = Quaternion_f( joint.orientation[0] * poseScale, joint.orientation[1] * poseScale,
+            joint.orientation[2] * poseScale, joint.orientation[3] * poseScale ).Normalize();
+         translationsOut[i] = Vector3f( joint.position[0], joint.position[1], joint.position[2] );
+      }
+   }
+}
+
+bool CompressAnim( MD5Anim *anim, const MD5CompressionSettings &settings, MD5CompressionStats *statsOut )
+{
+   const int32 numFrames = anim->numFrames;
+   const int32 numJoints = anim->numJoints;
+   if ( numFrames <= 0 || numJoints <= 0 || numFrames > 0xffff || ( anim->skeletonFrames == NULL && anim->poseCache.empty() ) )
+      return false;
+
+   // the tracks are built joint by joint, so gather the frames per joint first
+   std::vector<std::vector<Quaternion_f> > rotations( numJoints, std::vector<Quaternion_f>( numFrames ) );
+   std::vector<std::vector<Vector3f> > translations( numJoints, std::vector<Vector3f>( numFrames ) );
+   {
+      std::vector<Quaternion_f> frameRotations( numJoints );
+      std::vector<Vector3f> frameTranslations( numJoints );
+      for ( int32 f = 0; f < numFrames; f++ )
+      {
+         GetFramePose( *anim, f, frameRotations, frameTranslations );
+         for ( int32 i = 0; i < numJoints; i++ )
+         {
+            rotations[i][f] = frameRotations[i];
+            translations[i][f] = frameTranslations[i];
+         }
+      }
+   }
+
+   MD5CompressedAnim *compressed = new MD5CompressedAnim();
+   compressed->numFrames = numFrames;
+   compressed->numJoints = numJoints;
+   compressed->rotationTracks.resize( numJoints );
+   compressed->translationTracks.resize( numJoints );
+   compressed->translationRanges.resize( numJoints * 6 );
+
+   uint32 numConstantTracks = 0;
+   const RotationCodec rotationCodec;
+   TranslationCodec translationCodec;
+   for ( int32 i = 0; i < numJoints; i++ )
+   {
+      float *range = &compressed->translationRanges[i * 6];
+      for ( int32 c = 0; c < 3; c++ )
+      {
+         float minimum = translations[i][0][c];
+         float maximum = minimum;
+         for ( int32 f = 1; f < numFrames; f++ )
+         {
+            minimum = translations[i][f][c] < minimum ? translations[i][f][c] : minimum;
+            maximum = translations[i][f][c] > maximum ? translations[i][f][c] : maximum;
+         }
+         range[c] = minimum;
+         range[3 + c] = ( maximum - minimum ) / TRANSLATION_MAX;
+      }
+      translationCodec.range = range;
+
+      MD5CompressedTrack &rotationTrack = compressed->rotationTracks[i];
+      rotationTrack.firstKey = (uint32)compressed->rotationFrames.size();
+      rotationTrack.numKeys = FitTrack( rotationCodec, rotations[i], settings.maxRotationError,
+         compressed->rotationFrames, compressed->rotationKeys );
+
+      MD5CompressedTrack &translationTrack = compressed->translationTracks[i];
+      translationTrack.firstKey = (uint32)compressed->translationFrames.size();
+      translationTrack.numKeys = FitTrack( translationCodec, translations[i], settings.maxTranslationError,
+         compressed->translationFrames, compressed->translationKeys );
+
+      numConstantTracks += ( rotationTrack.numKeys == 1 ? 1 : 0 ) + ( translationTrack.numKeys == 1 ? 1 : 0 );
+   }
+
+   if ( statsOut != NULL )
+   {
+      MD5CompressionStats &stats = *statsOut;
+      stats.rawSize = anim->skeletonFrames != NULL ? numFrames * ( numJoints * sizeof(MD5Joint) + sizeof(MD5Joint*) )
+         : (uint32)( anim->poseCache.size() * sizeof(MD5PoseJoint) );
+      stats.compressedSize = compressed->GetSize();
+      stats.ratio = (float)stats.rawSize / (float)stats.compressedSize;
+      stats.numConstantTracks = numConstantTracks;
+      stats.numKeys = (uint32)( compressed->rotationFrames.size() + compressed->translationFrames.size() );
+      stats.maxRotationError = 0.0f;
+      stats.maxTranslationError = 0.0f;
+
+      // measured on what the skinning will see
+      std::vector<MD5Joint> pose( numJoints );
+      for ( int32 f = 0; f < numFrames; f++ )
+      {
+         SamplePose( *compressed, (float)f, &pose[0] );
+         for ( int32 i = 0; i < numJoints; i++ )
+         {
+            const float rotationError = rotationCodec.Error( pose[i].orientation, rotations[i][f] );
+            const float translationError = translationCodec.Error( pose[i].position, translations[i][f] );
+            stats.maxRotationError = rotationError > stats.maxRotationError ? rotationError : stats.maxRotationError;
+            stats.maxTranslationError = translationError > stats.maxTranslationError ? translationError : stats.maxTranslationError;
+         }
+      }
+   }
+
+   // the raw frames are not needed anymore
+   if ( anim->skeletonFrames != NULL )
+   {
+      for ( int32 f = 0; f < numFrames; f++ )
+         delete[] anim->skeletonFrames[f];
+      delete[] anim->skeletonFrames;
+      anim->skeletonFrames = NULL;
+   }
+   std::vector<MD5PoseJoint>().swap( anim->poseCache );
+   delete anim->compressed;
+   anim->compressed = compressed;
+   return true;
+}
+
+} // namespace md5
+
+} // namespace model
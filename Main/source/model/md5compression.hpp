@@ -0,0 +1,83 @@
+#ifndef _MD5COMPRESSION_HPP_INCLUDED_
+#define _MD5COMPRESSION_HPP_INCLUDED_
+
+#include <vector>
+
+#include "md5model.hpp"
+
+namespace model
+{
+
+namespace md5
+{
+
+// keys of one joint track, the constant tracks have a single key
+struct MD5CompressedTrack
+{
+   uint32 firstKey;
+   uint32 numKeys;
+};
+
+// Model space poses of an animation as reduced, quantized key tracks. Rotations are smallest three
+// quaternions in 48 bits, translations 16 bits per component within the range of their track.
+// Between two keys the values are interpolated linearly, so sampling a joint is a binary search in
+// its key frames and the decoding of two keys
+struct MD5CompressedAnim
+{
+   int32 numFrames;
+   int32 numJoints;
+
+   std::vector<MD5CompressedTrack> rotationTracks; // one per joint
+   std::vector<MD5CompressedTrack> translationTracks;
+   std::vector<uint16> rotationFrames; // frame of every key
+   std::vector<uint16> rotationKeys; // 3 per key
+   std::vector<uint16> translationFrames;
+   std::vector<uint16> translationKeys; // 3 per key
+   std::vector<float> translationRanges; // per joint the minimum and the step of x, y and z
+
+   MD5CompressedAnim() : numFrames(0), numJoints(0) {}
+
+   // bytes of the compressed data
+   uint32 GetSize() const;
+};
+
+struct MD5CompressionSettings
+{
+   // largest difference of a frame to the source, quantization and fit together, radians and model
+   // units. A frame that quantizes worse than this keeps its quantization error
+   float maxRotationError;
+   float maxTranslationError;
+
+   MD5CompressionSettings() : maxRotationError(0.001f), maxTranslationError(0.001f) {}
+};
+
+struct MD5CompressionStats
+{
+   uint32 rawSize; // bytes of the frames before compression
+   uint32 compressedSize;
+   float ratio;
+   // largest difference over all joints and frames, measured after compression
+   float maxRotationError; // radians
+   float maxTranslationError;
+   uint32 numConstantTracks;
+   uint32 numKeys;
+};
+
+// smallest three: the largest component is dropped and restored from the unit length, the index of
+// it goes into the top bits of the first two words and the others are stored with 15 bits each
+void PackQuaternion( const Quaternion_f &q, uint16 *out );
+Quaternion_f UnpackQuaternion( const uint16 *in );
+
+// replaces the frames of anim (skeletonFrames or poseCache) by anim->compressed, statsOut is optional
+bool CompressAnim( MD5Anim *anim, const MD5CompressionSettings &settings, MD5CompressionStats *statsOut = NULL );
+
+// pose between frame and nextFrame, nextFrame need not follow frame when the animation loops. Then
+// the pose of nextFrame is sampled into scratch, numJoints joints owned by the caller
+void SampleCompressedPose( const MD5CompressedAnim &anim, const int32 frame, const int32 nextFrame, const float interp,
+   MD5Joint *scratch, MD5Joint *out );
+
+} // namespace md5
+
+} // namespace model
+
+#endif
@@ -0,0 +1,997 @@
+#include "md5model.hpp"
+#include "md5compression.hpp"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include "core/fileio/linereader.hpp"
+#include "core/math/simd.hpp"
+#include "core/string/tokenlist.hpp"
+#include "core/task/scheduler.hpp"
+
+using core::string::StringView_c;
+using core::string::TokenList;
+using core::string::NextToken;
+using core::string::ParseFloat;
+using core::string::ParseInt;
+
+namespace model
+{
+
+namespace md5
+{
+
+// vertices per task when the meshes are skinned in parallel, a multiple of MD5_SKIN_BATCH
+static const int32 SKIN_GRAIN = 1024;
+
+// values in md5 files are separated by blanks and parentheses, "( x y z )" gives three tokens
+static const char *MD5_DELIMITERS = " \t()";
+
+static const float POSE_SCALE = 1.0f / INT16_MAX;
+
+static int32 PaddedSize( const int32 count )
+{
+   return (count + MD5_SKIN_BATCH - 1) & ~(MD5_SKIN_BATCH - 1);
+}
+
+MD5Mesh::MD5Mesh()
+{
+   meshes = NULL;
+   joints = NULL;
+   name = NULL;
+   numMeshes = 0;
+   numJoints = 0;
+   isAnimated = false;
+   modelSize = 0;
+}
+
+MD5Mesh::~MD5Mesh()
+{
+   FreeMesh();
+}
+
+// copies the text between the first two quotes of line into out, restOut is what follows
+static bool ReadQuoted( const StringView_c &line, char *out, const uint32 outSize, StringView_c &restOut )
+{
+   const int32 begin = line.FindFirst( '"' );
+   const int32 end = begin == -1 ? -1 : line.FindNext( '"', begin + 1 );
+   if ( end == -1 )
+      return false;
+
+   uint32 length = end - begin - 1;
+   if ( length >= outSize )
+      length = outSize - 1;
+   memcpy( out, line.Begin() + begin + 1, length );
+   out[length] = '\0';
+   restOut = line.SubView( end + 1 );
+   return true;
+}
+
+static bool IsDigit( const char c )
+{
+   return c >= '0' && c <= '9';
+}
+
+// [+-]digits[.digits][e[+-]digits], fast_atof throws on a token without digits or exponent digits,
+// so the spelling is checked before the token is handed to it
+static bool IsRealNumber( const StringView_c &token )
+{
+   const char *c = token.Begin();
+   const char *end = token.End();
+   if ( c != end && ( *c == '-' || *c == '+' ) )
+      c++;
+
+   uint32 numDigits = 0;
+   for ( ; c != end && IsDigit( *c ); c++ )
+      numDigits++;
+   if ( c != end && *c == '.' )
+      for ( c++; c != end && IsDigit( *c ); c++ )
+         numDigits++;
+   if ( numDigits == 0 )
+      return false;
+
+   if ( c != end && ( *c == 'e' || *c == 'E' ) )
+   {
+      c++;
+      if ( c != end && ( *c == '-' || *c == '+' ) )
+         c++;
+      if ( c == end || !IsDigit( *c ) )
+         return false;
+      while ( c != end && IsDigit( *c ) )
+         c++;
+   }
+   return c == end;
+}
+
+// the whole token has to be the number, "abc" or "1.5x" fail instead of reading as some value
+static bool ReadFloat( const StringView_c &token, float &out )
+{
+   if ( !IsRealNumber( token ) )
+      return false;
+   const char *stop;
+   out = ParseFloat( token.Begin(), token.End(), &stop );
+   return stop == token.End();
+}
+
+static bool ReadInt( const StringView_c &token, int32 &out )
+{
+   const char *stop;
+   out = ParseInt( token.Begin(), token.End(), &stop );
+   // one to nine digits, a longer number would wrap around
+   const char *digits = token.Begin();
+   if ( digits != token.End() && ( *digits == '-' || *digits == '+' ) )
+      digits++;
+   return stop == token.End() && stop > digits && stop - digits < 10;
+}
+
+// every element of a list takes at least a line, a count beyond the size of the file is corrupt
+// and must not reach the allocation
+static bool ReadCount( const StringView_c &token, const int32 maxCount, int32 &out )
+{
+   return ReadInt( token, out ) && out >= 0 && out <= maxCount;
+}
+
+template <uint32 N>
+static bool ReadVector( const TokenList<char, N> &tokens, const uint32 first, Vector3f &out )
+{
+   for ( uint32 i = 0; i < 3; i++ )
+      if ( !ReadFloat( tokens[first + i], out[i] ) )
+         return false;
+   return true;
+}
+
+// md5 files store x, y and z of unit quaternions only
+template <uint32 N>
+static bool ReadOrientation( const TokenList<char, N> &tokens, const uint32 first, Quaternion_f &out )
+{
+   for ( uint32 i = 0; i < 3; i++ )
+      if ( !ReadFloat( tokens[first + i], out[i] ) )
+         return false;
+   out[3] = 0.0f;
+   out.ComputeW();
+   return true;
+}
+
+static bool IsComment( const StringView_c &token )
+{
+   return token.EqualsN( "//", 2 );
+}
+
+bool MD5Mesh::LoadMesh( const char *filename )
+{
+   FreeMesh();
+   if ( !Open( filename, true ) )
+      return false;
+
+   const bool ok = ReadMesh();
+   Close();
+   if ( !ok )
+   {
+      FreeMesh();
+      return false;
+   }
+
+   const size_t length = strlen( filename );
+   name = new char[length + 1];
+   memcpy( name, filename, length + 1 );
+
+   PrepareSkinning();
+   return true;
+}
+
+bool MD5Mesh::ReadMesh()
+{
+   enum eSection
+   {
+      SECTION_NONE,
+      SECTION_JOINTS,
+      SECTION_MESH
+   };
+
+   LineReader reader( *this );
+   StringView_c line;
+   TokenList<char, 8> tokens;
+   eSection section = SECTION_NONE;
+   int32 numJointsRead = 0;
+   int32 numMeshesRead = 0;
+
+   while ( reader.ReadLine( line ) )
+   {
+      tokens.Split( line, MD5_DELIMITERS );
+      if ( tokens.IsEmpty() || IsComment( tokens[0] ) )
+         continue;
+
+      if ( tokens[0] == "}" )
+      {
+         section = SECTION_NONE;
+      }
+      else if ( section == SECTION_JOINTS )
+      {
+         // "name" parent ( px py pz ) ( qx qy qz )
+         if ( numJointsRead >= numJoints )
+            return false;
+         MD5Joint &joint = joints[numJointsRead];
+         StringView_c rest;
+         if ( !ReadQuoted( line, joint.name, sizeof(joint.name), rest ) || tokens.Split( rest, MD5_DELIMITERS ) < 7 )
+            return false;
+
+         if ( !ReadInt( tokens[0], joint.parentID ) || !ReadVector( tokens, 1, joint.position )
+            || !ReadOrientation( tokens, 4, joint.orientation ) )
+            return false;
+         // parents come before their children
+         if ( joint.parentID < -1 || joint.parentID >= numJointsRead )
+            return false;
+         numJointsRead++;
+      }
+      else if ( section == SECTION_MESH )
+      {
+         Mesh &mesh = meshes[numMeshesRead - 1];
+         if ( tokens[0] == "shader" )
+         {
+            StringView_c rest;
+            if ( !ReadQuoted( line, mesh.shaderName, sizeof(mesh.shaderName), rest ) )
+               return false;
+         }
+         else if ( tokens[0] == "numverts" && tokens.GetSize() > 1 && mesh.vertices == NULL )
+         {
+            if ( !ReadCount( tokens[1], GetSize(), mesh.numVertices ) )
+               return false;
+            mesh.vertices = new MD5Vertex[mesh.numVertices];
+         }
+         else if ( tokens[0] == "vert" && tokens.GetSize() > 5 )
+         {
+            // vert index ( s t ) startWeight weightCount
+            int32 index;
+            if ( !ReadInt( tokens[1], index ) || index < 0 || index >= mesh.numVertices )
+               return false;
+            MD5Vertex &vertex = mesh.vertices[index];
+            if ( !ReadFloat( tokens[2], vertex.st[0] ) || !ReadFloat( tokens[3], vertex.st[1] )
+               || !ReadInt( tokens[4], vertex.startWeight ) || !ReadInt( tokens[5], vertex.weightCount ) )
+               return false;
+         }
+         else if ( tokens[0] == "numtris" && tokens.GetSize() > 1 && mesh.triangles == NULL )
+         {
+            if ( !ReadCount( tokens[1], GetSize(), mesh.numTriangles ) )
+               return false;
+            mesh.triangles = new triangle_t[mesh.numTriangles];
+         }
+         else if ( tokens[0] == "tri" && tokens.GetSize() > 4 )
+         {
+            // tri index vertex0 vertex1 vertex2
+            int32 index;
+            if ( !ReadInt( tokens[1], index ) || index < 0 || index >= mesh.numTriangles )
+               return false;
+            for ( int32 i = 0; i < 3; i++ )
+            {
+               int32 vertex;
+               if ( !ReadInt( tokens[2 + i], vertex ) )
+                  return false;
+               mesh.triangles[index][i] = (uint32)vertex;
+            }
+         }
+         else if ( tokens[0] == "numweights" && tokens.GetSize() > 1 && mesh.weights == NULL )
+         {
+            if ( !ReadCount( tokens[1], GetSize(), mesh.numWeights ) )
+               return false;
+            mesh.weights = new MD5Weight[mesh.numWeights];
+         }
+         else if ( tokens[0] == "weight" && tokens.GetSize() > 6 )
+         {
+            // weight index joint bias ( x y z )
+            int32 index;
+            if ( !ReadInt( tokens[1], index ) || index < 0 || index >= mesh.numWeights )
+               return false;
+            MD5Weight &weight = mesh.weights[index];
+            if ( !ReadInt( tokens[2], weight.joint ) || !ReadFloat( tokens[3], weight.bias ) || !ReadVector( tokens, 4, weight.pos ) )
+               return false;
+         }
+      }
+      else if ( tokens[0] == "MD5Version" && tokens.GetSize() > 1 )
+      {
+         int32 version;
+         if ( !ReadInt( tokens[1], version ) || version != 10 )
+            return false;
+      }
+      else if ( tokens[0] == "numJoints" && tokens.GetSize() > 1 && joints == NULL )
+      {
+         if ( !ReadCount( tokens[1], GetSize(), numJoints ) || numJoints == 0 )
+            return false;
+         joints = new MD5Joint[numJoints];
+      }
+      else if ( tokens[0] == "numMeshes" && tokens.GetSize() > 1 && meshes == NULL )
+      {
+         if ( !ReadCount( tokens[1], GetSize(), numMeshes ) )
+            return false;
+         meshes = new Mesh[numMeshes];
+         for ( int32 i = 0; i < numMeshes; i++ )
+         {
+            Mesh &mesh = meshes[i];
+            mesh.shaderName[0] = '\0';
+            mesh.numVertices = mesh.numTriangles = mesh.numWeights = 0;
+            mesh.vertices = NULL;
+            mesh.triangles = NULL;
+            mesh.weights = NULL;
+            mesh.textureID = 0;
+            mesh.positionBuffer = NULL;
+            mesh.normalBuffer = NULL;
+            mesh.tex2DBuffer = NULL;
+            mesh.indexBuffer = NULL;
+         }
+      }
+      else if ( tokens[0] == "joints" )
+      {
+         if ( joints == NULL )
+            return false;
+         section = SECTION_JOINTS;
+      }
+      else if ( tokens[0] == "mesh" )
+      {
+         if ( numMeshesRead >= numMeshes )
+            return false;
+         numMeshesRead++;
+         section = SECTION_MESH;
+      }
+   }
+
+   if ( numJointsRead != numJoints || numMeshesRead != numMeshes )
+      return false;
+
+   // every index has to be in range before the skinning trusts them
+   for ( int32 m = 0; m < numMeshes; m++ )
+   {
+      const Mesh &mesh = meshes[m];
+      if ( mesh.vertices == NULL || mesh.triangles == NULL || mesh.weights == NULL )
+         return false;
+      for ( int32 i = 0; i < mesh.numVertices; i++ )
+      {
+         const MD5Vertex &vertex = mesh.vertices[i];
+         if ( vertex.startWeight < 0 || vertex.weightCount < 0 || vertex.startWeight + vertex.weightCount > mesh.numWeights )
+            return false;
+      }
+      for ( int32 i = 0; i < mesh.numTriangles; i++ )
+         for ( int32 j = 0; j < 3; j++ )
+            if ( mesh.triangles[i][j] >= (uint32)mesh.numVertices )
+               return false;
+      for ( int32 i = 0; i < mesh.numWeights; i++ )
+         if ( mesh.weights[i].joint < 0 || mesh.weights[i].joint >= numJoints )
+            return false;
+   }
+   return true;
+}
+
+void MD5Mesh::FreeMesh()
+{
+   for ( int32 i = 0; i < numMeshes; i++ )
+   {
+      Mesh &mesh = meshes[i];
+      delete[] mesh.vertices;
+      delete[] mesh.triangles;
+      delete[] mesh.weights;
+      delete[] mesh.positionBuffer;
+      delete[] mesh.normalBuffer;
+      delete[] mesh.tex2DBuffer;
+      delete[] mesh.indexBuffer;
+   }
+   delete[] meshes;
+   delete[] joints;
+   delete[] name;
+
+   meshes = NULL;
+   joints = NULL;
+   name = NULL;
+   numMeshes = 0;
+   numJoints = 0;
+   isAnimated = false;
+   animatedSkeleton.clear();
+   blendSkeleton.clear();
+   jointMatrices.clear();
+}
+
+// model space skeleton of one frame, the animated components replace those of the base frame
+static void BuildSkeleton( const std::vector<MD5JointInfo> &hierarchy, const std::vector<MD5BaseframeJoint> &baseFrame,
+   const float *frameData, MD5Joint *skeletonOut )
+{
+   for ( uint32 i = 0; i < hierarchy.size(); i++ )
+   {
+      const MD5JointInfo &info = hierarchy[i];
+      Vector3f position = baseFrame[i].position;
+      Quaternion_f orientation = baseFrame[i].orientation;
+
+      int32 component = info.startIndex;
+      for ( int32 j = 0; j < 3; j++ )
+         if ( info.flags & ( 1 << j ) )
+            position[j] = frameData[component++];
+      for ( int32 j = 0; j < 3; j++ )
+         if ( info.flags & ( 8 << j ) )
+            orientation[j] = frameData[component++];
+      orientation.ComputeW();
+
+      MD5Joint &joint = skeletonOut[i];
+      memcpy( joint.name, info.name, sizeof(joint.name) );
+      joint.parentID = info.parent;
+      if ( info.parent < 0 )
+      {
+         joint.position = position;
+         joint.orientation = orientation;
+      }
+      else
+      {
+         const MD5Joint &parent = skeletonOut[info.parent];
+         const Vector3f offset = parent.orientation.Rotate( position );
+         joint.position = Vector3f( parent.position[0] + offset[0], parent.position[1] + offset[1], parent.position[2] + offset[2] );
+         joint.orientation = parent.orientation * orientation;
+         joint.orientation.Normalize();
+      }
+   }
+}
+
+static int16 QuantizeUnit( const float value )
+{
+   const float scaled = floorf( value * INT16_MAX + 0.5f );
+   return (int16)( scaled > INT16_MAX ? INT16_MAX : ( scaled < -INT16_MAX ? -INT16_MAX : scaled ) );
+}
+
+bool MD5Mesh::LoadAnim( const char *filename, MD5Anim *md5Anim, const bool bakePoses )
+{
+   FreeAnim( md5Anim );
+   if ( !Open( filename, true ) )
+      return false;
+
+   const bool ok = ReadAnim( md5Anim, bakePoses );
+   Close();
+   if ( !ok )
+   {
+      FreeAnim( md5Anim );
+      return false;
+   }
+
+   isAnimated = true;
+   return true;
+}
+
+bool MD5Mesh::ReadAnim( MD5Anim *md5Anim, const bool bakePoses )
+{
+   enum eSection
+   {
+      SECTION_NONE,
+      SECTION_HIERARCHY,
+      SECTION_BOUNDS,
+      SECTION_BASEFRAME,
+      SECTION_FRAME
+   };
+
+   LineReader reader( *this );
+   StringView_c line;
+   TokenList<char, 8> tokens;
+   eSection section = SECTION_NONE;
+   int32 numAnimatedComponents = -1;
+   std::vector<MD5JointInfo> hierarchy;
+   std::vector<MD5BaseframeJoint> baseFrame;
+   std::vector<float> frameData;
+   std::vector<MD5Joint> skeleton;
+   std::vector<bool> framesRead;
+   int32 numBoundsRead = 0;
+   int32 frameIndex = -1;
+   int32 numComponentsRead = 0;
+
+   while ( reader.ReadLine( line ) )
+   {
+      if ( section == SECTION_FRAME )
+      {
+         // the components of a frame may be spread over any number of lines
+         StringView_c rest = line;
+         StringView_c token;
+         while ( section == SECTION_FRAME && NextToken( rest, token, MD5_DELIMITERS ) )
+         {
+            if ( IsComment( token ) )
+               break;
+            if ( token == "}" )
+            {
+               if ( numComponentsRead != numAnimatedComponents )
+                  return false;
+               BuildSkeleton( hierarchy, baseFrame, frameData.empty() ? NULL : &frameData[0], &skeleton[0] );
+
+               const int32 numJoints = md5Anim->numJoints;
+               if ( bakePoses )
+               {
+                  MD5PoseJoint *pose = &md5Anim->poseCache[frameIndex * numJoints];
+                  for ( int32 i = 0; i < numJoints; i++ )
+                  {
+                     for ( int32 j = 0; j < 4; j++ )
+                        pose[i].orientation[j] = QuantizeUnit( skeleton[i].orientation[j] );
+                     for ( int32 j = 0; j < 3; j++ )
+                        pose[i].position[j] = skeleton[i].position[j];
+                  }
+               }
+               else
+               {
+                  md5Anim->skeletonFrames[frameIndex] = new MD5Joint[numJoints];
+                  memcpy( md5Anim->skeletonFrames[frameIndex], &skeleton[0], numJoints * sizeof(MD5Joint) );
+               }
+               section = SECTION_NONE;
+            }
+            else
+            {
+               if ( numComponentsRead >= numAnimatedComponents )
+                  return false;
+               if ( !ReadFloat( token, frameData[numComponentsRead++] ) )
+                  return false;
+            }
+         }
+         continue;
+      }
+
+      tokens.Split( line, MD5_DELIMITERS );
+      if ( tokens.IsEmpty() || IsComment( tokens[0] ) )
+         continue;
+
+      if ( tokens[0] == "}" )
+      {
+         section = SECTION_NONE;
+      }
+      else if ( section == SECTION_HIERARCHY )
+      {
+         // "name" parent flags startIndex
+         MD5JointInfo info;
+         StringView_c rest;
+         if ( !ReadQuoted( line, info.name, sizeof(info.name), rest ) || tokens.Split( rest, MD5_DELIMITERS ) < 3 )
+            return false;
+         if ( !ReadInt( tokens[0], info.parent ) || !ReadInt( tokens[1], info.flags ) || !ReadInt( tokens[2], info.startIndex ) )
+            return false;
+
+         int32 numComponents = 0;
+         for ( int32 i = 0; i < 6; i++ )
+            if ( info.flags & ( 1 << i ) )
+               numComponents++;
+         const int32 index = (int32)hierarchy.size();
+         if ( index >= md5Anim->numJoints || info.parent < -1 || info.parent >= index
+            || info.startIndex < 0 || info.startIndex + numComponents > numAnimatedComponents )
+            return false;
+         hierarchy.push_back( info );
+      }
+      else if ( section == SECTION_BOUNDS )
+      {
+         // ( minX minY minZ ) ( maxX maxY maxZ )
+         if ( numBoundsRead >= md5Anim->numFrames || tokens.GetSize() < 6 )
+            return false;
+         if ( !ReadVector( tokens, 0, md5Anim->boundingboxes[numBoundsRead].min )
+            || !ReadVector( tokens, 3, md5Anim->boundingboxes[numBoundsRead].max ) )
+            return false;
+         numBoundsRead++;
+      }
+      else if ( section == SECTION_BASEFRAME )
+      {
+         // ( px py pz ) ( qx qy qz )
+         if ( (int32)baseFrame.size() >= md5Anim->numJoints || tokens.GetSize() < 6 )
+            return false;
+         MD5BaseframeJoint joint;
+         if ( !ReadVector( tokens, 0, joint.position ) || !ReadOrientation( tokens, 3, joint.orientation ) )
+            return false;
+         baseFrame.push_back( joint );
+      }
+      else if ( tokens[0] == "MD5Version" && tokens.GetSize() > 1 )
+      {
+         int32 version;
+         if ( !ReadInt( tokens[1], version ) || version != 10 )
+            return false;
+      }
+      else if ( tokens[0] == "numFrames" && tokens.GetSize() > 1 && md5Anim->numFrames == 0 )
+      {
+         if ( !ReadCount( tokens[1], GetSize(), md5Anim->numFrames ) || md5Anim->numFrames == 0 )
+            return false;
+         md5Anim->boundingboxes = new MD5BoundingBox[md5Anim->numFrames];
+         framesRead.assign( md5Anim->numFrames, false );
+      }
+      else if ( tokens[0] == "numJoints" && tokens.GetSize() > 1 && md5Anim->numJoints == 0 )
+      {
+         if ( !ReadCount( tokens[1], GetSize(), md5Anim->numJoints ) || md5Anim->numJoints == 0 )
+            return false;
+      }
+      else if ( tokens[0] == "frameRate" && tokens.GetSize() > 1 )
+      {
+         if ( !ReadInt( tokens[1], md5Anim->frameRate ) )
+            return false;
+      }
+      else if ( tokens[0] == "numAnimatedComponents" && tokens.GetSize() > 1 )
+      {
+         if ( !ReadCount( tokens[1], GetSize(), numAnimatedComponents ) )
+            return false;
+         frameData.resize( numAnimatedComponents );
+      }
+      else if ( tokens[0] == "hierarchy" )
+      {
+         if ( md5Anim->numJoints == 0 || numAnimatedComponents < 0 )
+            return false;
+         section = SECTION_HIERARCHY;
+      }
+      else if ( tokens[0] == "bounds" )
+      {
+         if ( md5Anim->numFrames == 0 )
+            return false;
+         section = SECTION_BOUNDS;
+      }
+      else if ( tokens[0] == "baseframe" )
+      {
+         section = SECTION_BASEFRAME;
+      }
+      else if ( tokens[0] == "frame" && tokens.GetSize() > 1 )
+      {
+         if ( !ReadInt( tokens[1], frameIndex ) || frameIndex < 0 || frameIndex >= md5Anim->numFrames || framesRead[frameIndex]
+            || (int32)hierarchy.size() != md5Anim->numJoints || (int32)baseFrame.size() != md5Anim->numJoints )
+            return false;
+         framesRead[frameIndex] = true;
+
+         if ( skeleton.empty() )
+         {
+            skeleton.resize( md5Anim->numJoints );
+            if ( bakePoses )
+            {
+               // frameIndex * numJoints indexes the cache, the product has to fit into an int32
+               if ( md5Anim->numJoints > INT32_MAX / md5Anim->numFrames )
+                  return false;
+               md5Anim->poseCache.resize( md5Anim->numFrames * md5Anim->numJoints );
+            }
+            else
+            {
+               md5Anim->skeletonFrames = new MD5Joint*[md5Anim->numFrames];
+               for ( int32 i = 0; i < md5Anim->numFrames; i++ )
+                  md5Anim->skeletonFrames[i] = NULL;
+            }
+         }
+         numComponentsRead = 0;
+         section = SECTION_FRAME;
+      }
+   }
+
+   if ( section != SECTION_NONE || md5Anim->frameRate <= 0 || numBoundsRead != md5Anim->numFrames )
+      return false;
+   for ( int32 i = 0; i < md5Anim->numFrames; i++ )
+      if ( !framesRead[i] )
+         return false;
+
+   // the animation has to fit the skeleton of the mesh
+   if ( md5Anim->numJoints != numJoints )
+      return false;
+   for ( int32 i = 0; i < numJoints; i++ )
+      if ( hierarchy[i].parent != joints[i].parentID )
+         return false;
+   return true;
+}
+
+void MD5Mesh::FreeAnim( MD5Anim *md5Anim )
+{
+   if ( md5Anim->skeletonFrames != NULL )
+   {
+      for ( int32 i = 0; i < md5Anim->numFrames; i++ )
+         delete[] md5Anim->skeletonFrames[i];
+      delete[] md5Anim->skeletonFrames;
+   }
+   delete[] md5Anim->boundingboxes;
+   std::vector<MD5PoseJoint>().swap( md5Anim->poseCache );
+   delete md5Anim->compressed;
+
+   md5Anim->skeletonFrames = NULL;
+   md5Anim->compressed = NULL;
+   md5Anim->boundingboxes = NULL;
+   md5Anim->numFrames = 0;
+   md5Anim->numJoints = 0;
+   md5Anim->frameRate = 0;
+}
+
+// bind pose position of a vertex from its weights
+static Vector3f BindPosition( const Mesh &mesh, const MD5Joint *joints, const int32 vertex )
+{
+   Vector3f position( 0.0f, 0.0f, 0.0f );
+   const MD5Vertex &v = mesh.vertices[vertex];
+   for ( int32 i = 0; i < v.weightCount; i++ )
+   {
+      const MD5Weight &weight = mesh.weights[v.startWeight + i];
+      const MD5Joint &joint = joints[weight.joint];
+      const Vector3f p = joint.orientation.Rotate( weight.pos );
+      position[0] += ( joint.position[0] + p[0] ) * weight.bias;
+      position[1] += ( joint.position[1] + p[1] ) * weight.bias;
+      position[2] += ( joint.position[2] + p[2] ) * weight.bias;
+   }
+   return position;
+}
+
+void MD5Mesh::PrepareSkinning()
+{
+   for ( int32 m = 0; m < numMeshes; m++ )
+   {
+      Mesh &mesh = meshes[m];
+
+      // smooth bind pose normals from the triangles
+      std::vector<Vector3f> positions( mesh.numVertices );
+      std::vector<Vector3f> normals( mesh.numVertices, Vector3f( 0.0f, 0.0f, 0.0f ) );
+      for ( int32 i = 0; i < mesh.numVertices; i++ )
+         positions[i] = BindPosition( mesh, joints, i );
+
+      for ( int32 i = 0; i < mesh.numTriangles; i++ )
+      {
+         const uint32 *triangle = mesh.triangles[i];
+         const Vector3f &p0 = positions[triangle[0]];
+         const Vector3f &p1 = positions[triangle[1]];
+         const Vector3f &p2 = positions[triangle[2]];
+         // md5 triangles are wound clockwise
+         const Vector3f e1( p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] );
+         const Vector3f e2( p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] );
+         const Vector3f n = e1.CrossProd( e2 );
+         for ( int32 j = 0; j < 3; j++ )
+         {
+            Vector3f &sum = normals[triangle[j]];
+            sum[0] += n[0];
+            sum[1] += n[1];
+            sum[2] += n[2];
+         }
+      }
+
+      // the weights carry the normal into the space of their joint, like the position
+      mesh.skinWeights.resize( mesh.numWeights );
+      for ( int32 i = 0; i < mesh.numVertices; i++ )
+      {
+         Vector3f normal = normals[i];
+         if ( normal.SqLength() > 0.0f )
+            normal.Normalize();
+
+         const MD5Vertex &v = mesh.vertices[i];
+         for ( int32 j = 0; j < v.weightCount; j++ )
+         {
+            const MD5Weight &weight = mesh.weights[v.startWeight + j];
+            const Vector3f jointNormal = joints[weight.joint].orientation.Conjugate().Rotate( normal );
+
+            MD5SkinWeight &skinWeight = mesh.skinWeights[v.startWeight + j];
+            skinWeight.position[0] = weight.pos[0];
+            skinWeight.position[1] = weight.pos[1];
+            skinWeight.position[2] = weight.pos[2];
+            skinWeight.bias = weight.bias;
+            skinWeight.normal[0] = jointNormal[0];
+            skinWeight.normal[1] = jointNormal[1];
+            skinWeight.normal[2] = jointNormal[2];
+            skinWeight.joint = weight.joint;
+         }
+      }
+
+      const int32 padded = PaddedSize( mesh.numVertices );
+      MD5SkinnedVertices &out = mesh.skinned;
+      out.positionX.assign( padded, 0.0f ); out.positionY.assign( padded, 0.0f ); out.positionZ.assign( padded, 0.0f );
+      out.normalX.assign( padded, 0.0f ); out.normalY.assign( padded, 0.0f ); out.normalZ.assign( padded, 0.0f );
+   }
+
+   animatedSkeleton.assign( joints, joints + numJoints );
+   jointMatrices.resize( numJoints * 16 );
+}
+
+void MD5Mesh::InterpolateSkeletons( const MD5Joint *skelA, const MD5Joint *skelB, const int32 numJoints, const float interp, MD5Joint *out )
+{
+   for ( int32 i = 0; i < numJoints; i++ )
+   {
+      const MD5Joint &a = skelA[i];
+      const MD5Joint &b = skelB[i];
+      out[i].parentID = a.parentID;
+      out[i].position = Vector3f(
+         a.position[0] + interp * ( b.position[0] - a.position[0] ),
+         a.position[1] + interp * ( b.position[1] - a.position[1] ),
+         a.position[2] + interp * ( b.position[2] - a.position[2] ) );
+      // neighbouring frames are close, nlerp is as good as slerp here
+      out[i].orientation = core::math::Nlerp( a.orientation, b.orientation, interp );
+   }
+}
+
+// the poses hold model space joints, blending them needs no walk over the hierarchy
+void MD5Mesh::InterpolatePoses( const MD5PoseJoint *poseA, const MD5PoseJoint *poseB, const int32 numJoints, const float interp, MD5Joint *out )
+{
+   for ( int32 i = 0; i < numJoints; i++ )
+   {
+      const MD5PoseJoint &a = poseA[i];
+      const MD5PoseJoint &b = poseB[i];
+      out[i].position = Vector3f(
+         a.position[0] + interp * ( b.position[0] - a.position[0] ),
+         a.position[1] + interp * ( b.position[1] - a.position[1] ),
+         a.position[2] + interp * ( b.position[2] - a.position[2] ) );
+      const Quaternion_f orientationA( a.orientation[0] * POSE_SCALE, a.orientation[1] * POSE_SCALE, a.orientation[2] * POSE_SCALE, a.orientation[3] * POSE_SCALE );
+      const Quaternion_f orientationB( b.orientation[0] * POSE_SCALE, b.orientation[1] * POSE_SCALE, b.orientation[2] * POSE_SCALE, b.orientation[3] * POSE_SCALE );
+      out[i].orientation = core::math::Nlerp( orientationA, orientationB, interp );
+   }
+}
+
+void MD5Mesh::ComputeJointMatrices( const MD5Joint *skeleton )
+{
+   for ( int32 i = 0; i < numJoints; i++ )
+   {
+      const Quaternion_f &q = skeleton[i].orientation;
+      const float x = q[0], y = q[1], z = q[2], w = q[3];
+      float *m = &jointMatrices[i * 16];
+
+      m[0] = 1.0f - 2.0f * ( y * y + z * z ); m[1] = 2.0f * ( x * y + w * z ); m[2] = 2.0f * ( x * z - w * y ); m[3] = 0.0f;
+      m[4] = 2.0f * ( x * y - w * z ); m[5] = 1.0f - 2.0f * ( x * x + z * z ); m[6] = 2.0f * ( y * z + w * x ); m[7] = 0.0f;
+      m[8] = 2.0f * ( x * z + w * y ); m[9] = 2.0f * ( y * z - w * x ); m[10] = 1.0f - 2.0f * ( x * x + y * y ); m[11] = 0.0f;
+      m[12] = skeleton[i].position[0]; m[13] = skeleton[i].position[1]; m[14] = skeleton[i].position[2]; m[15] = 1.0f;
+   }
+}
+
+// Both paths evaluate every vertex with the same operations in the same order, the SSE path
+// just does x, y and z at once. Normals are normalized with a true square root and division,
+// rsqrt differs between CPU vendors
+void MD5Mesh::ComputeVertexPositionsPerMesh( Mesh &mesh, const int32 firstVertex, const int32 endVertex ) const
+{
+   assert( firstVertex % MD5_SKIN_BATCH == 0 );
+
+   const MD5SkinWeight *skinWeights = mesh.skinWeights.empty() ? NULL : &mesh.skinWeights[0];
+   const float *matrices = &jointMatrices[0];
+   MD5SkinnedVertices &out = mesh.skinned;
+
+#ifdef CORE_MATH_SSE
+   for ( int32 batch = firstVertex; batch < endVertex; batch += MD5_SKIN_BATCH )
+   {
+      __m128 position[MD5_SKIN_BATCH];
+      __m128 normal[MD5_SKIN_BATCH];
+      for ( int32 lane = 0; lane < MD5_SKIN_BATCH; lane++ )
+      {
+         position[lane] = _mm_setzero_ps();
+         normal[lane] = _mm_setzero_ps();
+
+         // padding vertices stay at zero
+         const int32 vertex = batch + lane;
+         if ( vertex >= mesh.numVertices )
+            continue;
+
+         const MD5Vertex &v = mesh.vertices[vertex];
+         for ( int32 i = 0; i < v.weightCount; i++ )
+         {
+            const MD5SkinWeight &weight = skinWeights[v.startWeight + i];
+            const float *m = matrices + weight.joint * 16;
+            const __m128 col0 = _mm_loadu_ps( m );
+            const __m128 col1 = _mm_loadu_ps( m + 4 );
+            const __m128 col2 = _mm_loadu_ps( m + 8 );
+            const __m128 col3 = _mm_loadu_ps( m + 12 );
+            const __m128 bias = _mm_set1_ps( weight.bias );
+
+            __m128 p = _mm_add_ps( _mm_mul_ps( col0, _mm_set1_ps( weight.position[0] ) ), _mm_mul_ps( col1, _mm_set1_ps( weight.position[1] ) ) );
+            p = _mm_add_ps( _mm_add_ps( p, _mm_mul_ps( col2, _mm_set1_ps( weight.position[2] ) ) ), col3 );
+            position[lane] = _mm_add_ps( position[lane], _mm_mul_ps( p, bias ) );
+
+            __m128 n = _mm_add_ps( _mm_mul_ps( col0, _mm_set1_ps( weight.normal[0] ) ), _mm_mul_ps( col1, _mm_set1_ps( weight.normal[1] ) ) );
+            n = _mm_add_ps( n, _mm_mul_ps( col2, _mm_set1_ps( weight.normal[2] ) ) );
+            normal[lane] = _mm_add_ps( normal[lane], _mm_mul_ps( n, bias ) );
+         }
+      }
+
+      // four xyz vectors become the x, y and z of four vertices
+      _MM_TRANSPOSE4_PS( position[0], position[1], position[2], position[3] );
+      _mm_storeu_ps( &out.positionX[batch], position[0] );
+      _mm_storeu_ps( &out.positionY[batch], position[1] );
+      _mm_storeu_ps( &out.positionZ[batch], position[2] );
+
+      _MM_TRANSPOSE4_PS( normal[0], normal[1], normal[2], normal[3] );
+      const __m128 sqLength = _mm_add_ps( _mm_add_ps( _mm_mul_ps( normal[0], normal[0] ), _mm_mul_ps( normal[1], normal[1] ) ),
+         _mm_mul_ps( normal[2], normal[2] ) );
+      const __m128 nonZero = _mm_cmpgt_ps( sqLength, _mm_setzero_ps() );
+      const __m128 invLength = _mm_and_ps( nonZero, _mm_div_ps( _mm_set1_ps( 1.0f ), _mm_sqrt_ps( sqLength ) ) );
+      _mm_storeu_ps( &out.normalX[batch], _mm_mul_ps( normal[0], invLength ) );
+      _mm_storeu_ps( &out.normalY[batch], _mm_mul_ps( normal[1], invLength ) );
+      _mm_storeu_ps( &out.normalZ[batch], _mm_mul_ps( normal[2], invLength ) );
+   }
+#else
+   const int32 end = PaddedSize( endVertex );
+   for ( int32 vertex = firstVertex; vertex < end; vertex++ )
+   {
+      float position[3] = { 0.0f, 0.0f, 0.0f };
+      float normal[3] = { 0.0f, 0.0f, 0.0f };
+
+      if ( vertex < mesh.numVertices )
+      {
+         const MD5Vertex &v = mesh.vertices[vertex];
+         for ( int32 i = 0; i < v.weightCount; i++ )
+         {
+            const MD5SkinWeight &weight = skinWeights[v.startWeight + i];
+            const float *m = matrices + weight.joint * 16;
+            for ( int32 c = 0; c < 3; c++ )
+            {
+               const float p = ( ( m[c] * weight.position[0] + m[4 + c] * weight.position[1] ) + m[8 + c] * weight.position[2] ) + m[12 + c];
+               position[c] += p * weight.bias;
+               const float n = ( m[c] * weight.normal[0] + m[4 + c] * weight.normal[1] ) + m[8 + c] * weight.normal[2];
+               normal[c] += n * weight.bias;
+            }
+         }
+      }
+
+      out.positionX[vertex] = position[0];
+      out.positionY[vertex] = position[1];
+      out.positionZ[vertex] = position[2];
+
+      const float sqLength = ( normal[0] * normal[0] + normal[1] * normal[1] ) + normal[2] * normal[2];
+      const float invLength = sqLength > 0.0f ? 1.0f / sqrtf( sqLength ) : 0.0f;
+      out.normalX[vertex] = normal[0] * invLength;
+      out.normalY[vertex] = normal[1] * invLength;
+      out.normalZ[vertex] = normal[2] * invLength;
+   }
+#endif
+}
+
+void MD5Mesh::Skin( const MD5Joint *skeleton )
+{
+   if ( numMeshes == 0 || jointMatrices.empty() )
+      return;
+
+   ComputeJointMatrices( skeleton );
+
+   // ranges of whole batches over all meshes, so small meshes are grouped and big ones are split
+   struct SkinRange
+   {
+      int32 mesh;
+      int32 first;
+      int32 end;
+   };
+   std::vector<SkinRange> ranges;
+   for ( int32 m = 0; m < numMeshes; m++ )
+   {
+      for ( int32 first = 0; first < meshes[m].numVertices; first += SKIN_GRAIN )
+      {
+         SkinRange range = { m, first, first + SKIN_GRAIN < meshes[m].numVertices ? first + SKIN_GRAIN : meshes[m].numVertices };
+         ranges.push_back( range );
+      }
+   }
+
+   TaskScheduler *scheduler = TaskScheduler::GetActive();
+   if ( scheduler == NULL )
+   {
+      for ( uint32 i = 0; i < ranges.size(); i++ )
+         ComputeVertexPositionsPerMesh( meshes[ranges[i].mesh], ranges[i].first, ranges[i].end );
+      return;
+   }
+
+   scheduler->ParallelFor( 0, (uint32)ranges.size(), 1, [this, &ranges]( uint32 begin, uint32 end )
+   {
+      for ( uint32 i = begin; i < end; i++ )
+         ComputeVertexPositionsPerMesh( meshes[ranges[i].mesh], ranges[i].first, ranges[i].end );
+   } );
+}
+
+void MD5Mesh::Animate( const MD5Anim *anim, MD5AnimInfo *animInfo, const double dt )
+{
+   const int32 maxFrame = anim->numFrames - 1;
+   if ( maxFrame < 0 || anim->frameRate <= 0 || anim->numJoints != numJoints )
+      return;
+   if ( animInfo->maxTime <= 0.0 )
+      animInfo->maxTime = 1.0 / anim->frameRate;
+
+   // the info may come from a clip with more frames, the frames index the poses of this one
+   if ( animInfo->currentFrame < 0 )
+      animInfo->currentFrame = 0;
+   else if ( animInfo->currentFrame > maxFrame )
+      animInfo->currentFrame %= anim->numFrames;
+
+   // whole frames are stepped over, the remainder is kept so playback does not drift
+   animInfo->lastTime += dt;
+   while ( animInfo->lastTime >= animInfo->maxTime )
+   {
+      animInfo->lastTime -= animInfo->maxTime;
+      animInfo->currentFrame = animInfo->currentFrame >= maxFrame ? 0 : animInfo->currentFrame + 1;
+   }
+   // set every time, a zeroed info starts with frame 0 blending towards frame 1
+   animInfo->nextFrame = animInfo->currentFrame >= maxFrame ? 0 : animInfo->currentFrame + 1;
+   animInfo->currentTime += dt;
+
+   const float interp = (float)( animInfo->lastTime / animInfo->maxTime );
+   animatedSkeleton.resize( numJoints );
+   if ( anim->compressed != NULL )
+   {
+      // sized once, the loop back to the first frame does not allocate
+      blendSkeleton.resize( numJoints );
+      SampleCompressedPose( *anim->compressed, animInfo->currentFrame, animInfo->nextFrame, interp, &blendSkeleton[0],
+         &animatedSkeleton[0] );
+   }
+   else if ( !anim->poseCache.empty() )
+      InterpolatePoses( &anim->poseCache[animInfo->currentFrame * numJoints], &anim->poseCache[animInfo->nextFrame * numJoints],
+         numJoints, interp, &animatedSkeleton[0] );
+   else
+      InterpolateSkeletons( anim->skeletonFrames[animInfo->currentFrame], anim->skeletonFrames[animInfo->nextFrame],
+         numJoints, interp, &animatedSkeleton[0] );
+   Skin( &animatedSkeleton[0] );
+}
+
+} // namespace md5
+
+} // namespace model
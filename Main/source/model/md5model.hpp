@@ -1,6 +1,8 @@
 #ifndef _MD5MODEL_HPP_INCLUDED_
 #define _MD5MODEL_HPP_INCLUDED_
 
+#include <vector>
+
 #include "../core/math/vector2.hpp"
 #include "../core/math/vector3.hpp"
 #include "../core/math/quaternion.hpp"
@@ -40,6 +42,25 @@ struct MD5Vertex
 
 typedef uint32 triangle_t[3];
 
+// weight packed for skinning, position and normal in the space of the joint
+struct MD5SkinWeight
+{
+   float position[3];
+   float bias;
+   float normal[3]; // bind pose normal
+   int32 joint;
+};
+
+// skinned vertices as structure of arrays, padded to a multiple of MD5_SKIN_BATCH vertices
+struct MD5SkinnedVertices
+{
+   std::vector<float> positionX, positionY, positionZ;
+   std::vector<float> normalX, normalY, normalZ;
+};
+
+// vertices skinned together, the SoA output is written in whole batches
+const int32 MD5_SKIN_BATCH = 4;
+
 struct Mesh // maybe whole this should emigrate to Mesh-class?
 {
    char shaderName[256];
@@ -59,6 +80,10 @@ struct Mesh // maybe whole this should emigrate to Mesh-class?
    Vector3f *normalBuffer; // should emigrate to Mesh?
    Vector2f *tex2DBuffer; // should emigrate to Mesh?
    uint32 *indexBuffer;
+
+   // for CPU skinning, see MD5Mesh::PrepareSkinning
+   std::vector<MD5SkinWeight> skinWeights;
+   MD5SkinnedVertices skinned;
 };
 
 // *** md5anim *** //
@@ -83,14 +108,29 @@ struct MD5BoundingBox // aabbox.hpp facilities could be useful here
   Vector3f max;
 };
 
+// joint of a baked pose, the orientation quantized to 16 bits per component
+struct MD5PoseJoint
+{
+   int16 orientation[4]; // x, y, z, w times INT16_MAX
+   float position[3];
+};
+
+struct MD5CompressedAnim; // md5compression.hpp
+
 struct MD5Anim
 {
   int32 numFrames;
   int32 numJoints;
   int32 frameRate;
 
-  MD5Joint **skeletonFrames;
+  MD5Joint **skeletonFrames; // NULL when the poses are baked
   MD5BoundingBox *boundingboxes;
+  // baked model space poses, numJoints joints per frame and the frames one after the other
+  std::vector<MD5PoseJoint> poseCache;
+  // replaces skeletonFrames and poseCache after CompressAnim
+  MD5CompressedAnim *compressed;
+
+  MD5Anim() : numFrames(0), numJoints(0), frameRate(0), skeletonFrames(NULL), boundingboxes(NULL), compressed(NULL) {}
 };
 
 struct MD5AnimInfo
@@ -102,6 +142,10 @@ struct MD5AnimInfo
    double maxTime;
 };
 
+// CPU skinning: Animate interpolates the skeleton of the current frames, converts the joints to
+// matrices and skins every mesh into its SoA buffers. Meshes are split into ranges of vertices that
+// are skinned in parallel on the active TaskScheduler. Every vertex is computed the same way no
+// matter which thread or range it falls in, so the result is bit for bit reproducible
 class MD5Mesh : File
 {
 private:
@@ -112,13 +156,43 @@ private:
    int32 numJoints;
    bool isAnimated;
    int32 modelSize;//in bytes
+
+   std::vector<MD5Joint> animatedSkeleton;
+   std::vector<MD5Joint> blendSkeleton; // pose of the next frame when a compressed animation loops
+   std::vector<float> jointMatrices; // per joint 3 rotation columns and the translation, 4 floats each
+
+   bool ReadMesh();
+   bool ReadAnim( MD5Anim *md5Anim, const bool bakePoses );
+   void ComputeJointMatrices( const MD5Joint *skeleton );
+
+   MD5Mesh( const MD5Mesh &other );
+   MD5Mesh &operator=( const MD5Mesh &other );
 public:
+   MD5Mesh();
+   ~MD5Mesh();
+
+   // loads the bind pose and prepares the skinning, the vertices are not skinned yet
    bool LoadMesh( const char *filename );
-   void ComputeVertexPositionsPerMesh( MD5Mesh *mesh, MD5Joint *sk );
+   // packs the weights with their bind pose normals and sizes the skinning output, after loading
+   void PrepareSkinning();
+   // skins the vertices [firstVertex, endVertex) of mesh with the current joint matrices,
+   // firstVertex is a multiple of MD5_SKIN_BATCH
+   void ComputeVertexPositionsPerMesh( Mesh &mesh, const int32 firstVertex, const int32 endVertex ) const;
+   // skins all meshes with the pose of skeleton
+   void Skin( const MD5Joint *skeleton );
    void FreeMesh();
-   bool LoadAnim( const char *filename, MD5Anim *md5Anim );
-   void Animate( const MD5Anim *, MD5AnimInfo *, double );
-   void InterpolateSkeletons( const MD5Joint *skelA, const MD5Joint *skelB, const int32 numJoints, const float interp, joint_t *out );
+   // the animation has to match the skeleton of the loaded mesh. With bakePoses the frames are
+   // stored in the compact poseCache instead of skeletonFrames
+   bool LoadAnim( const char *filename, MD5Anim *md5Anim, const bool bakePoses = true );
+   static void FreeAnim( MD5Anim *md5Anim );
+   // advances animInfo by dt seconds and skins the meshes with the interpolated pose
+   void Animate( const MD5Anim *anim, MD5AnimInfo *animInfo, const double dt );
+   static void InterpolateSkeletons( const MD5Joint *skelA, const MD5Joint *skelB, const int32 numJoints, const float interp, MD5Joint *out );
+   static void InterpolatePoses( const MD5PoseJoint *poseA, const MD5PoseJoint *poseB, const int32 numJoints, const float interp, MD5Joint *out );
+
+   int32 GetNumMeshes() const { return numMeshes; }
+   const Mesh &GetMesh( const int32 index ) const { return meshes[index]; }
+   int32 GetNumJoints() const { return numJoints; }
 };
 
 } // namespace md5
@@ -1,7 +1,73 @@
-
 #include "mesh.hpp"
 
+#include <string.h>
+
 namespace mesh
 {
 
-} // namespace mesh
\ No newline at end of file
+uint32 GetStreamComponents( const eMeshStream stream )
+{
+   return stream == MS_TEXCOORD2 ? 2 : 3;
+}
+
+AttributeArena::AttributeArena()
+{
+   Clear();
+}
+
+void AttributeArena::Clear()
+{
+   block.clear();
+   for (int32 i = 0; i < MS_NUMSTREAMS; i++)
+   {
+      streams[i].offset = 0;
+      streams[i].count = 0;
+      streams[i].capacity = 0;
+   }
+}
+
+void AttributeArena::Relayout( const uint32 capacities[MS_NUMSTREAMS] )
+{
+   uint32 offsets[MS_NUMSTREAMS];
+   uint32 total = 0;
+   for (int32 i = 0; i < MS_NUMSTREAMS; i++)
+   {
+      offsets[i] = total;
+      // keep every stream 16 byte aligned relative to the block
+      total += (capacities[i] * GetStreamComponents((eMeshStream)i) + 3) & ~3u;
+   }
+
+   vector<float> newBlock(total);
+   for (int32 i = 0; i < MS_NUMSTREAMS; i++)
+   {
+      const uint32 numFloats = streams[i].count * GetStreamComponents((eMeshStream)i);
+      if (numFloats)
+         memcpy(&newBlock[offsets[i]], &block[streams[i].offset], numFloats * sizeof(float));
+      streams[i].offset = offsets[i];
+      streams[i].capacity = capacities[i];
+   }
+   block.swap(newBlock);
+}
+
+void AttributeArena::Reserve( const eMeshStream stream, const uint32 count )
+{
+   if (count <= streams[stream].capacity)
+      return;
+
+   uint32 capacities[MS_NUMSTREAMS];
+   for (int32 i = 0; i < MS_NUMSTREAMS; i++)
+      capacities[i] = streams[i].capacity;
+   capacities[stream] = count;
+   Relayout(capacities);
+}
+
+float *AttributeArena::Append( const eMeshStream stream )
+{
+   Stream &s = streams[stream];
+   if (s.count == s.capacity)
+      Reserve(stream, s.capacity < 64 ? 64 : s.capacity * 2);
+
+   return &block[s.offset + s.count++ * GetStreamComponents(stream)];
+}
+
+} // namespace mesh
@@ -3,8 +3,8 @@
 
 // this is the interface for all mesh loaders
 
+#include <assert.h>
 #include <iostream>
-#include <map>
 #include <vector>
 
 #include "core/bits.hpp"
@@ -33,99 +33,228 @@ using namespace std;
 namespace mesh
 {
 
+// attribute streams of a mesh, all streams live in one AttributeArena
+enum eMeshStream
+{
+   MS_POSITION = 0,
+   MS_NORMAL,
+   MS_TEXCOORD2,
+   MS_TEXCOORD3,
+   MS_TANGENT,
+   MS_COLOR,
+   MS_BINORMAL,
+   MS_NUMSTREAMS
+};
+
+// number of floats of one element of a stream
+uint32 GetStreamComponents( const eMeshStream stream );
+
+// One float block that holds every attribute stream of a mesh back to back, each stream starts
+// on a 16 byte boundary relative to the block. A stream that runs out of room grows the whole block
+// in one allocation, so filling a mesh costs a handful of allocations instead of one per element.
+// Pointers returned by GetData are invalidated by Append and Reserve
+class AttributeArena
+{
+private:
+   struct Stream
+   {
+      uint32 offset; // in floats
+      uint32 count; // in elements
+      uint32 capacity; // in elements
+   };
+
+   vector<float> block;
+   Stream streams[MS_NUMSTREAMS];
+
+   void Relayout( const uint32 capacities[MS_NUMSTREAMS] );
+public:
+   AttributeArena();
+
+   void Clear();
+   void Reserve( const eMeshStream stream, const uint32 count );
+   // returns the components of the new element, to be filled by the caller
+   float *Append( const eMeshStream stream );
+
+   float *GetData( const eMeshStream stream ) { return streams[stream].count ? &block[streams[stream].offset] : NULL; }
+   const float *GetData( const eMeshStream stream ) const { return streams[stream].count ? &block[streams[stream].offset] : NULL; }
+   uint32 GetCount( const eMeshStream stream ) const { return streams[stream].count; }
+};
+
+// Lightweight view of one polygon of a Mesh. The index arrays point into the mesh's flat index
+// streams, so a Face is only valid until the mesh gets another face. Indices are 0-based,
+// a corner without a normal or texture coordinate has the index INVALID_INDEX
 template <typename T>
 class Face
 {
 private:
    int32 numVertices;
-   // for trifaces
-   vector<T> vertexIndex;
-   vector<T> normalIndex;
-   vector<T> textureIndex;
-  
-   //uint32 materialIndex; ?
+   const T *vertexIndex;
+   const T *normalIndex;
+   const T *textureIndex;
 
 public:
-   Face( const int32 numVertices = 3 ) { this->numVertices = numVertices; }
+   static const T INVALID_INDEX = (T)~(T)0;
+
+   Face() { numVertices = 0; vertexIndex = normalIndex = textureIndex = NULL; }
+   Face( const int32 numVertices, const T *vertexIndex, const T *textureIndex, const T *normalIndex )
+   {
+      this->numVertices = numVertices;
+      this->vertexIndex = vertexIndex;
+      this->textureIndex = textureIndex;
+      this->normalIndex = normalIndex;
+   }
 
    int32 GetNumVertices(void) const { return numVertices; }
+   bool HasNormal() const { return normalIndex != NULL; }
+   bool HasTexture() const { return textureIndex != NULL; }
 
-   void AddVertexIndex( const T idx ) { vertexIndex.push_back( idx ); }
-   void AddNormalIndex( const T idx ) { normalIndex.push_back( idx ); }
-   void AddTextureIndex( const T idx ) { textureIndex.push_back( idx ); }
+   const T *GetVertexIdxPtr() const { return vertexIndex; }
+   const T *GetNormalIdxPtr() const { return normalIndex; }
+   const T *GetTextureIdxPtr() const { return textureIndex; }
 
-   T *GetVertexIdxPtr() { return &vertexIndex[0]; }
-   T *GetNormalIdxPtr() { return &normalIndex[0]; }
-   T *GetTextureIdxPtr() { return &textureIndex[0]; }
+   T GetVertexIdx( const int32 corner ) const { return vertexIndex[corner]; }
+   T GetNormalIdx( const int32 corner ) const { return normalIndex ? normalIndex[corner] : INVALID_INDEX; }
+   T GetTextureIdx( const int32 corner ) const { return textureIndex ? textureIndex[corner] : INVALID_INDEX; }
 };
 
+template <typename T>
+const T Face<T>::INVALID_INDEX;
+
 typedef Face<uint16> Face16;
 typedef Face<uint32> Face32;
 
+// Structure of arrays mesh. The attributes are stored per stream in one arena, the faces as flat
+// index streams with one entry per corner plus the offset of the first corner of every face, so
+// faceOffsets[i + 1] - faceOffsets[i] is the number of corners of face i.
+// The normal and texture index streams are either empty or as long as the vertex index stream
 template <typename TFace = uint32>
 class Mesh
 {
 private:
    int32 numGroups;
    eVertexFormat vertexFormat;
-   // generic basic types should be used (?)
-   // vector<Vector<generic type> > vertexList;
 
    // these are the unindexed lists!
-   vector<Vector3f> vertexList;
-   vector<Vector3f> normalList;
-   vector<Vector2f> texture2List;
-   vector<Vector3f> texture3List;
-   vector<Vector3f> tangentList;
-   vector<Vector3f> colorList;
-   vector<Vector3f> binormalList;
-
-   vector<Face<TFace> > faceList;
+   AttributeArena attributes;
+
+   vector<TFace> vertexIndices;
+   vector<TFace> normalIndices;
+   vector<TFace> textureIndices;
+   vector<uint32> faceOffsets;
+
+   void AddVector3( const eMeshStream stream, const Vector3f &v )
+   {
+      float *dst = attributes.Append(stream);
+      dst[0] = v[0]; dst[1] = v[1]; dst[2] = v[2];
+   }
+
+   // keeps an optional index stream the same length as the vertex index stream
+   static void AppendOptional( vector<TFace> &indices, const TFace *src, const int32 numVertices, const uint32 numCorners );
 public:
-   Mesh::Mesh()
+   Mesh()
    {
-      vertexList.clear();
-      faceList.clear();
       numGroups = 0;
       vertexFormat = VF_EMPTY;
+      faceOffsets.push_back(0);
    };
 
-   Mesh::~Mesh(){};
+   ~Mesh(){};
 
    eVertexFormat GetVertexFormat() const { return vertexFormat; }
-   void AddVertex( const Vector3f vertex ) { vertexList.push_back(vertex); }
-   void AddVertexNormal( const Vector3f vertexNormal ) { normalList.push_back(vertexNormal); }
-   void AddVertexTexture2( const Vector2f vertexTexture ) { texture2List.push_back(vertexTexture); }
-   void AddVertexTexture3( const Vector3f vertexTexture ) { texture3List.push_back(vertexTexture); }
-   void AddTangent(const Vector3f tangent) { tangentList.push_back(tangent); }
-   void AddBinormal(const Vector3f binormal) { binormalList.push_back(binormal); }
-   void AddFace( const Face<TFace> &face ) { faceList.push_back(face); }
-
-   float *GetVertexListPtr() { return &vertexList[0][0]; }
-   float *GetNormalListPtr() { return &normalList[0][0]; }
-   float *GetTexture2ListPtr() { return &texture2List[0][0]; }
-   float *GetTexture3ListPtr() { return &texture3List[0][0]; }
+   void AddVertex( const Vector3f &vertex ) { AddVector3(MS_POSITION, vertex); }
+   void AddVertexNormal( const Vector3f &vertexNormal ) { AddVector3(MS_NORMAL, vertexNormal); }
+   void AddVertexTexture2( const Vector2f &vertexTexture )
+   {
+      float *dst = attributes.Append(MS_TEXCOORD2);
+      dst[0] = vertexTexture[0]; dst[1] = vertexTexture[1];
+   }
+   void AddVertexTexture3( const Vector3f &vertexTexture ) { AddVector3(MS_TEXCOORD3, vertexTexture); }
+   void AddTangent( const Vector3f &tangent ) { AddVector3(MS_TANGENT, tangent); }
+   void AddBinormal( const Vector3f &binormal ) { AddVector3(MS_BINORMAL, binormal); }
+   void AddColor( const Vector3f &color ) { AddVector3(MS_COLOR, color); }
+
+   // add a polygon, textureIdx and normalIdx may be NULL
+   void AddFace( const int32 numVertices, const TFace *vertexIdx, const TFace *textureIdx, const TFace *normalIdx );
+   void ReserveFaces( const uint32 numFaces, const uint32 numCorners );
+   void ReserveStream( const eMeshStream stream, const uint32 count ) { attributes.Reserve(stream, count); }
+
+   float *GetVertexListPtr() { return attributes.GetData(MS_POSITION); }
+   float *GetNormalListPtr() { return attributes.GetData(MS_NORMAL); }
+   float *GetTexture2ListPtr() { return attributes.GetData(MS_TEXCOORD2); }
+   float *GetTexture3ListPtr() { return attributes.GetData(MS_TEXCOORD3); }
+   const float *GetStream( const eMeshStream stream ) const { return attributes.GetData(stream); }
+   uint32 GetStreamCount( const eMeshStream stream ) const { return attributes.GetCount(stream); }
 
    void SetComponents(eVertexFormat components) { vertexFormat = vertexFormat | components; }
+   bool HasComponents(eVertexFormat components) const { return (vertexFormat & components) != 0; }
+
+   uint32 GetNumElemVertexList() const { return attributes.GetCount(MS_POSITION); }
+   uint32 GetNumElemNormalList() const { return attributes.GetCount(MS_NORMAL); }
+   uint32 GetNumElemTexture2List() const { return attributes.GetCount(MS_TEXCOORD2); }
+   uint32 GetNumElemTexture3List() const { return attributes.GetCount(MS_TEXCOORD3); }
+
+   uint32 GetNumFaces() const { return (uint32)faceOffsets.size() - 1; }
+   uint32 GetNumCorners() const { return (uint32)vertexIndices.size(); }
+   Face<TFace> GetFace( const uint32 face ) const;
 
-   bool HasComponents(eVertexFormat components) const { return vertexFormat ^ components;  }
-   
-   uint32 GetNumElemVertexList() { return vertexList.size(); }
-   uint32 GetNumElemNormalList() { return normalList.size(); }
-   uint32 GetNumElemTexture2List() { return texture2List.size(); }
-   uint32 GetNumElemTexture3List() { return texture3List.size(); }
-
-   Face<TFace> *GetFaceListPtr() { return &faceList[0]; }
-
-   bool HasComponents(eVertexFormat components) { return vertexFormat & components; }
-   bool HasNormal() { return !normalList.empty();; }
-   bool HasTexture2() { return !texture2List.empty(); }
-   bool HasTexture3() { return !texture3List.empty(); }
-   bool HasTangent() { return !tangentList.empty(); }
-   bool HasColor() { return !colorList.empty(); }
-   bool HasBinormal() { return !binormal.empty(); }
+   // the flat index streams, one entry per corner
+   const TFace *GetVertexIndexPtr() const { return vertexIndices.empty() ? NULL : &vertexIndices[0]; }
+   const TFace *GetNormalIndexPtr() const { return normalIndices.empty() ? NULL : &normalIndices[0]; }
+   const TFace *GetTextureIndexPtr() const { return textureIndices.empty() ? NULL : &textureIndices[0]; }
+   const uint32 *GetFaceOffsetPtr() const { return &faceOffsets[0]; }
+
+   bool HasNormal() const { return attributes.GetCount(MS_NORMAL) != 0; }
+   bool HasTexture2() const { return attributes.GetCount(MS_TEXCOORD2) != 0; }
+   bool HasTexture3() const { return attributes.GetCount(MS_TEXCOORD3) != 0; }
+   bool HasTangent() const { return attributes.GetCount(MS_TANGENT) != 0; }
+   bool HasColor() const { return attributes.GetCount(MS_COLOR) != 0; }
+   bool HasBinormal() const { return attributes.GetCount(MS_BINORMAL) != 0; }
 };
 
+template <typename TFace>
+void Mesh<TFace>::AppendOptional( vector<TFace> &indices, const TFace *src, const int32 numVertices, const uint32 numCorners )
+{
+   if (src == NULL)
+   {
+      if (!indices.empty())
+         indices.insert(indices.end(), numVertices, Face<TFace>::INVALID_INDEX);
+      return;
+   }
+
+   // the first face with this attribute, the earlier corners have none
+   if (indices.size() < numCorners)
+      indices.resize(numCorners, Face<TFace>::INVALID_INDEX);
+   indices.insert(indices.end(), src, src + numVertices);
+}
+
+template <typename TFace>
+void Mesh<TFace>::AddFace( const int32 numVertices, const TFace *vertexIdx, const TFace *textureIdx, const TFace *normalIdx )
+{
+   assert(numVertices > 0 && vertexIdx != NULL);
+
+   const uint32 numCorners = (uint32)vertexIndices.size();
+   AppendOptional(textureIndices, textureIdx, numVertices, numCorners);
+   AppendOptional(normalIndices, normalIdx, numVertices, numCorners);
+   vertexIndices.insert(vertexIndices.end(), vertexIdx, vertexIdx + numVertices);
+   faceOffsets.push_back((uint32)vertexIndices.size());
+}
+
+template <typename TFace>
+void Mesh<TFace>::ReserveFaces( const uint32 numFaces, const uint32 numCorners )
+{
+   faceOffsets.reserve(numFaces + 1);
+   vertexIndices.reserve(numCorners);
+}
+
+template <typename TFace>
+Face<TFace> Mesh<TFace>::GetFace( const uint32 face ) const
+{
+   const uint32 first = faceOffsets[face];
+   return Face<TFace>((int32)(faceOffsets[face + 1] - first), &vertexIndices[first],
+      textureIndices.empty() ? NULL : &textureIndices[first],
+      normalIndices.empty() ? NULL : &normalIndices[first]);
+}
+
 typedef Mesh<uint16> Mesh16;
 typedef Mesh<uint32> Mesh32;
 
@@ -0,0 +1,213 @@
+#include "model/meshbin.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <Windows.h>
+
+#include "core/hash/fnv.hpp"
+using core::hash::Fnv1a64;
+using core::hash::FNV1A64_OFFSET;
+
+namespace meshbin
+{
+
+static uint64 AlignOffset( const uint64 offset )
+{
+   return (offset + MESHBIN_ALIGNMENT - 1) & ~(uint64)(MESHBIN_ALIGNMENT - 1);
+}
+
+static bool WritePadded( FILE *stream, const void *data, const uint64 size, uint64 &offset )
+{
+   static const byte zeros[MESHBIN_ALIGNMENT] = { 0 };
+
+   const uint64 start = AlignOffset( offset );
+   if ( start != offset && fwrite( zeros, 1, (size_t)(start - offset), stream ) != start - offset )
+      return false;
+   if ( size != 0 && fwrite( data, 1, (size_t)size, stream ) != size )
+      return false;
+
+   offset = start + size;
+   return true;
+}
+
+// the section fits the file, without letting a crafted offset wrap the end around
+static bool SectionFits( const uint64 offset, const uint64 sectionSize, const uint64 fileSize )
+{
+   return offset <= fileSize && sectionSize <= fileSize - offset;
+}
+
+// size and last write time from the directory entry, the file itself is not opened
+static bool GetSourceStamp( const String_c &path, uint64 &sizeOut, uint64 &timeOut )
+{
+   WIN32_FILE_ATTRIBUTE_DATA data;
+   if ( !GetFileAttributesExA( path.CString(), GetFileExInfoStandard, &data ) )
+      return false;
+
+   sizeOut = ((uint64)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+   timeOut = ((uint64)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+   return true;
+}
+
+bool HashSourceFile( const String_c &path, uint64 &hashOut, uint64 &sizeOut, uint64 &timeOut )
+{
+   // the time is taken before the content, a write in between makes the next check hash again
+   uint64 stampSize;
+   if ( !GetSourceStamp( path, stampSize, timeOut ) )
+      return false;
+
+   MappedFile source;
+   if ( !source.Open( path ) )
+      return false;
+
+   hashOut = Fnv1a64( source.GetData(), (size_t)source.GetSize(), FNV1A64_OFFSET );
+   sizeOut = source.GetSize();
+   return true;
+}
+
+bool WriteMeshBin( const String_c &path, const MeshBinDesc &desc )
+{
+   assert( desc.indexSize == 2 || desc.indexSize == 4 );
+   assert( desc.numVertices == 0 || desc.vertexStride >= sizeof(float) * 3 || !(desc.vertexFormat & vertexformat::VF_POSITION) );
+
+   MeshBinHeader header;
+   memset( &header, 0, sizeof(header) );
+   header.magic = MESHBIN_MAGIC;
+   header.version = MESHBIN_VERSION;
+   header.sourceHash = desc.sourceHash;
+   header.sourceSize = desc.sourceSize;
+   header.sourceTime = desc.sourceTime;
+   header.vertexFormat = (uint32)desc.vertexFormat;
+   header.vertexStride = desc.vertexStride;
+   header.numVertices = desc.numVertices;
+   header.numIndices = desc.numIndices;
+   header.indexSize = desc.indexSize;
+   header.numMaterials = desc.numMaterials;
+
+   // the position is the first component of an interleaved vertex
+   if ( (desc.vertexFormat & vertexformat::VF_POSITION) && desc.numVertices > 0 )
+   {
+      const byte *vertex = (const byte*)desc.vertices;
+      for ( int32 i = 0; i < 3; i++ )
+      {
+         header.boxMin[i] = FLOAT_MAX;
+         header.boxMax[i] = -FLOAT_MAX;
+      }
+      for ( uint32 v = 0; v < desc.numVertices; v++, vertex += desc.vertexStride )
+      {
+         const float *position = (const float*)vertex;
+         for ( int32 i = 0; i < 3; i++ )
+         {
+            header.boxMin[i] = position[i] < header.boxMin[i] ? position[i] : header.boxMin[i];
+            header.boxMax[i] = position[i] > header.boxMax[i] ? position[i] : header.boxMax[i];
+         }
+      }
+   }
+
+   header.vertexOffset = AlignOffset( sizeof(MeshBinHeader) );
+   header.indexOffset = AlignOffset( header.vertexOffset + (uint64)desc.numVertices * desc.vertexStride );
+   header.materialOffset = AlignOffset( header.indexOffset + (uint64)desc.numIndices * desc.indexSize );
+   header.fileSize = header.materialOffset + (uint64)desc.numMaterials * sizeof(MeshBinMaterial);
+
+   String_c tempPath = path + ".tmp";
+   FILE *stream = NULL;
+   if ( fopen_s( &stream, tempPath.CString(), "wb" ) != 0 )
+      return false;
+
+   uint64 offset = 0;
+   bool written = WritePadded( stream, &header, sizeof(header), offset ) &&
+      WritePadded( stream, desc.vertices, (uint64)desc.numVertices * desc.vertexStride, offset ) &&
+      WritePadded( stream, desc.indices, (uint64)desc.numIndices * desc.indexSize, offset ) &&
+      WritePadded( stream, desc.materials, (uint64)desc.numMaterials * sizeof(MeshBinMaterial), offset );
+   written = (fclose( stream ) == 0) && written;
+
+   assert( !written || offset == header.fileSize );
+   if ( !written || !MoveFileExA( tempPath.CString(), path.CString(), MOVEFILE_REPLACE_EXISTING ) )
+   {
+      DeleteFileA( tempPath.CString() );
+      return false;
+   }
+   return true;
+}
+
+MeshBinFile::MeshBinFile()
+{
+   header = NULL;
+}
+
+bool MeshBinFile::Open( const String_c &path )
+{
+   Close();
+
+   if ( !file.Open( path ) )
+      return false;
+
+   const uint64 size = file.GetSize();
+   const MeshBinHeader *candidate = (const MeshBinHeader*)file.GetData();
+
+   // reject anything that is not a complete file of the current version, the caller rebuilds it
+   bool valid = size >= sizeof(MeshBinHeader) &&
+      candidate->magic == MESHBIN_MAGIC &&
+      candidate->version == MESHBIN_VERSION &&
+      candidate->fileSize == size &&
+      (candidate->indexSize == 2 || candidate->indexSize == 4);
+   if ( valid )
+   {
+      // the counts are 32 bit, so the section sizes can not overflow 64 bits
+      const uint64 vertexSize = (uint64)candidate->numVertices * candidate->vertexStride;
+      const uint64 indexSize = (uint64)candidate->numIndices * candidate->indexSize;
+      const uint64 materialSize = (uint64)candidate->numMaterials * sizeof(MeshBinMaterial);
+      valid = candidate->vertexOffset >= sizeof(MeshBinHeader) &&
+         SectionFits( candidate->vertexOffset, vertexSize, size ) &&
+         SectionFits( candidate->indexOffset, indexSize, size ) &&
+         SectionFits( candidate->materialOffset, materialSize, size ) &&
+         candidate->vertexOffset + vertexSize <= candidate->indexOffset &&
+         candidate->indexOffset + indexSize <= candidate->materialOffset &&
+         (candidate->vertexOffset % MESHBIN_ALIGNMENT) == 0 &&
+         (candidate->indexOffset % MESHBIN_ALIGNMENT) == 0 &&
+         (candidate->materialOffset % MESHBIN_ALIGNMENT) == 0;
+   }
+
+   if ( !valid )
+   {
+      file.Close();
+      return false;
+   }
+
+   header = candidate;
+   return true;
+}
+
+void MeshBinFile::Close()
+{
+   file.Close();
+   header = NULL;
+}
+
+bool MeshBinFile::IsOpen() const
+{
+   return header != NULL;
+}
+
+bool MeshBinFile::IsStale( const String_c &sourcePath ) const
+{
+   assert( IsOpen() );
+
+   uint64 size, time;
+   if ( !GetSourceStamp( sourcePath, size, time ) )
+      return false;
+
+   // a size change is caught without touching the content, an unchanged write time skips the hash
+   if ( size != header->sourceSize )
+      return true;
+   if ( time == header->sourceTime )
+      return false;
+
+   MappedFile source;
+   if ( !source.Open( sourcePath ) )
+      return false;
+   if ( source.GetSize() != header->sourceSize )
+      return true;
+   return Fnv1a64( source.GetData(), (size_t)source.GetSize(), FNV1A64_OFFSET ) != header->sourceHash;
+}
+
+} // namespace meshbin
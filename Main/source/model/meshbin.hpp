@@ -0,0 +1,127 @@
+#ifndef _MESHBIN_HPP_INCLUDED_
+#define _MESHBIN_HPP_INCLUDED_
+
+// .meshbin is a binary cache of an imported mesh. It holds the indexed, interleaved vertex
+// stream, the index stream, the material table and the bounding box, laid out so that a
+// loaded file is used straight from the mapped view without any parsing. The size and the
+// last write time of the source in the header tell that it is unchanged without reading it,
+// when the time differs the content hash decides if the cache has to be rebuilt.
+
+#include "core/fileio/mappedfile.hpp"
+#include "core/string/string.hpp"
+using core::string::String_c;
+
+#include "gfx/vertexformat.hpp"
+using vertexformat::eVertexFormat;
+
+namespace meshbin
+{
+
+const uint32 MESHBIN_MAGIC = 0x4E49424D; // "MBIN"
+const uint32 MESHBIN_VERSION = 2;
+const uint32 MESHBIN_ALIGNMENT = 16; // every section starts on this boundary
+const uint32 MESHBIN_NAME_LENGTH = 64;
+const uint32 MESHBIN_PATH_LENGTH = 260;
+
+// all members are naturally aligned, the layout is the same for 32 and 64 bit builds
+struct MeshBinHeader
+{
+   uint32 magic;
+   uint32 version;
+   uint64 sourceHash; // FNV-1a 64 of the source file content
+   uint64 sourceSize;
+   uint64 sourceTime; // last write time of the source file, a FILETIME
+   uint32 vertexFormat; // eVertexFormat mask of the interleaved stream
+   uint32 vertexStride; // bytes per vertex
+   uint32 numVertices;
+   uint32 numIndices;
+   uint32 indexSize; // 2 or 4 bytes
+   uint32 numMaterials;
+   float boxMin[3];
+   float boxMax[3];
+   uint64 vertexOffset; // section offsets in bytes from the start of the file
+   uint64 indexOffset;
+   uint64 materialOffset;
+   uint64 fileSize;
+};
+
+struct MeshBinMaterial
+{
+   char name[MESHBIN_NAME_LENGTH];
+   char diffuseTexture[MESHBIN_PATH_LENGTH];
+   float ambient[3];
+   float diffuse[3];
+   float specular[3];
+   float shininess;
+   float transparency;
+   float refractIndex;
+   // range of the index stream drawn with this material
+   uint32 firstIndex;
+   uint32 numIndices;
+};
+
+static_assert(sizeof(MeshBinHeader) == 112, "meshbin header layout changed, bump MESHBIN_VERSION");
+static_assert(sizeof(MeshBinMaterial) == 372, "meshbin material layout changed, bump MESHBIN_VERSION");
+
+// the data handed to WriteMeshBin, the streams are stored as they are
+struct MeshBinDesc
+{
+   uint64 sourceHash;
+   uint64 sourceSize;
+   uint64 sourceTime;
+   eVertexFormat vertexFormat;
+   uint32 vertexStride;
+   const void *vertices;
+   uint32 numVertices;
+   const void *indices;
+   uint32 numIndices;
+   uint32 indexSize;
+   const MeshBinMaterial *materials;
+   uint32 numMaterials;
+};
+
+// hash the content of a source file and get its size and last write time, used for the staleness check
+bool HashSourceFile( const String_c &path, uint64 &hashOut, uint64 &sizeOut, uint64 &timeOut );
+
+// write a cache file, the bounding box is taken from the positions if the format has them.
+// The file is written next to the target and moved in place, so readers never see half a file
+bool WriteMeshBin( const String_c &path, const MeshBinDesc &desc );
+
+// a cache file mapped into memory, all getters point into the mapped view
+class MeshBinFile
+{
+private:
+   MappedFile file;
+   const MeshBinHeader *header;
+
+   MeshBinFile( const MeshBinFile &other );
+   MeshBinFile &operator=( const MeshBinFile &other );
+public:
+   MeshBinFile();
+
+   // map the file and validate the header and the section bounds
+   bool Open( const String_c &path );
+   void Close();
+   bool IsOpen() const;
+
+   // true if the source content differs from what the cache was built from. The content is only
+   // hashed when the size matches and the write time does not, a touched but unchanged source is
+   // hashed on every check until the cache is rebuilt.
+   // A source that can not be read keeps the cache, so caches can ship without sources
+   bool IsStale( const String_c &sourcePath ) const;
+
+   const MeshBinHeader *GetHeader() const { return header; }
+   eVertexFormat GetVertexFormat() const { return static_cast<eVertexFormat>(header->vertexFormat); }
+   uint32 GetVertexStride() const { return header->vertexStride; }
+   uint32 GetNumVertices() const { return header->numVertices; }
+   uint32 GetNumIndices() const { return header->numIndices; }
+   uint32 GetIndexSize() const { return header->indexSize; }
+   uint32 GetNumMaterials() const { return header->numMaterials; }
+   const void *GetVertexData() const { return file.GetData() + (size_t)header->vertexOffset; }
+   const void *GetIndexData() const { return file.GetData() + (size_t)header->indexOffset; }
+   const MeshBinMaterial *GetMaterials() const { return (const MeshBinMaterial*)(file.GetData() + (size_t)header->materialOffset); }
+};
+
+} // namespace meshbin
+
+#endif
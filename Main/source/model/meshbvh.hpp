@@ -0,0 +1,53 @@
+#ifndef _MESHBVH_HPP_INCLUDED_
+#define _MESHBVH_HPP_INCLUDED_
+
+#include <vector>
+
+#include "core/math/bvh.hpp"
+#include "model/mesh.hpp"
+
+using core::math::bvh::TriangleBvh;
+
+namespace mesh
+{
+
+// Builds a triangle BVH over the faces of a mesh for picking and overlap queries. Polygons are
+// fanned into triangles, triangleFaces (optional) receives the face of every triangle so the
+// triangle of a TriangleHit can be mapped back to the mesh
+template <typename TFace>
+void BuildMeshBvh( const Mesh<TFace> &mesh, TriangleBvh &out, vector<uint32> *triangleFaces = NULL )
+{
+   vector<uint32> indices;
+   if (triangleFaces != NULL)
+      triangleFaces->clear();
+
+   const uint32 numFaces = mesh.GetNumFaces();
+   const TFace *vertexIndices = mesh.GetVertexIndexPtr();
+   const uint32 *faceOffsets = mesh.GetFaceOffsetPtr();
+   indices.reserve(mesh.GetNumCorners() * 3);
+
+   for (uint32 face = 0; face < numFaces; face++)
+   {
+      const uint32 first = faceOffsets[face];
+      const uint32 numCorners = faceOffsets[face + 1] - first;
+      for (uint32 corner = 2; corner < numCorners; corner++)
+      {
+         indices.push_back(vertexIndices[first]);
+         indices.push_back(vertexIndices[first + corner - 1]);
+         indices.push_back(vertexIndices[first + corner]);
+         if (triangleFaces != NULL)
+            triangleFaces->push_back(face);
+      }
+   }
+
+   if (indices.empty())
+   {
+      out.Clear();
+      return;
+   }
+   out.Build(mesh.GetStream(MS_POSITION), mesh.GetNumElemVertexList(), &indices[0], (uint32)indices.size() / 3);
+}
+
+} // namespace mesh
+
+#endif
@@ -1,26 +1,32 @@
 #include "objLoader.hpp"
+#include "core/fileio/linereader.hpp"
+#include "core/string/tokenlist.hpp"
 
 using core::string::String_c;
+using core::string::StringView_c;
+using core::string::TokenList;
+using core::string::NextToken;
 
 bool MtlFile::Read()
 {
    assert( isOpen );
 
-   vector<String_c> tokens;
-   String_c token, lineC;
+   LineReader reader( *this );
+   StringView_c line;
+   TokenList<char, 8> tokens;
    int newmtlCount = -1;
    bool materialOpen = true;
    //materials = NULL;
 
-   while( ReadLine(lineC) )
+   while( reader.ReadLine(line) )
 	{
-	   lineC.Tokenize(tokens);
+	   tokens.Split( line, " \t" );
 
-      // skip comments
-      if( tokens[0] == NULL || tokens[0] == '#' )
+      // skip empty lines and comments
+      if( tokens.IsEmpty() || tokens[0][0] == '#' )
 			continue;
       
-      else if ( tokens[0] == "newmtl" ) // material
+      else if ( tokens[0] == "newmtl" && tokens.GetSize() > 1 ) // material
       {
          Material newMtl;
          materialOpen = true;
@@ -36,11 +42,14 @@ bool MtlFile::Read()
          newMtl.SetRefractIndex( 1.0f );
          newMtl.SetRefract( 0.0f );
 
-         newMtl.SetMaterialName( tokens[1] );
+         newMtl.SetMaterialName( String_c( tokens[1] ) );
 
          materials.push_back( newMtl );
       }
-      else if ( tokens[0] == "Ka" && materialOpen ) // ambient
+      // the properties below belong to the last newmtl
+      else if ( newmtlCount < 0 || !materialOpen )
+         continue;
+      else if ( tokens[0] == "Ka" && tokens.GetSize() > 3 ) // ambient
       {
          Vector3f temp;
 
@@ -49,7 +58,7 @@ bool MtlFile::Read()
          temp[2] = tokens[3].StringToFloat();      
          materials[newmtlCount].SetAmbientVec( temp );
       }
-      else if ( tokens[0] == "Kd" && materialOpen ) // diffuse
+      else if ( tokens[0] == "Kd" && tokens.GetSize() > 3 ) // diffuse
       {
          Vector3f temp;
          temp[0] = tokens[1].StringToFloat();
@@ -57,7 +66,7 @@ bool MtlFile::Read()
          temp[2] = tokens[3].StringToFloat();      
          materials[newmtlCount].SetDiffuseVec( temp );
       }
-      else if ( tokens[0] == "Ks" && materialOpen ) // specular
+      else if ( tokens[0] == "Ks" && tokens.GetSize() > 3 ) // specular
       {
          Vector3f temp;
          temp[0] = tokens[1].StringToFloat();
@@ -65,38 +74,36 @@ bool MtlFile::Read()
          temp[2] = tokens[3].StringToFloat();      
          materials[newmtlCount].SetSpecularVec( temp );
       }
-      else if ( tokens[0] == "Ns" && materialOpen ) // shine
+      else if ( tokens.GetSize() < 2 )
+         continue;
+      else if ( tokens[0] == "Ns" ) // shine
       {
-         float t = tokens[1].StringToFloat();
          materials[newmtlCount].SetShine( tokens[1].StringToFloat() );
       }
-		else if( tokens[0] == "d" && materialOpen ) // transparency
+		else if( tokens[0] == "d" ) // transparency
 		{
          materials[newmtlCount].SetTransparency( tokens[1].StringToFloat() );
 		}
-      else if( tokens[0] == "r" && materialOpen ) // reflection
+      else if( tokens[0] == "r" ) // reflection
 		{
          materials[newmtlCount].SetReflection( tokens[1].StringToFloat() );
 		}
-		else if( tokens[0] == "Ni" && materialOpen ) //refract index
+		else if( tokens[0] == "Ni" ) //refract index
 		{
 			materials[newmtlCount].SetRefractIndex( tokens[1].StringToFloat() );
 		}
-		else if( tokens[0] == "illum" && materialOpen ) // illumination type
+		else if( tokens[0] == "illum" ) // illumination type
 		{
          // type of lighting technique ??
 		}
-		else if( tokens[0] == "map_Kd" && materialOpen ) // texture map
+		else if( tokens[0] == "map_Kd" ) // texture map
 		{
-         String_c textureFileName = tokens[1];
-         //must remove /n character
-         textureFileName = textureFileName( 0, textureFileName.GetSize()-1  );
-         materials[newmtlCount].SetTextureFileName( textureFileName );
+         // the file name is the rest of the line, it may contain spaces
+         const StringView_c textureFileName = line.SubView( tokens[1].Begin() - line.Begin() ).Trim();
+         materials[newmtlCount].SetTextureFileName( String_c( textureFileName ) );
 		}
 		//else
   //       cout << "Unknown tag in material file ! " << endl;  
-
-      tokens.clear();
    }
 
    return true;
@@ -104,6 +111,7 @@ bool MtlFile::Read()
 
 ObjFile::ObjFile()
 {
+   numFaceErrors = 0;
 }
 
 void ObjFile::SetMaterialFilePath( String_c inPath )
@@ -111,24 +119,72 @@ void ObjFile::SetMaterialFilePath( String_c inPath )
    this->materialFilePath = inPath;
 }
 
+// obj indices are 1-based, negative indices are relative to the end of the list read so far.
+// 0 and indices outside the list give INVALID_INDEX
+static uint32 ToMeshIndex( const int32 objIndex, const uint32 listSize )
+{
+   if (objIndex > 0 && (uint32)objIndex <= listSize)
+      return (uint32)(objIndex - 1);
+   if (objIndex < 0 && (uint32)(-(int64)objIndex) <= listSize)
+      return listSize - (uint32)(-(int64)objIndex);
+   return Face32::INVALID_INDEX;
+}
+
+// parses one face corner, "v", "v/t", "v//n" or "v/t/n". A texture coordinate or normal index out of
+// range is left INVALID_INDEX, false for a position index out of range
+static bool ReadCorner( const StringView_c &corner, const Mesh32 &mesh, uint32 &vertexIdx, uint32 &textureIdx, uint32 &normalIdx,
+   bool &hasTexture, bool &hasNormal )
+{
+   vertexIdx = ToMeshIndex( corner.StringToInt(), mesh.GetNumElemVertexList() );
+   if (vertexIdx == Face32::INVALID_INDEX)
+      return false;
+
+   int32 idx = corner.FindFirst('/');
+   if (idx == -1 || (uint32)idx + 1 >= corner.GetSize())
+      return true;
+
+   if (corner[idx+1] == '/')
+   {
+      normalIdx = ToMeshIndex( corner.SubView(idx+2).StringToInt(), mesh.GetNumElemNormalList() );
+      hasNormal = true;
+   }
+   else if (core::IsADigit(corner[idx+1]) || corner[idx+1] == '-')
+   {
+      const StringView_c rest = corner.SubView(idx+1);
+      textureIdx = ToMeshIndex( rest.StringToInt(), mesh.GetNumElemTexture2List() );
+      hasTexture = true;
+      if ((idx = rest.FindFirst('/')) != -1)
+      {
+         normalIdx = ToMeshIndex( rest.SubView(idx+1).StringToInt(), mesh.GetNumElemNormalList() );
+         hasNormal = true;
+      }
+   }
+   return true;
+}
+
 bool ObjFile::Read()
 {
    assert( isOpen );
 
    if (this->GetSize() == 0)
       return false;
-   String_c buffer;
-   vector<String_c> tokens;
-   String_c token;
 
+   // lines and tokens are views into the reader's buffer, nothing is allocated per line
+   LineReader reader( *this );
+   StringView_c line;
+   TokenList<char, 4> tokens;
+
+   numFaceErrors = 0;
    int currentGroupIndex = -1;
+   // corner indices of the current face, kept across lines to avoid reallocating
+   vector<uint32> vertexIdx, textureIdx, normalIdx;
  
-   while ( ReadLine(buffer) )
+   while ( reader.ReadLine(line) )
    {
-      buffer.Tokenize( tokens );
-
-      if (tokens[0] == "#" ) {}
-      else if( tokens[0] == "v"  )
+      // keyword and up to three values, face corners are read from the rest of the line
+      tokens.Split( line, " \t" );
+      if (tokens.IsEmpty() || tokens[0][0] == '#') {}
+      else if( tokens[0] == "v" && tokens.GetSize() > 3 )
       {
          Vector3f vtemp;
          
@@ -143,7 +199,7 @@ bool ObjFile::Read()
 
          mesh.SetComponents(VF_POSITION);
       }
-      else if( tokens[0] == "vn" )
+      else if( tokens[0] == "vn" && tokens.GetSize() > 3 )
       {
          Vector3f vntemp;
          vntemp[0] = tokens[1].StringToFloat();
@@ -161,7 +217,7 @@ bool ObjFile::Read()
          //newGroup.groupNum = currentGroupIndex;
      
       }
-      else if( tokens[0] == "mtllib" )
+      else if( tokens[0] == "mtllib" && tokens.GetSize() > 1 )
       {
          //Material file is listed as file name only in obj file:
          // "mtllib castle.mtl" For example. Therefore need to specify path to this file location. Smarter solution probably exists
@@ -169,7 +225,7 @@ bool ObjFile::Read()
 
          //create new file, fill it with materials and put it into material list
          MtlFile newMtlFile;
-         String_c materialFileLocation = materialFilePath + tokens[1]( 0, tokens[1].GetSize() - 1 );
+         String_c materialFileLocation = materialFilePath + String_c( tokens[1] );
 
          newMtlFile.Open( materialFileLocation );         
          newMtlFile.Read();
@@ -178,7 +234,7 @@ bool ObjFile::Read()
          MtlFileList.push_back( newMtlFile );
      
       }
-      else if( tokens[0]== "vt" )
+      else if( tokens[0]== "vt" && tokens.GetSize() > 2 )
       {
  
          Vector2f vttemp;
@@ -190,12 +246,6 @@ bool ObjFile::Read()
       }
       else if( tokens[0] == "f" )
       {
-         //triangular face:
-         String_c test;
-         Face32 newFace;
-         //need vertexIndexCount
-         int32 vertexIndexCount = 0;
-
          //3 attributes
          //f 1/2/3 4/5/6 7/8/9
 
@@ -207,55 +257,34 @@ bool ObjFile::Read()
 
          //1 attribute( V )
          //f 1 2 3
-
-
-         for ( int i = 1; i < newFace.GetNumVertices() + 1; i++ )
+         vertexIdx.clear();
+         textureIdx.clear();
+         normalIdx.clear();
+         bool hasTexture = false, hasNormal = false, isValid = true;
+
+         StringView_c rest = line.SubView( tokens[0].End() - line.Begin() );
+         StringView_c corner;
+         while ( NextToken( rest, corner, " \t" ) )
          {
-            int idx;
-            //newFace.vertexIndex[vertexIndexCount] = tokens[i].StringToInt();
-
-            newFace.AddVertexIndex( tokens[i].StringToInt() );
-            
-            if ((idx = tokens[i].FindFirst('/')) != -1)
-            {
-               if (tokens[i][idx+1] == '/')
-               {
-                  tokens[i] = tokens[i](idx+2);
-                  //newFace.normalIndex[vertexIndexCount] = tokens[i].StringToInt();
-                  newFace.AddNormalIndex( tokens[i].StringToInt() );
-               }
-               else if (core::IsADigit(tokens[i][idx+1]))
-               {
-                  tokens[i] = tokens[i](idx+1);
-                  //newFace.textureIndex[vertexIndexCount] = tokens[i].StringToInt();
-                  newFace.AddTextureIndex( tokens[i].StringToInt() );
-                  if ((idx = tokens[i].FindFirst('/')) != -1)
-                  {
-                     tokens[i] = tokens[i](idx+1);
-                     //newFace.normalIndex[vertexIndexCount] = tokens[i].StringToInt();
-                     newFace.AddNormalIndex( tokens[i].StringToInt() );
-                  }
-               }
-            }
-
-            //vertexIndexCount++;
+            uint32 v, t = Face32::INVALID_INDEX, n = Face32::INVALID_INDEX;
+            if (!ReadCorner( corner, mesh, v, t, n, hasTexture, hasNormal ))
+               isValid = false;
+            vertexIdx.push_back( v );
+            textureIdx.push_back( t );
+            normalIdx.push_back( n );
          }
 
+         // the corners are trusted by the vertex buffers and the bvh, a face reaching outside is dropped
+         const int32 numVertices = (int32)vertexIdx.size();
+         if (!isValid)
+            numFaceErrors++;
+         if (!isValid || numVertices < 3)
+            continue;
 
-         //if ( tokens[i+1][1] == '/' )
-
-
-         //newFace.vertexIndex[vertexIndexCount] = tokens[i+1].StringToInt();
-
-
-         //ParseIndices( newFace.vertexIndex,newFace.normalIndex, 
-         //   newFace.textureIndex, test );
-
-         mesh.AddFace( newFace );
+         mesh.AddFace( numVertices, &vertexIdx[0], hasTexture ? &textureIdx[0] : NULL, hasNormal ? &normalIdx[0] : NULL );
          //if( currentGroupIndex > 0 )
          // this->groupsMap[currentGroupIndex].numFaces++;
       }
-     tokens.clear();
    }//WHILE
 
    return true; 
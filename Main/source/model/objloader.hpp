@@ -127,6 +127,7 @@ private:
    String_c materialFilePath;
 public:
    Mesh32 mesh; // assume the PNT for obj file for the time being
+   uint32 numFaceErrors; // faces dropped by Read, a vertex index outside the positions read so far
 
    ObjFile();
    void SetMaterialFilePath( String_c path );
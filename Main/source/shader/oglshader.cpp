@@ -14,8 +14,6 @@ namespace shader
 GLSLShader::GLSLShader()
 {
    m_totalShaders = 0;
-   m_attributeMap.clear();
-   m_uniformLocationMap.clear();
    m_shaders[VERTEX_SHADER] = 0; //tmp
    m_shaders[FRAGMENT_SHADER] = 0; //tmp
    m_shaders[GEOMETRY_SHADER] = 0; //tmp
@@ -23,8 +21,6 @@ GLSLShader::GLSLShader()
 
 GLSLShader::~GLSLShader()
 {
-   m_attributeMap.clear();
-   m_uniformLocationMap.clear();
 }
 
 void GLSLShader::Load(GLenum type, const string &filename)
@@ -72,19 +68,26 @@ void GLSLShader::Load(GLenum type, const string &filename)
 }
 
 //An indexer that returns the location of the attribute
-GLuint GLSLShader::operator[](const string &attribute)
+GLuint GLSLShader::operator[](const NameId &attribute)
 {
    return m_attributeMap[attribute];
 }
 
-GLuint GLSLShader::operator()(const string &uniform)
+GLuint GLSLShader::operator()(const NameId &uniform)
 {
-   return m_uniformLocationMap[uniform];
+   return GetUniformLocation(uniform);
+}
+
+// -1 for uniforms that were not added, glUniform* ignores that location
+GLint GLSLShader::GetUniformLocation(const NameId &uniform) const
+{
+   const GLint *location = m_uniformLocationMap.Find(uniform);
+   return location != NULL ? *location : -1;
 }
 
 void GLSLShader::AddUniform(const string &uniform)
 {
-   m_uniformLocationMap[uniform] = glGetUniformLocation(m_program, uniform.c_str());
+   m_uniformLocationMap[NameId::Intern(uniform.c_str())] = glGetUniformLocation(m_program, uniform.c_str());
 }
 
 void GLSLShader::Use()
@@ -99,7 +102,7 @@ void GLSLShader::Unuse()
 
 void GLSLShader::AddAttribute(const string &attribute)
 {
-   m_attributeMap[attribute] = glGetAttribLocation(m_program, attribute.c_str());
+   m_attributeMap[NameId::Intern(attribute.c_str())] = glGetAttribLocation(m_program, attribute.c_str());
 
 }
 
@@ -140,11 +143,11 @@ void GLSLShader::DeleteProgram()
    glDeleteProgram(m_program);
 }
 
-void GLSLShader::AddUniformData(const char* variableName, const void *_array, eVectorType type, int32 numElementsToModify)
+void GLSLShader::AddUniformData(const NameId &variableName, const void *_array, eVectorType type, int32 numElementsToModify)
 {
    assert(numElementsToModify > 0);
 
-   int32 uniformHandle = m_uniformLocationMap[variableName];
+   int32 uniformHandle = GetUniformLocation(variableName);
    switch (type)
    {
       //uniforms for scalars, 1 in number
@@ -192,10 +195,10 @@ void GLSLShader::AddUniformData(const char* variableName, const void *_array, eV
 }
 
 // assume for the sake of simplification. Assume that 4x4 float matrix is most common, but should be generalized in distant future
-void GLSLShader::AddUniformData(const char* variableName, const void *_array, eMatrixType type, int32 n, bool transposed)
+void GLSLShader::AddUniformData(const NameId &variableName, const void *_array, eMatrixType type, int32 n, bool transposed)
 {
    // n = number of matrices to modify
-   int32 uniformHandle = m_uniformLocationMap[variableName];
+   int32 uniformHandle = GetUniformLocation(variableName);
    // TODO: make glUniform for scalars into vector form glUniform*v, because it is easier to extend for 1, 2, 3 and 4(instead of supplying them individually)
    // note that scalars are interpreted as vectors, even just 1 float is
    switch (type)
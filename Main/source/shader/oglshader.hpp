@@ -2,18 +2,20 @@
 #define _OGLSHADER_HPP_INCLUDED_
 
 #include <vector>
-#include <map>
 
 #include "ogldriver.hpp"
 #include "shadertypes.hpp"
 
+#include "core/containers/flathashmap.hpp"
 #include "core/fileio/file.hpp"
+#include "core/string/nameid.hpp"
 
 #include <string>
 using std::getline;
 using std::string;
 
-using std::map;
+using core::containers::FlatHashMap;
+using core::string::NameId;
 
 namespace shader
 {
@@ -33,20 +35,22 @@ namespace shader
       GLuint m_program;
       int32 m_totalShaders;
       //eShaderType m_type;
-      map<string, GLuint> m_attributeMap;
-      map<string, GLuint> m_uniformLocationMap;
+      // keyed by the interned names, a lookup with a literal name compares integers only
+      FlatHashMap<NameId, GLuint> m_attributeMap;
+      FlatHashMap<NameId, GLint> m_uniformLocationMap;
       enum ShaderType { VERTEX_SHADER, FRAGMENT_SHADER, GEOMETRY_SHADER }; //tmp
       GLuint m_shaders[3];//0->vertexshader, 1->fragmentshader, 2->geometryshader //tmp
    public:
       GLSLShader();
       ~GLSLShader();
       void Load(GLenum type, const string &filename);
-      GLuint operator[](const string &attribute);
-      GLuint operator()(const string &uniform);
+      GLuint operator[](const NameId &attribute);
+      GLuint operator()(const NameId &uniform);
+      GLint GetUniformLocation(const NameId &uniform) const;
 
       void AddUniform(const string &uniform);
-      void AddUniformData(const char *variableName, const void *_array, eVectorType type, int32 numElementsToModify);
-      void AddUniformData(const char *variableName, const void *_array, eMatrixType type, int32 numMatrices, bool transposed = false);
+      void AddUniformData(const NameId &variableName, const void *_array, eVectorType type, int32 numElementsToModify);
+      void AddUniformData(const NameId &variableName, const void *_array, eMatrixType type, int32 numMatrices, bool transposed = false);
       void AddUniformSampler(const char* variableName, eOpaqueType sampler);
 
       void Use();
@@ -73,7 +77,7 @@ namespace shader
       uint32 handle;
       //std::vector<uint32> uniformHandles;
       //int32 uniformHandle; // midlertidig forenkling med 1 uniform drhndtak
-      map<const char*, int32> handleMap;
+      FlatHashMap<NameId, int32> handleMap;
 
       //can have varying number of source files for each type of shader: vertex, geometry and fragment
       //vector<Shader> sources;
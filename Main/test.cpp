@@ -25,6 +25,9 @@ using win32window::Win32Window;
 #include "win32/win32console.hpp"
 #include "core/math/frustum.hpp"
 #include "core/math/camera.hpp"
+#include "core/memory/frameallocator.hpp"
+#include "core/task/scheduler.hpp"
+#include "asset/assetloader.hpp"
 using namespace std;
 
 HINSTANCE hInst;
@@ -42,15 +45,21 @@ INT WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
    LPSTR lpCmdLine, int nCmdShow)
 {
 
+   // temporaries of a frame live in here, double buffered so the last frame stays readable
+   FrameAllocator frameAllocator( 2 );
+   FrameAllocator::SetActive( &frameAllocator );
+
+   // one pool of worker threads for parsing, culling and the like
+   TaskScheduler scheduler;
+   TaskScheduler::SetActive( &scheduler );
+
    FreeCamera camera( FRUSTUM_ORTHOGRAPHIC, -1.0f, 1.0f, -1.0f, 1.0f, 0.3f, 1000.0f );
 
    //FreeCamera camera(FRUSTUM_PERSPECTIVE, -1.0f, 1.0f, 1.0f, -1.0f, 0.3f, 1000.0f);
 
-   ObjFile cube;
-   cube.Open("assets/testObjects/cubePNT.obj");
-
-   cube.Read();
-   cube.Close();
+   // the cube is loaded by a worker while the window and the GL context are created
+   asset::AssetLoader assetLoader;
+   asset::AssetHandle<asset::ObjMesh> cubeAsset = assetLoader.LoadObjMesh("assets/testObjects/cubePNT.obj", "assets/testObjects/");
    Win32Console debugConsole;
    debugConsole.Create(100, 50, 100, 50);
    bool resized = false;
@@ -75,7 +84,10 @@ INT WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
    oglContext.SetDepthTest(ZBUF_LESSEQUAL, 0.0f, 1.0f, 1.0f);
    //oglContext.EnableCulling();
   
-   VertexBuffer<float> buffer(cube.mesh.GetVertexFormat(), 3, USAGE_STATIC_READ, ACCESS_READ_ONLY,BBTARGET_ARRAY_BUFFER );
+   if (!cubeAsset.Wait())
+      return -1;
+   asset::ObjMesh &cube = *cubeAsset.Get();
+   VertexBuffer<float> buffer(cube.vertexFormat, 3, USAGE_STATIC_READ, ACCESS_READ_ONLY,BBTARGET_ARRAY_BUFFER );
 
    GLSLShader shader;
    shader.Load(GL_VERTEX_SHADER, "source/shader/glsl/vertex/triangle.vert");
@@ -148,6 +160,9 @@ INT WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
       /*if (GetAsyncKeyState('K') & 0x8000)
          msg.message = WM_QUIT;*/
 
+      // GPU uploads of assets finished by the workers
+      assetLoader.ProcessUploads();
+
       oglContext.ClearBuffers();
       shader.Use();
       //glBindVertexArray(vaoID);
@@ -162,6 +177,7 @@ INT WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
       glBindBuffer(GL_ARRAY_BUFFER, 0);
     
       oglContext.SwapFrontAndBackBuffer();
+      frameAllocator.EndFrame();
    }
 
    //f.CopyToBuffer( buf );